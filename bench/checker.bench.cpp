@@ -0,0 +1,38 @@
+#include "checker/checker.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+// A program of `count` functions with a few dozen statements each.
+static std::string program(int count)
+{
+  std::string input;
+
+  for (int i = 0; i < count; i++) {
+    input += "fn f" + std::to_string(i) + "(a: int, b: float, s: string): float {\n";
+    for (int j = 0; j < 16; j++) {
+      input += "  let x" + std::to_string(j) + ": int = a * " + std::to_string(j) + " + s[a];\n"
+               "  if (x" + std::to_string(j) + " > b) { b = b + x" + std::to_string(j) + "; }\n";
+    }
+    input += "  return b" + (i > 0 ? " + f" + std::to_string(i - 1) + "(a, b, s)" : "") + ";\n}\n";
+  }
+
+  return input;
+}
+
+TEST_CASE("Checker", "[checker][!benchmark]")
+{
+  SourceManager sources;
+  Lexer lexer(sources, sources.add("bench.tl", program(20000)));
+  Parser parser(lexer.tokenize());
+  Ast ast = parser.parse();
+  TypeTable types;
+
+  BENCHMARK("20000 functions, 1 job") { return Checker(ast, types, 1).check().size(); };
+
+  BENCHMARK("20000 functions, 4 jobs") { return Checker(ast, types, 4).check().size(); };
+
+  BENCHMARK("20000 functions, 8 jobs") { return Checker(ast, types, 8).check().size(); };
+}
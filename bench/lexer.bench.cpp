@@ -0,0 +1,73 @@
+#include "lexer/lexer.hpp"
+#include "utf8/utf8.hpp"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+static std::string source(const char *identifier, const char *text, int functions)
+{
+  std::string input;
+
+  for (int i = 0; i < functions; i++) {
+    std::string n = std::to_string(i);
+    input += "fn " + std::string(identifier) + n + "(a: int, b: int): int {\n";
+    input += "  let counter_" + n + " = a * 0x1f + b / 3; // running total\n";
+    input += "  while (counter_" + n + " < 1'000) counter_" + n + " += 2.5;\n";
+    input += "  print(\"" + std::string(text) + "\", counter_" + n + ");\n";
+    input += "  return counter_" + n + " >= 10 ? 'y' : 'n';\n}\n";
+  }
+
+  return input;
+}
+
+TEST_CASE("Lexer throughput", "[lexer][!benchmark]")
+{
+  std::string ascii = source("function_", "value of the counter", 20000);
+  std::string utf8  = source("fonction_été_", "valeur du compteur – ünïcödé", 20000);
+
+  BENCHMARK("UTF-8 validation of ASCII source")
+  {
+    return utf8_validate(ascii.data(), ascii.size());
+  };
+
+  BENCHMARK("UTF-8 validation of UTF-8 source")
+  {
+    return utf8_validate(utf8.data(), utf8.size());
+  };
+
+  BENCHMARK("ASCII source (" + std::to_string(ascii.size() >> 20) + " MiB)")
+  {
+    SourceManager sources;
+    Lexer lexer(sources, sources.add("bench.tl", ascii));
+    return lexer.tokenize().size();
+  };
+
+  BENCHMARK("UTF-8 source (" + std::to_string(utf8.size() >> 20) + " MiB)")
+  {
+    SourceManager sources;
+    Lexer lexer(sources, sources.add("bench.tl", utf8));
+    return lexer.tokenize().size();
+  };
+}
+
+template <typename Policy> static std::size_t count_tokens(const std::string &input)
+{
+  SourceManager sources;
+  BasicLexer<Policy> lexer(sources, sources.add("bench.tl", input));
+  std::size_t count = 1;
+
+  while (lexer.next().type != TokenType::T_EOF)
+    count++;
+  return count;
+}
+
+TEST_CASE("Lexer policies", "[lexer][!benchmark]")
+{
+  std::string ascii = source("function_", "value of the counter", 20000);
+
+  BENCHMARK("Positions and values") { return count_tokens<LexerPolicy>(ascii); };
+
+  BENCHMARK("Positions, values and trivia") { return count_tokens<TriviaLexerPolicy>(ascii); };
+
+  BENCHMARK("Token types only") { return count_tokens<BareLexerPolicy>(ascii); };
+}
@@ -0,0 +1,41 @@
+#include "lexer/lexer.hpp"
+#include "loader/loader.hpp"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+static std::size_t lex_all(const std::vector<std::string> &paths, bool batched)
+{
+  Loader loader(paths, batched);
+  SourceManager sources;
+  Source source;
+  std::size_t tokens = 0;
+
+  while (loader.next(source)) {
+    Lexer lexer(sources, sources.add(source.path, std::move(source.contents)));
+    tokens += lexer.tokenize().size();
+  }
+
+  return tokens;
+}
+
+TEST_CASE("Loading of many small files", "[loader][!benchmark]")
+{
+  std::vector<std::string> paths;
+
+  for (int i = 0; i < 4000; i++) {
+    paths.push_back("tela-bench-" + std::to_string(i) + ".tl");
+
+    std::ofstream file(paths.back(), std::ios::binary);
+    file << "fn f" << i << "(a: int): int { let x = a * " << i << "; return x + 1; }\n";
+  }
+
+  BENCHMARK("Batched, 4000 files") { return lex_all(paths, true); };
+  BENCHMARK("One by one, 4000 files") { return lex_all(paths, false); };
+
+  for (const std::string &path : paths)
+    std::remove(path.c_str());
+}
@@ -0,0 +1,100 @@
+#include "lsp/lsp.hpp"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <string>
+
+static std::string change(int line, int col, int end_col, const std::string &text)
+{
+  return "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didChange\",\"params\":{\"textDocument\":"
+         "{\"uri\":\"file:///bench.tl\",\"version\":2},\"contentChanges\":[{\"range\":{\"start\":"
+         "{\"line\":" + std::to_string(line) + ",\"character\":" + std::to_string(col) + "},"
+         "\"end\":{\"line\":" + std::to_string(line) + ",\"character\":"
+         + std::to_string(end_col) + "}},\"text\":\"" + text + "\"}]}}";
+}
+
+TEST_CASE("Language server", "[lsp][!benchmark]")
+{
+  std::string input;
+  for (int i = 0; i < 10000; i++) {
+    input += "fn f" + std::to_string(i) + "(a: int, s: string): int {\n"
+             "  let b = a * " + std::to_string(i) + " + s[0]; // comment\n"
+             "  /* while (b > 10) */ b -= 3;\n"
+             "  return b + f" + std::to_string(i / 2) + "(a, \"text\");\n"
+             "}\n";
+  }
+
+  std::stringstream in;
+  std::ostringstream out;
+  LanguageServer server(in, out);
+  Json open = Json::object()
+                  .set("jsonrpc", "2.0")
+                  .set("method", "textDocument/didOpen")
+                  .set("params", Json::object().set(
+                                     "textDocument", Json::object()
+                                                         .set("uri", "file:///bench.tl")
+                                                         .set("languageId", "tela")
+                                                         .set("version", 1)
+                                                         .set("text", input)));
+  Json full = Json::parse("{\"jsonrpc\":\"2.0\",\"id\":1,"
+                          "\"method\":\"textDocument/semanticTokens/full\",\"params\":"
+                          "{\"textDocument\":{\"uri\":\"file:///bench.tl\"}}}");
+  // The server numbers its results in order, which the deltas refer to.
+  unsigned long results = 0;
+  auto delta            = [&results] {
+    return Json::parse("{\"jsonrpc\":\"2.0\",\"id\":2,"
+                       "\"method\":\"textDocument/semanticTokens/full/delta\",\"params\":"
+                       "{\"textDocument\":{\"uri\":\"file:///bench.tl\"},\"previousResultId\":\""
+                       + std::to_string(results++) + "\"}}");
+  };
+
+  server.handle(Json::parse("{\"jsonrpc\":\"2.0\",\"id\":0,\"method\":\"initialize\"}"));
+  server.handle(open);
+
+  BENCHMARK("Opening 50000 lines")
+  {
+    out.str("");
+    server.handle(open);
+    return out.tellp();
+  };
+
+  BENCHMARK("semanticTokens/full of 50000 lines")
+  {
+    out.str("");
+    server.handle(full);
+    results++;
+    return out.tellp();
+  };
+
+  // Every round types a character into a line in the middle and deletes it again, and asks for
+  // the tokens after each.
+  server.handle(full);
+  results++;
+  std::string type   = change(25001, 9, 9, "x");
+  std::string remove = change(25001, 9, 10, "");
+
+  BENCHMARK("A keystroke and semanticTokens/full/delta, twice")
+  {
+    out.str("");
+    server.handle(Json::parse(type));
+    server.handle(delta());
+    server.handle(Json::parse(remove));
+    server.handle(delta());
+    return out.tellp();
+  };
+
+  // A comment opened at the top runs to the first */ of the document, which the old tokens only
+  // meet again after it.
+  std::string comment   = change(0, 0, 0, "/*");
+  std::string uncomment = change(0, 0, 2, "");
+
+  BENCHMARK("Opening and closing a comment at the top, with deltas")
+  {
+    out.str("");
+    server.handle(Json::parse(comment));
+    server.handle(delta());
+    server.handle(Json::parse(uncomment));
+    server.handle(delta());
+    return out.tellp();
+  };
+}
@@ -0,0 +1,47 @@
+#include "irgen/irgen.hpp"
+#include "lexer/lexer.hpp"
+#include "optimizer/optimizer.hpp"
+#include "parser/parser.hpp"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+static Ast parse(const std::string &input)
+{
+  SourceManager sources;
+  Lexer lexer(sources, sources.add("bench.tl", input));
+  Parser parser(lexer.tokenize());
+  return parser.parse();
+}
+
+TEST_CASE("SSA optimization of large functions", "[optimizer][!benchmark]")
+{
+  std::string input = "fn f(a: int, b: int): int { let s = 0; let i = 0;";
+  for (int i = 0; i < 50000; i++) {
+    input += " s += a * b; let t" + std::to_string(i) + " = s + 1;";
+    input += " if (i) { s = s + b * a; } i++;";
+  }
+  input += " return s; }";
+
+  Ast ast = parse(input);
+
+  BENCHMARK("SSA construction (50k statements)")
+  {
+    IrGen irgen(ast);
+    return irgen.generate().instrs.size();
+  };
+
+  IrGen irgen(ast);
+  Ir ir = irgen.generate();
+
+  BENCHMARK_ADVANCED("Optimization (50k statements)")(Catch::Benchmark::Chronometer meter)
+  {
+    std::vector<Ir> copies(meter.runs(), ir);
+    meter.measure([&](int i) {
+      Optimizer optimizer(copies[i]);
+      optimizer.optimize();
+      return copies[i].instrs.size();
+    });
+  };
+}
@@ -0,0 +1,34 @@
+#include "parser/parser.hpp"
+#include "pipeline/pipeline.hpp"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+TEST_CASE("Pipelined lexing and parsing", "[pipeline][!benchmark]")
+{
+  std::string input;
+  for (int i = 0; i < 50000; i++) {
+    input += "fn f" + std::to_string(i) + "(a: int, s: string): int {\n"
+             "  let b = a * " + std::to_string(i) + " + s[0]; // comment\n"
+             "  while (b > 10) { b -= 3; }\n"
+             "  return b + f" + std::to_string(i / 2) + "(a, \"text\");\n"
+             "}\n";
+  }
+
+  BENCHMARK("50000 functions, lexed then parsed")
+  {
+    SourceManager sources;
+    Lexer lexer(sources, sources.add("bench.tl", input));
+    Parser parser(lexer.tokenize());
+    return parser.parse().size();
+  };
+
+  BENCHMARK("50000 functions, pipelined")
+  {
+    SourceManager sources;
+    Lexer lexer(sources, sources.add("bench.tl", input));
+    TokenPipeline tokens(lexer);
+    Parser parser(tokens);
+    return parser.parse().size();
+  };
+}
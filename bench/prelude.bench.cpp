@@ -0,0 +1,42 @@
+#include "prelude/prelude.hpp"
+#include "folder/folder.hpp"
+#include "lexer/lexer.hpp"
+#include "module/module.hpp"
+#include "parser/parser.hpp"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <string_view>
+
+// What tela does with `input`, given the prelude, before the program runs, which takes the same
+// time either way.
+static std::size_t build(const char *input, std::string_view prelude)
+{
+  SourceManager sources;
+  Lexer lexer(sources, sources.add("bench.tl", input));
+  Parser parser(lexer.tokenize());
+  Ast ast = parser.parse();
+
+  Folder folder(ast);
+  folder.fold();
+
+  Modules modules(sources, 1, nullptr, prelude);
+  return modules.build(ast, "bench.tl").code.size();
+}
+
+TEST_CASE("Cold start with the prelude", "[prelude][!benchmark]")
+{
+  const char *input = "fn main() { return abs(-3) + max(1, 2); }";
+
+  BENCHMARK("Trivial program, snapshot")
+  {
+    return build(input, std::string_view(PRELUDE_SNAPSHOT, PRELUDE_SNAPSHOT_SIZE));
+  };
+
+  BENCHMARK("Trivial program, prelude compiled from source")
+  {
+    SourceManager sources;
+    std::string image = prelude_image(sources, sources.load(TELA_PRELUDE_SOURCE));
+    return build(input, image);
+  };
+}
@@ -0,0 +1,76 @@
+#include "symbols/symbols.hpp"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// The obvious alternative: a node-based map per scope, searched from the innermost one out.
+struct ScopeMaps {
+  std::vector<std::unordered_map<std::uint32_t, std::uint32_t>> scopes;
+
+  ScopeMaps() : scopes(1) { }
+
+  void enter() { this->scopes.emplace_back(); }
+  void leave() { this->scopes.pop_back(); }
+  void declare(std::uint32_t name, std::uint32_t value) { this->scopes.back()[name] = value; }
+
+  std::uint32_t find(std::uint32_t name) const
+  {
+    for (auto scope = this->scopes.rbegin(); scope != this->scopes.rend(); ++scope) {
+      auto found = scope->find(name);
+      if (found != scope->end())
+        return found->second;
+    }
+    return SymbolTable::NONE;
+  }
+};
+
+// Opens `depth` nested scopes declaring a few names each, some of them shadowing outer ones,
+// looks up names of every level from the innermost scope, and unwinds.
+template <typename Table> static std::uint64_t nested(int depth)
+{
+  Table table;
+  std::uint64_t sum = 0;
+
+  for (int level = 0; level < depth; level++) {
+    table.enter();
+    for (std::uint32_t i = 0; i < 4; i++)
+      table.declare((std::uint32_t)level * 3 + i, (std::uint32_t)level);
+  }
+  for (std::uint32_t name = 0; name < (std::uint32_t)depth * 3; name += 7)
+    sum += table.find(name);
+  for (int level = 0; level < depth; level++)
+    table.leave();
+
+  return sum;
+}
+
+// Declares `count` names in a single scope and looks each of them up twice.
+template <typename Table> static std::uint64_t flat(std::uint32_t count)
+{
+  Table table;
+  std::uint64_t sum = 0;
+
+  table.enter();
+  for (std::uint32_t name = 0; name < count; name++)
+    table.declare(name, name);
+  for (int round = 0; round < 2; round++) {
+    for (std::uint32_t name = 0; name < count; name++)
+      sum += table.find(name);
+  }
+  table.leave();
+
+  return sum;
+}
+
+TEST_CASE("Symbol table", "[symbols][!benchmark]")
+{
+  BENCHMARK("Nested scopes, flat table (2000 levels)") { return nested<SymbolTable>(2000); };
+
+  BENCHMARK("Nested scopes, map per scope (2000 levels)") { return nested<ScopeMaps>(2000); };
+
+  BENCHMARK("Flat namespace, flat table (1M names)") { return flat<SymbolTable>(1 << 20); };
+
+  BENCHMARK("Flat namespace, map per scope (1M names)") { return flat<ScopeMaps>(1 << 20); };
+}
@@ -0,0 +1,50 @@
+#include "value/value.hpp"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+TEST_CASE("Value operations", "[value][!benchmark]")
+{
+  std::vector<Value> ints, floats, mixed;
+  for (int i = 0; i < 1000000; i++) {
+    ints.push_back(Value::from_int(i * 7 - 3500000));
+    floats.push_back(Value::from_float(i * 0.25));
+    mixed.push_back(i % 2 ? Value::from_int(i) : Value::from_float(i * 0.5));
+  }
+
+  BENCHMARK("Integer sum (1M values)")
+  {
+    Value sum = Value::from_int(0);
+    for (Value value : ints)
+      sum = Value::int_add(sum, value);
+    return sum.as_int();
+  };
+
+  BENCHMARK("Floating-point sum (1M values)")
+  {
+    Value sum = Value::from_float(0.0);
+    for (Value value : floats)
+      sum = Value::from_float(sum.as_float() + value.as_float());
+    return sum.as_float();
+  };
+
+  BENCHMARK("Type dispatch (1M values)")
+  {
+    Value sum = Value::from_int(0);
+    for (Value value : mixed) {
+      if (Value::both_int(sum, value))
+        sum = Value::int_add(sum, value);
+      else
+        sum = Value::from_float(sum.as_float() + value.as_float());
+    }
+    return sum.as_float();
+  };
+
+  BENCHMARK("Truthiness (1M values)")
+  {
+    int count = 0;
+    for (Value value : mixed)
+      count += value.truthy();
+    return count;
+  };
+}
@@ -0,0 +1,67 @@
+#include "compiler/compiler.hpp"
+#include "folder/folder.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include "vm/vm.hpp"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+static Bytecode compile(const char *input)
+{
+  SourceManager sources;
+  Lexer lexer(sources, sources.add("bench.tl", input));
+  Parser parser(lexer.tokenize());
+  Ast ast = parser.parse();
+
+  Folder folder(ast);
+  folder.fold();
+
+  Compiler compiler(ast);
+  return compiler.compile();
+}
+
+TEST_CASE("Interpreter dispatch", "[vm][!benchmark]")
+{
+  Bytecode loop = compile("fn main() { let i = 0; while (i < 1000000) i++; return i; }");
+
+  Bytecode arithmetic = compile("fn main() {"
+                                "  let i = 0; let x = 0;"
+                                "  while (i < 1000000) { x = (x + i * 3 - 1) % 1000; i += 1; }"
+                                "  return x;"
+                                "}");
+
+  Bytecode bitwise = compile("fn main() {"
+                             "  let i = 0; let x = 0;"
+                             "  while (i < 1000000) { x ^= i & 0xff | ~x; i++; }"
+                             "  return x;"
+                             "}");
+
+  Bytecode logical = compile("fn main() {"
+                             "  let i = 0; let n = 0;"
+                             "  while (i < 1000000) { if (i % 3 == 0 && i % 5 != 0 || !i) n++; i++; }"
+                             "  return n;"
+                             "}");
+
+  Bytecode calls = compile("fn fib(n: int): int { return n < 2 ? n : fib(n - 1) + fib(n - 2); }"
+                           "fn main() { return fib(25); }");
+
+  Bytecode floats = compile("fn main() {"
+                            "  let i = 0; let x = 0.0;"
+                            "  while (i < 1000000) { x = x * 0.5 + 1.5; i++; }"
+                            "  return i;"
+                            "}");
+
+  Vm vm_loop(loop);
+  Vm vm_arithmetic(arithmetic);
+  Vm vm_bitwise(bitwise);
+  Vm vm_logical(logical);
+  Vm vm_calls(calls);
+  Vm vm_floats(floats);
+
+  BENCHMARK("Counting loop (1M iterations)") { return vm_loop.run().as_int(); };
+  BENCHMARK("Integer arithmetic (1M iterations)") { return vm_arithmetic.run().as_int(); };
+  BENCHMARK("Bitwise operators (1M iterations)") { return vm_bitwise.run().as_int(); };
+  BENCHMARK("Logical operators (1M iterations)") { return vm_logical.run().as_int(); };
+  BENCHMARK("Recursive calls (fib 25)") { return vm_calls.run().as_int(); };
+  BENCHMARK("Floating-point arithmetic (1M iterations)") { return vm_floats.run().as_int(); };
+}
@@ -0,0 +1,185 @@
+#include "ast.hpp"
+
+Ast::Ast(std::vector<Token> tokens)
+{
+  this->tokens = std::move(tokens);
+
+  this->kinds.reserve(this->tokens.size() + 1);
+  this->main_tokens.reserve(this->tokens.size() + 1);
+  this->data.reserve(this->tokens.size() + 1);
+  this->extra.reserve(this->tokens.size() / 2 + 1);
+}
+
+std::uint32_t Ast::add_node(Kind kind, std::uint32_t token, std::uint32_t lhs, std::uint32_t rhs)
+{
+  this->kinds.push_back(kind);
+  this->main_tokens.push_back(token);
+  this->data.push_back({ lhs, rhs });
+
+  return (std::uint32_t)this->kinds.size() - 1;
+}
+
+std::uint32_t Ast::add_extra(std::uint32_t a, std::uint32_t b)
+{
+  this->extra.push_back(a);
+  this->extra.push_back(b);
+
+  return (std::uint32_t)this->extra.size() - 2;
+}
+
+std::uint32_t Ast::add_list(const std::uint32_t *items, std::uint32_t count)
+{
+  std::uint32_t list = (std::uint32_t)this->extra.size();
+
+  this->extra.push_back(count);
+  this->extra.insert(this->extra.end(), items, items + count);
+
+  return list;
+}
+
+std::uint32_t Ast::size() const { return (std::uint32_t)this->kinds.size(); }
+
+Ast::Kind Ast::kind(std::uint32_t node) const { return this->kinds[node]; }
+
+Token &Ast::token(std::uint32_t node) { return this->tokens[this->main_tokens[node]]; }
+
+std::uint32_t Ast::lhs(std::uint32_t node) const { return this->data[node].lhs; }
+
+std::uint32_t Ast::rhs(std::uint32_t node) const { return this->data[node].rhs; }
+
+std::uint32_t Ast::list_size(std::uint32_t list) const { return this->extra[list]; }
+
+const std::uint32_t *Ast::list_items(std::uint32_t list) const
+{
+  return this->extra.data() + list + 1;
+}
+
+std::string Ast::dump(std::uint32_t node)
+{
+  std::string out;
+
+  auto dump_list = [&](const char *head, std::uint32_t list) {
+    out += "(";
+    out += head;
+    for (std::uint32_t i = 0; i < this->list_size(list); i++) {
+      if (i > 0 || *head != '\0')
+        out += " ";
+      out += this->dump(this->list_items(list)[i]);
+    }
+    out += ")";
+  };
+
+  switch (this->kind(node)) {
+  case Kind::N_PROGRAM:
+    dump_list("program", this->lhs(node));
+    break;
+
+  case Kind::N_IMPORT:
+    out += "(import " + this->token(node).value + ")";
+    break;
+
+  case Kind::N_FN:
+    out += "(fn ";
+    out += this->token(node).value;
+    out += " ";
+    dump_list("", this->extra[this->lhs(node)]);
+    if (this->extra[this->lhs(node) + 1] != NONE)
+      out += " " + this->dump(this->extra[this->lhs(node) + 1]);
+    out += " " + this->dump(this->rhs(node)) + ")";
+    break;
+
+  case Kind::N_PARAM:
+    out += "(" + this->token(node).value + " " + this->dump(this->lhs(node)) + ")";
+    break;
+
+  case Kind::N_VARIADIC:
+    out += "...";
+    break;
+
+  case Kind::N_TYPE:
+  case Kind::N_NUMBER:
+  case Kind::N_ID:
+    out += this->token(node).value;
+    break;
+
+  case Kind::N_CHAR:
+    out += "'" + this->token(node).value + "'";
+    break;
+
+  case Kind::N_STRING:
+    out += "\"" + this->token(node).value + "\"";
+    break;
+
+  case Kind::N_BLOCK:
+    dump_list("block", this->lhs(node));
+    break;
+
+  case Kind::N_LET:
+    out += "(let " + this->token(node).value;
+    if (this->lhs(node) != NONE)
+      out += " " + this->dump(this->lhs(node));
+    if (this->rhs(node) != NONE)
+      out += " " + this->dump(this->rhs(node));
+    out += ")";
+    break;
+
+  case Kind::N_IF:
+    out += "(if " + this->dump(this->lhs(node)) + " " + this->dump(this->extra[this->rhs(node)]);
+    if (this->extra[this->rhs(node) + 1] != NONE)
+      out += " " + this->dump(this->extra[this->rhs(node) + 1]);
+    out += ")";
+    break;
+
+  case Kind::N_WHILE:
+    out += "(while " + this->dump(this->lhs(node)) + " " + this->dump(this->rhs(node)) + ")";
+    break;
+
+  case Kind::N_RETURN:
+    out += "(return";
+    if (this->lhs(node) != NONE)
+      out += " " + this->dump(this->lhs(node));
+    out += ")";
+    break;
+
+  case Kind::N_EXPR:
+    out += this->dump(this->lhs(node));
+    break;
+
+  case Kind::N_UNARY:
+    out += std::string("(") + this->token(node).str() + " " + this->dump(this->lhs(node)) + ")";
+    break;
+
+  case Kind::N_POSTFIX:
+    out += "(" + this->dump(this->lhs(node)) + " " + this->token(node).str() + ")";
+    break;
+
+  case Kind::N_BINARY:
+  case Kind::N_ASSIGN:
+    out += std::string("(") + this->token(node).str() + " " + this->dump(this->lhs(node)) + " "
+         + this->dump(this->rhs(node)) + ")";
+    break;
+
+  case Kind::N_TERNARY:
+    out += "(? " + this->dump(this->lhs(node)) + " " + this->dump(this->extra[this->rhs(node)])
+         + " " + this->dump(this->extra[this->rhs(node) + 1]) + ")";
+    break;
+
+  case Kind::N_CALL:
+    out += "(call " + this->dump(this->lhs(node));
+    for (std::uint32_t i = 0; i < this->list_size(this->rhs(node)); i++)
+      out += " " + this->dump(this->list_items(this->rhs(node))[i]);
+    out += ")";
+    break;
+
+  case Kind::N_INDEX:
+    out += "([] " + this->dump(this->lhs(node)) + " " + this->dump(this->rhs(node)) + ")";
+    break;
+
+  case Kind::N_MEMBER:
+    out += "(. " + this->dump(this->lhs(node)) + " "
+         + this->tokens[this->main_tokens[node] + 1].value + ")";
+    break;
+  }
+
+  return out;
+}
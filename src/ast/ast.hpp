@@ -0,0 +1,82 @@
+#ifndef AST_HPP
+#define AST_HPP
+
+#include "token/token.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Nodes live in parallel arrays and refer to each other by 32-bit index. Node 0 is always the
+// program root, so index 0 doubles as "no node" for optional children. Every other node is
+// created after its children, so passes can visit the tree bottom-up by walking the arrays in
+// order. Variable-length child lists are stored in `extra` as a count followed by the node
+// indices.
+class Ast {
+  public:
+  enum class Kind : std::uint8_t {
+    N_PROGRAM,  // lhs: list of declarations
+    N_IMPORT,   // token: module name
+    N_FN,       // token: name, lhs: extra -> [params list, return type], rhs: body
+    N_PARAM,    // token: name, lhs: type
+    N_VARIADIC, // token: ...
+    N_TYPE,     // token: type name
+
+    N_BLOCK,    // lhs: list of statements
+    N_LET,      // token: name, lhs: type, rhs: initializer
+    N_IF,       // lhs: condition, rhs: extra -> [then, else]
+    N_WHILE,    // lhs: condition, rhs: body
+    N_RETURN,   // lhs: value
+    N_EXPR,     // lhs: expression
+
+    N_NUMBER,   // token: literal
+    N_CHAR,     // token: literal
+    N_STRING,   // token: literal
+    N_ID,       // token: name
+
+    N_UNARY,    // token: operator, lhs: operand
+    N_POSTFIX,  // token: operator, lhs: operand
+    N_BINARY,   // token: operator, lhs, rhs
+    N_ASSIGN,   // token: operator, lhs: target, rhs: value
+    N_TERNARY,  // lhs: condition, rhs: extra -> [then, else]
+    N_CALL,     // lhs: callee, rhs: list of arguments
+    N_INDEX,    // lhs: base, rhs: index
+    N_MEMBER,   // token: '.', followed by the member name, lhs: base
+  };
+
+  struct Data {
+    std::uint32_t lhs;
+    std::uint32_t rhs;
+  };
+
+  static const std::uint32_t NONE = 0;
+
+  std::vector<Token> tokens;
+
+  std::vector<Kind> kinds;
+  std::vector<std::uint32_t> main_tokens;
+  std::vector<Data> data;
+
+  std::vector<std::uint32_t> extra;
+
+  Ast(std::vector<Token> tokens);
+
+  std::uint32_t add_node(Kind kind, std::uint32_t token, std::uint32_t lhs, std::uint32_t rhs);
+  std::uint32_t add_extra(std::uint32_t a, std::uint32_t b);
+  std::uint32_t add_list(const std::uint32_t *items, std::uint32_t count);
+
+  std::uint32_t size() const;
+
+  Kind kind(std::uint32_t node) const;
+  Token &token(std::uint32_t node);
+  std::uint32_t lhs(std::uint32_t node) const;
+  std::uint32_t rhs(std::uint32_t node) const;
+
+  std::uint32_t list_size(std::uint32_t list) const;
+  const std::uint32_t *list_items(std::uint32_t list) const;
+
+  std::string dump(std::uint32_t node = 0);
+};
+
+typedef Ast::Kind AstKind;
+
+#endif
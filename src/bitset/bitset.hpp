@@ -0,0 +1,96 @@
+#ifndef BITSET_HPP
+#define BITSET_HPP
+
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Fixed-size set of dense ids, used by the dataflow analyses over the IR.
+class Bitset {
+  std::vector<std::uint64_t> words;
+  std::uint32_t bits;
+
+  static unsigned int lowest_bit(std::uint64_t word)
+  {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (unsigned int)index;
+#else
+    return (unsigned int)__builtin_ctzll(word);
+#endif
+  }
+
+  public:
+  Bitset(std::uint32_t bits = 0) : words((bits + 63) / 64, 0), bits(bits) {}
+
+  std::uint32_t size() const { return this->bits; }
+
+  bool test(std::uint32_t bit) const { return this->words[bit / 64] >> (bit % 64) & 1; }
+  void set(std::uint32_t bit) { this->words[bit / 64] |= (std::uint64_t)1 << (bit % 64); }
+  void reset(std::uint32_t bit) { this->words[bit / 64] &= ~((std::uint64_t)1 << (bit % 64)); }
+
+  void clear()
+  {
+    for (std::uint64_t &word : this->words)
+      word = 0;
+  }
+
+  void reset_range(std::uint32_t first, std::uint32_t end)
+  {
+    for (; first < end && first % 64 != 0; first++)
+      this->reset(first);
+    for (; first + 64 <= end; first += 64)
+      this->words[first / 64] = 0;
+    for (; first < end; first++)
+      this->reset(first);
+  }
+
+  // Adds every bit of `other` and returns whether anything changed.
+  bool unite(const Bitset &other)
+  {
+    std::uint64_t changed = 0;
+
+    for (std::size_t i = 0; i < this->words.size(); i++) {
+      std::uint64_t word = this->words[i] | other.words[i];
+      changed |= word ^ this->words[i];
+      this->words[i] = word;
+    }
+
+    return changed != 0;
+  }
+
+  void subtract(const Bitset &other)
+  {
+    for (std::size_t i = 0; i < this->words.size(); i++)
+      this->words[i] &= ~other.words[i];
+  }
+
+  std::uint32_t count() const
+  {
+    std::uint32_t count = 0;
+
+    for (std::uint64_t word : this->words) {
+      for (; word != 0; word &= word - 1)
+        count++;
+    }
+
+    return count;
+  }
+
+  bool operator==(const Bitset &other) const { return this->words == other.words; }
+  bool operator!=(const Bitset &other) const { return this->words != other.words; }
+
+  template <typename F> void each(F f) const
+  {
+    for (std::size_t i = 0; i < this->words.size(); i++) {
+      for (std::uint64_t word = this->words[i]; word != 0; word &= word - 1)
+        f((std::uint32_t)(i * 64 + lowest_bit(word)));
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include "bytecode.hpp"
+#include <cstdio>
+
+const char *const Bytecode::NATIVES[] = {
+  "print",
+};
+
+const std::uint32_t Bytecode::NATIVE_COUNT = sizeof(Bytecode::NATIVES) / sizeof(const char *);
+
+// The parts of every opcode, in order, which are the opcode itself but for superinstructions.
+static const Op PARTS[][2] = {
+#define TELA_OPCODE_PARTS(name, size, effect) { Op::name, Op::name },
+  TELA_OPCODES(TELA_OPCODE_PARTS)
+#undef TELA_OPCODE_PARTS
+#define TELA_SUPERINSTRUCTION_PARTS(name, first, second) { Op::first, Op::second },
+  TELA_SUPERINSTRUCTIONS(TELA_SUPERINSTRUCTION_PARTS)
+#undef TELA_SUPERINSTRUCTION_PARTS
+};
+
+const unsigned int Bytecode::OP_COUNT      = sizeof(PARTS) / sizeof(PARTS[0]);
+const unsigned int Bytecode::BASE_OP_COUNT = (unsigned int)Op::O_HALT + 1;
+
+static_assert(sizeof(PARTS) / sizeof(PARTS[0]) <= 256, "Too many superinstructions.");
+
+const char *Bytecode::op_name(Op op)
+{
+  static const char *const names[] = {
+#define TELA_OPCODE_NAME(name, size, effect) #name,
+    TELA_OPCODES(TELA_OPCODE_NAME)
+#undef TELA_OPCODE_NAME
+#define TELA_SUPERINSTRUCTION_NAME(name, first, second) #name,
+    TELA_SUPERINSTRUCTIONS(TELA_SUPERINSTRUCTION_NAME)
+#undef TELA_SUPERINSTRUCTION_NAME
+  };
+
+  return names[(std::uint8_t)op];
+}
+
+unsigned int Bytecode::op_size(Op op)
+{
+  static const unsigned char sizes[] = {
+#define TELA_OPCODE_SIZE(name, size, effect) size,
+    TELA_OPCODES(TELA_OPCODE_SIZE)
+#undef TELA_OPCODE_SIZE
+  };
+
+  return sizes[(std::uint8_t)op_first(op)];
+}
+
+int Bytecode::op_effect(Op op)
+{
+  static const signed char effects[] = {
+#define TELA_OPCODE_EFFECT(name, size, effect) effect,
+    TELA_OPCODES(TELA_OPCODE_EFFECT)
+#undef TELA_OPCODE_EFFECT
+  };
+
+  return effects[(std::uint8_t)op_first(op)];
+}
+
+bool Bytecode::op_branches(Op op)
+{
+  switch (op_second(op)) {
+  case Op::O_JUMP:
+  case Op::O_JUMP_IF_FALSE:
+  case Op::O_AND:
+  case Op::O_OR:
+  case Op::O_CALL:
+  case Op::O_RETURN:
+  case Op::O_HALT:
+    return true;
+  default:
+    return false;
+  }
+}
+
+Op Bytecode::op_first(Op op) { return PARTS[(std::uint8_t)op][0]; }
+
+Op Bytecode::op_second(Op op) { return PARTS[(std::uint8_t)op][1]; }
+
+std::uint32_t Bytecode::emit(Op op)
+{
+  this->code.push_back((std::uint8_t)op);
+
+  return (std::uint32_t)this->code.size() - 1;
+}
+
+void Bytecode::emit_u8(std::uint8_t value) { this->code.push_back(value); }
+
+void Bytecode::emit_u16(std::uint16_t value)
+{
+  this->code.push_back((std::uint8_t)value);
+  this->code.push_back((std::uint8_t)(value >> 8));
+}
+
+void Bytecode::emit_u32(std::uint32_t value)
+{
+  for (int shift = 0; shift < 32; shift += 8)
+    this->code.push_back((std::uint8_t)(value >> shift));
+}
+
+void Bytecode::patch_u32(std::uint32_t at, std::uint32_t value)
+{
+  for (int shift = 0; shift < 32; shift += 8)
+    this->code[at++] = (std::uint8_t)(value >> shift);
+}
+
+std::uint32_t Bytecode::read_u32(std::uint32_t at) const
+{
+  return (std::uint32_t)this->code[at] | (std::uint32_t)this->code[at + 1] << 8
+       | (std::uint32_t)this->code[at + 2] << 16 | (std::uint32_t)this->code[at + 3] << 24;
+}
+
+std::uint16_t Bytecode::read_u16(std::uint32_t at) const
+{
+  return (std::uint16_t)(this->code[at] | this->code[at + 1] << 8);
+}
+
+SourceLoc Bytecode::locate(std::uint32_t pc) const
+{
+  std::uint32_t lo = 0, hi = (std::uint32_t)this->locations.size();
+  while (lo < hi) {
+    std::uint32_t mid = (lo + hi) / 2;
+    if (this->locations[mid].pc <= pc)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo == 0 ? SourceManager::NONE : this->locations[lo - 1].loc;
+}
+
+std::vector<std::uint8_t> Bytecode::fused() const
+{
+  // The superinstruction of every pair of instructions, or 0 when there is none.
+  static const std::vector<std::uint8_t> pairs = [] {
+    std::vector<std::uint8_t> pairs(BASE_OP_COUNT * BASE_OP_COUNT, 0);
+    for (unsigned int op = BASE_OP_COUNT; op < OP_COUNT; op++) {
+      unsigned int first  = (unsigned int)op_first((Op)op);
+      unsigned int second = (unsigned int)op_second((Op)op);
+      if (!op_branches((Op)first) && pairs[first * BASE_OP_COUNT + second] == 0)
+        pairs[first * BASE_OP_COUNT + second] = (std::uint8_t)op;
+    }
+    return pairs;
+  }();
+
+  std::vector<std::uint8_t> code = this->code;
+
+  for (std::uint32_t pc = 0; pc < code.size();) {
+    std::uint32_t next = pc + 1 + op_size((Op)code[pc]);
+
+    if (next < code.size() && code[pc] < BASE_OP_COUNT && code[next] < BASE_OP_COUNT
+        && pairs[code[pc] * BASE_OP_COUNT + code[next]] != 0)
+      code[pc] = pairs[code[pc] * BASE_OP_COUNT + code[next]];
+    pc = next;
+  }
+
+  return code;
+}
+
+std::string Bytecode::disassemble() const
+{
+  std::string out;
+  char line[128];
+
+  for (std::uint32_t pc = 0; pc < this->code.size();) {
+    for (auto &function : this->functions) {
+      if (function.entry == pc)
+        out += function.name + ":\n";
+    }
+
+    Op op = (Op)this->code[pc];
+    std::snprintf(line, sizeof(line), "%04u %s", pc, op_name(op));
+    out += line;
+
+    switch (op_first(op)) {
+    case Op::O_CONST: {
+      const Value &value = this->constants[this->read_u32(pc + 1)];
+      if (value.is_float())
+        std::snprintf(line, sizeof(line), " %g", value.as_float());
+      else if (value.is_char())
+        std::snprintf(line, sizeof(line), " '%c'", value.as_char());
+      else if (value.is_string()) {
+        std::string_view str = this->strings.get(value.as_string());
+        std::snprintf(line, sizeof(line), " \"%.*s\"", (int)str.size(), str.data());
+      } else
+        std::snprintf(line, sizeof(line), " %lld", (long long)value.as_int());
+      out += line;
+      break;
+    }
+    case Op::O_LOAD_LOCAL:
+    case Op::O_STORE_LOCAL:
+      std::snprintf(line, sizeof(line), " %u", this->read_u16(pc + 1));
+      out += line;
+      break;
+    case Op::O_LOAD_GLOBAL:
+    case Op::O_STORE_GLOBAL:
+      std::snprintf(line, sizeof(line), " %u", this->read_u32(pc + 1));
+      out += line;
+      break;
+    case Op::O_JUMP:
+    case Op::O_JUMP_IF_FALSE:
+    case Op::O_AND:
+    case Op::O_OR:
+      std::snprintf(line, sizeof(line), " %04u", pc + 5 + (std::int32_t)this->read_u32(pc + 1));
+      out += line;
+      break;
+    case Op::O_CALL:
+      std::snprintf(line, sizeof(line), " %s %u",
+                    this->functions[this->read_u32(pc + 1)].name.c_str(), this->code[pc + 5]);
+      out += line;
+      break;
+    case Op::O_CALL_NATIVE:
+      std::snprintf(line, sizeof(line), " %s %u", NATIVES[this->code[pc + 1]], this->code[pc + 2]);
+      out += line;
+      break;
+    default:
+      break;
+    }
+
+    out += "\n";
+    pc += 1 + op_size(op);
+  }
+
+  return out;
+}
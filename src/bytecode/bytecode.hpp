@@ -0,0 +1,138 @@
+#ifndef BYTECODE_HPP
+#define BYTECODE_HPP
+
+#include "interner/interner.hpp"
+#include "source/source.hpp"
+#include "superinstructions.hpp"
+#include "value/value.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// X(name, operand bytes, stack effect). Operands are stored little-endian right after the
+// opcode byte. The stack effects of O_CALL and O_CALL_NATIVE don't include the popped arguments.
+#define TELA_OPCODES(X)      \
+  X(O_CONST, 4, 1)           \
+  X(O_LOAD_LOCAL, 2, 1)      \
+  X(O_STORE_LOCAL, 2, 0)     \
+  X(O_LOAD_GLOBAL, 4, 1)     \
+  X(O_STORE_GLOBAL, 4, 0)    \
+  X(O_POP, 0, -1)            \
+  X(O_DUP, 0, 1)             \
+  X(O_ADD, 0, -1)            \
+  X(O_SUB, 0, -1)            \
+  X(O_MUL, 0, -1)            \
+  X(O_DIV, 0, -1)            \
+  X(O_MOD, 0, -1)            \
+  X(O_BAND, 0, -1)           \
+  X(O_BOR, 0, -1)            \
+  X(O_BXOR, 0, -1)           \
+  X(O_EQ, 0, -1)             \
+  X(O_NEQ, 0, -1)            \
+  X(O_GT, 0, -1)             \
+  X(O_LT, 0, -1)             \
+  X(O_GEQ, 0, -1)            \
+  X(O_LEQ, 0, -1)            \
+  X(O_NEG, 0, 0)             \
+  X(O_NOT, 0, 0)             \
+  X(O_BNOT, 0, 0)            \
+  X(O_BOOL, 0, 0)            \
+  X(O_INCR, 0, 0)            \
+  X(O_DECR, 0, 0)            \
+  X(O_INDEX, 0, -1)          \
+  X(O_JUMP, 4, 0)            \
+  X(O_JUMP_IF_FALSE, 4, -1)  \
+  X(O_AND, 4, -1)            \
+  X(O_OR, 4, -1)             \
+  X(O_CALL, 5, 1)            \
+  X(O_CALL_NATIVE, 2, 1)     \
+  X(O_RETURN, 0, -1)         \
+  X(O_HALT, 0, -1)
+
+// Superinstructions come from TELA_SUPERINSTRUCTIONS(X), with X(name, first, second), which
+// tela-superinstructions generates at build time from the pairs of instructions that ran most
+// often one after the other. A superinstruction takes the place of the opcode of its first part
+// and leaves the second in place, so that code keeps its layout and a jump to the second part
+// still lands on an instruction; the operands and stack effect of a superinstruction are those
+// of its first part.
+
+class Bytecode {
+  public:
+  enum class Op : std::uint8_t {
+#define TELA_OPCODE_ENUM(name, size, effect) name,
+    TELA_OPCODES(TELA_OPCODE_ENUM)
+#undef TELA_OPCODE_ENUM
+#define TELA_SUPERINSTRUCTION_ENUM(name, first, second) name,
+    TELA_SUPERINSTRUCTIONS(TELA_SUPERINSTRUCTION_ENUM)
+#undef TELA_SUPERINSTRUCTION_ENUM
+  };
+
+  enum class Native : std::uint8_t {
+    N_PRINT,
+  };
+
+  struct Function {
+    std::string name;
+    std::uint32_t entry;
+    std::uint16_t params;
+    std::uint16_t slots;
+    std::uint32_t max_stack;
+    bool variadic;
+  };
+
+  struct Location {
+    std::uint32_t pc;
+    SourceLoc loc;
+  };
+
+  // Entry of a function that is defined by an imported module.
+  static constexpr std::uint32_t EXTERN = 0xffffffff;
+
+  static const char *const NATIVES[];
+  static const std::uint32_t NATIVE_COUNT;
+
+  // The number of opcodes, and of those that are not superinstructions, which come last.
+  static const unsigned int OP_COUNT;
+  static const unsigned int BASE_OP_COUNT;
+
+  std::vector<std::uint8_t> code;
+  std::vector<Value> constants;
+  Interner strings;
+  std::vector<Function> functions;
+  std::vector<Location> locations;
+
+  std::uint32_t globals = 0;
+  std::uint32_t entry   = 0;
+  std::uint32_t max_stack = 0;
+
+  static const char *op_name(Op op);
+  static unsigned int op_size(Op op);
+  static int op_effect(Op op);
+  // Whether an instruction may go on somewhere other than the next one, which keeps it from
+  // being the first part of a superinstruction.
+  static bool op_branches(Op op);
+  // The parts of a superinstruction, which are both `op` itself for any other instruction.
+  static Op op_first(Op op);
+  static Op op_second(Op op);
+
+  std::uint32_t emit(Op op);
+  void emit_u8(std::uint8_t value);
+  void emit_u16(std::uint16_t value);
+  void emit_u32(std::uint32_t value);
+  void patch_u32(std::uint32_t at, std::uint32_t value);
+
+  std::uint32_t read_u32(std::uint32_t at) const;
+  std::uint16_t read_u16(std::uint32_t at) const;
+
+  SourceLoc locate(std::uint32_t pc) const;
+
+  // The code with every instruction that is followed by the second part of a superinstruction
+  // it is the first part of turned into that superinstruction.
+  std::vector<std::uint8_t> fused() const;
+
+  std::string disassemble() const;
+};
+
+typedef Bytecode::Op Op;
+
+#endif
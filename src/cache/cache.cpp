@@ -0,0 +1,109 @@
+#include "cache.hpp"
+#include "file/file.hpp"
+#include "folder/folder.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include "pipeline/pipeline.hpp"
+#include <filesystem>
+
+ParseCache::ParseCache(SourceManager &sources, bool pipelined) : sources(sources)
+{
+  this->reused    = 0;
+  this->pipelined = pipelined;
+}
+
+std::shared_ptr<Ast> ParseCache::parse(const std::string &path)
+{
+  std::error_code error;
+  std::string key = std::filesystem::absolute(path, error).string();
+  if (error)
+    key = path;
+
+  std::unique_ptr<File> file(new File(path));
+  std::uint64_t hash = ParseCache::hash(std::string_view(file->data(), file->size()));
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto found = this->entries.find(key);
+    if (found != this->entries.end() && found->second.ast && found->second.hash == hash) {
+      this->reused++;
+      return found->second.ast;
+    }
+  }
+
+  bool pipeline        = this->pipelined && file->size() >= PIPELINE_SIZE;
+  std::uint32_t buffer = this->sources.add(path, std::move(file));
+  Lexer lexer(this->sources, buffer);
+  std::unique_ptr<Ast> parsed;
+
+  try {
+    if (pipeline) {
+      TokenPipeline tokens(lexer);
+      Parser parser(tokens);
+      parsed.reset(new Ast(parser.parse()));
+    } else {
+      Parser parser(lexer.tokenize());
+      parsed.reset(new Ast(parser.parse()));
+    }
+
+    Folder folder(*parsed);
+    folder.fold();
+  } catch (...) {
+    this->store(key, hash, nullptr, buffer);
+    throw;
+  }
+
+  SourceManager *sources = &this->sources;
+  std::shared_ptr<Ast> ast(parsed.release(), [sources, buffer](Ast *ast) {
+    delete ast;
+    sources->release(buffer);
+  });
+
+  this->store(key, hash, ast, NONE);
+  return ast;
+}
+
+// Replaces the entry of `key`. The AST it held is freed, with its buffer, once its last holder
+// lets go of it, and the buffer of a failed parse once the error it was kept for is long reported.
+void ParseCache::store(const std::string &key, std::uint64_t hash, std::shared_ptr<Ast> ast,
+                       std::uint32_t failed)
+{
+  std::shared_ptr<Ast> superseded;
+  std::uint32_t stale = NONE;
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto inserted = this->entries.emplace(key, Entry { hash, nullptr, NONE });
+    Entry &entry  = inserted.first->second;
+    superseded    = std::move(entry.ast);
+    stale         = entry.failed;
+    entry.hash    = hash;
+    entry.ast     = std::move(ast);
+    entry.failed  = failed;
+  }
+
+  if (stale != NONE)
+    this->sources.release(stale);
+}
+
+std::uint32_t ParseCache::hits()
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  return this->reused;
+}
+
+// FNV-1a.
+std::uint64_t ParseCache::hash(std::string_view contents)
+{
+  std::uint64_t hash = 0xcbf29ce484222325;
+
+  for (char c : contents) {
+    hash ^= (unsigned char)c;
+    hash *= 0x100000001b3;
+  }
+
+  return hash;
+}
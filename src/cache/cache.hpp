@@ -0,0 +1,56 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include "ast/ast.hpp"
+#include "source/source.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Folded ASTs of the sources parsed so far, keyed by absolute path and checked against a hash of
+// the contents, so that a long-lived process only lexes and parses the files that changed. A
+// cached AST keeps the tokens, and so the names and literals, of its source, and its locations
+// keep referring to the buffer it was parsed from. That buffer is released from the SourceManager
+// once the AST is both superseded by a newer parse and no longer held by any caller.
+//
+// When pipelined, sources of at least PIPELINE_SIZE bytes are lexed on a thread of their own
+// while they are parsed, through a TokenPipeline. Smaller ones are not worth the thread.
+class ParseCache {
+  struct Entry {
+    std::uint64_t hash;
+    std::shared_ptr<Ast> ast;
+    // The buffer of the last parse when it failed, kept for the locations of its error.
+    std::uint32_t failed;
+  };
+
+  SourceManager &sources;
+  std::unordered_map<std::string, Entry> entries;
+  std::uint32_t reused;
+  bool pipelined;
+  std::mutex mutex;
+
+  public:
+  static constexpr std::size_t PIPELINE_SIZE = 256 << 10;
+
+  ParseCache(SourceManager &sources, bool pipelined = false);
+
+  // Parses and folds the source at `path`, unless an earlier call parsed the same contents from
+  // it. The AST stays valid for as long as the returned handle is held.
+  std::shared_ptr<Ast> parse(const std::string &path);
+
+  // The number of calls to parse() that were answered from the cache.
+  std::uint32_t hits();
+
+  private:
+  static constexpr std::uint32_t NONE = 0xffffffff;
+
+  void store(const std::string &key, std::uint64_t hash, std::shared_ptr<Ast> ast,
+             std::uint32_t failed);
+  static std::uint64_t hash(std::string_view contents);
+};
+
+#endif
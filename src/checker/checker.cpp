@@ -0,0 +1,564 @@
+#include "checker.hpp"
+#include "constant/constant.hpp"
+#include "scheduler/scheduler.hpp"
+#include "value/value.hpp"
+#include <algorithm>
+
+Checker::Checker(Ast &ast, TypeTable &types, unsigned int jobs, const Compiler::Exports *exports,
+                 const std::vector<Bytecode::Function> *prelude)
+    : ast(ast), types(types)
+{
+  this->exports = exports;
+  this->prelude = prelude;
+  this->jobs    = std::max(jobs, 1u);
+  this->imports = false;
+}
+
+std::vector<Checker::Diagnostic> Checker::check()
+{
+  std::uint32_t decls       = this->ast.lhs(0);
+  const std::uint32_t *item = this->ast.list_items(decls);
+  std::uint32_t count       = this->ast.list_size(decls);
+
+  std::vector<Diagnostic> diagnostics = this->check_declarations();
+
+  // The nodes of a declaration are added right before the declaration itself, so the distance
+  // between two of them is the size of the second.
+  std::vector<std::uint32_t> functions;
+  std::vector<std::uint32_t> sizes;
+  std::uint64_t total = 0;
+
+  for (std::uint32_t i = 0; i < count; i++) {
+    if (this->ast.kind(item[i]) == AstKind::N_FN) {
+      functions.push_back(item[i]);
+      sizes.push_back(item[i] - (i > 0 ? item[i - 1] : 0));
+      total += sizes.back();
+    }
+  }
+
+  // A few runs of functions of similar size per worker, so that one long function does not
+  // leave the others idle, without paying for a task per function.
+  std::uint32_t runs = (std::uint32_t)std::min<std::size_t>(functions.size(), this->jobs * 4);
+  std::vector<Body> bodies(runs);
+  std::uint64_t done = 0;
+  Scheduler scheduler(this->jobs);
+
+  for (std::uint32_t run = 0, first = 0, last = 0; run < runs; run++, first = last) {
+    std::uint64_t target = total * (run + 1) / runs;
+    std::uint64_t size   = 0;
+    std::size_t limit    = functions.size() - (runs - run - 1);
+
+    for (; last < limit && (last == first || run + 1 == runs || done + sizes[last] <= target);
+         last++) {
+      done += sizes[last];
+      size += sizes[last];
+    }
+
+    const std::uint32_t *items = functions.data() + first;
+    std::uint32_t n            = last - first;
+    scheduler.add("check", (double)size,
+                  [this, &bodies, run, items, n] { this->check_functions(bodies[run], items, n); });
+  }
+  scheduler.run();
+
+  for (Body &body : bodies) {
+    for (Diagnostic &diagnostic : body.diagnostics)
+      diagnostics.push_back(std::move(diagnostic));
+  }
+
+  std::stable_sort(diagnostics.begin(), diagnostics.end(),
+                   [](const Diagnostic &a, const Diagnostic &b) { return a.loc < b.loc; });
+
+  return diagnostics;
+}
+
+std::vector<Checker::Diagnostic> Checker::check_declarations()
+{
+  std::uint32_t decls       = this->ast.lhs(0);
+  const std::uint32_t *item = this->ast.list_items(decls);
+  std::uint32_t count       = this->ast.list_size(decls);
+
+  Body top;
+  top.result = TypeTable::ANY;
+
+  for (std::uint32_t i = 0; i < count; i++)
+    this->declare(top, item[i]);
+  this->declare_prelude();
+
+  // Initializers of globals run before main, with nothing but the globals in scope.
+  for (std::uint32_t i = 0; i < count; i++) {
+    if (this->ast.kind(item[i]) == AstKind::N_LET && this->ast.rhs(item[i]) != Ast::NONE) {
+      std::uint32_t value = this->ast.rhs(item[i]);
+      this->expect(top, value, this->declarations.at(item[i]), this->check_expr(top, value));
+    }
+  }
+
+  return std::move(top.diagnostics);
+}
+
+std::vector<Checker::Diagnostic> Checker::check_function(std::uint32_t node)
+{
+  Body body;
+  this->check_function(body, node);
+
+  return std::move(body.diagnostics);
+}
+
+void Checker::declare(Body &body, std::uint32_t node)
+{
+  std::string &name = this->ast.token(node).value;
+  TypeId type       = TypeTable::ANY;
+
+  if (this->ast.kind(node) == AstKind::N_IMPORT) {
+    this->import(body, node);
+    return;
+  }
+
+  if (this->ast.kind(node) == AstKind::N_LET)
+    type = this->annotation(body, this->ast.lhs(node));
+  else {
+    std::uint32_t params = this->ast.extra[this->ast.lhs(node)];
+    std::uint32_t ret    = this->ast.extra[this->ast.lhs(node) + 1];
+    std::vector<TypeId> list;
+    bool variadic = false;
+
+    for (std::uint32_t i = 0; i < this->ast.list_size(params); i++) {
+      std::uint32_t param = this->ast.list_items(params)[i];
+      if (this->ast.kind(param) == AstKind::N_VARIADIC)
+        variadic = true;
+      else
+        list.push_back(this->annotation(body, this->ast.lhs(param)));
+    }
+
+    type = this->types.function(this->annotation(body, ret), list, variadic);
+  }
+
+  this->declarations.emplace(node, type);
+
+  if (!this->globals.emplace(name, Global{ type, this->ast.kind(node) == AstKind::N_FN }).second)
+    this->error(body, node, "Redefinition of '" + name + "'.");
+}
+
+void Checker::import(Body &body, std::uint32_t node)
+{
+  std::string &name = this->ast.token(node).value;
+
+  this->imports = true;
+  if (this->exports == nullptr)
+    return;
+
+  auto module = this->exports->find(name);
+  if (module == this->exports->end()) {
+    this->error(body, node, "Unknown module: " + name);
+    return;
+  }
+
+  for (const Bytecode::Function &function : module->second) {
+    std::vector<TypeId> params(function.params, TypeTable::ANY);
+    TypeId type = this->types.function(TypeTable::ANY, params, function.variadic);
+
+    if (!this->globals.emplace(function.name, Global{ type, true }).second)
+      this->error(body, node, "Redefinition of '" + function.name + "'.");
+  }
+}
+
+// Declares the functions of the prelude that the program does not declare itself, as the compiler
+// resolves calls to them without an import.
+void Checker::declare_prelude()
+{
+  const std::vector<Bytecode::Function> *prelude = this->prelude;
+
+  if (prelude == nullptr && this->exports != nullptr) {
+    auto module = this->exports->find(Compiler::PRELUDE);
+    if (module != this->exports->end())
+      prelude = &module->second;
+  }
+  if (prelude == nullptr)
+    return;
+
+  for (const Bytecode::Function &function : *prelude) {
+    std::vector<TypeId> params(function.params, TypeTable::ANY);
+    TypeId type = this->types.function(TypeTable::ANY, params, function.variadic);
+    this->globals.emplace(function.name, Global{ type, true });
+  }
+}
+
+void Checker::check_functions(Body &body, const std::uint32_t *items, std::uint32_t count)
+{
+  for (std::uint32_t i = 0; i < count; i++)
+    this->check_function(body, items[i]);
+}
+
+void Checker::check_function(Body &body, std::uint32_t node)
+{
+  std::uint32_t params = this->ast.extra[this->ast.lhs(node)];
+  TypeId signature                   = this->declarations.at(node);
+  const std::vector<TypeId> &types = this->types.params(signature);
+
+  body.result = this->types.result(signature);
+  body.symbols.enter();
+  for (std::uint32_t i = 0; i < types.size(); i++)
+    this->declare_local(body, this->ast.list_items(params)[i], types[i]);
+
+  this->check_stmt(body, this->ast.rhs(node));
+  body.symbols.leave();
+  body.locals.clear();
+}
+
+void Checker::check_stmt(Body &body, std::uint32_t node)
+{
+  switch (this->ast.kind(node)) {
+  case AstKind::N_BLOCK: {
+    std::uint32_t list = this->ast.lhs(node);
+
+    body.symbols.enter();
+    for (std::uint32_t i = 0; i < this->ast.list_size(list); i++)
+      this->check_stmt(body, this->ast.list_items(list)[i]);
+    body.symbols.leave();
+    break;
+  }
+
+  case AstKind::N_LET: {
+    TypeId type = this->annotation(body, this->ast.lhs(node));
+
+    if (this->ast.rhs(node) != Ast::NONE)
+      this->expect(body, this->ast.rhs(node), type, this->check_expr(body, this->ast.rhs(node)));
+    this->declare_local(body, node, type);
+    break;
+  }
+
+  case AstKind::N_IF: {
+    std::uint32_t then  = this->ast.extra[this->ast.rhs(node)];
+    std::uint32_t other = this->ast.extra[this->ast.rhs(node) + 1];
+
+    this->check_expr(body, this->ast.lhs(node));
+    this->check_stmt(body, then);
+    if (other != Ast::NONE)
+      this->check_stmt(body, other);
+    break;
+  }
+
+  case AstKind::N_WHILE:
+    this->check_expr(body, this->ast.lhs(node));
+    this->check_stmt(body, this->ast.rhs(node));
+    break;
+
+  case AstKind::N_RETURN:
+    if (this->ast.lhs(node) != Ast::NONE) {
+      std::uint32_t value = this->ast.lhs(node);
+      this->expect(body, value, body.result, this->check_expr(body, value));
+    } else
+      this->expect(body, node, body.result, TypeTable::NIL);
+    break;
+
+  case AstKind::N_EXPR:
+    this->check_expr(body, this->ast.lhs(node));
+    break;
+
+  default:
+    this->check_expr(body, node);
+    break;
+  }
+}
+
+TypeId Checker::check_expr(Body &body, std::uint32_t node)
+{
+  switch (this->ast.kind(node)) {
+  case AstKind::N_NUMBER: {
+    Constant constant;
+    try {
+      constant = Constant::parse(this->ast.token(node).value);
+    } catch (Error &error) {
+      this->error(body, node, error.what());
+      return TypeTable::UNKNOWN;
+    }
+
+    if (constant.type == ConstantType::C_FLOAT)
+      return TypeTable::FLOAT;
+    if (!constant.in_range()) {
+      this->error(body, node, "Integer constant out of range: " + this->ast.token(node).value);
+      return TypeTable::UNKNOWN;
+    }
+    return TypeTable::INT;
+  }
+
+  case AstKind::N_CHAR:
+    return TypeTable::CHAR;
+
+  case AstKind::N_STRING:
+    return TypeTable::STRING;
+
+  case AstKind::N_ID:
+    return this->lookup(body, node);
+
+  case AstKind::N_UNARY:
+  case AstKind::N_POSTFIX:
+    return this->check_unary(body, node);
+
+  case AstKind::N_BINARY: {
+    TypeId lhs = this->check_expr(body, this->ast.lhs(node));
+    TypeId rhs = this->check_expr(body, this->ast.rhs(node));
+
+    if (this->ast.token(node).is_in(TokenType::T_AND | TokenType::T_OR))
+      return TypeTable::INT;
+    return this->check_binary(body, node, this->ast.token(node).type, lhs, rhs);
+  }
+
+  case AstKind::N_ASSIGN:
+    return this->check_assign(body, node);
+
+  case AstKind::N_TERNARY: {
+    this->check_expr(body, this->ast.lhs(node));
+    TypeId then  = this->check_expr(body, this->ast.extra[this->ast.rhs(node)]);
+    TypeId other = this->check_expr(body, this->ast.extra[this->ast.rhs(node) + 1]);
+
+    return then == other ? then : TypeTable::ANY;
+  }
+
+  case AstKind::N_CALL:
+    return this->check_call(body, node);
+
+  case AstKind::N_INDEX: {
+    TypeId base  = this->check_expr(body, this->ast.lhs(node));
+    TypeId index = this->check_expr(body, this->ast.rhs(node));
+
+    if (base == TypeTable::UNKNOWN || index == TypeTable::UNKNOWN)
+      return TypeTable::UNKNOWN;
+    if ((base != TypeTable::STRING && base != TypeTable::ANY)
+        || (!integral(index) && index != TypeTable::ANY)) {
+      this->error(body, node, "Invalid operands to '[]'.");
+      return TypeTable::UNKNOWN;
+    }
+    return TypeTable::CHAR;
+  }
+
+  default:
+    this->error(body, node,
+                std::string("Unsupported expression: ") + this->ast.token(node).str());
+    return TypeTable::UNKNOWN;
+  }
+}
+
+TypeId Checker::check_unary(Body &body, std::uint32_t node)
+{
+  TokenType op = this->ast.token(node).type;
+  TypeId type;
+
+  if (op == TokenType::T_INCR || op == TokenType::T_DECR) {
+    if (this->ast.kind(this->ast.lhs(node)) != AstKind::N_ID) {
+      this->error(body, node,
+                  std::string("Unsupported operand of '") + this->ast.token(node).str() + "'.");
+      return TypeTable::UNKNOWN;
+    }
+
+    type = this->lookup(body, this->ast.lhs(node));
+    if (type == TypeTable::CHAR || type == TypeTable::INT || type == TypeTable::FLOAT
+        || type == TypeTable::ANY || type == TypeTable::UNKNOWN)
+      return type;
+  } else {
+    type = this->check_expr(body, this->ast.lhs(node));
+    if (type == TypeTable::UNKNOWN)
+      return type;
+
+    switch (op) {
+    case TokenType::T_NOT:
+      return TypeTable::INT;
+    case TokenType::T_SUB:
+      if (type == TypeTable::FLOAT || type == TypeTable::ANY)
+        return type;
+      if (integral(type))
+        return TypeTable::INT;
+      break;
+    case TokenType::T_BNOT:
+      if (type == TypeTable::ANY)
+        return type;
+      if (integral(type))
+        return TypeTable::INT;
+      break;
+    default:
+      return type;
+    }
+  }
+
+  this->error(body, node,
+              std::string("Invalid operand of '") + this->ast.token(node).str() + "'.");
+  return TypeTable::UNKNOWN;
+}
+
+TypeId Checker::check_binary(Body &body, std::uint32_t node, TokenType op, TypeId lhs,
+                             TypeId rhs)
+{
+  bool comparison = (bool)(op & (TokenType::T_EQ | TokenType::T_NEQ | TokenType::T_GT
+                                 | TokenType::T_LT | TokenType::T_GEQ | TokenType::T_LEQ));
+
+  if (lhs == TypeTable::UNKNOWN || rhs == TypeTable::UNKNOWN)
+    return TypeTable::UNKNOWN;
+  if (lhs == TypeTable::ANY || rhs == TypeTable::ANY)
+    return comparison ? TypeTable::INT : TypeTable::ANY;
+
+  if ((bool)(op & (TokenType::T_ADD | TokenType::T_SUB | TokenType::T_MUL | TokenType::T_DIV
+                   | TokenType::T_ADDASSIGN | TokenType::T_SUBASSIGN | TokenType::T_MULASSIGN
+                   | TokenType::T_DIVASSIGN))) {
+    if (integral(lhs) && integral(rhs))
+      return TypeTable::INT;
+    if (numeric(lhs) && numeric(rhs))
+      return TypeTable::FLOAT;
+  } else if ((bool)(op & (TokenType::T_EQ | TokenType::T_NEQ))) {
+    if ((numeric(lhs) && numeric(rhs)) || (lhs == TypeTable::STRING && rhs == TypeTable::STRING))
+      return TypeTable::INT;
+  } else if (comparison) {
+    if (numeric(lhs) && numeric(rhs))
+      return TypeTable::INT;
+  } else if (integral(lhs) && integral(rhs))
+    return TypeTable::INT;
+
+  this->error(body, node,
+              std::string("Invalid operands to '") + this->ast.token(node).str() + "'.");
+  return TypeTable::UNKNOWN;
+}
+
+TypeId Checker::check_assign(Body &body, std::uint32_t node)
+{
+  std::uint32_t target = this->ast.lhs(node);
+  TypeId value         = this->check_expr(body, this->ast.rhs(node));
+
+  if (this->ast.kind(target) != AstKind::N_ID) {
+    this->error(body, node,
+                std::string("Unsupported assignment target for '") + this->ast.token(node).str()
+                    + "'.");
+    return TypeTable::UNKNOWN;
+  }
+
+  TypeId type = this->lookup(body, target);
+  if (this->ast.token(node).type != TokenType::T_ASSIGN)
+    value = this->check_binary(body, node, this->ast.token(node).type, type, value);
+
+  this->expect(body, this->ast.rhs(node), type, value);
+  return value;
+}
+
+TypeId Checker::check_call(Body &body, std::uint32_t node)
+{
+  std::uint32_t callee = this->ast.lhs(node);
+  std::uint32_t args   = this->ast.rhs(node);
+  std::uint32_t argc   = this->ast.list_size(args);
+
+  std::vector<TypeId> found;
+  for (std::uint32_t i = 0; i < argc; i++)
+    found.push_back(this->check_expr(body, this->ast.list_items(args)[i]));
+
+  if (this->ast.kind(callee) != AstKind::N_ID) {
+    this->error(body, node, "Only named functions can be called.");
+    return TypeTable::UNKNOWN;
+  }
+
+  std::string &name = this->ast.token(callee).value;
+  std::uint32_t id  = body.names.find(name);
+  auto global       = this->globals.find(name);
+
+  if ((id != Interner::NONE && body.symbols.find(id) != SymbolTable::NONE)
+      || (global != this->globals.end() && !global->second.function)) {
+    this->error(body, callee, "'" + name + "' is not a function.");
+    return TypeTable::UNKNOWN;
+  }
+
+  if (global != this->globals.end()) {
+    TypeId type                        = global->second.type;
+    const std::vector<TypeId> &params = this->types.params(type);
+
+    if (argc < params.size() || (argc > params.size() && !this->types.variadic(type))) {
+      this->error(body, node, "Wrong number of arguments to '" + name + "'.");
+      return this->types.result(type);
+    }
+
+    for (std::uint32_t i = 0; i < params.size(); i++)
+      this->expect(body, this->ast.list_items(args)[i], params[i], found[i]);
+    return this->types.result(type);
+  }
+
+  for (std::uint32_t native = 0; native < Bytecode::NATIVE_COUNT; native++) {
+    if (name == Bytecode::NATIVES[native])
+      return TypeTable::ANY;
+  }
+
+  if (this->imports && this->exports == nullptr)
+    return TypeTable::ANY;
+
+  this->error(body, callee, "Undefined function: " + name);
+  return TypeTable::UNKNOWN;
+}
+
+void Checker::declare_local(Body &body, std::uint32_t node, TypeId type)
+{
+  std::string &name = this->ast.token(node).value;
+  std::uint32_t id  = body.names.intern(name);
+
+  if (body.symbols.declared(id))
+    this->error(body, node, "Redefinition of '" + name + "'.");
+
+  body.symbols.declare(id, (std::uint32_t)body.locals.size());
+  body.locals.push_back(type);
+}
+
+// The type of the variable named by an N_ID node.
+TypeId Checker::lookup(Body &body, std::uint32_t node)
+{
+  std::string &name = this->ast.token(node).value;
+  std::uint32_t id  = body.names.find(name);
+
+  if (id != Interner::NONE) {
+    std::uint32_t local = body.symbols.find(id);
+    if (local != SymbolTable::NONE)
+      return body.locals[local];
+  }
+
+  auto global = this->globals.find(name);
+  if (global != this->globals.end() && !global->second.function)
+    return global->second.type;
+
+  this->error(body, node, "Undefined identifier: " + name);
+  return TypeTable::UNKNOWN;
+}
+
+// The type written by an N_TYPE node, or `any` where none was written.
+TypeId Checker::annotation(Body &body, std::uint32_t node)
+{
+  if (node == Ast::NONE)
+    return TypeTable::ANY;
+
+  TypeId type = TypeTable::primitive(this->ast.token(node).value);
+  if (type == TypeTable::NONE) {
+    this->error(body, node, "Unknown type: " + this->ast.token(node).value);
+    return TypeTable::UNKNOWN;
+  }
+
+  return type;
+}
+
+void Checker::expect(Body &body, std::uint32_t node, TypeId expected, TypeId found)
+{
+  if (!assignable(expected, found)) {
+    this->error(body, node, "Type mismatch: expected " + this->types.str(expected) + ", found "
+                                + this->types.str(found) + ".");
+  }
+}
+
+void Checker::error(Body &body, std::uint32_t node, const std::string &message)
+{
+  body.diagnostics.push_back({ this->ast.token(node).loc, message });
+}
+
+// Integers are widened to floats, and chars to either, as they are by arithmetic.
+bool Checker::assignable(TypeId to, TypeId from)
+{
+  if (to == from || to == TypeTable::ANY || to == TypeTable::UNKNOWN || from == TypeTable::ANY
+      || from == TypeTable::UNKNOWN)
+    return true;
+
+  return (to == TypeTable::INT && from == TypeTable::CHAR)
+         || (to == TypeTable::FLOAT && integral(from));
+}
+
+bool Checker::integral(TypeId type) { return type == TypeTable::INT || type == TypeTable::CHAR; }
+
+bool Checker::numeric(TypeId type) { return integral(type) || type == TypeTable::FLOAT; }
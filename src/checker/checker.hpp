@@ -0,0 +1,99 @@
+#ifndef CHECKER_HPP
+#define CHECKER_HPP
+
+#include "ast/ast.hpp"
+#include "compiler/compiler.hpp"
+#include "interner/interner.hpp"
+#include "source/source.hpp"
+#include "symbols/symbols.hpp"
+#include "types/types.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Resolves the names of a program and checks its types, reporting every error rather than the
+// first one. Variables and results without annotations are of type `any`, which is compatible
+// with every type, so annotations are only enforced where they are written.
+//
+// Top-level declarations are collected first, on the calling thread. Function bodies only read
+// them, so they are then checked in parallel, in contiguous runs of functions that each collect
+// their own diagnostics, and the diagnostics are merged back in source order.
+class Checker {
+  public:
+  struct Diagnostic {
+    SourceLoc loc;
+    std::string message;
+  };
+
+  private:
+  struct Global {
+    TypeId type;
+    bool function;
+  };
+
+  // What checking one run of function bodies needs for itself.
+  struct Body {
+    Interner names;
+    SymbolTable symbols;
+    std::vector<TypeId> locals;
+    TypeId result;
+    std::vector<Diagnostic> diagnostics;
+  };
+
+  Ast &ast;
+  TypeTable &types;
+  const Compiler::Exports *exports;
+  const std::vector<Bytecode::Function> *prelude;
+  unsigned int jobs;
+
+  std::unordered_map<std::string, Global> globals;
+  // The type of every top-level declaration by node, as the globals only keep the first
+  // declaration of a name.
+  std::unordered_map<std::uint32_t, TypeId> declarations;
+  bool imports;
+
+  public:
+  // Functions of the modules that the program imports are looked up in `exports`. Without it,
+  // calls to undeclared functions are accepted in a program with imports, since they may be
+  // defined by the imported modules. The functions of `prelude`, or else those of the module
+  // Compiler::PRELUDE in `exports`, are in scope without an import.
+  Checker(Ast &ast, TypeTable &types, unsigned int jobs = 1,
+          const Compiler::Exports *exports = nullptr,
+          const std::vector<Bytecode::Function> *prelude = nullptr);
+
+  std::vector<Diagnostic> check();
+
+  // The two halves of check(), for checking functions one at a time: the top-level declarations
+  // and the initializers of the globals, which must come first, and then the body of the
+  // function declared by `node`.
+  std::vector<Diagnostic> check_declarations();
+  std::vector<Diagnostic> check_function(std::uint32_t node);
+
+  private:
+  void declare(Body &body, std::uint32_t node);
+  void import(Body &body, std::uint32_t node);
+  void declare_prelude();
+  void check_functions(Body &body, const std::uint32_t *items, std::uint32_t count);
+  void check_function(Body &body, std::uint32_t node);
+
+  void check_stmt(Body &body, std::uint32_t node);
+  TypeId check_expr(Body &body, std::uint32_t node);
+  TypeId check_unary(Body &body, std::uint32_t node);
+  TypeId check_binary(Body &body, std::uint32_t node, TokenType op, TypeId lhs, TypeId rhs);
+  TypeId check_assign(Body &body, std::uint32_t node);
+  TypeId check_call(Body &body, std::uint32_t node);
+
+  void declare_local(Body &body, std::uint32_t node, TypeId type);
+  TypeId lookup(Body &body, std::uint32_t node);
+  TypeId annotation(Body &body, std::uint32_t node);
+  void expect(Body &body, std::uint32_t node, TypeId expected, TypeId found);
+
+  void error(Body &body, std::uint32_t node, const std::string &message);
+
+  static bool assignable(TypeId to, TypeId from);
+  static bool integral(TypeId type);
+  static bool numeric(TypeId type);
+};
+
+#endif
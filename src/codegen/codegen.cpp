@@ -0,0 +1,1166 @@
+#include "codegen.hpp"
+#include "constant/constant.hpp"
+#include <algorithm>
+#include <climits>
+
+// Allocatable registers: caller-saved ones first, then callee-saved ones for values that live
+// across calls. %rax, %rcx and %rdx are kept as scratch registers.
+static const char *const REGISTERS[] = {
+  "%rsi", "%rdi", "%r8", "%r9", "%r10", "%r11", "%rbx", "%r12", "%r13", "%r14", "%r15",
+};
+static const int REGISTER_COUNT = 11;
+static const int CALLEE_SAVED   = 6;
+
+static const char *const ARGUMENTS[] = { "%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9" };
+static const unsigned int ARGUMENT_COUNT = 6;
+
+static bool is_memory(const std::string &operand)
+{
+  return !operand.empty() && operand.back() == ')';
+}
+
+static bool is_register(const std::string &operand)
+{
+  return !operand.empty() && operand[0] == '%';
+}
+
+static std::string label(std::uint32_t label)
+{
+  return ".L" + std::to_string(label);
+}
+
+static std::string immediate(std::int64_t value)
+{
+  return "$" + std::to_string(value);
+}
+
+Codegen::Codegen(Ast &ast) : ast(ast)
+{
+  this->labels = 0;
+  this->vregs  = 0;
+  this->params = 0;
+  this->slots  = 0;
+  this->saved  = 0;
+  this->ret    = 0;
+}
+
+std::string Codegen::generate()
+{
+  std::uint32_t decls       = this->ast.lhs(0);
+  const std::uint32_t *item = this->ast.list_items(decls);
+  std::uint32_t count       = this->ast.list_size(decls);
+
+  for (std::uint32_t i = 0; i < count; i++)
+    this->declare(item[i]);
+
+  this->out = "\t.text\n";
+
+  for (std::uint32_t i = 0; i < count; i++) {
+    if (this->ast.kind(item[i]) == AstKind::N_FN) {
+      this->lower_function(item[i]);
+      this->emit_function("tela_" + this->ast.token(item[i]).value);
+    }
+  }
+
+  this->lower_entry();
+  this->out += "\t.globl main\n";
+  this->emit_function("main");
+
+  if (!this->formats.empty()) {
+    this->out += "\t.section .rodata\n";
+
+    for (std::uint32_t i = 0; i < this->formats.size(); i++) {
+      this->out += ".LC" + std::to_string(i) + ":\n\t.string \"";
+      for (char c : this->formats[i]) {
+        if (c == '"' || c == '\\') {
+          this->out += '\\';
+          this->out += c;
+        } else if (c == '\n')
+          this->out += "\\n";
+        else if (c >= 0x20 && c < 0x7f)
+          this->out += c;
+        else {
+          char octal[8];
+          std::snprintf(octal, sizeof(octal), "\\%03o", (unsigned char)c);
+          this->out += octal;
+        }
+      }
+      this->out += "\"\n";
+    }
+  }
+
+  if (!this->global_list.empty()) {
+    this->out += "\t.bss\n\t.p2align 3\n";
+    for (const std::string &global : this->global_list)
+      this->out += "tela_" + global + ":\n\t.zero 8\n";
+  }
+
+  this->out += "\t.section .note.GNU-stack,\"\",@progbits\n";
+
+  return std::move(this->out);
+}
+
+void Codegen::declare(std::uint32_t node)
+{
+  std::string &name = this->ast.token(node).value;
+
+  if (this->ast.kind(node) == AstKind::N_IMPORT)
+    this->error(node, "Imports are only supported by the bytecode compiler.");
+  if (this->functions.count(name) || this->globals.count(name))
+    this->error(node, "Redefinition of '%s'.", name.c_str());
+
+  if (this->ast.kind(node) == AstKind::N_LET) {
+    this->globals[name] = (std::uint32_t)this->global_list.size();
+    this->global_list.push_back(name);
+    return;
+  }
+
+  std::uint32_t params = this->ast.extra[this->ast.lhs(node)];
+
+  Function function;
+  function.name     = name;
+  function.params   = 0;
+  function.variadic = false;
+
+  for (std::uint32_t i = 0; i < this->ast.list_size(params); i++) {
+    if (this->ast.kind(this->ast.list_items(params)[i]) == AstKind::N_VARIADIC)
+      function.variadic = true;
+    else
+      function.params++;
+  }
+
+  this->functions[name] = (std::uint32_t)this->function_list.size();
+  this->function_list.push_back(function);
+}
+
+void Codegen::lower_function(std::uint32_t node)
+{
+  std::uint32_t params = this->ast.extra[this->ast.lhs(node)];
+
+  this->code.clear();
+  this->args.clear();
+  this->locals.clear();
+  this->scopes.clear();
+  this->vregs  = 0;
+  this->params = this->function_list[this->functions[this->ast.token(node).value]].params;
+
+  this->begin_scope();
+  for (std::uint32_t i = 0, index = 0; i < this->ast.list_size(params); i++) {
+    std::uint32_t param = this->ast.list_items(params)[i];
+    if (this->ast.kind(param) == AstKind::N_PARAM)
+      this->add(IrOp::I_PARAM, this->declare_local(param), NO_VREG, NO_VREG, index++);
+  }
+
+  this->lower_stmt(this->ast.rhs(node));
+  this->end_scope();
+
+  this->add(IrOp::I_RETURN, NO_VREG, this->add(IrOp::I_CONST, this->new_vreg()));
+}
+
+void Codegen::lower_entry()
+{
+  std::uint32_t decls       = this->ast.lhs(0);
+  const std::uint32_t *item = this->ast.list_items(decls);
+
+  this->code.clear();
+  this->args.clear();
+  this->locals.clear();
+  this->scopes.clear();
+  this->vregs  = 0;
+  this->params = 0;
+
+  for (std::uint32_t i = 0; i < this->ast.list_size(decls); i++) {
+    if (this->ast.kind(item[i]) == AstKind::N_LET && this->ast.rhs(item[i]) != Ast::NONE) {
+      std::uint32_t value  = this->lower_expr(this->ast.rhs(item[i]));
+      std::uint32_t global = this->globals[this->ast.token(item[i]).value];
+      this->add(IrOp::I_STORE_GLOBAL, NO_VREG, value, NO_VREG, global);
+    }
+  }
+
+  auto main = this->functions.find("main");
+  if (main != this->functions.end()) {
+    if (this->function_list[main->second].params != 0)
+      this->error(Ast::NONE, "Function 'main' must not take parameters.");
+
+    std::uint32_t result = this->new_vreg();
+    this->add(IrOp::I_CALL, result, (std::uint32_t)this->args.size(), 0, main->second);
+    this->add(IrOp::I_RETURN, NO_VREG, result);
+  } else
+    this->add(IrOp::I_RETURN, NO_VREG, this->add(IrOp::I_CONST, this->new_vreg()));
+}
+
+void Codegen::lower_stmt(std::uint32_t node)
+{
+  switch (this->ast.kind(node)) {
+  case AstKind::N_BLOCK: {
+    std::uint32_t list = this->ast.lhs(node);
+
+    this->begin_scope();
+    for (std::uint32_t i = 0; i < this->ast.list_size(list); i++)
+      this->lower_stmt(this->ast.list_items(list)[i]);
+    this->end_scope();
+    break;
+  }
+
+  case AstKind::N_LET: {
+    std::uint32_t value;
+    if (this->ast.rhs(node) != Ast::NONE)
+      value = this->lower_expr(this->ast.rhs(node));
+    else
+      value = this->add(IrOp::I_CONST, this->new_vreg());
+
+    this->add(IrOp::I_COPY, this->declare_local(node), value);
+    break;
+  }
+
+  case AstKind::N_IF: {
+    std::uint32_t then  = this->ast.extra[this->ast.rhs(node)];
+    std::uint32_t other = this->ast.extra[this->ast.rhs(node) + 1];
+    std::uint32_t skip_then = this->new_label();
+
+    this->add(IrOp::I_JUMP_IF_FALSE, NO_VREG, this->lower_expr(this->ast.lhs(node)), NO_VREG,
+              skip_then);
+    this->lower_stmt(then);
+
+    if (other != Ast::NONE) {
+      std::uint32_t skip_else = this->new_label();
+      this->add(IrOp::I_JUMP, NO_VREG, NO_VREG, NO_VREG, skip_else);
+      this->add(IrOp::I_LABEL, NO_VREG, NO_VREG, NO_VREG, skip_then);
+      this->lower_stmt(other);
+      this->add(IrOp::I_LABEL, NO_VREG, NO_VREG, NO_VREG, skip_else);
+    } else
+      this->add(IrOp::I_LABEL, NO_VREG, NO_VREG, NO_VREG, skip_then);
+    break;
+  }
+
+  case AstKind::N_WHILE: {
+    std::uint32_t start = this->new_label();
+    std::uint32_t exit  = this->new_label();
+
+    this->add(IrOp::I_LABEL, NO_VREG, NO_VREG, NO_VREG, start);
+    this->add(IrOp::I_JUMP_IF_FALSE, NO_VREG, this->lower_expr(this->ast.lhs(node)), NO_VREG, exit);
+    this->lower_stmt(this->ast.rhs(node));
+    this->add(IrOp::I_JUMP, NO_VREG, NO_VREG, NO_VREG, start);
+    this->add(IrOp::I_LABEL, NO_VREG, NO_VREG, NO_VREG, exit);
+    break;
+  }
+
+  case AstKind::N_RETURN: {
+    std::uint32_t value;
+    if (this->ast.lhs(node) != Ast::NONE)
+      value = this->lower_expr(this->ast.lhs(node));
+    else
+      value = this->add(IrOp::I_CONST, this->new_vreg());
+    this->add(IrOp::I_RETURN, NO_VREG, value);
+    break;
+  }
+
+  case AstKind::N_EXPR:
+    this->lower_expr(this->ast.lhs(node));
+    break;
+
+  default:
+    this->lower_expr(node);
+    break;
+  }
+}
+
+std::uint32_t Codegen::lower_expr(std::uint32_t node)
+{
+  switch (this->ast.kind(node)) {
+  case AstKind::N_NUMBER: {
+    Token &token      = this->ast.token(node);
+    Constant constant = Constant::parse(token.value, token.loc);
+
+    if (constant.type != ConstantType::C_INT)
+      this->error(node, "Floating-point values are not supported by the native backend.");
+    return this->add(IrOp::I_CONST, this->new_vreg(), NO_VREG, NO_VREG, constant.i);
+  }
+
+  case AstKind::N_CHAR:
+    return this->add(IrOp::I_CONST, this->new_vreg(), NO_VREG, NO_VREG,
+                     (unsigned char)this->ast.token(node).value[0]);
+
+  case AstKind::N_ID:
+    return this->lower_load(node);
+
+  case AstKind::N_UNARY:
+    switch (this->ast.token(node).type) {
+    case TokenType::T_INCR:
+    case TokenType::T_DECR:
+      return this->lower_incr(node, false);
+    case TokenType::T_SUB:
+      return this->add(IrOp::I_NEG, this->new_vreg(), this->lower_expr(this->ast.lhs(node)));
+    case TokenType::T_NOT:
+      return this->add(IrOp::I_NOT, this->new_vreg(), this->lower_expr(this->ast.lhs(node)));
+    case TokenType::T_BNOT:
+      return this->add(IrOp::I_BNOT, this->new_vreg(), this->lower_expr(this->ast.lhs(node)));
+    default:
+      return this->lower_expr(this->ast.lhs(node));
+    }
+
+  case AstKind::N_POSTFIX:
+    return this->lower_incr(node, true);
+
+  case AstKind::N_BINARY: {
+    if (this->ast.token(node).is_in(TokenType::T_AND | TokenType::T_OR))
+      return this->lower_logical(node);
+
+    std::uint32_t a = this->lower_expr(this->ast.lhs(node));
+    std::uint32_t b = this->lower_expr(this->ast.rhs(node));
+    return this->add(binary_op(this->ast.token(node).type), this->new_vreg(), a, b);
+  }
+
+  case AstKind::N_ASSIGN:
+    return this->lower_assign(node);
+
+  case AstKind::N_TERNARY:
+    return this->lower_ternary(node);
+
+  case AstKind::N_CALL:
+    return this->lower_call(node);
+
+  default:
+    this->error(node, "Unsupported by the native backend: %s", this->ast.token(node).str());
+  }
+}
+
+std::uint32_t Codegen::lower_assign(std::uint32_t node)
+{
+  std::uint32_t target = this->ast.lhs(node);
+  if (this->ast.kind(target) != AstKind::N_ID)
+    this->error(node, "Unsupported assignment target for '%s'.", this->ast.token(node).str());
+
+  std::uint32_t value;
+  if (this->ast.token(node).type == TokenType::T_ASSIGN)
+    value = this->lower_expr(this->ast.rhs(node));
+  else {
+    std::uint32_t current = this->lower_load(target);
+    std::uint32_t operand = this->lower_expr(this->ast.rhs(node));
+    value = this->add(binary_op(this->ast.token(node).type), this->new_vreg(), current, operand);
+  }
+
+  this->lower_store(target, value);
+  return value;
+}
+
+std::uint32_t Codegen::lower_incr(std::uint32_t node, bool postfix)
+{
+  std::uint32_t target = this->ast.lhs(node);
+  if (this->ast.kind(target) != AstKind::N_ID)
+    this->error(node, "Unsupported operand of '%s'.", this->ast.token(node).str());
+
+  IrOp op = this->ast.token(node).type == TokenType::T_INCR ? IrOp::I_ADD : IrOp::I_SUB;
+
+  std::uint32_t current = this->lower_load(target);
+  std::uint32_t one     = this->add(IrOp::I_CONST, this->new_vreg(), NO_VREG, NO_VREG, 1);
+  std::uint32_t next    = this->add(op, this->new_vreg(), current, one);
+
+  this->lower_store(target, next);
+  return postfix ? current : next;
+}
+
+std::uint32_t Codegen::lower_logical(std::uint32_t node)
+{
+  IrOp op = this->ast.token(node).type == TokenType::T_AND ? IrOp::I_JUMP_IF_FALSE
+                                                            : IrOp::I_JUMP_IF_TRUE;
+  std::uint32_t result = this->new_vreg();
+  std::uint32_t end    = this->new_label();
+
+  this->add(IrOp::I_BOOL, result, this->lower_expr(this->ast.lhs(node)));
+  this->add(op, NO_VREG, result, NO_VREG, end);
+  this->add(IrOp::I_BOOL, result, this->lower_expr(this->ast.rhs(node)));
+  this->add(IrOp::I_LABEL, NO_VREG, NO_VREG, NO_VREG, end);
+
+  return result;
+}
+
+std::uint32_t Codegen::lower_ternary(std::uint32_t node)
+{
+  std::uint32_t result    = this->new_vreg();
+  std::uint32_t skip_then = this->new_label();
+  std::uint32_t skip_else = this->new_label();
+
+  this->add(IrOp::I_JUMP_IF_FALSE, NO_VREG, this->lower_expr(this->ast.lhs(node)), NO_VREG,
+            skip_then);
+  this->add(IrOp::I_COPY, result, this->lower_expr(this->ast.extra[this->ast.rhs(node)]));
+  this->add(IrOp::I_JUMP, NO_VREG, NO_VREG, NO_VREG, skip_else);
+
+  this->add(IrOp::I_LABEL, NO_VREG, NO_VREG, NO_VREG, skip_then);
+  this->add(IrOp::I_COPY, result, this->lower_expr(this->ast.extra[this->ast.rhs(node) + 1]));
+  this->add(IrOp::I_LABEL, NO_VREG, NO_VREG, NO_VREG, skip_else);
+
+  return result;
+}
+
+std::uint32_t Codegen::lower_call(std::uint32_t node)
+{
+  std::uint32_t callee = this->ast.lhs(node);
+  std::uint32_t list   = this->ast.rhs(node);
+  std::uint32_t argc   = this->ast.list_size(list);
+
+  if (this->ast.kind(callee) != AstKind::N_ID)
+    this->error(node, "Only named functions can be called.");
+
+  std::string &name = this->ast.token(callee).value;
+  if (this->resolve_local(name) != NO_VREG || this->globals.count(name))
+    this->error(callee, "'%s' is not a function.", name.c_str());
+
+  auto function = this->functions.find(name);
+  if (function == this->functions.end()) {
+    if (name == "print")
+      return this->lower_print(node);
+    this->error(callee, "Undefined function: %s", name.c_str());
+  }
+
+  Function &target = this->function_list[function->second];
+  if (argc < target.params || (argc > target.params && !target.variadic))
+    this->error(node, "Wrong number of arguments to '%s'.", name.c_str());
+
+  std::vector<std::uint32_t> values;
+  for (std::uint32_t i = 0; i < argc; i++)
+    values.push_back(this->lower_expr(this->ast.list_items(list)[i]));
+
+  std::uint32_t items = (std::uint32_t)this->args.size();
+  this->args.insert(this->args.end(), values.begin(), values.end());
+
+  return this->add(IrOp::I_CALL, this->new_vreg(), items, argc, function->second);
+}
+
+// Arguments of print are formatted by printf: string and char literals are spliced into the
+// format string, everything else is printed as a 64-bit integer.
+std::uint32_t Codegen::lower_print(std::uint32_t node)
+{
+  std::uint32_t list = this->ast.rhs(node);
+  std::string format;
+  std::vector<std::uint32_t> values;
+
+  for (std::uint32_t i = 0; i < this->ast.list_size(list); i++) {
+    std::uint32_t arg = this->ast.list_items(list)[i];
+    if (i > 0)
+      format += ' ';
+
+    if (this->ast.kind(arg) == AstKind::N_STRING || this->ast.kind(arg) == AstKind::N_CHAR) {
+      for (char c : this->ast.token(arg).value)
+        format += c == '%' ? "%%" : std::string(1, c);
+    } else {
+      format += "%lld";
+      values.push_back(this->lower_expr(arg));
+    }
+  }
+  format += '\n';
+
+  std::uint32_t items = (std::uint32_t)this->args.size();
+  this->args.insert(this->args.end(), values.begin(), values.end());
+  this->formats.push_back(format);
+
+  return this->add(IrOp::I_PRINT, this->new_vreg(), items, (std::uint32_t)values.size(),
+                   (std::int64_t)this->formats.size() - 1);
+}
+
+std::uint32_t Codegen::lower_load(std::uint32_t node)
+{
+  std::string &name = this->ast.token(node).value;
+
+  std::uint32_t local = this->resolve_local(name);
+  if (local != NO_VREG)
+    return this->add(IrOp::I_COPY, this->new_vreg(), local);
+
+  auto global = this->globals.find(name);
+  if (global == this->globals.end())
+    this->error(node, "Undefined identifier: %s", name.c_str());
+
+  return this->add(IrOp::I_LOAD_GLOBAL, this->new_vreg(), NO_VREG, NO_VREG, global->second);
+}
+
+void Codegen::lower_store(std::uint32_t node, std::uint32_t value)
+{
+  std::string &name = this->ast.token(node).value;
+
+  std::uint32_t local = this->resolve_local(name);
+  if (local != NO_VREG) {
+    this->add(IrOp::I_COPY, local, value);
+    return;
+  }
+
+  auto global = this->globals.find(name);
+  if (global == this->globals.end())
+    this->error(node, "Undefined identifier: %s", name.c_str());
+
+  this->add(IrOp::I_STORE_GLOBAL, NO_VREG, value, NO_VREG, global->second);
+}
+
+void Codegen::begin_scope() { this->scopes.push_back((std::uint32_t)this->locals.size()); }
+
+void Codegen::end_scope()
+{
+  this->locals.resize(this->scopes.back());
+  this->scopes.pop_back();
+}
+
+std::uint32_t Codegen::declare_local(std::uint32_t node)
+{
+  std::string &name = this->ast.token(node).value;
+
+  for (std::uint32_t i = this->scopes.back(); i < this->locals.size(); i++) {
+    if (this->locals[i].name == name)
+      this->error(node, "Redefinition of '%s'.", name.c_str());
+  }
+
+  std::uint32_t vreg = this->new_vreg();
+  this->locals.push_back({ name, vreg });
+
+  return vreg;
+}
+
+std::uint32_t Codegen::resolve_local(const std::string &name)
+{
+  for (std::size_t i = this->locals.size(); i-- > 0;) {
+    if (this->locals[i].name == name)
+      return this->locals[i].vreg;
+  }
+
+  return NO_VREG;
+}
+
+std::uint32_t Codegen::new_vreg()
+{
+  return this->vregs++;
+}
+
+std::uint32_t Codegen::new_label()
+{
+  return this->labels++;
+}
+
+std::uint32_t Codegen::add(IrOp op, std::uint32_t dst, std::uint32_t a, std::uint32_t b,
+                           std::int64_t imm)
+{
+  this->code.push_back({ op, false, dst, a, b, imm });
+  return dst;
+}
+
+template <typename F> void Codegen::each_use(Instr &instr, F f)
+{
+  switch (instr.op) {
+  case IrOp::I_CONST:
+  case IrOp::I_PARAM:
+  case IrOp::I_LOAD_GLOBAL:
+  case IrOp::I_LABEL:
+  case IrOp::I_JUMP:
+  case IrOp::I_NOP:
+    break;
+  case IrOp::I_CALL:
+  case IrOp::I_PRINT:
+    for (std::uint32_t i = instr.a; i < instr.a + instr.b; i++)
+      f(this->args[i]);
+    break;
+  case IrOp::I_COPY:
+  case IrOp::I_STORE_GLOBAL:
+  case IrOp::I_NEG:
+  case IrOp::I_NOT:
+  case IrOp::I_BNOT:
+  case IrOp::I_BOOL:
+  case IrOp::I_JUMP_IF_FALSE:
+  case IrOp::I_JUMP_IF_TRUE:
+  case IrOp::I_RETURN:
+    f(instr.a);
+    break;
+  default:
+    f(instr.a);
+    if (!instr.immediate)
+      f(instr.b);
+    break;
+  }
+}
+
+void Codegen::count()
+{
+  this->uses.assign(this->vregs, 0);
+  this->defs.assign(this->vregs, 0);
+
+  for (Instr &instr : this->code) {
+    if (instr.dst != NO_VREG)
+      this->defs[instr.dst]++;
+    this->each_use(instr, [&](std::uint32_t &vreg) { this->uses[vreg]++; });
+  }
+}
+
+// Removes the copies introduced by lowering every variable read into a fresh temporary, folds
+// small constants into the instructions using them and deletes unreachable and dead pure
+// instructions.
+void Codegen::optimize()
+{
+  for (bool changed = true; changed;) {
+    changed = false;
+    this->count();
+
+    std::vector<std::uint32_t> constants(this->vregs, NO_VREG);
+    bool reachable = true;
+
+    for (std::uint32_t i = 0; i < this->code.size(); i++) {
+      Instr &instr = this->code[i];
+
+      if (instr.op == IrOp::I_LABEL)
+        reachable = true;
+      else if (!reachable) {
+        changed |= instr.op != IrOp::I_NOP;
+        instr.op = IrOp::I_NOP;
+        continue;
+      } else if (instr.op == IrOp::I_JUMP || instr.op == IrOp::I_RETURN)
+        reachable = false;
+
+      if (instr.op == IrOp::I_CONST && this->defs[instr.dst] == 1)
+        constants[instr.dst] = i;
+
+      if (instr.dst != NO_VREG && this->uses[instr.dst] == 0 && is_pure(instr.op)) {
+        instr.op = IrOp::I_NOP;
+        changed  = true;
+        continue;
+      }
+
+      if (instr.op >= IrOp::I_ADD && instr.op <= IrOp::I_LEQ && instr.op != IrOp::I_DIV
+          && instr.op != IrOp::I_MOD && !instr.immediate && constants[instr.b] != NO_VREG
+          && instr.a != instr.b) {
+        std::int64_t value = this->code[constants[instr.b]].imm;
+        if (value >= INT32_MIN && value <= INT32_MAX) {
+          instr.immediate = true;
+          instr.imm       = value;
+          changed         = true;
+          continue;
+        }
+      }
+
+      // t = ...; x = t  =>  x = ...
+      if (instr.op == IrOp::I_COPY && i > 0 && this->code[i - 1].op != IrOp::I_NOP
+          && this->code[i - 1].dst == instr.a && this->defs[instr.a] == 1
+          && this->uses[instr.a] == 1) {
+        this->code[i - 1].dst = instr.dst;
+        instr.op              = IrOp::I_NOP;
+        changed               = true;
+        continue;
+      }
+
+      // t = x; ... use t  =>  ... use x, as long as x isn't redefined in between.
+      if (instr.op == IrOp::I_COPY && this->defs[instr.dst] == 1 && this->uses[instr.dst] == 1) {
+        for (std::uint32_t j = i + 1; j < this->code.size(); j++) {
+          Instr &next = this->code[j];
+          if (next.op == IrOp::I_LABEL)
+            break;
+
+          bool found = false;
+          this->each_use(next, [&](std::uint32_t &vreg) {
+            if (vreg == instr.dst) {
+              vreg  = instr.a;
+              found = true;
+            }
+          });
+
+          if (found) {
+            instr.op = IrOp::I_NOP;
+            changed  = true;
+            break;
+          }
+          if (next.dst == instr.a || next.op == IrOp::I_JUMP || next.op == IrOp::I_JUMP_IF_FALSE
+              || next.op == IrOp::I_JUMP_IF_TRUE || next.op == IrOp::I_RETURN)
+            break;
+        }
+      }
+    }
+
+    this->code.erase(std::remove_if(this->code.begin(), this->code.end(),
+                                    [](const Instr &instr) { return instr.op == IrOp::I_NOP; }),
+                     this->code.end());
+  }
+
+  this->count();
+}
+
+// Live intervals over the linear code. Lowering keeps every variable in scope from its
+// declaration on, so a value only flows around a loop if it was defined before the loop header;
+// such intervals are stretched to the loop's back edge.
+void Codegen::compute_intervals()
+{
+  this->intervals.assign(this->vregs, { UINT32_MAX, 0, false, -1, -1 });
+
+  std::vector<std::uint32_t> positions(this->labels, 0);
+  std::vector<std::uint32_t> calls;
+
+  for (std::uint32_t i = 0; i < this->code.size(); i++) {
+    Instr &instr = this->code[i];
+
+    auto touch = [&](std::uint32_t &vreg) {
+      this->intervals[vreg].start = std::min(this->intervals[vreg].start, i);
+      this->intervals[vreg].end   = std::max(this->intervals[vreg].end, i);
+    };
+
+    if (instr.dst != NO_VREG)
+      touch(instr.dst);
+    this->each_use(instr, touch);
+
+    if (instr.op == IrOp::I_LABEL)
+      positions[instr.imm] = i;
+    if (instr.op == IrOp::I_CALL || instr.op == IrOp::I_PRINT)
+      calls.push_back(i);
+  }
+
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> loops;
+  for (std::uint32_t i = 0; i < this->code.size(); i++) {
+    IrOp op = this->code[i].op;
+    if ((op == IrOp::I_JUMP || op == IrOp::I_JUMP_IF_FALSE || op == IrOp::I_JUMP_IF_TRUE)
+        && positions[this->code[i].imm] < i)
+      loops.push_back({ positions[this->code[i].imm], i });
+  }
+
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (auto &loop : loops) {
+      for (Interval &interval : this->intervals) {
+        if (interval.start < loop.first && interval.end >= loop.first
+            && interval.end < loop.second) {
+          interval.end = loop.second;
+          changed      = true;
+        }
+      }
+    }
+  }
+
+  for (Interval &interval : this->intervals) {
+    auto call = std::upper_bound(calls.begin(), calls.end(), interval.start);
+    interval.crosses_call = call != calls.end() && *call < interval.end;
+  }
+}
+
+// Linear scan (Poletto and Sarkar): walk the intervals by start point, expire the ones that
+// ended, and when no register is free spill whichever interval ends last.
+void Codegen::allocate()
+{
+  std::vector<std::uint32_t> order;
+  for (std::uint32_t vreg = 0; vreg < this->vregs; vreg++) {
+    if (this->intervals[vreg].start != UINT32_MAX)
+      order.push_back(vreg);
+  }
+  std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+    return this->intervals[a].start < this->intervals[b].start;
+  });
+
+  std::vector<std::uint32_t> active;
+  bool used[REGISTER_COUNT] = {};
+
+  this->slots = std::min(this->params, ARGUMENT_COUNT);
+
+  for (std::uint32_t vreg : order) {
+    Interval &current = this->intervals[vreg];
+
+    for (std::size_t i = 0; i < active.size();) {
+      if (this->intervals[active[i]].end <= current.start) {
+        used[this->intervals[active[i]].reg] = false;
+        active.erase(active.begin() + (std::ptrdiff_t)i);
+      } else
+        i++;
+    }
+
+    int first = current.crosses_call ? CALLEE_SAVED : 0;
+    for (int reg = first; reg < REGISTER_COUNT; reg++) {
+      if (!used[reg]) {
+        current.reg = reg;
+        break;
+      }
+    }
+
+    if (current.reg < 0) {
+      std::size_t victim = active.size();
+      for (std::size_t i = 0; i < active.size(); i++) {
+        Interval &candidate = this->intervals[active[i]];
+        if (candidate.reg >= first
+            && (victim == active.size() || candidate.end > this->intervals[active[victim]].end))
+          victim = i;
+      }
+
+      if (victim == active.size() || this->intervals[active[victim]].end <= current.end) {
+        current.slot = (int)this->slots++;
+        continue;
+      }
+
+      Interval &spilled = this->intervals[active[victim]];
+      current.reg       = spilled.reg;
+      spilled.reg       = -1;
+      spilled.slot      = (int)this->slots++;
+      active.erase(active.begin() + (std::ptrdiff_t)victim);
+    }
+
+    used[current.reg] = true;
+    active.push_back(vreg);
+  }
+}
+
+void Codegen::emit_function(const std::string &symbol)
+{
+  this->optimize();
+  this->compute_intervals();
+  this->allocate();
+
+  std::vector<int> callee;
+  for (int reg = CALLEE_SAVED; reg < REGISTER_COUNT; reg++) {
+    for (Interval &interval : this->intervals) {
+      if (interval.reg == reg) {
+        callee.push_back(reg);
+        break;
+      }
+    }
+  }
+
+  std::uint32_t frame = this->slots * 8;
+  if ((callee.size() * 8 + frame) % 16 != 0)
+    frame += 8;
+
+  this->saved = (std::uint32_t)callee.size();
+  this->ret   = this->new_label();
+
+  this->out += "\t.p2align 4\n" + symbol + ":\n";
+  this->emit("pushq %rbp");
+  this->emit("movq %rsp, %rbp");
+  for (int reg : callee)
+    this->emit(std::string("pushq ") + REGISTERS[reg]);
+  if (frame > 0)
+    this->emit("subq " + immediate(frame) + ", %rsp");
+
+  for (std::uint32_t i = 0; i < std::min(this->params, ARGUMENT_COUNT); i++)
+    this->emit(std::string("movq ") + ARGUMENTS[i] + ", " + this->slot(i));
+
+  for (std::uint32_t i = 0; i < this->code.size(); i++) {
+    const Instr &instr = this->code[i];
+    std::string dst    = instr.dst != NO_VREG ? this->operand(instr.dst) : "";
+    std::string a      = instr.a != NO_VREG && instr.op != IrOp::I_CALL && instr.op != IrOp::I_PRINT
+                             ? this->operand(instr.a)
+                             : "";
+
+    switch (instr.op) {
+    case IrOp::I_CONST:
+      if (instr.imm >= INT32_MIN && instr.imm <= INT32_MAX)
+        this->emit("movq " + immediate(instr.imm) + ", " + dst);
+      else if (is_register(dst))
+        this->emit("movabsq " + immediate(instr.imm) + ", " + dst);
+      else {
+        this->emit("movabsq " + immediate(instr.imm) + ", %rax");
+        this->emit("movq %rax, " + dst);
+      }
+      break;
+
+    case IrOp::I_COPY:
+      this->emit_move(a, dst);
+      break;
+
+    case IrOp::I_PARAM:
+      if (instr.imm < ARGUMENT_COUNT)
+        this->emit_move(this->slot((std::uint32_t)instr.imm), dst);
+      else
+        this->emit_move(std::to_string(16 + 8 * (instr.imm - ARGUMENT_COUNT)) + "(%rbp)", dst);
+      break;
+
+    case IrOp::I_LOAD_GLOBAL:
+      this->emit_move("tela_" + this->global_list[instr.imm] + "(%rip)", dst);
+      break;
+
+    case IrOp::I_STORE_GLOBAL:
+      this->emit_move(a, "tela_" + this->global_list[instr.imm] + "(%rip)");
+      break;
+
+    case IrOp::I_ADD:
+    case IrOp::I_SUB:
+    case IrOp::I_MUL:
+    case IrOp::I_AND:
+    case IrOp::I_OR:
+    case IrOp::I_XOR: {
+      static const char *const mnemonics[] = {
+        "addq ", "subq ", "imulq ", "", "", "andq ", "orq ", "xorq ",
+      };
+      std::string mnemonic = mnemonics[(int)instr.op - (int)IrOp::I_ADD];
+      std::string b        = this->source(instr);
+
+      if (is_register(dst) && (b != dst || a == dst)) {
+        this->emit_move(a, dst);
+        this->emit(mnemonic + b + ", " + dst);
+      } else if (is_memory(dst) && a == dst && !is_memory(b) && instr.op != IrOp::I_MUL)
+        this->emit(mnemonic + b + ", " + dst);
+      else {
+        this->emit("movq " + a + ", %rax");
+        this->emit(mnemonic + b + ", %rax");
+        this->emit("movq %rax, " + dst);
+      }
+      if (instr.op == IrOp::I_ADD || instr.op == IrOp::I_SUB || instr.op == IrOp::I_MUL)
+        this->emit_wrap(dst);
+      break;
+    }
+
+    case IrOp::I_DIV:
+    case IrOp::I_MOD:
+      this->emit("movq " + a + ", %rax");
+      this->emit("cqto");
+      this->emit("idivq " + this->operand(instr.b));
+      this->emit(std::string("movq ") + (instr.op == IrOp::I_DIV ? "%rax" : "%rdx") + ", " + dst);
+      if (instr.op == IrOp::I_DIV)
+        this->emit_wrap(dst);
+      break;
+
+    case IrOp::I_EQ:
+    case IrOp::I_NEQ:
+    case IrOp::I_GT:
+    case IrOp::I_LT:
+    case IrOp::I_GEQ:
+    case IrOp::I_LEQ: {
+      static const char *const conditions[] = { "e", "ne", "g", "l", "ge", "le" };
+      static const char *const inverted[]   = { "ne", "e", "le", "ge", "l", "g" };
+      int condition = (int)instr.op - (int)IrOp::I_EQ;
+
+      this->emit_compare(instr);
+
+      // Fuse the comparison with a conditional jump consuming it.
+      if (i + 1 < this->code.size() && this->uses[instr.dst] == 1
+          && this->code[i + 1].a == instr.dst
+          && (this->code[i + 1].op == IrOp::I_JUMP_IF_FALSE
+              || this->code[i + 1].op == IrOp::I_JUMP_IF_TRUE)) {
+        bool if_false = this->code[i + 1].op == IrOp::I_JUMP_IF_FALSE;
+        this->emit(std::string("j") + (if_false ? inverted : conditions)[condition] + " "
+                   + label((std::uint32_t)this->code[i + 1].imm));
+        i++;
+        break;
+      }
+
+      this->emit(std::string("set") + conditions[condition] + " %al");
+      this->emit("movzbl %al, %eax");
+      this->emit("movq %rax, " + dst);
+      break;
+    }
+
+    case IrOp::I_NEG:
+    case IrOp::I_BNOT: {
+      std::string mnemonic = instr.op == IrOp::I_NEG ? "negq " : "notq ";
+
+      if (is_register(dst) || a == dst) {
+        this->emit_move(a, dst);
+        this->emit(mnemonic + dst);
+      } else {
+        this->emit("movq " + a + ", %rax");
+        this->emit(mnemonic + "%rax");
+        this->emit("movq %rax, " + dst);
+      }
+      if (instr.op == IrOp::I_NEG)
+        this->emit_wrap(dst);
+      break;
+    }
+
+    case IrOp::I_NOT:
+    case IrOp::I_BOOL:
+      this->emit("cmpq $0, " + a);
+      this->emit(instr.op == IrOp::I_NOT ? "sete %al" : "setne %al");
+      this->emit("movzbl %al, %eax");
+      this->emit("movq %rax, " + dst);
+      break;
+
+    case IrOp::I_LABEL:
+      this->out += label((std::uint32_t)instr.imm) + ":\n";
+      break;
+
+    case IrOp::I_JUMP:
+      this->emit("jmp " + label((std::uint32_t)instr.imm));
+      break;
+
+    case IrOp::I_JUMP_IF_FALSE:
+    case IrOp::I_JUMP_IF_TRUE:
+      this->emit("cmpq $0, " + a);
+      this->emit((instr.op == IrOp::I_JUMP_IF_FALSE ? "je " : "jne ")
+                 + label((std::uint32_t)instr.imm));
+      break;
+
+    case IrOp::I_CALL:
+      this->emit_call("tela_" + this->function_list[instr.imm].name, instr.a, instr.b, -1);
+      if (!dst.empty())
+        this->emit("movq %rax, " + dst);
+      break;
+
+    case IrOp::I_PRINT:
+      this->emit_call("printf@PLT", instr.a, instr.b, (int)instr.imm);
+      if (!dst.empty())
+        this->emit("movq $0, " + dst);
+      break;
+
+    case IrOp::I_RETURN:
+      this->emit_move(a, "%rax");
+      if (i + 1 < this->code.size())
+        this->emit("jmp " + label(this->ret));
+      break;
+
+    case IrOp::I_NOP:
+      break;
+    }
+  }
+
+  this->out += label(this->ret) + ":\n";
+  if (callee.empty())
+    this->emit("movq %rbp, %rsp");
+  else
+    this->emit("leaq " + std::to_string(-8 * (int)callee.size()) + "(%rbp), %rsp");
+  for (std::size_t i = callee.size(); i-- > 0;)
+    this->emit(std::string("popq ") + REGISTERS[callee[i]]);
+  this->emit("popq %rbp");
+  this->emit("ret");
+}
+
+std::string Codegen::operand(std::uint32_t vreg) const
+{
+  const Interval &interval = this->intervals[vreg];
+
+  if (interval.reg >= 0)
+    return REGISTERS[interval.reg];
+  return this->slot((std::uint32_t)interval.slot);
+}
+
+// Stack slots sit below the saved callee-saved registers; the first ones hold the incoming
+// register parameters.
+std::string Codegen::slot(std::uint32_t slot) const
+{
+  return std::to_string(-8 * (int)(this->saved + slot + 1)) + "(%rbp)";
+}
+
+std::string Codegen::source(const Instr &instr) const
+{
+  return instr.immediate ? immediate(instr.imm) : this->operand(instr.b);
+}
+
+void Codegen::emit_move(const std::string &src, const std::string &dst)
+{
+  if (src == dst)
+    return;
+
+  if (is_memory(src) && is_memory(dst)) {
+    this->emit("movq " + src + ", %rax");
+    this->emit("movq %rax, " + dst);
+  } else
+    this->emit("movq " + src + ", " + dst);
+}
+
+// Sign-extends an integer result from bit 47, which wraps it to the integers of the interpreter.
+void Codegen::emit_wrap(const std::string &dst)
+{
+  this->emit("shlq $16, " + dst);
+  this->emit("sarq $16, " + dst);
+}
+
+void Codegen::emit_compare(const Instr &instr)
+{
+  std::string a = this->operand(instr.a);
+  std::string b = this->source(instr);
+
+  if (is_memory(a) && is_memory(b)) {
+    this->emit("movq " + a + ", %rax");
+    a = "%rax";
+  }
+  this->emit("cmpq " + b + ", " + a);
+}
+
+// Arguments are pushed and popped into their registers so that no argument register is
+// overwritten before it has been read. The stack stays 16-byte aligned at the call.
+void Codegen::emit_call(const std::string &symbol, std::uint32_t items, std::uint32_t count,
+                        int format)
+{
+  unsigned int first     = format >= 0 ? 1 : 0;
+  unsigned int registers = std::min(count, ARGUMENT_COUNT - first);
+  unsigned int stack     = count - registers;
+  unsigned int padding   = stack % 2;
+
+  if (padding)
+    this->emit("subq $8, %rsp");
+  for (unsigned int i = count; i-- > registers;)
+    this->emit("pushq " + this->operand(this->args[items + i]));
+  for (unsigned int i = 0; i < registers; i++)
+    this->emit("pushq " + this->operand(this->args[items + i]));
+  for (unsigned int i = registers; i-- > 0;)
+    this->emit(std::string("popq ") + ARGUMENTS[first + i]);
+
+  if (format >= 0) {
+    this->emit("leaq .LC" + std::to_string(format) + "(%rip), %rdi");
+    this->emit("xorl %eax, %eax");
+  }
+
+  this->emit("call " + symbol);
+  if (stack + padding > 0)
+    this->emit("addq " + immediate(8 * (stack + padding)) + ", %rsp");
+}
+
+void Codegen::emit(const std::string &line)
+{
+  this->out += '\t';
+  this->out += line;
+  this->out += '\n';
+}
+
+bool Codegen::is_pure(IrOp op)
+{
+  switch (op) {
+  case IrOp::I_DIV:
+  case IrOp::I_MOD:
+  case IrOp::I_STORE_GLOBAL:
+  case IrOp::I_LABEL:
+  case IrOp::I_JUMP:
+  case IrOp::I_JUMP_IF_FALSE:
+  case IrOp::I_JUMP_IF_TRUE:
+  case IrOp::I_CALL:
+  case IrOp::I_PRINT:
+  case IrOp::I_RETURN:
+    return false;
+  default:
+    return true;
+  }
+}
+
+Codegen::IrOp Codegen::binary_op(TokenType type)
+{
+  switch (type) {
+  case TokenType::T_ADD:
+  case TokenType::T_ADDASSIGN:
+    return IrOp::I_ADD;
+  case TokenType::T_SUB:
+  case TokenType::T_SUBASSIGN:
+    return IrOp::I_SUB;
+  case TokenType::T_MUL:
+  case TokenType::T_MULASSIGN:
+    return IrOp::I_MUL;
+  case TokenType::T_DIV:
+  case TokenType::T_DIVASSIGN:
+    return IrOp::I_DIV;
+  case TokenType::T_MOD:
+  case TokenType::T_MODASSIGN:
+    return IrOp::I_MOD;
+  case TokenType::T_BAND:
+  case TokenType::T_ANDASSIGN:
+    return IrOp::I_AND;
+  case TokenType::T_BOR:
+  case TokenType::T_ORASSIGN:
+    return IrOp::I_OR;
+  case TokenType::T_BXOR:
+  case TokenType::T_XORASSIGN:
+    return IrOp::I_XOR;
+  case TokenType::T_EQ:
+    return IrOp::I_EQ;
+  case TokenType::T_NEQ:
+    return IrOp::I_NEQ;
+  case TokenType::T_GT:
+    return IrOp::I_GT;
+  case TokenType::T_LT:
+    return IrOp::I_LT;
+  case TokenType::T_GEQ:
+    return IrOp::I_GEQ;
+  default:
+    return IrOp::I_LEQ;
+  }
+}
+
+void Codegen::error(std::uint32_t node, const char *format, const char *arg)
+{
+  if (node == Ast::NONE)
+    throw Error(format, arg);
+
+  Token &token = this->ast.token(node);
+  throw Error(token.loc, format, arg);
+}
@@ -0,0 +1,159 @@
+#ifndef CODEGEN_HPP
+#define CODEGEN_HPP
+
+#include "ast/ast.hpp"
+#include "error/error.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Ahead-of-time backend producing x86-64 assembly (AT&T syntax, System V ABI) for the system
+// assembler. Each function is lowered to a linear IR over virtual registers, cleaned up by copy
+// forwarding and dead code elimination, and given machine registers by linear-scan allocation.
+// Values are integers held in 64-bit registers and wrapped to 48 bits after every operation that
+// can leave that range, as in the interpreter; floating-point values and strings (other than as
+// arguments to print) are rejected. Division by zero traps like in C.
+class Codegen {
+  enum class IrOp : std::uint8_t {
+    I_CONST,         // dst = imm
+    I_COPY,          // dst = a
+    I_PARAM,         // dst = parameter imm
+    I_LOAD_GLOBAL,   // dst = global imm
+    I_STORE_GLOBAL,  // global imm = a
+    I_ADD,           // dst = a op b (or a op imm if immediate)
+    I_SUB,
+    I_MUL,
+    I_DIV,
+    I_MOD,
+    I_AND,
+    I_OR,
+    I_XOR,
+    I_EQ,
+    I_NEQ,
+    I_GT,
+    I_LT,
+    I_GEQ,
+    I_LEQ,
+    I_NEG,           // dst = op a
+    I_NOT,
+    I_BNOT,
+    I_BOOL,
+    I_LABEL,         // label imm
+    I_JUMP,          // goto label imm
+    I_JUMP_IF_FALSE, // if !a goto label imm
+    I_JUMP_IF_TRUE,  // if a goto label imm
+    I_CALL,          // dst = function imm (args[a .. a + b])
+    I_PRINT,         // dst = print with format imm (args[a .. a + b])
+    I_RETURN,        // return a
+    I_NOP,
+  };
+
+  struct Instr {
+    IrOp op;
+    bool immediate;
+    std::uint32_t dst;
+    std::uint32_t a;
+    std::uint32_t b;
+    std::int64_t imm;
+  };
+
+  struct Interval {
+    std::uint32_t start;
+    std::uint32_t end;
+    bool crosses_call;
+    int reg;
+    int slot;
+  };
+
+  struct Local {
+    std::string name;
+    std::uint32_t vreg;
+  };
+
+  struct Function {
+    std::string name;
+    std::uint16_t params;
+    bool variadic;
+  };
+
+  static constexpr std::uint32_t NO_VREG = 0xffffffff;
+
+  Ast &ast;
+  std::string out;
+
+  std::unordered_map<std::string, std::uint32_t> functions;
+  std::unordered_map<std::string, std::uint32_t> globals;
+  std::vector<Function> function_list;
+  std::vector<std::string> global_list;
+  std::vector<std::string> formats;
+  std::uint32_t labels;
+
+  std::vector<Instr> code;
+  std::vector<std::uint32_t> args;
+  std::vector<Interval> intervals;
+  std::vector<std::uint32_t> uses;
+  std::vector<std::uint32_t> defs;
+  std::uint32_t vregs;
+  std::uint32_t params;
+  std::uint32_t slots;
+  std::uint32_t saved;
+  std::uint32_t ret;
+
+  std::vector<Local> locals;
+  std::vector<std::uint32_t> scopes;
+
+  public:
+  Codegen(Ast &ast);
+
+  std::string generate();
+
+  private:
+  void declare(std::uint32_t node);
+  void lower_function(std::uint32_t node);
+  void lower_entry();
+
+  void lower_stmt(std::uint32_t node);
+  std::uint32_t lower_expr(std::uint32_t node);
+  std::uint32_t lower_assign(std::uint32_t node);
+  std::uint32_t lower_incr(std::uint32_t node, bool postfix);
+  std::uint32_t lower_logical(std::uint32_t node);
+  std::uint32_t lower_ternary(std::uint32_t node);
+  std::uint32_t lower_call(std::uint32_t node);
+  std::uint32_t lower_print(std::uint32_t node);
+  std::uint32_t lower_load(std::uint32_t node);
+  void lower_store(std::uint32_t node, std::uint32_t value);
+
+  void begin_scope();
+  void end_scope();
+  std::uint32_t declare_local(std::uint32_t node);
+  std::uint32_t resolve_local(const std::string &name);
+
+  std::uint32_t new_vreg();
+  std::uint32_t new_label();
+  std::uint32_t add(IrOp op, std::uint32_t dst, std::uint32_t a = NO_VREG,
+                    std::uint32_t b = NO_VREG, std::int64_t imm = 0);
+
+  template <typename F> void each_use(Instr &instr, F f);
+  void count();
+  void optimize();
+  void compute_intervals();
+  void allocate();
+  void emit_function(const std::string &symbol);
+
+  std::string operand(std::uint32_t vreg) const;
+  std::string slot(std::uint32_t slot) const;
+  std::string source(const Instr &instr) const;
+  void emit_move(const std::string &src, const std::string &dst);
+  void emit_compare(const Instr &instr);
+  void emit_wrap(const std::string &dst);
+  void emit_call(const std::string &symbol, std::uint32_t items, std::uint32_t count, int format);
+  void emit(const std::string &line);
+
+  static bool is_pure(IrOp op);
+  static IrOp binary_op(TokenType type);
+
+  [[noreturn]] void error(std::uint32_t node, const char *format, const char *arg = "");
+};
+
+#endif
@@ -0,0 +1,646 @@
+#include "compiler.hpp"
+#include "constant/constant.hpp"
+#include <cstring>
+
+Compiler::Compiler(Ast &ast) : ast(ast)
+{
+  this->exports   = nullptr;
+  this->locals    = 0;
+  this->slots     = 0;
+  this->depth     = 0;
+  this->max_depth = 0;
+}
+
+Bytecode Compiler::compile()
+{
+  this->compile_program();
+
+  std::uint32_t main = this->lookup("main");
+  if (main != SymbolTable::NONE && (main & S_KIND) == S_FUNCTION) {
+    if (this->program.functions[main & ~S_KIND].params != 0)
+      this->error(Ast::NONE, "Function 'main' must not take parameters.");
+
+    this->emit(Op::O_CALL);
+    this->program.emit_u32(main & ~S_KIND);
+    this->program.emit_u8(0);
+  } else
+    this->emit_const(Value());
+  this->emit(Op::O_HALT);
+
+  this->program.max_stack = (std::uint32_t)this->max_depth;
+
+  return std::move(this->program);
+}
+
+// Compiles the program as a module of a larger one. The code at `entry` initializes the globals
+// and returns instead of calling main, and the functions exported by the imported modules are
+// declared with an entry of Bytecode::EXTERN, to be resolved by name when the modules are linked.
+// So are the functions of the prelude that the program calls without defining them.
+Bytecode Compiler::compile_module(const Exports &exports)
+{
+  this->exports = &exports;
+  this->compile_program();
+
+  this->emit_const(Value());
+  this->emit(Op::O_RETURN);
+
+  this->program.max_stack = (std::uint32_t)this->max_depth;
+
+  return std::move(this->program);
+}
+
+bool Compiler::uses_prelude() const { return !this->preluded.empty(); }
+
+void Compiler::compile_program()
+{
+  std::uint32_t decls       = this->ast.lhs(0);
+  const std::uint32_t *item = this->ast.list_items(decls);
+  std::uint32_t count       = this->ast.list_size(decls);
+
+  for (std::uint32_t i = 0; i < count; i++)
+    this->declare(item[i]);
+
+  for (std::uint32_t i = 0; i < count; i++) {
+    if (this->ast.kind(item[i]) == AstKind::N_FN)
+      this->compile_function(item[i]);
+  }
+
+  this->program.entry = (std::uint32_t)this->program.code.size();
+  this->depth         = 0;
+  this->max_depth     = 0;
+
+  for (std::uint32_t i = 0; i < count; i++) {
+    if (this->ast.kind(item[i]) == AstKind::N_LET && this->ast.rhs(item[i]) != Ast::NONE) {
+      this->compile_expr(this->ast.rhs(item[i]));
+      this->emit_store(item[i]);
+      this->emit(Op::O_POP);
+    }
+  }
+}
+
+void Compiler::declare(std::uint32_t node)
+{
+  std::string &name = this->ast.token(node).value;
+
+  if (this->ast.kind(node) == AstKind::N_IMPORT) {
+    this->import(node);
+    return;
+  }
+
+  if (this->ast.kind(node) == AstKind::N_LET) {
+    this->declare_global(node, name, S_GLOBAL | this->program.globals++);
+    return;
+  }
+
+  std::uint32_t params = this->ast.extra[this->ast.lhs(node)];
+
+  Bytecode::Function function;
+  function.name      = name;
+  function.entry     = 0;
+  function.params    = 0;
+  function.slots     = 0;
+  function.max_stack = 0;
+  function.variadic  = false;
+
+  for (std::uint32_t i = 0; i < this->ast.list_size(params); i++) {
+    if (this->ast.kind(this->ast.list_items(params)[i]) == AstKind::N_VARIADIC)
+      function.variadic = true;
+    else
+      function.params++;
+  }
+
+  this->declare_global(node, name, S_FUNCTION | (std::uint32_t)this->program.functions.size());
+  this->program.functions.push_back(function);
+}
+
+void Compiler::import(std::uint32_t node)
+{
+  std::string &name = this->ast.token(node).value;
+
+  if (this->exports == nullptr || this->exports->count(name) == 0)
+    this->error(node, "Unknown module: %s", name.c_str());
+
+  for (const Bytecode::Function &exported : this->exports->at(name)) {
+    Bytecode::Function function = exported;
+    function.entry              = Bytecode::EXTERN;
+    function.slots              = 0;
+    function.max_stack          = 0;
+
+    this->declare_global(node, function.name,
+                         S_FUNCTION | (std::uint32_t)this->program.functions.size());
+    this->program.functions.push_back(function);
+  }
+}
+
+void Compiler::compile_function(std::uint32_t node)
+{
+  std::uint32_t index  = this->lookup(this->ast.token(node).value) & ~S_KIND;
+  std::uint32_t params = this->ast.extra[this->ast.lhs(node)];
+
+  this->program.functions[index].entry = (std::uint32_t)this->program.code.size();
+
+  this->locals    = 0;
+  this->slots     = 0;
+  this->depth     = 0;
+  this->max_depth = 0;
+
+  this->begin_scope();
+  for (std::uint32_t i = 0; i < this->ast.list_size(params); i++) {
+    std::uint32_t param = this->ast.list_items(params)[i];
+    if (this->ast.kind(param) == AstKind::N_PARAM)
+      this->declare_local(param);
+  }
+
+  this->compile_stmt(this->ast.rhs(node));
+  this->end_scope();
+
+  this->emit_const(Value());
+  this->emit(Op::O_RETURN);
+
+  this->program.functions[index].slots     = (std::uint16_t)this->slots;
+  this->program.functions[index].max_stack = (std::uint32_t)this->max_depth;
+}
+
+void Compiler::compile_stmt(std::uint32_t node)
+{
+  switch (this->ast.kind(node)) {
+  case AstKind::N_BLOCK: {
+    std::uint32_t list = this->ast.lhs(node);
+
+    this->begin_scope();
+    for (std::uint32_t i = 0; i < this->ast.list_size(list); i++)
+      this->compile_stmt(this->ast.list_items(list)[i]);
+    this->end_scope();
+    break;
+  }
+
+  case AstKind::N_LET: {
+    if (this->ast.rhs(node) != Ast::NONE)
+      this->compile_expr(this->ast.rhs(node));
+    else
+      this->emit_const(Value());
+
+    std::uint16_t slot = this->declare_local(node);
+    this->emit(Op::O_STORE_LOCAL);
+    this->program.emit_u16(slot);
+    this->emit(Op::O_POP);
+    break;
+  }
+
+  case AstKind::N_IF: {
+    std::uint32_t then  = this->ast.extra[this->ast.rhs(node)];
+    std::uint32_t other = this->ast.extra[this->ast.rhs(node) + 1];
+
+    this->compile_expr(this->ast.lhs(node));
+    std::uint32_t skip_then = this->emit_jump(Op::O_JUMP_IF_FALSE);
+    this->compile_stmt(then);
+
+    if (other != Ast::NONE) {
+      std::uint32_t skip_else = this->emit_jump(Op::O_JUMP);
+      this->patch_jump(skip_then);
+      this->compile_stmt(other);
+      this->patch_jump(skip_else);
+    } else
+      this->patch_jump(skip_then);
+    break;
+  }
+
+  case AstKind::N_WHILE: {
+    std::uint32_t start = (std::uint32_t)this->program.code.size();
+
+    this->compile_expr(this->ast.lhs(node));
+    std::uint32_t exit = this->emit_jump(Op::O_JUMP_IF_FALSE);
+    this->compile_stmt(this->ast.rhs(node));
+    this->emit_loop(start);
+    this->patch_jump(exit);
+    break;
+  }
+
+  case AstKind::N_RETURN:
+    if (this->ast.lhs(node) != Ast::NONE)
+      this->compile_expr(this->ast.lhs(node));
+    else
+      this->emit_const(Value());
+    this->emit(Op::O_RETURN);
+    break;
+
+  case AstKind::N_EXPR:
+    this->compile_expr(this->ast.lhs(node));
+    this->emit(Op::O_POP);
+    break;
+
+  default:
+    this->compile_expr(node);
+    this->emit(Op::O_POP);
+    break;
+  }
+}
+
+void Compiler::compile_expr(std::uint32_t node)
+{
+  switch (this->ast.kind(node)) {
+  case AstKind::N_NUMBER: {
+    Token &token      = this->ast.token(node);
+    Constant constant = Constant::parse(token.value, token.loc);
+
+    if (constant.type == ConstantType::C_INT) {
+      if (!constant.in_range())
+        this->error(node, "Integer constant out of range: %s", token.value.c_str());
+      this->emit_const(Value::from_int(constant.i));
+    } else
+      this->emit_const(Value::from_float(constant.f));
+    break;
+  }
+
+  case AstKind::N_CHAR:
+    this->emit_const(Value::from_char(this->ast.token(node).value[0]));
+    break;
+
+  case AstKind::N_STRING: {
+    this->emit_const(Value::from_string(this->program.strings.intern(this->ast.token(node).value)));
+    break;
+  }
+
+  case AstKind::N_ID:
+    this->emit_load(node);
+    break;
+
+  case AstKind::N_UNARY:
+    switch (this->ast.token(node).type) {
+    case TokenType::T_INCR:
+    case TokenType::T_DECR:
+      this->compile_incr(node, false);
+      break;
+    case TokenType::T_SUB:
+      this->compile_expr(this->ast.lhs(node));
+      this->emit(Op::O_NEG, node);
+      break;
+    case TokenType::T_NOT:
+      this->compile_expr(this->ast.lhs(node));
+      this->emit(Op::O_NOT, node);
+      break;
+    case TokenType::T_BNOT:
+      this->compile_expr(this->ast.lhs(node));
+      this->emit(Op::O_BNOT, node);
+      break;
+    default:
+      this->compile_expr(this->ast.lhs(node));
+      break;
+    }
+    break;
+
+  case AstKind::N_POSTFIX:
+    this->compile_incr(node, true);
+    break;
+
+  case AstKind::N_BINARY:
+    if (this->ast.token(node).is_in(TokenType::T_AND | TokenType::T_OR)) {
+      this->compile_logical(node);
+      break;
+    }
+
+    this->compile_expr(this->ast.lhs(node));
+    this->compile_expr(this->ast.rhs(node));
+    this->emit(binary_op(this->ast.token(node).type), node);
+    break;
+
+  case AstKind::N_ASSIGN:
+    this->compile_assign(node);
+    break;
+
+  case AstKind::N_TERNARY:
+    this->compile_ternary(node);
+    break;
+
+  case AstKind::N_CALL:
+    this->compile_call(node);
+    break;
+
+  case AstKind::N_INDEX:
+    this->compile_expr(this->ast.lhs(node));
+    this->compile_expr(this->ast.rhs(node));
+    this->emit(Op::O_INDEX, node);
+    break;
+
+  default:
+    this->error(node, "Unsupported expression: %s", this->ast.token(node).str());
+  }
+}
+
+void Compiler::compile_assign(std::uint32_t node)
+{
+  std::uint32_t target = this->ast.lhs(node);
+  if (this->ast.kind(target) != AstKind::N_ID)
+    this->error(node, "Unsupported assignment target for '%s'.", this->ast.token(node).str());
+
+  if (this->ast.token(node).type == TokenType::T_ASSIGN)
+    this->compile_expr(this->ast.rhs(node));
+  else {
+    this->emit_load(target);
+    this->compile_expr(this->ast.rhs(node));
+    this->emit(binary_op(this->ast.token(node).type), node);
+  }
+
+  this->emit_store(target);
+}
+
+void Compiler::compile_incr(std::uint32_t node, bool postfix)
+{
+  std::uint32_t target = this->ast.lhs(node);
+  if (this->ast.kind(target) != AstKind::N_ID)
+    this->error(node, "Unsupported operand of '%s'.", this->ast.token(node).str());
+
+  Op op = this->ast.token(node).type == TokenType::T_INCR ? Op::O_INCR : Op::O_DECR;
+
+  this->emit_load(target);
+  if (postfix)
+    this->emit(Op::O_DUP);
+  this->emit(op, node);
+  this->emit_store(target);
+  if (postfix)
+    this->emit(Op::O_POP);
+}
+
+void Compiler::compile_logical(std::uint32_t node)
+{
+  Op op = this->ast.token(node).type == TokenType::T_AND ? Op::O_AND : Op::O_OR;
+
+  this->compile_expr(this->ast.lhs(node));
+  std::uint32_t skip = this->emit_jump(op);
+  this->compile_expr(this->ast.rhs(node));
+  this->emit(Op::O_BOOL);
+  this->patch_jump(skip);
+}
+
+void Compiler::compile_ternary(std::uint32_t node)
+{
+  this->compile_expr(this->ast.lhs(node));
+  std::uint32_t skip_then = this->emit_jump(Op::O_JUMP_IF_FALSE);
+  this->compile_expr(this->ast.extra[this->ast.rhs(node)]);
+  std::uint32_t skip_else = this->emit_jump(Op::O_JUMP);
+
+  this->patch_jump(skip_then);
+  this->depth--;
+  this->compile_expr(this->ast.extra[this->ast.rhs(node) + 1]);
+  this->patch_jump(skip_else);
+}
+
+void Compiler::compile_call(std::uint32_t node)
+{
+  std::uint32_t callee = this->ast.lhs(node);
+  std::uint32_t args   = this->ast.rhs(node);
+  std::uint32_t argc   = this->ast.list_size(args);
+
+  if (this->ast.kind(callee) != AstKind::N_ID)
+    this->error(node, "Only named functions can be called.");
+
+  std::string &name    = this->ast.token(callee).value;
+  std::uint32_t symbol = this->lookup(name);
+  if (symbol != SymbolTable::NONE && (symbol & S_KIND) != S_FUNCTION)
+    this->error(callee, "'%s' is not a function.", name.c_str());
+  if (argc > 255)
+    this->error(node, "Too many arguments.");
+
+  for (std::uint32_t i = 0; i < argc; i++)
+    this->compile_expr(this->ast.list_items(args)[i]);
+
+  if (symbol == SymbolTable::NONE) {
+    for (std::uint32_t native = 0; native < Bytecode::NATIVE_COUNT; native++) {
+      if (name == Bytecode::NATIVES[native]) {
+        this->emit(Op::O_CALL_NATIVE, node);
+        this->program.emit_u8((std::uint8_t)native);
+        this->program.emit_u8((std::uint8_t)argc);
+        this->depth -= (int)argc;
+        return;
+      }
+    }
+
+    symbol = this->lookup_prelude(name);
+    if (symbol == SymbolTable::NONE)
+      this->error(callee, "Undefined function: %s", name.c_str());
+  }
+
+  Bytecode::Function &target = this->program.functions[symbol & ~S_KIND];
+
+  if (argc < target.params || (argc > target.params && !target.variadic))
+    this->error(node, "Wrong number of arguments to '%s'.", name.c_str());
+  for (; argc > target.params; argc--)
+    this->emit(Op::O_POP);
+
+  this->emit(Op::O_CALL, node);
+  this->program.emit_u32(symbol & ~S_KIND);
+  this->program.emit_u8((std::uint8_t)argc);
+  this->depth -= (int)argc;
+}
+
+void Compiler::begin_scope()
+{
+  this->symbols.enter();
+  this->scopes.push_back(this->locals);
+}
+
+void Compiler::end_scope()
+{
+  this->symbols.leave();
+  this->locals = this->scopes.back();
+  this->scopes.pop_back();
+}
+
+std::uint16_t Compiler::declare_local(std::uint32_t node)
+{
+  std::string &name = this->ast.token(node).value;
+  std::uint32_t id  = this->names.intern(name);
+
+  if (this->symbols.declared(id))
+    this->error(node, "Redefinition of '%s'.", name.c_str());
+
+  if (this->locals >= 0xffff)
+    this->error(node, "Too many local variables.");
+
+  std::uint16_t slot = (std::uint16_t)this->locals++;
+  this->symbols.declare(id, S_LOCAL | slot);
+  if (this->locals > this->slots)
+    this->slots = this->locals;
+
+  return slot;
+}
+
+void Compiler::declare_global(std::uint32_t node, const std::string &name, std::uint32_t symbol)
+{
+  std::uint32_t id = this->names.intern(name);
+
+  if (this->symbols.find(id) != SymbolTable::NONE)
+    this->error(node, "Redefinition of '%s'.", name.c_str());
+
+  this->symbols.declare(id, symbol);
+}
+
+// The innermost symbol named `name`, or SymbolTable::NONE.
+std::uint32_t Compiler::lookup(const std::string &name) const
+{
+  std::uint32_t id = this->names.find(name);
+
+  return id != Interner::NONE ? this->symbols.find(id) : SymbolTable::NONE;
+}
+
+// Declares the function `name` of the prelude as external the first time the program calls it,
+// so that a program that calls none of them is linked without the prelude. Returns the symbol of
+// the function, or NONE.
+std::uint32_t Compiler::lookup_prelude(const std::string &name)
+{
+  auto found = this->preluded.find(name);
+  if (found != this->preluded.end())
+    return found->second;
+
+  if (this->exports == nullptr)
+    return SymbolTable::NONE;
+  auto prelude = this->exports->find(PRELUDE);
+  if (prelude == this->exports->end())
+    return SymbolTable::NONE;
+
+  for (const Bytecode::Function &exported : prelude->second) {
+    if (exported.name != name)
+      continue;
+
+    Bytecode::Function function = exported;
+    function.entry              = Bytecode::EXTERN;
+    function.slots              = 0;
+    function.max_stack          = 0;
+
+    std::uint32_t symbol = S_FUNCTION | (std::uint32_t)this->program.functions.size();
+    this->program.functions.push_back(function);
+    this->preluded[name] = symbol;
+    return symbol;
+  }
+
+  return SymbolTable::NONE;
+}
+
+void Compiler::emit(Op op, std::uint32_t node)
+{
+  if (node != Ast::NONE) {
+    Token &token = this->ast.token(node);
+    this->program.locations.push_back({ (std::uint32_t)this->program.code.size(), token.loc });
+  }
+
+  this->program.emit(op);
+
+  this->depth += Bytecode::op_effect(op);
+  if (this->depth > this->max_depth)
+    this->max_depth = this->depth;
+}
+
+void Compiler::emit_const(Value value)
+{
+  this->emit(Op::O_CONST);
+  this->program.emit_u32((std::uint32_t)this->program.constants.size());
+  this->program.constants.push_back(value);
+}
+
+void Compiler::emit_load(std::uint32_t node)
+{
+  std::string &name = this->ast.token(node).value;
+
+  std::uint32_t symbol = this->lookup(name);
+
+  if (symbol != SymbolTable::NONE && (symbol & S_KIND) == S_LOCAL) {
+    this->emit(Op::O_LOAD_LOCAL);
+    this->program.emit_u16((std::uint16_t)symbol);
+    return;
+  }
+
+  if (symbol == SymbolTable::NONE || (symbol & S_KIND) != S_GLOBAL)
+    this->error(node, "Undefined identifier: %s", name.c_str());
+
+  this->emit(Op::O_LOAD_GLOBAL);
+  this->program.emit_u32(symbol & ~S_KIND);
+}
+
+void Compiler::emit_store(std::uint32_t node)
+{
+  std::string &name = this->ast.token(node).value;
+
+  std::uint32_t symbol = this->lookup(name);
+
+  if (symbol != SymbolTable::NONE && (symbol & S_KIND) == S_LOCAL) {
+    this->emit(Op::O_STORE_LOCAL);
+    this->program.emit_u16((std::uint16_t)symbol);
+    return;
+  }
+
+  if (symbol == SymbolTable::NONE || (symbol & S_KIND) != S_GLOBAL)
+    this->error(node, "Undefined identifier: %s", name.c_str());
+
+  this->emit(Op::O_STORE_GLOBAL);
+  this->program.emit_u32(symbol & ~S_KIND);
+}
+
+std::uint32_t Compiler::emit_jump(Op op)
+{
+  this->emit(op);
+  this->program.emit_u32(0);
+
+  return (std::uint32_t)this->program.code.size() - 4;
+}
+
+void Compiler::emit_loop(std::uint32_t target)
+{
+  this->emit(Op::O_JUMP);
+  this->program.emit_u32((std::uint32_t)(target - (this->program.code.size() + 4)));
+}
+
+void Compiler::patch_jump(std::uint32_t at)
+{
+  this->program.patch_u32(at, (std::uint32_t)(this->program.code.size() - (at + 4)));
+}
+
+Op Compiler::binary_op(TokenType type)
+{
+  switch (type) {
+  case TokenType::T_ADD:
+  case TokenType::T_ADDASSIGN:
+    return Op::O_ADD;
+  case TokenType::T_SUB:
+  case TokenType::T_SUBASSIGN:
+    return Op::O_SUB;
+  case TokenType::T_MUL:
+  case TokenType::T_MULASSIGN:
+    return Op::O_MUL;
+  case TokenType::T_DIV:
+  case TokenType::T_DIVASSIGN:
+    return Op::O_DIV;
+  case TokenType::T_MOD:
+  case TokenType::T_MODASSIGN:
+    return Op::O_MOD;
+  case TokenType::T_BAND:
+  case TokenType::T_ANDASSIGN:
+    return Op::O_BAND;
+  case TokenType::T_BOR:
+  case TokenType::T_ORASSIGN:
+    return Op::O_BOR;
+  case TokenType::T_BXOR:
+  case TokenType::T_XORASSIGN:
+    return Op::O_BXOR;
+  case TokenType::T_EQ:
+    return Op::O_EQ;
+  case TokenType::T_NEQ:
+    return Op::O_NEQ;
+  case TokenType::T_GT:
+    return Op::O_GT;
+  case TokenType::T_LT:
+    return Op::O_LT;
+  case TokenType::T_GEQ:
+    return Op::O_GEQ;
+  default:
+    return Op::O_LEQ;
+  }
+}
+
+void Compiler::error(std::uint32_t node, const char *format, const char *arg)
+{
+  if (node == Ast::NONE)
+    throw Error(format, arg);
+
+  Token &token = this->ast.token(node);
+  throw Error(token.loc, format, arg);
+}
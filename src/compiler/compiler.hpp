@@ -0,0 +1,87 @@
+#ifndef COMPILER_HPP
+#define COMPILER_HPP
+
+#include "ast/ast.hpp"
+#include "bytecode/bytecode.hpp"
+#include "error/error.hpp"
+#include "interner/interner.hpp"
+#include "symbols/symbols.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Compiler {
+  public:
+  // The functions exported by each module that a program may import, by module name.
+  typedef std::unordered_map<std::string, std::vector<Bytecode::Function>> Exports;
+
+  // The module whose exports, when given, a program may call without importing it.
+  static constexpr const char *PRELUDE = "prelude";
+
+  private:
+  // Symbols bind a name to a local slot, a global or a function, told apart by the top two bits.
+  static constexpr std::uint32_t S_LOCAL    = 0u << 30;
+  static constexpr std::uint32_t S_GLOBAL   = 1u << 30;
+  static constexpr std::uint32_t S_FUNCTION = 2u << 30;
+  static constexpr std::uint32_t S_KIND     = 3u << 30;
+
+  Ast &ast;
+  Bytecode program;
+  const Exports *exports;
+
+  Interner names;
+  SymbolTable symbols;
+  std::unordered_map<std::string, std::uint32_t> preluded;
+
+  std::uint32_t locals;
+  std::vector<std::uint32_t> scopes;
+  std::uint32_t slots;
+
+  int depth;
+  int max_depth;
+
+  public:
+  Compiler(Ast &ast);
+
+  Bytecode compile();
+  Bytecode compile_module(const Exports &exports);
+
+  // Whether the module compiled by compile_module() calls functions of the prelude.
+  bool uses_prelude() const;
+
+  private:
+  void compile_program();
+  void declare(std::uint32_t node);
+  void import(std::uint32_t node);
+  void compile_function(std::uint32_t node);
+
+  void compile_stmt(std::uint32_t node);
+  void compile_expr(std::uint32_t node);
+  void compile_assign(std::uint32_t node);
+  void compile_incr(std::uint32_t node, bool postfix);
+  void compile_logical(std::uint32_t node);
+  void compile_ternary(std::uint32_t node);
+  void compile_call(std::uint32_t node);
+
+  void begin_scope();
+  void end_scope();
+  std::uint16_t declare_local(std::uint32_t node);
+  void declare_global(std::uint32_t node, const std::string &name, std::uint32_t symbol);
+  std::uint32_t lookup(const std::string &name) const;
+  std::uint32_t lookup_prelude(const std::string &name);
+
+  void emit(Op op, std::uint32_t node = Ast::NONE);
+  void emit_const(Value value);
+  void emit_load(std::uint32_t node);
+  void emit_store(std::uint32_t node);
+  std::uint32_t emit_jump(Op op);
+  void emit_loop(std::uint32_t target);
+  void patch_jump(std::uint32_t at);
+
+  static Op binary_op(TokenType type);
+
+  [[noreturn]] void error(std::uint32_t node, const char *format, const char *arg = "");
+};
+
+#endif
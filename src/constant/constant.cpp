@@ -0,0 +1,77 @@
+#include "constant.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+
+Constant::Constant()
+{
+  this->type = Type::C_INT;
+  this->i    = 0;
+}
+
+Constant::Constant(std::int64_t i)
+{
+  this->type = Type::C_INT;
+  this->i    = i;
+}
+
+Constant::Constant(double f)
+{
+  this->type = Type::C_FLOAT;
+  this->f    = f;
+}
+
+Constant Constant::parse(const std::string &literal, SourceLoc loc)
+{
+  int base = literal.compare(0, 2, "0x") == 0 ? 16 : literal.compare(0, 2, "0b") == 0 ? 2 : 10;
+
+  if (base == 10 && literal.find_first_of(".eEin") != std::string::npos)
+    return Constant(std::strtod(literal.c_str(), nullptr));
+
+  // Folded constants are written back as decimal literals, which may be negative.
+  errno = 0;
+  std::int64_t value;
+  if (base == 10)
+    value = (std::int64_t)std::strtoll(literal.c_str(), nullptr, 10);
+  else {
+    unsigned long long bits = std::strtoull(literal.c_str() + 2, nullptr, base);
+    if (bits > (unsigned long long)INT64_MAX)
+      errno = ERANGE;
+    value = (std::int64_t)bits;
+  }
+
+  if (errno == ERANGE)
+    throw Error(loc, "Integer constant out of range: %s", literal.c_str());
+
+  return Constant(value);
+}
+
+std::int64_t Constant::wrap(std::int64_t i) { return (std::int64_t)((std::uint64_t)i << 16) >> 16; }
+
+std::string Constant::str() const
+{
+  if (this->type == Type::C_INT)
+    return std::to_string(this->i);
+
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.15g", this->f);
+  if (std::strtod(buf, nullptr) != this->f)
+    std::snprintf(buf, sizeof(buf), "%.17g", this->f);
+
+  std::string out(buf);
+  if (out.find_first_of(".eEin") == std::string::npos)
+    out += ".0";
+
+  return out;
+}
+
+double Constant::as_float() const { return this->type == Type::C_INT ? (double)this->i : this->f; }
+
+bool Constant::is_zero() const { return this->type == Type::C_INT ? this->i == 0 : this->f == 0.0; }
+
+bool Constant::is_int(std::int64_t value) const
+{
+  return this->type == Type::C_INT && this->i == value;
+}
+
+bool Constant::in_range() const { return this->type == Type::C_FLOAT || wrap(this->i) == this->i; }
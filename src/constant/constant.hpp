@@ -0,0 +1,40 @@
+#ifndef CONSTANT_HPP
+#define CONSTANT_HPP
+
+#include "error/error.hpp"
+#include "source/source.hpp"
+#include <cstdint>
+#include <string>
+
+class Constant {
+  public:
+  enum class Type {
+    C_INT,
+    C_FLOAT,
+  } type;
+
+  union {
+    std::int64_t i;
+    double f;
+  };
+
+  Constant();
+  Constant(std::int64_t i);
+  Constant(double f);
+
+  // Throws an error at `loc` for an integer literal that doesn't fit in 64 bits.
+  static Constant parse(const std::string &literal, SourceLoc loc = SourceManager::NONE);
+  // Wraps an integer around to the 48 bits of integers at runtime.
+  static std::int64_t wrap(std::int64_t i);
+
+  std::string str() const;
+  double as_float() const;
+  bool is_zero() const;
+  bool is_int(std::int64_t value) const;
+  // Whether this is a float or an integer that fits in the 48 bits of integers at runtime.
+  bool in_range() const;
+};
+
+typedef Constant::Type ConstantType;
+
+#endif
@@ -28,6 +28,9 @@ const char *Error::msg_sprintf(const char *format, std::va_list args)
     format++;
   } while (*format != '\0');
 
+  out = (char *)std::realloc(out, ++length * sizeof(char));
+  out[length - 1] = '\0';
+
   return out;
 }
 
@@ -41,11 +44,9 @@ Error::Error(const char *format, ...)
   va_end(args);
 }
 
-Error::Error(const char *filename, unsigned int row, unsigned int col, const char *format, ...)
+Error::Error(SourceLoc loc, const char *format, ...)
 {
-  this->filename = filename;
-  this->row = row;
-  this->col = col;
+  this->loc = loc;
 
   std::va_list args;
   va_start(args, format);
@@ -55,6 +56,6 @@ Error::Error(const char *filename, unsigned int row, unsigned int col, const cha
   va_end(args);
 }
 
-Error::~Error() { delete this->msg; }
+Error::~Error() { std::free((void *)this->msg); }
 
 const char *Error::what() { return this->msg; }
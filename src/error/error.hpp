@@ -1,6 +1,7 @@
 #ifndef ERROR_HPP
 #define ERROR_HPP
 
+#include "source/source.hpp"
 #include <cstdarg>
 #include <cstdlib>
 #include <cstring>
@@ -11,12 +12,10 @@ class Error {
   static const char *msg_sprintf(const char *format, std::va_list args);
 
   public:
-  const char *filename = nullptr;
-  unsigned int row = 0;
-  unsigned int col = 0;
+  SourceLoc loc = SourceManager::NONE;
 
   Error(const char *format, ...);
-  Error(const char *filename, unsigned int row, unsigned int col, const char *format, ...);
+  Error(SourceLoc loc, const char *format, ...);
   ~Error();
 
   const char *what();
@@ -0,0 +1,101 @@
+#include "file.hpp"
+#include "error/error.hpp"
+#include <fstream>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TELA_MMAP 1
+#else
+#define TELA_MMAP 0
+#endif
+
+File::File(const std::string &path, std::size_t threshold)
+{
+  this->mapping = nullptr;
+  this->mapped  = 0;
+
+#if TELA_MMAP
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw Error("Cannot open file: %s", path.c_str());
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && (std::size_t)st.st_size >= threshold
+      && this->map(fd, (std::size_t)st.st_size)) {
+    close(fd);
+    return;
+  }
+  close(fd);
+#endif
+
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    throw Error("Cannot open file: %s", path.c_str());
+
+  std::stringstream input;
+  input << file.rdbuf();
+
+  this->buffer = input.str();
+  this->bytes  = this->buffer.c_str();
+  this->length = this->buffer.size();
+}
+
+File::~File()
+{
+#if TELA_MMAP
+  if (this->mapping != nullptr)
+    munmap(this->mapping, this->mapped);
+#endif
+}
+
+// Drops the mapped pages that lie entirely before `offset`. They are read back from the file if
+// touched again, so this only affects memory use.
+void File::release(std::size_t offset) const
+{
+#if TELA_MMAP
+  if (this->mapping == nullptr)
+    return;
+
+  std::size_t page = (std::size_t)sysconf(_SC_PAGESIZE);
+  std::size_t size = offset / page * page;
+  if (size > 0)
+    madvise(this->mapping, size, MADV_DONTNEED);
+#else
+  (void)offset;
+#endif
+}
+
+// Reserves one page more than the file needs and maps the file over the start of the
+// reservation. The tail of the last file page reads as zeros, and when the file ends exactly on
+// a page boundary the spare anonymous page provides the terminating zero.
+bool File::map(int fd, std::size_t size)
+{
+#if TELA_MMAP
+  std::size_t page = (std::size_t)sysconf(_SC_PAGESIZE);
+  std::size_t span = (size / page + 1) * page;
+
+  void *base = mmap(nullptr, span, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED)
+    return false;
+
+  if (mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+    munmap(base, span);
+    return false;
+  }
+  madvise(base, size, MADV_SEQUENTIAL);
+
+  this->mapping = base;
+  this->mapped  = span;
+  this->bytes   = (const char *)base;
+  this->length  = size;
+  return true;
+#else
+  (void)fd;
+  (void)size;
+  return false;
+#endif
+}
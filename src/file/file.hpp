@@ -0,0 +1,40 @@
+#ifndef FILE_HPP
+#define FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+// Read-only contents of a whole file. Regular files of at least `threshold` bytes are
+// memory-mapped where the platform allows it, so that inputs larger than memory are paged in
+// and out by the kernel; anything else is read into a buffer. In both cases the byte just past
+// the end of the contents is readable and zero.
+//
+// Pages of a mapping stay resident once touched, so sequential readers call release() behind
+// their cursor to keep the resident set bounded.
+class File {
+  std::string buffer;
+  const char *bytes;
+  std::size_t length;
+
+  void *mapping;
+  std::size_t mapped;
+
+  public:
+  static constexpr std::size_t MAP_THRESHOLD = 1 << 20;
+
+  File(const std::string &path, std::size_t threshold = MAP_THRESHOLD);
+  File(const File &) = delete;
+  File &operator=(const File &) = delete;
+  ~File();
+
+  const char *data() const { return this->bytes; }
+  std::size_t size() const { return this->length; }
+  bool is_mapped() const { return this->mapping != nullptr; }
+
+  void release(std::size_t offset) const;
+
+  private:
+  bool map(int fd, std::size_t size);
+};
+
+#endif
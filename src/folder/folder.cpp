@@ -0,0 +1,350 @@
+#include "folder.hpp"
+
+Folder::Folder(Ast &ast) : ast(ast) { }
+
+void Folder::fold()
+{
+  this->forward.resize(this->ast.size());
+  for (std::uint32_t node = 0; node < this->ast.size(); node++)
+    this->forward[node] = node;
+  this->integers.assign(this->ast.size(), false);
+
+  for (std::uint32_t node = 1; node < this->ast.size(); node++) {
+    this->remap(node);
+    this->fold_node(node);
+    this->integers[node] = this->integral(node);
+  }
+  this->remap(0);
+}
+
+void Folder::remap(std::uint32_t node)
+{
+  Ast::Data &data = this->ast.data[node];
+
+  auto remap_list = [&](std::uint32_t list) {
+    for (std::uint32_t i = 1; i <= this->ast.extra[list]; i++)
+      this->ast.extra[list + i] = this->forward[this->ast.extra[list + i]];
+  };
+
+  switch (this->ast.kind(node)) {
+  case AstKind::N_PROGRAM:
+  case AstKind::N_BLOCK:
+    remap_list(data.lhs);
+    break;
+
+  case AstKind::N_FN:
+    data.rhs = this->forward[data.rhs];
+    break;
+
+  case AstKind::N_IF:
+  case AstKind::N_TERNARY:
+    data.lhs                      = this->forward[data.lhs];
+    this->ast.extra[data.rhs]     = this->forward[this->ast.extra[data.rhs]];
+    this->ast.extra[data.rhs + 1] = this->forward[this->ast.extra[data.rhs + 1]];
+    break;
+
+  case AstKind::N_CALL:
+    data.lhs = this->forward[data.lhs];
+    remap_list(data.rhs);
+    break;
+
+  default:
+    data.lhs = this->forward[data.lhs];
+    data.rhs = this->forward[data.rhs];
+    break;
+  }
+}
+
+void Folder::fold_node(std::uint32_t node)
+{
+  Constant cond;
+
+  switch (this->ast.kind(node)) {
+  case AstKind::N_UNARY:
+    this->fold_unary(node);
+    break;
+
+  case AstKind::N_BINARY:
+    if (this->ast.token(node).is_in(TokenType::T_AND | TokenType::T_OR))
+      this->fold_logical(node);
+    else
+      this->fold_binary(node);
+    break;
+
+  case AstKind::N_ASSIGN:
+    if (this->ast.token(node).is_in(TokenType::T_DIVASSIGN | TokenType::T_MODASSIGN))
+      this->check_divisor(node, this->ast.rhs(node));
+    break;
+
+  case AstKind::N_TERNARY:
+    if (this->constant(this->ast.lhs(node), cond))
+      this->replace(node, this->ast.extra[this->ast.rhs(node) + (cond.is_zero() ? 1 : 0)]);
+    break;
+
+  case AstKind::N_IF:
+    if (this->constant(this->ast.lhs(node), cond)) {
+      std::uint32_t branch = this->ast.extra[this->ast.rhs(node) + (cond.is_zero() ? 1 : 0)];
+      if (branch != Ast::NONE)
+        this->replace(node, branch);
+      else
+        this->erase(node);
+    }
+    break;
+
+  case AstKind::N_WHILE:
+    if (this->constant(this->ast.lhs(node), cond) && cond.is_zero())
+      this->erase(node);
+    break;
+
+  default:
+    break;
+  }
+}
+
+void Folder::fold_unary(std::uint32_t node)
+{
+  TokenType op          = this->ast.token(node).type;
+  std::uint32_t operand = this->ast.lhs(node);
+
+  Constant value;
+  if (this->constant(operand, value)) {
+    switch (op) {
+    case TokenType::T_ADD:
+      this->replace(node, value);
+      break;
+    case TokenType::T_SUB:
+      if (value.type == ConstantType::C_INT)
+        this->replace(node, Constant((std::int64_t)(0 - (std::uint64_t)value.i)));
+      else
+        this->replace(node, Constant(-value.f));
+      break;
+    case TokenType::T_NOT:
+      this->replace(node, Constant((std::int64_t)value.is_zero()));
+      break;
+    case TokenType::T_BNOT:
+      if (value.type == ConstantType::C_INT)
+        this->replace(node, Constant(~value.i));
+      break;
+    default:
+      break;
+    }
+    return;
+  }
+
+  if (op == TokenType::T_ADD && this->integers[operand])
+    this->replace(node, operand);
+  else if ((op == TokenType::T_SUB || op == TokenType::T_BNOT)
+           && this->ast.kind(operand) == AstKind::N_UNARY && this->ast.token(operand).type == op
+           && this->integers[this->ast.lhs(operand)])
+    this->replace(node, this->ast.lhs(operand));
+}
+
+void Folder::fold_binary(std::uint32_t node)
+{
+  TokenType op      = this->ast.token(node).type;
+  std::uint32_t lhs = this->ast.lhs(node);
+  std::uint32_t rhs = this->ast.rhs(node);
+
+  if (op == TokenType::T_DIV || op == TokenType::T_MOD)
+    this->check_divisor(node, rhs);
+
+  Constant a, b;
+  bool is_a = this->constant(lhs, a);
+  bool is_b = this->constant(rhs, b);
+
+  if (is_a && is_b) {
+    if (a.type == ConstantType::C_INT && b.type == ConstantType::C_INT) {
+      std::uint64_t x = (std::uint64_t)a.i;
+      std::uint64_t y = (std::uint64_t)b.i;
+
+      switch (op) {
+      case TokenType::T_ADD:
+        return this->replace(node, Constant((std::int64_t)(x + y)));
+      case TokenType::T_SUB:
+        return this->replace(node, Constant((std::int64_t)(x - y)));
+      case TokenType::T_MUL:
+        return this->replace(node, Constant((std::int64_t)(x * y)));
+      case TokenType::T_DIV:
+        return this->replace(node, Constant(b.i == -1 ? (std::int64_t)(0 - x) : a.i / b.i));
+      case TokenType::T_MOD:
+        return this->replace(node, Constant(b.i == -1 ? (std::int64_t)0 : a.i % b.i));
+      case TokenType::T_BAND:
+        return this->replace(node, Constant(a.i & b.i));
+      case TokenType::T_BOR:
+        return this->replace(node, Constant(a.i | b.i));
+      case TokenType::T_BXOR:
+        return this->replace(node, Constant(a.i ^ b.i));
+      case TokenType::T_EQ:
+        return this->replace(node, Constant((std::int64_t)(a.i == b.i)));
+      case TokenType::T_NEQ:
+        return this->replace(node, Constant((std::int64_t)(a.i != b.i)));
+      case TokenType::T_GT:
+        return this->replace(node, Constant((std::int64_t)(a.i > b.i)));
+      case TokenType::T_LT:
+        return this->replace(node, Constant((std::int64_t)(a.i < b.i)));
+      case TokenType::T_GEQ:
+        return this->replace(node, Constant((std::int64_t)(a.i >= b.i)));
+      case TokenType::T_LEQ:
+        return this->replace(node, Constant((std::int64_t)(a.i <= b.i)));
+      default:
+        return;
+      }
+    }
+
+    double x = a.as_float();
+    double y = b.as_float();
+
+    switch (op) {
+    case TokenType::T_ADD:
+      return this->replace(node, Constant(x + y));
+    case TokenType::T_SUB:
+      return this->replace(node, Constant(x - y));
+    case TokenType::T_MUL:
+      return this->replace(node, Constant(x * y));
+    case TokenType::T_DIV:
+      return this->replace(node, Constant(x / y));
+    case TokenType::T_EQ:
+      return this->replace(node, Constant((std::int64_t)(x == y)));
+    case TokenType::T_NEQ:
+      return this->replace(node, Constant((std::int64_t)(x != y)));
+    case TokenType::T_GT:
+      return this->replace(node, Constant((std::int64_t)(x > y)));
+    case TokenType::T_LT:
+      return this->replace(node, Constant((std::int64_t)(x < y)));
+    case TokenType::T_GEQ:
+      return this->replace(node, Constant((std::int64_t)(x >= y)));
+    case TokenType::T_LEQ:
+      return this->replace(node, Constant((std::int64_t)(x <= y)));
+    default:
+      return;
+    }
+  }
+
+  bool int_a = this->integers[lhs];
+  bool int_b = this->integers[rhs];
+
+  switch (op) {
+  case TokenType::T_ADD:
+  case TokenType::T_BOR:
+  case TokenType::T_BXOR:
+    if (is_b && b.is_int(0) && int_a)
+      this->replace(node, lhs);
+    else if (is_a && a.is_int(0) && int_b)
+      this->replace(node, rhs);
+    break;
+  case TokenType::T_SUB:
+    if (is_b && b.is_int(0) && int_a)
+      this->replace(node, lhs);
+    break;
+  case TokenType::T_MUL:
+    if (is_b && b.is_int(1) && int_a)
+      this->replace(node, lhs);
+    else if (is_a && a.is_int(1) && int_b)
+      this->replace(node, rhs);
+    break;
+  case TokenType::T_DIV:
+    if (is_b && b.is_int(1) && int_a)
+      this->replace(node, lhs);
+    break;
+  default:
+    break;
+  }
+}
+
+void Folder::fold_logical(std::uint32_t node)
+{
+  bool is_and = this->ast.token(node).type == TokenType::T_AND;
+
+  Constant a, b;
+  if (!this->constant(this->ast.lhs(node), a))
+    return;
+
+  if (is_and && a.is_zero())
+    this->replace(node, Constant((std::int64_t)0));
+  else if (!is_and && !a.is_zero())
+    this->replace(node, Constant((std::int64_t)1));
+  else if (this->constant(this->ast.rhs(node), b))
+    this->replace(node, Constant((std::int64_t)!b.is_zero()));
+}
+
+bool Folder::constant(std::uint32_t node, Constant &out)
+{
+  if (this->ast.kind(node) != AstKind::N_NUMBER)
+    return false;
+
+  // Integers out of the runtime's range are left for the compiler to report.
+  Token &token = this->ast.token(node);
+  out          = Constant::parse(token.value, token.loc);
+  return out.in_range();
+}
+
+// Whether a node always evaluates to an integer, rather than a char, a float or a string, when it
+// evaluates at all. Its operands were decided on before it, as they come first.
+bool Folder::integral(std::uint32_t node)
+{
+  Constant value;
+
+  switch (this->ast.kind(node)) {
+  case AstKind::N_NUMBER:
+    return this->constant(node, value) && value.type == ConstantType::C_INT;
+
+  case AstKind::N_UNARY:
+    switch (this->ast.token(node).type) {
+    case TokenType::T_NOT:
+    case TokenType::T_BNOT:
+      return true;
+    case TokenType::T_ADD:
+    case TokenType::T_SUB:
+      return this->integers[this->ast.lhs(node)];
+    default:
+      return false;
+    }
+
+  case AstKind::N_BINARY:
+    switch (this->ast.token(node).type) {
+    case TokenType::T_ADD:
+    case TokenType::T_SUB:
+    case TokenType::T_MUL:
+    case TokenType::T_DIV:
+    case TokenType::T_MOD:
+      return this->integers[this->ast.lhs(node)] && this->integers[this->ast.rhs(node)];
+    default:
+      return true;
+    }
+
+  default:
+    return false;
+  }
+}
+
+void Folder::replace(std::uint32_t node, Constant value)
+{
+  SourceLoc loc = this->ast.token(node).loc;
+
+  if (value.type == ConstantType::C_INT)
+    value.i = Constant::wrap(value.i);
+
+  this->ast.tokens.push_back(Token(TokenType::T_NUMBER, value.str(), loc));
+
+  this->ast.kinds[node]       = AstKind::N_NUMBER;
+  this->ast.main_tokens[node] = (std::uint32_t)this->ast.tokens.size() - 1;
+  this->ast.data[node]        = { Ast::NONE, Ast::NONE };
+}
+
+void Folder::replace(std::uint32_t node, std::uint32_t with) { this->forward[node] = with; }
+
+void Folder::erase(std::uint32_t node)
+{
+  this->ast.kinds[node] = AstKind::N_BLOCK;
+  this->ast.data[node]  = { this->ast.add_list(nullptr, 0), Ast::NONE };
+}
+
+void Folder::check_divisor(std::uint32_t node, std::uint32_t divisor)
+{
+  Constant value;
+  if (!this->constant(divisor, value) || !value.is_zero())
+    return;
+
+  Token &token = this->ast.token(node);
+  throw Error(token.loc, "Division by zero.");
+}
@@ -0,0 +1,42 @@
+#ifndef FOLDER_HPP
+#define FOLDER_HPP
+
+#include "ast/ast.hpp"
+#include "constant/constant.hpp"
+#include "error/error.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Evaluates constant subexpressions and applies algebraic identities in place. Folded nodes
+// become N_NUMBER nodes backed by synthetic tokens; simplified nodes are bypassed by redirecting
+// their parent to the surviving operand. An identity only applies to operands that are known to
+// be integers, since it would otherwise drop the conversion of a char or the error of a float.
+class Folder {
+  Ast &ast;
+
+  std::vector<std::uint32_t> forward;
+  std::vector<bool> integers;
+
+  public:
+  Folder(Ast &ast);
+
+  void fold();
+
+  private:
+  void remap(std::uint32_t node);
+  void fold_node(std::uint32_t node);
+
+  void fold_unary(std::uint32_t node);
+  void fold_binary(std::uint32_t node);
+  void fold_logical(std::uint32_t node);
+
+  bool constant(std::uint32_t node, Constant &out);
+  bool integral(std::uint32_t node);
+  void replace(std::uint32_t node, Constant value);
+  void replace(std::uint32_t node, std::uint32_t with);
+  void erase(std::uint32_t node);
+  void check_divisor(std::uint32_t node, std::uint32_t divisor);
+};
+
+#endif
@@ -0,0 +1,253 @@
+#include "interface.hpp"
+#include "error/error.hpp"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+bool Interface::Stamp::operator==(const Stamp &other) const
+{
+  return this->size == other.size && this->time == other.time;
+}
+
+Interface::Interface(const std::string &path) : file(new File(path, 0))
+{
+  this->open(this->file->data(), this->file->size(), path);
+}
+
+Interface::Interface(const char *data, std::size_t size, const std::string &name)
+{
+  this->open(data, size, name);
+}
+
+void Interface::open(const char *data, std::size_t size, const std::string &name)
+{
+  this->header = (const Header *)data;
+  if (size < sizeof(Header) || this->header->magic != MAGIC
+      || this->header->version != VERSION)
+    throw Error("Invalid interface file: %s", name.c_str());
+
+  std::uint64_t offset = sizeof(Header);
+  auto take = [&](std::uint64_t count, std::uint64_t item) {
+    const char *at = data + offset;
+    offset += count * item;
+    return at;
+  };
+
+  this->functions = (const Function *)take(this->header->functions, sizeof(Function));
+  this->imports   = (const Import *)take(this->header->dependencies, sizeof(Import));
+  this->constants = (const std::uint64_t *)take(this->header->constants, sizeof(std::uint64_t));
+  this->strings   = (const String *)take(this->header->strings, sizeof(String));
+  this->code      = (const std::uint8_t *)take(this->header->code, 1);
+  this->chars     = take(this->header->chars, 1);
+
+  if (offset != size || this->header->entry >= this->header->code)
+    throw Error("Invalid interface file: %s", name.c_str());
+
+  auto in_chars = [&](std::uint32_t at, std::uint32_t length) {
+    return at <= this->header->chars && length <= this->header->chars - at;
+  };
+
+  for (std::uint32_t i = 0; i < this->header->functions; i++) {
+    const Function &function = this->functions[i];
+    if (!in_chars(function.name, function.name_size)
+        || (function.entry != Bytecode::EXTERN && function.entry >= this->header->code))
+      throw Error("Invalid interface file: %s", name.c_str());
+  }
+  for (std::uint32_t i = 0; i < this->header->dependencies; i++) {
+    if (!in_chars(this->imports[i].name, this->imports[i].name_size))
+      throw Error("Invalid interface file: %s", name.c_str());
+  }
+  for (std::uint32_t i = 0; i < this->header->strings; i++) {
+    if (!in_chars(this->strings[i].offset, this->strings[i].size))
+      throw Error("Invalid interface file: %s", name.c_str());
+  }
+}
+
+bool Interface::stamp(const std::string &path, Stamp &stamp)
+{
+  std::error_code error;
+
+  stamp.size = (std::uint64_t)std::filesystem::file_size(path, error);
+  if (error)
+    return false;
+
+  auto time = std::filesystem::last_write_time(path, error);
+  if (error)
+    return false;
+
+  stamp.time = (std::int64_t)time.time_since_epoch().count();
+  return true;
+}
+
+// FNV-1a over the name, arity and variadicity of every exported function.
+std::uint64_t Interface::hash(const std::vector<Bytecode::Function> &exports)
+{
+  std::uint64_t hash = 0xcbf29ce484222325;
+  auto mix           = [&](std::uint8_t byte) { hash = (hash ^ byte) * 0x100000001b3; };
+
+  for (const Bytecode::Function &function : exports) {
+    for (char c : function.name)
+      mix((std::uint8_t)c);
+    mix(0);
+    mix((std::uint8_t)function.params);
+    mix((std::uint8_t)(function.params >> 8));
+    mix(function.variadic);
+  }
+
+  return hash;
+}
+
+std::string Interface::image(const Bytecode &program, const Stamp &source,
+                             const std::vector<Dependency> &dependencies)
+{
+  std::string chars;
+  auto add_chars = [&](std::string_view str) {
+    std::uint32_t at = (std::uint32_t)chars.size();
+    chars.append(str.data(), str.size());
+    return at;
+  };
+
+  std::vector<Function> functions;
+  std::vector<Bytecode::Function> exports;
+
+  for (const Bytecode::Function &function : program.functions) {
+    functions.push_back({ add_chars(function.name), (std::uint32_t)function.name.size(),
+                          function.entry, function.params, function.slots, function.max_stack,
+                          function.variadic });
+    if (function.entry != Bytecode::EXTERN)
+      exports.push_back(function);
+  }
+
+  std::vector<Import> imports;
+  for (const Dependency &dependency : dependencies) {
+    imports.push_back({ add_chars(dependency.name), (std::uint32_t)dependency.name.size(),
+                        dependency.hash });
+  }
+
+  std::vector<std::uint64_t> constants(program.constants.size());
+  if (!constants.empty())
+    std::memcpy(constants.data(), program.constants.data(), constants.size() * sizeof(Value));
+
+  std::vector<String> strings;
+  for (std::uint32_t id = 0; id < program.strings.size(); id++) {
+    std::string_view str = program.strings.get(id);
+    strings.push_back({ add_chars(str), (std::uint32_t)str.size() });
+  }
+
+  Header header;
+  header.magic        = MAGIC;
+  header.version      = VERSION;
+  header.source       = source;
+  header.hash         = Interface::hash(exports);
+  header.functions    = (std::uint32_t)functions.size();
+  header.dependencies = (std::uint32_t)imports.size();
+  header.constants    = (std::uint32_t)constants.size();
+  header.strings      = (std::uint32_t)strings.size();
+  header.code         = (std::uint32_t)program.code.size();
+  header.chars        = (std::uint32_t)chars.size();
+  header.globals      = program.globals;
+  header.entry        = program.entry;
+  header.max_stack    = program.max_stack;
+  header.reserved     = 0;
+
+  std::string image;
+  auto put = [&](const void *data, std::size_t size) {
+    image.append((const char *)data, size);
+  };
+
+  put(&header, sizeof(header));
+  put(functions.data(), functions.size() * sizeof(Function));
+  put(imports.data(), imports.size() * sizeof(Import));
+  put(constants.data(), constants.size() * sizeof(std::uint64_t));
+  put(strings.data(), strings.size() * sizeof(String));
+  put(program.code.data(), program.code.size());
+  put(chars.data(), chars.size());
+
+  return image;
+}
+
+void Interface::write(const std::string &path, const Bytecode &program, const Stamp &source,
+                      const std::vector<Dependency> &dependencies)
+{
+  std::string image     = Interface::image(program, source, dependencies);
+  std::string temporary = path + ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(image.data(), (std::streamsize)image.size());
+
+    if (!out.flush())
+      throw Error("Cannot write file: %s", temporary.c_str());
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary, path, error);
+  if (error) {
+    std::remove(temporary.c_str());
+    throw Error("Cannot write file: %s", path.c_str());
+  }
+}
+
+const Interface::Stamp &Interface::source() const { return this->header->source; }
+
+std::uint64_t Interface::hash() const { return this->header->hash; }
+
+std::uint32_t Interface::dependency_count() const { return this->header->dependencies; }
+
+Interface::Dependency Interface::dependency(std::uint32_t i) const
+{
+  const Import &import = this->imports[i];
+
+  return { std::string(this->view(import.name, import.name_size)), import.hash };
+}
+
+std::vector<Bytecode::Function> Interface::exports() const
+{
+  std::vector<Bytecode::Function> exports;
+
+  for (std::uint32_t i = 0; i < this->header->functions; i++) {
+    const Function &function = this->functions[i];
+    if (function.entry == Bytecode::EXTERN)
+      continue;
+
+    exports.push_back({ std::string(this->view(function.name, function.name_size)),
+                        function.entry, function.params, function.slots, function.max_stack,
+                        function.variadic != 0 });
+  }
+
+  return exports;
+}
+
+Bytecode Interface::program() const
+{
+  Bytecode program;
+
+  program.code.assign(this->code, this->code + this->header->code);
+
+  program.constants.resize(this->header->constants);
+  if (this->header->constants != 0) {
+    std::memcpy((void *)program.constants.data(), this->constants,
+                this->header->constants * sizeof(std::uint64_t));
+  }
+
+  for (std::uint32_t i = 0; i < this->header->strings; i++)
+    program.strings.intern(this->view(this->strings[i].offset, this->strings[i].size));
+
+  for (std::uint32_t i = 0; i < this->header->functions; i++) {
+    const Function &function = this->functions[i];
+    program.functions.push_back({ std::string(this->view(function.name, function.name_size)),
+                                  function.entry, function.params, function.slots,
+                                  function.max_stack, function.variadic != 0 });
+  }
+
+  program.globals   = this->header->globals;
+  program.entry     = this->header->entry;
+  program.max_stack = this->header->max_stack;
+
+  return program;
+}
+
+std::string_view Interface::view(std::uint32_t offset, std::uint32_t size) const
+{
+  return std::string_view(this->chars + offset, size);
+}
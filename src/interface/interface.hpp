@@ -0,0 +1,122 @@
+#ifndef INTERFACE_HPP
+#define INTERFACE_HPP
+
+#include "bytecode/bytecode.hpp"
+#include "file/file.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The compiled form of a module: the functions it exports, the interface hashes of the modules
+// it was compiled against, and its bytecode. The file is a header followed by fixed-size records
+// and byte arrays in the byte order of the host, laid out so that it is used in place from a
+// mapping rather than parsed; a file written on a host of the other byte order fails the magic
+// check and is simply rebuilt.
+//
+// The interface hash only covers the exported signatures, so changing the body of a function
+// leaves the modules compiled against it valid.
+class Interface {
+  public:
+  struct Stamp {
+    std::uint64_t size;
+    std::int64_t time;
+
+    bool operator==(const Stamp &other) const;
+  };
+
+  struct Dependency {
+    std::string name;
+    std::uint64_t hash;
+  };
+
+  private:
+  struct Header {
+    std::uint32_t magic;
+    std::uint32_t version;
+    Stamp source;
+    std::uint64_t hash;
+
+    std::uint32_t functions;
+    std::uint32_t dependencies;
+    std::uint32_t constants;
+    std::uint32_t strings;
+    std::uint32_t code;
+    std::uint32_t chars;
+
+    std::uint32_t globals;
+    std::uint32_t entry;
+    std::uint32_t max_stack;
+    std::uint32_t reserved;
+  };
+
+  struct Function {
+    std::uint32_t name;
+    std::uint32_t name_size;
+    std::uint32_t entry;
+    std::uint16_t params;
+    std::uint16_t slots;
+    std::uint32_t max_stack;
+    std::uint32_t variadic;
+  };
+
+  struct Import {
+    std::uint32_t name;
+    std::uint32_t name_size;
+    std::uint64_t hash;
+  };
+
+  struct String {
+    std::uint32_t offset;
+    std::uint32_t size;
+  };
+
+  std::unique_ptr<File> file;
+  const Header *header;
+  const Function *functions;
+  const Import *imports;
+  const std::uint64_t *constants;
+  const String *strings;
+  const std::uint8_t *code;
+  const char *chars;
+
+  public:
+  static constexpr std::uint32_t MAGIC   = 0x494c4554; // "TELI"
+  static constexpr std::uint32_t VERSION = 1;
+
+  // Maps the interface file at `path`, throwing an Error when it is missing or malformed.
+  Interface(const std::string &path);
+  // Uses the interface image at `data` in place, such as one linked into the executable. It must
+  // be aligned to 8 bytes and outlive the interface.
+  Interface(const char *data, std::size_t size, const std::string &name);
+
+  // Stores the size and modification time of the file at `path` into `stamp`, or returns false
+  // when there is no such file.
+  static bool stamp(const std::string &path, Stamp &stamp);
+  static std::uint64_t hash(const std::vector<Bytecode::Function> &exports);
+
+  // The contents of the interface file of `program`, compiled by Compiler::compile_module()
+  // from a source with the given stamp.
+  static std::string image(const Bytecode &program, const Stamp &source,
+                           const std::vector<Dependency> &dependencies);
+  // Writes the image of `program` as an interface file. The file is written aside and renamed
+  // over `path`, so readers never see a partial interface.
+  static void write(const std::string &path, const Bytecode &program, const Stamp &source,
+                    const std::vector<Dependency> &dependencies);
+
+  const Stamp &source() const;
+  std::uint64_t hash() const;
+
+  std::uint32_t dependency_count() const;
+  Dependency dependency(std::uint32_t i) const;
+
+  std::vector<Bytecode::Function> exports() const;
+  Bytecode program() const;
+
+  private:
+  void open(const char *data, std::size_t size, const std::string &name);
+  std::string_view view(std::uint32_t offset, std::uint32_t size) const;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include "interner.hpp"
+
+Interner::Interner()
+{
+  this->offsets.push_back(0);
+  this->table.assign(16, NONE);
+}
+
+std::uint32_t Interner::intern(std::string_view str)
+{
+  std::uint32_t hash = Interner::hash(str);
+  std::uint32_t slot = this->probe(str, hash);
+
+  if (this->table[slot] != NONE)
+    return this->table[slot];
+
+  std::uint32_t id = this->size();
+  this->chars.insert(this->chars.end(), str.begin(), str.end());
+  this->offsets.push_back((std::uint32_t)this->chars.size());
+  this->hashes.push_back(hash);
+  this->table[slot] = id;
+
+  // Keep the load factor under 3/4.
+  if ((std::uint64_t)this->size() * 4 >= (std::uint64_t)this->table.size() * 3)
+    this->grow();
+
+  return id;
+}
+
+std::uint32_t Interner::find(std::string_view str) const
+{
+  return this->table[this->probe(str, Interner::hash(str))];
+}
+
+std::string_view Interner::get(std::uint32_t id) const
+{
+  return std::string_view(this->chars.data() + this->offsets[id],
+                          this->offsets[id + 1] - this->offsets[id]);
+}
+
+std::uint32_t Interner::size() const
+{
+  return (std::uint32_t)this->hashes.size();
+}
+
+std::uint32_t Interner::probe(std::string_view str, std::uint32_t hash) const
+{
+  std::uint32_t mask = (std::uint32_t)this->table.size() - 1;
+
+  for (std::uint32_t slot = hash & mask;; slot = (slot + 1) & mask) {
+    std::uint32_t id = this->table[slot];
+    if (id == NONE || (this->hashes[id] == hash && this->get(id) == str))
+      return slot;
+  }
+}
+
+void Interner::grow()
+{
+  this->table.assign(this->table.size() * 2, NONE);
+  std::uint32_t mask = (std::uint32_t)this->table.size() - 1;
+
+  for (std::uint32_t id = 0; id < this->size(); id++) {
+    std::uint32_t slot = this->hashes[id] & mask;
+    while (this->table[slot] != NONE)
+      slot = (slot + 1) & mask;
+    this->table[slot] = id;
+  }
+}
+
+// FNV-1a.
+std::uint32_t Interner::hash(std::string_view str)
+{
+  std::uint32_t hash = 2166136261u;
+
+  for (char c : str) {
+    hash ^= (unsigned char)c;
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
@@ -0,0 +1,34 @@
+#ifndef INTERNER_HPP
+#define INTERNER_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Maps strings to dense 32-bit ids. The characters of every interned string are kept in a single
+// buffer, and ids are found through an open-addressing table, so interning never allocates per
+// string and an id fits into the payload of a Value.
+class Interner {
+  std::vector<char> chars;
+  std::vector<std::uint32_t> offsets;
+  std::vector<std::uint32_t> hashes;
+  std::vector<std::uint32_t> table;
+
+  public:
+  static constexpr std::uint32_t NONE = 0xffffffff;
+
+  Interner();
+
+  std::uint32_t intern(std::string_view str);
+  std::uint32_t find(std::string_view str) const;
+  std::string_view get(std::uint32_t id) const;
+  std::uint32_t size() const;
+
+  private:
+  std::uint32_t probe(std::string_view str, std::uint32_t hash) const;
+  void grow();
+
+  static std::uint32_t hash(std::string_view str);
+};
+
+#endif
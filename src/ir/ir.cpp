@@ -0,0 +1,286 @@
+#include "ir.hpp"
+#include "constant/constant.hpp"
+#include <algorithm>
+#include <cstring>
+
+std::uint32_t Ir::add_list(const std::uint32_t *items, std::uint32_t count)
+{
+  std::uint32_t list = (std::uint32_t)this->extra.size();
+
+  this->extra.push_back(count);
+  this->extra.insert(this->extra.end(), items, items + count);
+
+  return list;
+}
+
+std::uint32_t Ir::block_of(std::uint32_t instr) const
+{
+  auto block = std::upper_bound(this->blocks.begin(), this->blocks.end(), instr,
+                                [](std::uint32_t instr, const Block &block) {
+                                  return instr < block.first;
+                                });
+
+  return (std::uint32_t)(block - this->blocks.begin()) - 1;
+}
+
+std::uint32_t Ir::successors(std::uint32_t block, std::uint32_t *out) const
+{
+  const Block &range = this->blocks[block];
+  if (range.first == range.end)
+    return 0;
+
+  const Instr &last = this->instrs[range.end - 1];
+  switch (last.op) {
+  case Op::I_JUMP:
+    out[0] = last.a;
+    return 1;
+  case Op::I_BRANCH:
+    out[0] = last.b;
+    out[1] = (std::uint32_t)last.imm;
+    return 2;
+  default:
+    return 0;
+  }
+}
+
+// Drops I_NOP instructions and dead blocks (whose predecessor list is NONE) and renumbers what
+// remains, keeping the arena dense and every block contiguous.
+void Ir::compact()
+{
+  std::vector<std::uint32_t> instr_map(this->instrs.size(), NONE);
+  std::vector<std::uint32_t> block_map(this->blocks.size(), NONE);
+  std::vector<Instr> instrs;
+  std::vector<Block> blocks;
+
+  for (Function &function : this->functions) {
+    std::uint32_t first = (std::uint32_t)blocks.size();
+
+    for (std::uint32_t block = function.first; block < function.end; block++) {
+      Block &range = this->blocks[block];
+      if (range.preds == NONE)
+        continue;
+
+      block_map[block] = (std::uint32_t)blocks.size();
+      blocks.push_back({ (std::uint32_t)instrs.size(), 0, range.preds });
+
+      for (std::uint32_t i = range.first; i < range.end; i++) {
+        if (this->instrs[i].op != Op::I_NOP) {
+          instr_map[i] = (std::uint32_t)instrs.size();
+          instrs.push_back(this->instrs[i]);
+        }
+      }
+      blocks.back().end = (std::uint32_t)instrs.size();
+    }
+
+    function.first = first;
+    function.end   = (std::uint32_t)blocks.size();
+  }
+
+  std::vector<std::uint32_t> extra;
+  auto copy_list = [&](std::uint32_t list, const std::vector<std::uint32_t> &map) {
+    std::uint32_t copy = (std::uint32_t)extra.size();
+
+    extra.push_back(this->list_size(list));
+    for (std::uint32_t i = 0; i < this->list_size(list); i++)
+      extra.push_back(map[this->list_items(list)[i]]);
+
+    return copy;
+  };
+
+  for (Instr &instr : instrs) {
+    if (instr.op == Op::I_PHI || instr.op == Op::I_CALL || instr.op == Op::I_PRINT)
+      instr.b = copy_list(instr.b, instr_map);
+    else
+      this->each_operand(instr, [&](std::uint32_t &value) { value = instr_map[value]; });
+
+    if (instr.op == Op::I_JUMP)
+      instr.a = block_map[instr.a];
+    else if (instr.op == Op::I_BRANCH) {
+      instr.b   = block_map[instr.b];
+      instr.imm = block_map[instr.imm];
+    }
+  }
+
+  for (Block &block : blocks)
+    block.preds = copy_list(block.preds, block_map);
+
+  this->instrs = std::move(instrs);
+  this->blocks = std::move(blocks);
+  this->extra  = std::move(extra);
+}
+
+// Live values at the entry and exit of every block of a function, computed by iterating the
+// usual backward dataflow equations over bitsets. Bit i of a set stands for the i-th
+// instruction of the function. A phi operand is live at the end of the matching predecessor
+// rather than at the start of the phi's block.
+void Ir::liveness(std::uint32_t function, std::vector<Bitset> &live_in,
+                  std::vector<Bitset> &live_out)
+{
+  const Function &range = this->functions[function];
+  std::uint32_t base    = this->blocks[range.first].first;
+  std::uint32_t size    = this->blocks[range.end - 1].end - base;
+  std::uint32_t count   = range.end - range.first;
+
+  std::vector<Bitset> gen(count, Bitset(size));
+  std::vector<Bitset> phi_uses(count, Bitset(size));
+
+  for (std::uint32_t block = 0; block < count; block++) {
+    Block &current = this->blocks[range.first + block];
+
+    for (std::uint32_t i = current.first; i < current.end; i++) {
+      Instr &instr = this->instrs[i];
+
+      if (instr.op == Op::I_PHI) {
+        const std::uint32_t *preds = this->list_items(current.preds);
+        for (std::uint32_t k = 0; k < this->list_size(instr.b); k++)
+          phi_uses[preds[k] - range.first].set(this->list_items(instr.b)[k] - base);
+        continue;
+      }
+
+      this->each_operand(instr, [&](std::uint32_t &value) {
+        if (value < current.first || value >= current.end)
+          gen[block].set(value - base);
+      });
+    }
+  }
+
+  live_in.assign(count, Bitset(size));
+  live_out.assign(count, Bitset(size));
+
+  for (bool changed = true; changed;) {
+    changed = false;
+
+    for (std::uint32_t block = count; block-- > 0;) {
+      std::uint32_t succs[2];
+      std::uint32_t succ_count = this->successors(range.first + block, succs);
+
+      Bitset out = phi_uses[block];
+      for (std::uint32_t i = 0; i < succ_count; i++)
+        out.unite(live_in[succs[i] - range.first]);
+
+      Bitset in = out;
+      in.reset_range(this->blocks[range.first + block].first - base,
+                     this->blocks[range.first + block].end - base);
+      in.unite(gen[block]);
+
+      if (in != live_in[block] || out != live_out[block]) {
+        live_in[block]  = std::move(in);
+        live_out[block] = std::move(out);
+        changed         = true;
+      }
+    }
+  }
+}
+
+std::string Ir::dump()
+{
+  std::string out;
+  char line[64];
+
+  auto value = [&](std::uint32_t value) { return "%" + std::to_string(value); };
+  auto list  = [&](std::uint32_t list) {
+    std::string items;
+    for (std::uint32_t i = 0; i < this->list_size(list); i++)
+      items += (i > 0 ? ", " : "") + value(this->list_items(list)[i]);
+    return items;
+  };
+
+  for (Function &function : this->functions) {
+    out += "fn " + function.name + "(" + std::to_string(function.params)
+         + (function.variadic ? ", ...)\n" : ")\n");
+
+    for (std::uint32_t block = function.first; block < function.end; block++) {
+      Block &range = this->blocks[block];
+
+      out += "b" + std::to_string(block) + ":";
+      if (range.preds != NONE && this->list_size(range.preds) > 0) {
+        out += " ; preds =";
+        for (std::uint32_t i = 0; i < this->list_size(range.preds); i++)
+          out += (i > 0 ? ", b" : " b") + std::to_string(this->list_items(range.preds)[i]);
+      }
+      out += "\n";
+
+      for (std::uint32_t i = range.first; i < range.end; i++) {
+        Instr &instr = this->instrs[i];
+        if (instr.op == Op::I_NOP)
+          continue;
+
+        out += "  ";
+        if (!is_terminator(instr.op) && instr.op != Op::I_STORE_GLOBAL)
+          out += value(i) + " = ";
+        out += op_name(instr.op);
+
+        switch (instr.op) {
+        case Op::I_CONST:
+        case Op::I_PARAM:
+          out += " " + std::to_string(instr.imm);
+          break;
+        case Op::I_FLOAT: {
+          double f;
+          std::memcpy(&f, &instr.imm, sizeof(f));
+          out += " " + Constant(f).str();
+          break;
+        }
+        case Op::I_CHAR:
+          std::snprintf(line, sizeof(line), " '%c'", (char)instr.imm);
+          out += line;
+          break;
+        case Op::I_STRING:
+          out += " \"" + std::string(this->strings.get((std::uint32_t)instr.imm)) + "\"";
+          break;
+        case Op::I_PHI:
+          out += " " + list(instr.b);
+          break;
+        case Op::I_LOAD_GLOBAL:
+          out += " " + this->globals[instr.imm];
+          break;
+        case Op::I_STORE_GLOBAL:
+          out += " " + this->globals[instr.imm] + ", " + value(instr.a);
+          break;
+        case Op::I_CALL:
+          out += " " + this->functions[instr.imm].name + "(" + list(instr.b) + ")";
+          break;
+        case Op::I_PRINT:
+          out += "(" + list(instr.b) + ")";
+          break;
+        case Op::I_JUMP:
+          out += " b" + std::to_string(instr.a);
+          break;
+        case Op::I_BRANCH:
+          out += " " + value(instr.a) + ", b" + std::to_string(instr.b) + ", b"
+               + std::to_string(instr.imm);
+          break;
+        default: {
+          const char *separator = " ";
+          this->each_operand(instr, [&](std::uint32_t &operand) {
+            out += separator + value(operand);
+            separator = ", ";
+          });
+          break;
+        }
+        }
+
+        out += "\n";
+      }
+    }
+  }
+
+  return out;
+}
+
+const char *Ir::op_name(Op op)
+{
+  static const char *const names[] = {
+    "nop", "const", "float", "char", "string", "param", "phi", "copy", "add", "sub", "mul",
+    "div", "mod", "and", "or", "xor", "eq", "neq", "gt", "lt", "geq", "leq", "index", "neg",
+    "not", "bnot", "bool", "incr", "decr", "load_global", "store_global", "call", "print", "jump",
+    "branch", "return",
+  };
+
+  return names[(int)op];
+}
+
+bool Ir::is_terminator(Op op)
+{
+  return op == Op::I_JUMP || op == Op::I_BRANCH || op == Op::I_RETURN;
+}
@@ -0,0 +1,139 @@
+#ifndef IR_HPP
+#define IR_HPP
+
+#include "bitset/bitset.hpp"
+#include "interner/interner.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Mid-level SSA representation of a program. Instructions live in a single arena and are named
+// by their dense 32-bit index, which is also the value they produce. Every basic block is a
+// contiguous range of that arena, with its phis first and its terminator last, and every
+// function is a contiguous range of blocks. Operand lists (phi operands, call arguments) and
+// predecessor lists are stored in `extra` as a count followed by the items; the operands of a
+// phi are in the order of its block's predecessors.
+class Ir {
+  public:
+  enum class Op : std::uint8_t {
+    I_NOP,
+    I_CONST,        // imm: integer
+    I_FLOAT,        // imm: bits of a double
+    I_CHAR,         // imm: character
+    I_STRING,       // imm: string id
+    I_PARAM,        // imm: parameter index
+    I_PHI,          // b: list of operands
+    I_COPY,         // a
+    I_ADD,          // a, b
+    I_SUB,
+    I_MUL,
+    I_DIV,
+    I_MOD,
+    I_AND,
+    I_OR,
+    I_XOR,
+    I_EQ,
+    I_NEQ,
+    I_GT,
+    I_LT,
+    I_GEQ,
+    I_LEQ,
+    I_INDEX,
+    I_NEG,          // a
+    I_NOT,
+    I_BNOT,
+    I_BOOL,
+    I_INCR,
+    I_DECR,
+    I_LOAD_GLOBAL,  // imm: global
+    I_STORE_GLOBAL, // a: value, imm: global
+    I_CALL,         // b: list of arguments, imm: function
+    I_PRINT,        // b: list of arguments
+    I_JUMP,         // a: target block
+    I_BRANCH,       // a: condition, b: then block, imm: else block
+    I_RETURN,       // a: value
+  };
+
+  struct Instr {
+    Op op;
+    std::uint32_t a;
+    std::uint32_t b;
+    std::int64_t imm;
+  };
+
+  struct Block {
+    std::uint32_t first;
+    std::uint32_t end;
+    std::uint32_t preds;
+  };
+
+  struct Function {
+    std::string name;
+    std::uint32_t params;
+    bool variadic;
+    std::uint32_t first;
+    std::uint32_t end;
+  };
+
+  static constexpr std::uint32_t NONE = 0xffffffff;
+
+  std::vector<Instr> instrs;
+  std::vector<Block> blocks;
+  std::vector<Function> functions;
+  std::vector<std::uint32_t> extra;
+
+  std::vector<std::string> globals;
+  Interner strings;
+  std::uint32_t entry = NONE;
+
+  std::uint32_t add_list(const std::uint32_t *items, std::uint32_t count);
+  std::uint32_t list_size(std::uint32_t list) const { return this->extra[list]; }
+  std::uint32_t *list_items(std::uint32_t list) { return &this->extra[list + 1]; }
+  const std::uint32_t *list_items(std::uint32_t list) const { return &this->extra[list + 1]; }
+
+  std::uint32_t block_of(std::uint32_t instr) const;
+  std::uint32_t successors(std::uint32_t block, std::uint32_t *out) const;
+
+  // Calls `f` with a reference to every value operand of `instr`.
+  template <typename F> void each_operand(Instr &instr, F f)
+  {
+    switch (instr.op) {
+    case Op::I_PHI:
+    case Op::I_CALL:
+    case Op::I_PRINT:
+      for (std::uint32_t i = 0; i < this->list_size(instr.b); i++)
+        f(this->list_items(instr.b)[i]);
+      break;
+    case Op::I_COPY:
+    case Op::I_NEG:
+    case Op::I_NOT:
+    case Op::I_BNOT:
+    case Op::I_BOOL:
+    case Op::I_INCR:
+    case Op::I_DECR:
+    case Op::I_STORE_GLOBAL:
+    case Op::I_BRANCH:
+    case Op::I_RETURN:
+      f(instr.a);
+      break;
+    default:
+      if (instr.op >= Op::I_ADD && instr.op <= Op::I_INDEX) {
+        f(instr.a);
+        f(instr.b);
+      }
+      break;
+    }
+  }
+
+  void compact();
+  void liveness(std::uint32_t function, std::vector<Bitset> &live_in,
+                std::vector<Bitset> &live_out);
+  std::string dump();
+
+  static const char *op_name(Op op);
+  static bool is_terminator(Op op);
+};
+
+typedef Ir::Op IrOp;
+
+#endif
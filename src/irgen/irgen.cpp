@@ -0,0 +1,774 @@
+#include "irgen.hpp"
+#include "constant/constant.hpp"
+#include "value/value.hpp"
+#include <cstring>
+
+static std::uint64_t definition(std::uint32_t var, std::uint32_t block)
+{
+  return (std::uint64_t)var << 32 | block;
+}
+
+IrGen::IrGen(Ast &ast) : ast(ast)
+{
+  this->block = 0;
+  this->vars  = 0;
+}
+
+Ir IrGen::generate()
+{
+  std::uint32_t decls       = this->ast.lhs(0);
+  const std::uint32_t *item = this->ast.list_items(decls);
+  std::uint32_t count       = this->ast.list_size(decls);
+
+  for (std::uint32_t i = 0; i < count; i++)
+    this->declare(item[i]);
+
+  this->ir.entry = (std::uint32_t)this->ir.functions.size();
+  this->ir.functions.push_back({ "<entry>", 0, false, 0, 0 });
+
+  for (std::uint32_t i = 0; i < count; i++) {
+    if (this->ast.kind(item[i]) == AstKind::N_FN)
+      this->gen_function(item[i]);
+  }
+  this->gen_entry();
+
+  // Lay the instructions out block by block and renumber them accordingly.
+  std::vector<std::uint32_t> ids(this->ir.instrs.size(), Ir::NONE);
+  std::vector<Ir::Instr> instrs;
+  instrs.reserve(this->order.size());
+
+  for (std::uint32_t i = 0; i < this->order.size(); i++) {
+    ids[this->order[i]] = i;
+    instrs.push_back(this->ir.instrs[this->order[i]]);
+  }
+
+  for (Ir::Instr &instr : instrs)
+    this->ir.each_operand(instr, [&](std::uint32_t &value) { value = ids[value]; });
+
+  this->ir.instrs = std::move(instrs);
+  this->order.clear();
+
+  return std::move(this->ir);
+}
+
+void IrGen::declare(std::uint32_t node)
+{
+  std::string &name = this->ast.token(node).value;
+
+  if (this->ast.kind(node) == AstKind::N_IMPORT)
+    this->error(node, "Imports are only supported by the bytecode compiler.");
+  if (this->functions.count(name) || this->globals.count(name))
+    this->error(node, "Redefinition of '%s'.", name.c_str());
+
+  if (this->ast.kind(node) == AstKind::N_LET) {
+    this->globals[name] = (std::uint32_t)this->ir.globals.size();
+    this->ir.globals.push_back(name);
+    return;
+  }
+
+  std::uint32_t params = this->ast.extra[this->ast.lhs(node)];
+
+  Ir::Function function = { name, 0, false, 0, 0 };
+  for (std::uint32_t i = 0; i < this->ast.list_size(params); i++) {
+    if (this->ast.kind(this->ast.list_items(params)[i]) == AstKind::N_VARIADIC)
+      function.variadic = true;
+    else
+      function.params++;
+  }
+
+  this->functions[name] = (std::uint32_t)this->ir.functions.size();
+  this->ir.functions.push_back(function);
+}
+
+void IrGen::begin_function(std::uint32_t function)
+{
+  (void)function;
+
+  this->blocks.clear();
+  this->definitions.clear();
+  this->locals.clear();
+  this->scopes.clear();
+  this->names.clear();
+  this->vars = 0;
+
+  this->block = this->new_block();
+  this->seal_block(this->block);
+}
+
+void IrGen::end_function(std::uint32_t function)
+{
+  if (!this->terminated())
+    this->add(IrOp::I_RETURN, this->add(IrOp::I_CONST));
+
+  std::uint32_t base = (std::uint32_t)this->ir.blocks.size();
+
+  for (Block &block : this->blocks) {
+    std::uint32_t first = (std::uint32_t)this->order.size();
+    this->order.insert(this->order.end(), block.phis.begin(), block.phis.end());
+    this->order.insert(this->order.end(), block.instrs.begin(), block.instrs.end());
+
+    for (std::uint32_t &pred : block.preds)
+      pred += base;
+    std::uint32_t preds = this->ir.add_list(block.preds.data(), (std::uint32_t)block.preds.size());
+    this->ir.blocks.push_back({ first, (std::uint32_t)this->order.size(), preds });
+
+    if (!block.instrs.empty()) {
+      Ir::Instr &last = this->ir.instrs[block.instrs.back()];
+      if (last.op == IrOp::I_JUMP)
+        last.a += base;
+      else if (last.op == IrOp::I_BRANCH) {
+        last.b += base;
+        last.imm += base;
+      }
+    }
+  }
+
+  this->ir.functions[function].first = base;
+  this->ir.functions[function].end   = (std::uint32_t)this->ir.blocks.size();
+}
+
+void IrGen::gen_function(std::uint32_t node)
+{
+  std::uint32_t function = this->functions[this->ast.token(node).value];
+  std::uint32_t params   = this->ast.extra[this->ast.lhs(node)];
+
+  this->begin_function(function);
+
+  this->begin_scope();
+  for (std::uint32_t i = 0, index = 0; i < this->ast.list_size(params); i++) {
+    std::uint32_t param = this->ast.list_items(params)[i];
+    if (this->ast.kind(param) == AstKind::N_PARAM) {
+      std::uint32_t var = this->declare_local(param);
+      this->write_variable(var, this->block, this->add(IrOp::I_PARAM, Ir::NONE, Ir::NONE, index++));
+    }
+  }
+
+  this->gen_stmt(this->ast.rhs(node));
+  this->end_scope();
+
+  this->end_function(function);
+}
+
+void IrGen::gen_entry()
+{
+  std::uint32_t decls       = this->ast.lhs(0);
+  const std::uint32_t *item = this->ast.list_items(decls);
+
+  this->begin_function(this->ir.entry);
+
+  for (std::uint32_t i = 0; i < this->ast.list_size(decls); i++) {
+    if (this->ast.kind(item[i]) == AstKind::N_LET && this->ast.rhs(item[i]) != Ast::NONE) {
+      std::uint32_t value = this->gen_expr(this->ast.rhs(item[i]));
+      std::uint32_t global = this->globals[this->ast.token(item[i]).value];
+      this->add(IrOp::I_STORE_GLOBAL, value, Ir::NONE, global);
+    }
+  }
+
+  auto main = this->functions.find("main");
+  if (main != this->functions.end()) {
+    if (this->ir.functions[main->second].params != 0)
+      this->error(Ast::NONE, "Function 'main' must not take parameters.");
+
+    this->add(IrOp::I_RETURN, this->add_list(IrOp::I_CALL, {}, main->second));
+  }
+
+  this->end_function(this->ir.entry);
+}
+
+void IrGen::gen_stmt(std::uint32_t node)
+{
+  switch (this->ast.kind(node)) {
+  case AstKind::N_BLOCK: {
+    std::uint32_t list = this->ast.lhs(node);
+
+    this->begin_scope();
+    for (std::uint32_t i = 0; i < this->ast.list_size(list); i++)
+      this->gen_stmt(this->ast.list_items(list)[i]);
+    this->end_scope();
+    break;
+  }
+
+  case AstKind::N_LET: {
+    std::uint32_t value;
+    if (this->ast.rhs(node) != Ast::NONE)
+      value = this->gen_expr(this->ast.rhs(node));
+    else
+      value = this->add(IrOp::I_CONST);
+
+    this->write_variable(this->declare_local(node), this->block, value);
+    break;
+  }
+
+  case AstKind::N_IF: {
+    std::uint32_t then  = this->ast.extra[this->ast.rhs(node)];
+    std::uint32_t other = this->ast.extra[this->ast.rhs(node) + 1];
+
+    std::uint32_t cond       = this->gen_expr(this->ast.lhs(node));
+    std::uint32_t then_block = this->new_block();
+    std::uint32_t else_block = other != Ast::NONE ? this->new_block() : Ir::NONE;
+    std::uint32_t join       = this->new_block();
+
+    this->branch(cond, then_block, other != Ast::NONE ? else_block : join);
+    this->seal_block(then_block);
+
+    this->block = then_block;
+    this->gen_stmt(then);
+    if (!this->terminated())
+      this->jump(join);
+
+    if (other != Ast::NONE) {
+      this->seal_block(else_block);
+      this->block = else_block;
+      this->gen_stmt(other);
+      if (!this->terminated())
+        this->jump(join);
+    }
+
+    this->seal_block(join);
+    this->block = join;
+    break;
+  }
+
+  case AstKind::N_WHILE: {
+    std::uint32_t header = this->new_block();
+    this->jump(header);
+    this->block = header;
+
+    std::uint32_t cond = this->gen_expr(this->ast.lhs(node));
+    std::uint32_t body = this->new_block();
+    std::uint32_t exit = this->new_block();
+
+    this->branch(cond, body, exit);
+    this->seal_block(body);
+
+    this->block = body;
+    this->gen_stmt(this->ast.rhs(node));
+    if (!this->terminated())
+      this->jump(header);
+
+    this->seal_block(header);
+    this->seal_block(exit);
+    this->block = exit;
+    break;
+  }
+
+  case AstKind::N_RETURN: {
+    std::uint32_t value;
+    if (this->ast.lhs(node) != Ast::NONE)
+      value = this->gen_expr(this->ast.lhs(node));
+    else
+      value = this->add(IrOp::I_CONST);
+    this->add(IrOp::I_RETURN, value);
+
+    // Anything after a return goes into an unreachable block.
+    this->block = this->new_block();
+    this->seal_block(this->block);
+    break;
+  }
+
+  case AstKind::N_EXPR:
+    this->gen_expr(this->ast.lhs(node));
+    break;
+
+  default:
+    this->gen_expr(node);
+    break;
+  }
+}
+
+std::uint32_t IrGen::gen_expr(std::uint32_t node)
+{
+  switch (this->ast.kind(node)) {
+  case AstKind::N_NUMBER: {
+    Token &token      = this->ast.token(node);
+    Constant constant = Constant::parse(token.value, token.loc);
+
+    if (constant.type == ConstantType::C_INT) {
+      if (!constant.in_range())
+        this->error(node, "Integer constant out of range: %s", token.value.c_str());
+      return this->add(IrOp::I_CONST, Ir::NONE, Ir::NONE, constant.i);
+    }
+
+    std::int64_t bits;
+    std::memcpy(&bits, &constant.f, sizeof(bits));
+    return this->add(IrOp::I_FLOAT, Ir::NONE, Ir::NONE, bits);
+  }
+
+  case AstKind::N_CHAR:
+    return this->add(IrOp::I_CHAR, Ir::NONE, Ir::NONE,
+                     (unsigned char)this->ast.token(node).value[0]);
+
+  case AstKind::N_STRING:
+    return this->add(IrOp::I_STRING, Ir::NONE, Ir::NONE,
+                     this->ir.strings.intern(this->ast.token(node).value));
+
+  case AstKind::N_ID:
+    return this->gen_load(node);
+
+  case AstKind::N_UNARY:
+    switch (this->ast.token(node).type) {
+    case TokenType::T_INCR:
+    case TokenType::T_DECR:
+      return this->gen_incr(node, false);
+    case TokenType::T_SUB:
+      return this->add(IrOp::I_NEG, this->gen_expr(this->ast.lhs(node)));
+    case TokenType::T_NOT:
+      return this->add(IrOp::I_NOT, this->gen_expr(this->ast.lhs(node)));
+    case TokenType::T_BNOT:
+      return this->add(IrOp::I_BNOT, this->gen_expr(this->ast.lhs(node)));
+    default:
+      return this->gen_expr(this->ast.lhs(node));
+    }
+
+  case AstKind::N_POSTFIX:
+    return this->gen_incr(node, true);
+
+  case AstKind::N_BINARY: {
+    if (this->ast.token(node).is_in(TokenType::T_AND | TokenType::T_OR))
+      return this->gen_logical(node);
+
+    std::uint32_t a = this->gen_expr(this->ast.lhs(node));
+    std::uint32_t b = this->gen_expr(this->ast.rhs(node));
+    return this->add(binary_op(this->ast.token(node).type), a, b);
+  }
+
+  case AstKind::N_ASSIGN:
+    return this->gen_assign(node);
+
+  case AstKind::N_TERNARY:
+    return this->gen_ternary(node);
+
+  case AstKind::N_CALL:
+    return this->gen_call(node);
+
+  case AstKind::N_INDEX: {
+    std::uint32_t a = this->gen_expr(this->ast.lhs(node));
+    std::uint32_t b = this->gen_expr(this->ast.rhs(node));
+    return this->add(IrOp::I_INDEX, a, b);
+  }
+
+  default:
+    this->error(node, "Unsupported expression: %s", this->ast.token(node).str());
+  }
+}
+
+std::uint32_t IrGen::gen_assign(std::uint32_t node)
+{
+  std::uint32_t target = this->ast.lhs(node);
+  if (this->ast.kind(target) != AstKind::N_ID)
+    this->error(node, "Unsupported assignment target for '%s'.", this->ast.token(node).str());
+
+  std::uint32_t value;
+  if (this->ast.token(node).type == TokenType::T_ASSIGN)
+    value = this->gen_expr(this->ast.rhs(node));
+  else {
+    std::uint32_t current = this->gen_load(target);
+    std::uint32_t operand = this->gen_expr(this->ast.rhs(node));
+    value = this->add(binary_op(this->ast.token(node).type), current, operand);
+  }
+
+  this->gen_store(target, value);
+  return value;
+}
+
+std::uint32_t IrGen::gen_incr(std::uint32_t node, bool postfix)
+{
+  std::uint32_t target = this->ast.lhs(node);
+  if (this->ast.kind(target) != AstKind::N_ID)
+    this->error(node, "Unsupported operand of '%s'.", this->ast.token(node).str());
+
+  IrOp op = this->ast.token(node).type == TokenType::T_INCR ? IrOp::I_INCR : IrOp::I_DECR;
+
+  std::uint32_t current = this->gen_load(target);
+  std::uint32_t next    = this->add(op, current);
+
+  this->gen_store(target, next);
+  return postfix ? current : next;
+}
+
+std::uint32_t IrGen::gen_logical(std::uint32_t node)
+{
+  std::uint32_t left = this->add(IrOp::I_BOOL, this->gen_expr(this->ast.lhs(node)));
+  std::uint32_t rhs  = this->new_block();
+  std::uint32_t join = this->new_block();
+
+  if (this->ast.token(node).type == TokenType::T_AND)
+    this->branch(left, rhs, join);
+  else
+    this->branch(left, join, rhs);
+  this->seal_block(rhs);
+
+  this->block         = rhs;
+  std::uint32_t right = this->add(IrOp::I_BOOL, this->gen_expr(this->ast.rhs(node)));
+  this->jump(join);
+
+  this->seal_block(join);
+  this->block = join;
+
+  std::uint32_t phi = this->new_phi(join);
+  std::uint32_t operands[] = { left, right };
+  this->ir.instrs[phi].b = this->ir.add_list(operands, 2);
+
+  return phi;
+}
+
+std::uint32_t IrGen::gen_ternary(std::uint32_t node)
+{
+  std::uint32_t cond       = this->gen_expr(this->ast.lhs(node));
+  std::uint32_t then_block = this->new_block();
+  std::uint32_t else_block = this->new_block();
+  std::uint32_t join       = this->new_block();
+
+  this->branch(cond, then_block, else_block);
+  this->seal_block(then_block);
+  this->seal_block(else_block);
+
+  this->block        = then_block;
+  std::uint32_t then = this->gen_expr(this->ast.extra[this->ast.rhs(node)]);
+  this->jump(join);
+
+  this->block         = else_block;
+  std::uint32_t other = this->gen_expr(this->ast.extra[this->ast.rhs(node) + 1]);
+  this->jump(join);
+
+  this->seal_block(join);
+  this->block = join;
+
+  std::uint32_t phi = this->new_phi(join);
+  std::uint32_t operands[] = { then, other };
+  this->ir.instrs[phi].b = this->ir.add_list(operands, 2);
+
+  return phi;
+}
+
+std::uint32_t IrGen::gen_call(std::uint32_t node)
+{
+  std::uint32_t callee = this->ast.lhs(node);
+  std::uint32_t list   = this->ast.rhs(node);
+  std::uint32_t argc   = this->ast.list_size(list);
+
+  if (this->ast.kind(callee) != AstKind::N_ID)
+    this->error(node, "Only named functions can be called.");
+
+  std::string &name = this->ast.token(callee).value;
+  if (this->resolve_local(name) != Ir::NONE || this->globals.count(name))
+    this->error(callee, "'%s' is not a function.", name.c_str());
+
+  auto function = this->functions.find(name);
+  if (function == this->functions.end() && name != "print")
+    this->error(callee, "Undefined function: %s", name.c_str());
+
+  if (function != this->functions.end()) {
+    Ir::Function &target = this->ir.functions[function->second];
+    if (argc < target.params || (argc > target.params && !target.variadic))
+      this->error(node, "Wrong number of arguments to '%s'.", name.c_str());
+  }
+
+  std::vector<std::uint32_t> args;
+  for (std::uint32_t i = 0; i < argc; i++)
+    args.push_back(this->gen_expr(this->ast.list_items(list)[i]));
+
+  if (function == this->functions.end())
+    return this->add_list(IrOp::I_PRINT, args);
+  return this->add_list(IrOp::I_CALL, args, function->second);
+}
+
+std::uint32_t IrGen::gen_load(std::uint32_t node)
+{
+  std::string &name = this->ast.token(node).value;
+
+  std::uint32_t var = this->resolve_local(name);
+  if (var != Ir::NONE)
+    return this->read_variable(var, this->block);
+
+  auto global = this->globals.find(name);
+  if (global == this->globals.end())
+    this->error(node, "Undefined identifier: %s", name.c_str());
+
+  return this->add(IrOp::I_LOAD_GLOBAL, Ir::NONE, Ir::NONE, global->second);
+}
+
+void IrGen::gen_store(std::uint32_t node, std::uint32_t value)
+{
+  std::string &name = this->ast.token(node).value;
+
+  std::uint32_t var = this->resolve_local(name);
+  if (var != Ir::NONE) {
+    this->write_variable(var, this->block, value);
+    return;
+  }
+
+  auto global = this->globals.find(name);
+  if (global == this->globals.end())
+    this->error(node, "Undefined identifier: %s", name.c_str());
+
+  this->add(IrOp::I_STORE_GLOBAL, value, Ir::NONE, global->second);
+}
+
+std::uint32_t IrGen::new_block()
+{
+  this->blocks.push_back({ {}, {}, {}, {}, false });
+  return (std::uint32_t)this->blocks.size() - 1;
+}
+
+// A block is sealed once all of its predecessors are known; the phis created for reads before
+// that point get their operands now.
+void IrGen::seal_block(std::uint32_t block)
+{
+  for (std::size_t i = 0; i < this->blocks[block].incomplete.size(); i++) {
+    auto incomplete = this->blocks[block].incomplete[i];
+    std::uint32_t value = this->add_phi_operands(incomplete.first, block, incomplete.second);
+    this->write_variable(incomplete.first, block, value);
+  }
+
+  this->blocks[block].incomplete.clear();
+  this->blocks[block].sealed = true;
+}
+
+void IrGen::jump(std::uint32_t target)
+{
+  this->add(IrOp::I_JUMP, target);
+  this->blocks[target].preds.push_back(this->block);
+}
+
+void IrGen::branch(std::uint32_t cond, std::uint32_t then, std::uint32_t other)
+{
+  this->add(IrOp::I_BRANCH, cond, then, other);
+  this->blocks[then].preds.push_back(this->block);
+  this->blocks[other].preds.push_back(this->block);
+}
+
+bool IrGen::terminated() const
+{
+  const Block &block = this->blocks[this->block];
+  return !block.instrs.empty() && Ir::is_terminator(this->ir.instrs[block.instrs.back()].op);
+}
+
+void IrGen::write_variable(std::uint32_t var, std::uint32_t block, std::uint32_t value)
+{
+  this->definitions[definition(var, block)] = value;
+}
+
+// Looks up the definition of a variable reaching the given block. The recursive formulation of
+// the paper would overflow the stack on long chains of blocks, so the walk over the
+// predecessors is done with an explicit stack.
+std::uint32_t IrGen::read_variable(std::uint32_t var, std::uint32_t block)
+{
+  struct Frame {
+    std::uint32_t block;
+    std::uint32_t phi;
+    std::uint32_t next;
+  };
+
+  std::vector<Frame> stack = { { block, Ir::NONE, 0 } };
+  std::uint32_t result     = Ir::NONE;
+
+  while (!stack.empty()) {
+    Frame &frame   = stack.back();
+    Block &current = this->blocks[frame.block];
+
+    if (result != Ir::NONE) {
+      if (frame.phi == Ir::NONE) {
+        this->write_variable(var, frame.block, result);
+        stack.pop_back();
+        continue;
+      }
+
+      this->ir.list_items(this->ir.instrs[frame.phi].b)[frame.next++] = result;
+      result = Ir::NONE;
+    } else if (frame.phi == Ir::NONE) {
+      auto found = this->definitions.find(definition(var, frame.block));
+      if (found != this->definitions.end()) {
+        result = found->second;
+        stack.pop_back();
+        continue;
+      }
+
+      if (!current.sealed) {
+        result = this->new_phi(frame.block);
+        current.incomplete.push_back({ var, result });
+        this->write_variable(var, frame.block, result);
+        stack.pop_back();
+        continue;
+      }
+
+      if (current.preds.size() == 1) {
+        stack.push_back({ current.preds[0], Ir::NONE, 0 });
+        continue;
+      }
+
+      frame.phi = this->new_phi(frame.block);
+      std::uint32_t count          = (std::uint32_t)current.preds.size();
+      this->ir.instrs[frame.phi].b = this->ir.add_list(current.preds.data(), count);
+      this->write_variable(var, frame.block, frame.phi);
+    }
+
+    if (frame.next < current.preds.size()) {
+      stack.push_back({ current.preds[frame.next], Ir::NONE, 0 });
+      continue;
+    }
+
+    result = this->phi_value(frame.phi);
+    this->write_variable(var, frame.block, result);
+    stack.pop_back();
+  }
+
+  return result;
+}
+
+std::uint32_t IrGen::new_phi(std::uint32_t block)
+{
+  std::uint32_t phi = (std::uint32_t)this->ir.instrs.size();
+
+  this->ir.instrs.push_back({ IrOp::I_PHI, Ir::NONE, Ir::NONE, 0 });
+  this->blocks[block].phis.push_back(phi);
+
+  return phi;
+}
+
+std::uint32_t IrGen::add_phi_operands(std::uint32_t var, std::uint32_t block, std::uint32_t phi)
+{
+  std::vector<std::uint32_t> operands;
+  for (std::uint32_t pred : this->blocks[block].preds)
+    operands.push_back(this->read_variable(var, pred));
+
+  this->ir.instrs[phi].b = this->ir.add_list(operands.data(), (std::uint32_t)operands.size());
+  return this->phi_value(phi);
+}
+
+// Turns a phi whose operands are all the same value (or the phi itself) into a copy of that
+// value. A phi without any other operand is only reachable through unreachable code and
+// becomes zero.
+std::uint32_t IrGen::phi_value(std::uint32_t phi)
+{
+  std::uint32_t same = Ir::NONE;
+  Ir::Instr &instr   = this->ir.instrs[phi];
+
+  for (std::uint32_t i = 0; i < this->ir.list_size(instr.b); i++) {
+    std::uint32_t operand = this->ir.list_items(instr.b)[i];
+    while (this->ir.instrs[operand].op == IrOp::I_COPY)
+      operand = this->ir.instrs[operand].a;
+
+    if (operand == same || operand == phi)
+      continue;
+    if (same != Ir::NONE)
+      return phi;
+    same = operand;
+  }
+
+  if (same == Ir::NONE) {
+    instr.op  = IrOp::I_CONST;
+    instr.imm = 0;
+    return phi;
+  }
+
+  instr.op = IrOp::I_COPY;
+  instr.a  = same;
+  return same;
+}
+
+void IrGen::begin_scope() { this->scopes.push_back((std::uint32_t)this->locals.size()); }
+
+// Locals are looked up by name in `names`, which holds the innermost declaration; each local
+// remembers the one it shadows so that scopes can be unwound in constant time per local.
+void IrGen::end_scope()
+{
+  while (this->locals.size() > this->scopes.back()) {
+    Local &local = this->locals.back();
+
+    if (local.shadowed == Ir::NONE)
+      this->names.erase(local.name);
+    else
+      this->names[local.name] = local.shadowed;
+    this->locals.pop_back();
+  }
+
+  this->scopes.pop_back();
+}
+
+std::uint32_t IrGen::declare_local(std::uint32_t node)
+{
+  std::string &name = this->ast.token(node).value;
+
+  auto found             = this->names.find(name);
+  std::uint32_t shadowed = found != this->names.end() ? found->second : Ir::NONE;
+  if (shadowed != Ir::NONE && shadowed >= this->scopes.back())
+    this->error(node, "Redefinition of '%s'.", name.c_str());
+
+  this->names[name] = (std::uint32_t)this->locals.size();
+  this->locals.push_back({ name, this->vars, shadowed });
+  return this->vars++;
+}
+
+std::uint32_t IrGen::resolve_local(const std::string &name)
+{
+  auto found = this->names.find(name);
+  return found != this->names.end() ? this->locals[found->second].var : Ir::NONE;
+}
+
+std::uint32_t IrGen::add(IrOp op, std::uint32_t a, std::uint32_t b, std::int64_t imm)
+{
+  std::uint32_t instr = (std::uint32_t)this->ir.instrs.size();
+
+  this->ir.instrs.push_back({ op, a, b, imm });
+  this->blocks[this->block].instrs.push_back(instr);
+
+  return instr;
+}
+
+std::uint32_t IrGen::add_list(IrOp op, const std::vector<std::uint32_t> &items, std::int64_t imm)
+{
+  std::uint32_t list = this->ir.add_list(items.data(), (std::uint32_t)items.size());
+  return this->add(op, Ir::NONE, list, imm);
+}
+
+IrOp IrGen::binary_op(TokenType type)
+{
+  switch (type) {
+  case TokenType::T_ADD:
+  case TokenType::T_ADDASSIGN:
+    return IrOp::I_ADD;
+  case TokenType::T_SUB:
+  case TokenType::T_SUBASSIGN:
+    return IrOp::I_SUB;
+  case TokenType::T_MUL:
+  case TokenType::T_MULASSIGN:
+    return IrOp::I_MUL;
+  case TokenType::T_DIV:
+  case TokenType::T_DIVASSIGN:
+    return IrOp::I_DIV;
+  case TokenType::T_MOD:
+  case TokenType::T_MODASSIGN:
+    return IrOp::I_MOD;
+  case TokenType::T_BAND:
+  case TokenType::T_ANDASSIGN:
+    return IrOp::I_AND;
+  case TokenType::T_BOR:
+  case TokenType::T_ORASSIGN:
+    return IrOp::I_OR;
+  case TokenType::T_BXOR:
+  case TokenType::T_XORASSIGN:
+    return IrOp::I_XOR;
+  case TokenType::T_EQ:
+    return IrOp::I_EQ;
+  case TokenType::T_NEQ:
+    return IrOp::I_NEQ;
+  case TokenType::T_GT:
+    return IrOp::I_GT;
+  case TokenType::T_LT:
+    return IrOp::I_LT;
+  case TokenType::T_GEQ:
+    return IrOp::I_GEQ;
+  default:
+    return IrOp::I_LEQ;
+  }
+}
+
+void IrGen::error(std::uint32_t node, const char *format, const char *arg)
+{
+  if (node == Ast::NONE)
+    throw Error(format, arg);
+
+  Token &token = this->ast.token(node);
+  throw Error(token.loc, format, arg);
+}
@@ -0,0 +1,95 @@
+#ifndef IRGEN_HPP
+#define IRGEN_HPP
+
+#include "ast/ast.hpp"
+#include "error/error.hpp"
+#include "ir/ir.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Builds SSA form directly from the AST with the algorithm of Braun et al. ("Simple and
+// Efficient Construction of Static Single Assignment Form"): local variables are never stored
+// to memory, reads look up the reaching definition through the predecessors, and phis are
+// placed lazily in blocks whose predecessors are not all known yet.
+class IrGen {
+  struct Local {
+    std::string name;
+    std::uint32_t var;
+    std::uint32_t shadowed;
+  };
+
+  struct Block {
+    std::vector<std::uint32_t> phis;
+    std::vector<std::uint32_t> instrs;
+    std::vector<std::uint32_t> preds;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> incomplete;
+    bool sealed;
+  };
+
+  Ast &ast;
+  Ir ir;
+
+  std::unordered_map<std::string, std::uint32_t> functions;
+  std::unordered_map<std::string, std::uint32_t> globals;
+  std::vector<std::uint32_t> order;
+
+  std::vector<Block> blocks;
+  std::uint32_t block;
+  std::unordered_map<std::uint64_t, std::uint32_t> definitions;
+  std::uint32_t vars;
+
+  std::vector<Local> locals;
+  std::vector<std::uint32_t> scopes;
+  std::unordered_map<std::string, std::uint32_t> names;
+
+  public:
+  IrGen(Ast &ast);
+
+  Ir generate();
+
+  private:
+  void declare(std::uint32_t node);
+  void begin_function(std::uint32_t function);
+  void end_function(std::uint32_t function);
+  void gen_function(std::uint32_t node);
+  void gen_entry();
+
+  void gen_stmt(std::uint32_t node);
+  std::uint32_t gen_expr(std::uint32_t node);
+  std::uint32_t gen_assign(std::uint32_t node);
+  std::uint32_t gen_incr(std::uint32_t node, bool postfix);
+  std::uint32_t gen_logical(std::uint32_t node);
+  std::uint32_t gen_ternary(std::uint32_t node);
+  std::uint32_t gen_call(std::uint32_t node);
+  std::uint32_t gen_load(std::uint32_t node);
+  void gen_store(std::uint32_t node, std::uint32_t value);
+
+  std::uint32_t new_block();
+  void seal_block(std::uint32_t block);
+  void jump(std::uint32_t target);
+  void branch(std::uint32_t cond, std::uint32_t then, std::uint32_t other);
+  bool terminated() const;
+
+  void write_variable(std::uint32_t var, std::uint32_t block, std::uint32_t value);
+  std::uint32_t read_variable(std::uint32_t var, std::uint32_t block);
+  std::uint32_t new_phi(std::uint32_t block);
+  std::uint32_t add_phi_operands(std::uint32_t var, std::uint32_t block, std::uint32_t phi);
+  std::uint32_t phi_value(std::uint32_t phi);
+
+  void begin_scope();
+  void end_scope();
+  std::uint32_t declare_local(std::uint32_t node);
+  std::uint32_t resolve_local(const std::string &name);
+
+  std::uint32_t add(IrOp op, std::uint32_t a = Ir::NONE, std::uint32_t b = Ir::NONE,
+                    std::int64_t imm = 0);
+  std::uint32_t add_list(IrOp op, const std::vector<std::uint32_t> &items, std::int64_t imm = 0);
+
+  static IrOp binary_op(TokenType type);
+
+  [[noreturn]] void error(std::uint32_t node, const char *format, const char *arg = "");
+};
+
+#endif
@@ -0,0 +1,508 @@
+#include "json.hpp"
+#include "error/error.hpp"
+#include "utf8/utf8.hpp"
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// Reads a JSON text, following RFC 8259. Strings must be valid UTF-8.
+class JsonParser {
+  std::string_view text;
+  std::size_t i;
+  unsigned int depth;
+
+  public:
+  static constexpr unsigned int MAX_DEPTH = 512;
+
+  JsonParser(std::string_view text) : text(text)
+  {
+    this->i     = 0;
+    this->depth = 0;
+  }
+
+  Json parse()
+  {
+    Json value = this->value();
+
+    this->skip();
+    if (this->i != this->text.size())
+      this->fail();
+
+    return value;
+  }
+
+  private:
+  [[noreturn]] void fail()
+  {
+    throw Error("Invalid JSON at offset %s.", std::to_string(this->i).c_str());
+  }
+
+  void skip()
+  {
+    while (this->i < this->text.size()
+           && (this->text[this->i] == ' ' || this->text[this->i] == '\t'
+               || this->text[this->i] == '\n' || this->text[this->i] == '\r'))
+      this->i++;
+  }
+
+  bool next(char c)
+  {
+    this->skip();
+    if (this->i < this->text.size() && this->text[this->i] == c) {
+      this->i++;
+      return true;
+    }
+    return false;
+  }
+
+  void expect(char c)
+  {
+    if (!this->next(c))
+      this->fail();
+  }
+
+  bool word(std::string_view word)
+  {
+    if (this->text.compare(this->i, word.size(), word) != 0)
+      return false;
+    this->i += word.size();
+    return true;
+  }
+
+  Json value()
+  {
+    this->skip();
+    if (this->i == this->text.size())
+      this->fail();
+
+    switch (this->text[this->i]) {
+    case '{':
+      return this->object();
+    case '[':
+      return this->array();
+    case '"':
+      return Json(this->string());
+    case 't':
+      if (this->word("true"))
+        return Json(true);
+      break;
+    case 'f':
+      if (this->word("false"))
+        return Json(false);
+      break;
+    case 'n':
+      if (this->word("null"))
+        return Json();
+      break;
+    default:
+      return this->number();
+    }
+
+    this->fail();
+  }
+
+  Json object()
+  {
+    Json object = Json::object();
+
+    if (++this->depth > MAX_DEPTH)
+      this->fail();
+    this->i++;
+
+    if (!this->next('}')) {
+      do {
+        this->skip();
+        if (this->i == this->text.size() || this->text[this->i] != '"')
+          this->fail();
+        std::string key = this->string();
+
+        this->expect(':');
+        object.set(key, this->value());
+      } while (this->next(','));
+      this->expect('}');
+    }
+
+    this->depth--;
+    return object;
+  }
+
+  Json array()
+  {
+    Json array = Json::array();
+
+    if (++this->depth > MAX_DEPTH)
+      this->fail();
+    this->i++;
+
+    if (!this->next(']')) {
+      do
+        array.push(this->value());
+      while (this->next(','));
+      this->expect(']');
+    }
+
+    this->depth--;
+    return array;
+  }
+
+  // The byte at the cursor, or NUL at the end of the text.
+  char peek() const { return this->i < this->text.size() ? this->text[this->i] : '\0'; }
+
+  Json number()
+  {
+    std::size_t start = this->i;
+
+    this->next('-');
+    if (!std::isdigit((unsigned char)this->peek()))
+      this->fail();
+    if (this->peek() == '0')
+      this->i++;
+    else
+      this->digits();
+
+    if (this->peek() == '.') {
+      this->i++;
+      this->digits();
+    }
+    if (this->peek() == 'e' || this->peek() == 'E') {
+      this->i++;
+      if (this->peek() == '+' || this->peek() == '-')
+        this->i++;
+      this->digits();
+    }
+
+    std::string number(this->text.substr(start, this->i - start));
+    return Json(std::strtod(number.c_str(), nullptr));
+  }
+
+  void digits()
+  {
+    std::size_t start = this->i;
+
+    while (std::isdigit((unsigned char)this->peek()))
+      this->i++;
+    if (this->i == start)
+      this->fail();
+  }
+
+  std::string string()
+  {
+    std::string str;
+    this->i++;
+
+    for (;;) {
+      std::size_t start = this->i;
+      while (this->i < this->text.size() && this->text[this->i] != '"'
+             && this->text[this->i] != '\\' && (unsigned char)this->text[this->i] >= 0x20)
+        this->i++;
+      if (utf8_validate(this->text.data() + start, this->i - start) != this->i - start)
+        this->fail();
+      str.append(this->text.data() + start, this->i - start);
+
+      if (this->i == this->text.size() || (unsigned char)this->text[this->i] < 0x20)
+        this->fail();
+      if (this->text[this->i++] == '"')
+        return str;
+      if (this->i == this->text.size())
+        this->fail();
+
+      switch (this->text[this->i++]) {
+      case '"':
+        str += '"';
+        break;
+      case '\\':
+        str += '\\';
+        break;
+      case '/':
+        str += '/';
+        break;
+      case 'b':
+        str += '\b';
+        break;
+      case 'f':
+        str += '\f';
+        break;
+      case 'n':
+        str += '\n';
+        break;
+      case 'r':
+        str += '\r';
+        break;
+      case 't':
+        str += '\t';
+        break;
+      case 'u':
+        this->escape(str);
+        break;
+      default:
+        this->fail();
+      }
+    }
+  }
+
+  std::uint32_t hex()
+  {
+    std::uint32_t value = 0;
+
+    for (int digit = 0; digit < 4; digit++, this->i++) {
+      char c = this->peek();
+      if (c >= '0' && c <= '9')
+        value = value << 4 | (std::uint32_t)(c - '0');
+      else if (c >= 'a' && c <= 'f')
+        value = value << 4 | (std::uint32_t)(c - 'a' + 10);
+      else if (c >= 'A' && c <= 'F')
+        value = value << 4 | (std::uint32_t)(c - 'A' + 10);
+      else
+        this->fail();
+    }
+
+    return value;
+  }
+
+  // Appends the code point of a \u escape as UTF-8. A surrogate that is not part of a pair
+  // becomes U+FFFD, so that strings are always valid UTF-8.
+  void escape(std::string &str)
+  {
+    std::uint32_t cp = this->hex();
+
+    if (cp >= 0xd800 && cp <= 0xdbff && this->text.compare(this->i, 2, "\\u") == 0) {
+      std::size_t back = this->i;
+      this->i += 2;
+
+      std::uint32_t low = this->hex();
+      if (low >= 0xdc00 && low <= 0xdfff)
+        cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+      else
+        this->i = back;
+    }
+    if (cp >= 0xd800 && cp <= 0xdfff)
+      cp = 0xfffd;
+
+    if (cp < 0x80) {
+      str += (char)cp;
+    } else if (cp < 0x800) {
+      str += (char)(0xc0 | cp >> 6);
+      str += (char)(0x80 | (cp & 0x3f));
+    } else if (cp < 0x10000) {
+      str += (char)(0xe0 | cp >> 12);
+      str += (char)(0x80 | (cp >> 6 & 0x3f));
+      str += (char)(0x80 | (cp & 0x3f));
+    } else {
+      str += (char)(0xf0 | cp >> 18);
+      str += (char)(0x80 | (cp >> 12 & 0x3f));
+      str += (char)(0x80 | (cp >> 6 & 0x3f));
+      str += (char)(0x80 | (cp & 0x3f));
+    }
+  }
+};
+
+Json::Json()
+{
+  this->type    = Kind::J_NULL;
+  this->boolean = false;
+  this->number  = 0;
+}
+
+Json::Json(bool value) : Json()
+{
+  this->type    = Kind::J_BOOL;
+  this->boolean = value;
+}
+
+Json::Json(int value) : Json((double)value) { }
+
+Json::Json(unsigned int value) : Json((double)value) { }
+
+Json::Json(long long value) : Json((double)value) { }
+
+Json::Json(double value) : Json()
+{
+  this->type   = Kind::J_NUMBER;
+  this->number = value;
+}
+
+Json::Json(const char *value) : Json(std::string(value)) { }
+
+Json::Json(std::string value) : Json()
+{
+  this->type = Kind::J_STRING;
+  this->text = std::move(value);
+}
+
+Json Json::array()
+{
+  Json array;
+  array.type = Kind::J_ARRAY;
+  return array;
+}
+
+Json Json::object()
+{
+  Json object;
+  object.type = Kind::J_OBJECT;
+  return object;
+}
+
+Json Json::raw(std::string json)
+{
+  Json raw;
+  raw.type = Kind::J_RAW;
+  raw.text = std::move(json);
+  return raw;
+}
+
+Json Json::parse(std::string_view text) { return JsonParser(text).parse(); }
+
+Json::Kind Json::kind() const { return this->type; }
+
+bool Json::is_null() const { return this->type == Kind::J_NULL; }
+
+bool Json::as_bool() const
+{
+  if (this->type != Kind::J_BOOL)
+    throw Error("Expected a boolean.");
+  return this->boolean;
+}
+
+double Json::as_number() const
+{
+  if (this->type != Kind::J_NUMBER)
+    throw Error("Expected a number.");
+  return this->number;
+}
+
+const std::string &Json::as_string() const
+{
+  if (this->type != Kind::J_STRING)
+    throw Error("Expected a string.");
+  return this->text;
+}
+
+std::size_t Json::size() const { return this->items.size(); }
+
+const Json &Json::operator[](std::size_t index) const { return this->items[index]; }
+
+Json &Json::push(Json value)
+{
+  this->items.push_back(std::move(value));
+  return *this;
+}
+
+const Json &Json::operator[](const std::string &key) const
+{
+  static const Json none;
+
+  for (const std::pair<std::string, Json> &member : this->members) {
+    if (member.first == key)
+      return member.second;
+  }
+
+  return none;
+}
+
+Json &Json::set(const std::string &key, Json value)
+{
+  for (std::pair<std::string, Json> &member : this->members) {
+    if (member.first == key) {
+      member.second = std::move(value);
+      return *this;
+    }
+  }
+
+  this->members.emplace_back(key, std::move(value));
+  return *this;
+}
+
+std::string Json::dump() const
+{
+  std::string out;
+  this->dump(out);
+  return out;
+}
+
+void Json::dump(std::string &out) const
+{
+  char buffer[32];
+
+  switch (this->type) {
+  case Kind::J_NULL:
+    out += "null";
+    break;
+  case Kind::J_BOOL:
+    out += this->boolean ? "true" : "false";
+    break;
+  case Kind::J_NUMBER:
+    // Integers are written without a fraction, as protocols that expect them parse them.
+    if (std::isfinite(this->number) && this->number == std::floor(this->number)
+        && std::fabs(this->number) < 9007199254740992.0)
+      std::snprintf(buffer, sizeof(buffer), "%lld", (long long)this->number);
+    else if (std::isfinite(this->number))
+      std::snprintf(buffer, sizeof(buffer), "%.17g", this->number);
+    else
+      std::snprintf(buffer, sizeof(buffer), "null");
+    out += buffer;
+    break;
+  case Kind::J_STRING:
+    Json::escape(this->text, out);
+    break;
+  case Kind::J_ARRAY:
+    out += '[';
+    for (std::size_t i = 0; i < this->items.size(); i++) {
+      if (i != 0)
+        out += ',';
+      this->items[i].dump(out);
+    }
+    out += ']';
+    break;
+  case Kind::J_OBJECT:
+    out += '{';
+    for (std::size_t i = 0; i < this->members.size(); i++) {
+      if (i != 0)
+        out += ',';
+      Json::escape(this->members[i].first, out);
+      out += ':';
+      this->members[i].second.dump(out);
+    }
+    out += '}';
+    break;
+  case Kind::J_RAW:
+    out += this->text;
+    break;
+  }
+}
+
+void Json::escape(const std::string &str, std::string &out)
+{
+  static const char HEX[] = "0123456789abcdef";
+
+  out += '"';
+  for (char c : str) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      if ((unsigned char)c < 0x20) {
+        out += "\\u00";
+        out += HEX[c >> 4];
+        out += HEX[c & 0xf];
+      } else {
+        out += c;
+      }
+    }
+  }
+  out += '"';
+}
@@ -0,0 +1,79 @@
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// A JSON value, as exchanged with editors. Objects keep their members in the order they were
+// set, and looking up a member that is not there gives null, so that optional fields of a message
+// read as absent rather than throw.
+//
+// A raw value is text that is already JSON, and is dumped as is. It lets a large array, such as
+// semantic tokens, be written without making a value of every element.
+class Json {
+  public:
+  enum class Kind : std::uint8_t {
+    J_NULL,
+    J_BOOL,
+    J_NUMBER,
+    J_STRING,
+    J_ARRAY,
+    J_OBJECT,
+    J_RAW,
+  };
+
+  private:
+  Kind type;
+  bool boolean;
+  double number;
+  std::string text;
+  std::vector<Json> items;
+  std::vector<std::pair<std::string, Json>> members;
+
+  public:
+  Json();
+  Json(bool value);
+  Json(int value);
+  Json(unsigned int value);
+  Json(long long value);
+  Json(double value);
+  Json(const char *value);
+  Json(std::string value);
+
+  static Json array();
+  static Json object();
+  static Json raw(std::string json);
+
+  // Parses a whole JSON text, or throws an Error.
+  static Json parse(std::string_view text);
+
+  Kind kind() const;
+  bool is_null() const;
+
+  // The value as a boolean, number or string, or an Error if it is not one.
+  bool as_bool() const;
+  double as_number() const;
+  const std::string &as_string() const;
+
+  // The elements of an array.
+  std::size_t size() const;
+  const Json &operator[](std::size_t index) const;
+  Json &push(Json value);
+
+  // The members of an object.
+  const Json &operator[](const std::string &key) const;
+  Json &set(const std::string &key, Json value);
+
+  std::string dump() const;
+  void dump(std::string &out) const;
+
+  private:
+  static void escape(const std::string &str, std::string &out);
+};
+
+typedef Json::Kind JsonKind;
+
+#endif
@@ -1,298 +1,412 @@
 #include "lexer.hpp"
+#include "rules.hpp"
+#include "utf8/utf8.hpp"
+#include <cstring>
+#include <string_view>
 
-const char WHITESPACES[5] = " \n\t\r";
-const char DIGITS[11]     = "0123456789";
-const char LETTERS[53]    = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+template <typename Policy>
+BasicLexer<Policy>::BasicLexer(SourceManager &sources, std::uint32_t source) : sources(sources)
+{
+  this->source    = source;
+  this->file      = sources.file(source);
+  this->stream    = nullptr;
+  this->begin     = sources.data(source);
+  this->end       = this->begin + sources.size(source);
+  this->i         = this->begin;
+  this->released  = this->begin;
+  this->validated = false;
 
-bool char_is_in(char c, const char *list);
+  this->line      = 0;
+  this->col       = 1;
+}
 
-Lexer::Lexer(std::string filename, std::string input)
+template <typename Policy>
+BasicLexer<Policy>::BasicLexer(SourceManager &sources, std::uint32_t source, std::istream &stream)
+    : sources(sources)
 {
-  this->filename = filename.c_str();
-  this->input    = input;
-  this->i        = this->input.begin();
+  this->source    = source;
+  this->file      = nullptr;
+  this->stream    = &stream;
+  this->capacity  = BUFFER_SIZE;
+  this->held_size = 0;
+  this->exhausted = false;
+  this->begin     = this->input.c_str();
+  this->end       = this->begin;
+  this->i         = this->begin;
+  this->released  = this->begin;
+  this->validated = true;
 
-  this->row      = 1;
-  this->col      = 1;
+  this->line      = 0;
+  this->col       = 1;
 }
 
-std::vector<Token> Lexer::tokenize()
+template <typename Policy> std::vector<Token> BasicLexer<Policy>::tokenize()
 {
   std::vector<Token> output;
 
-  while (this->i != this->input.end()) {
+  do
+    output.push_back(this->next());
+  while (output.back().type != TokenType::T_EOF);
+
+  return output;
+}
+
+// Validates the whole input up front, RELEASE_SIZE bytes at a time so that the pages of a
+// mapped file can be dropped as soon as they have been checked. Chunks end on the first byte of
+// a sequence so that none is split between two of them.
+template <typename Policy> void BasicLexer<Policy>::validate()
+{
+  for (const char *chunk = this->begin; chunk != this->end;) {
+    const char *last = this->end;
+
+    if ((std::size_t)(this->end - chunk) > RELEASE_SIZE) {
+      last = chunk + RELEASE_SIZE;
+      while (((unsigned char)*last & 0xc0) == 0x80 && last > chunk + RELEASE_SIZE - 3)
+        last--;
+    }
+
+    std::size_t size    = (std::size_t)(last - chunk);
+    std::size_t invalid = utf8_validate(chunk, size);
+    if (invalid != size)
+      this->invalid_utf8(chunk + invalid);
+
+    chunk = last;
+    if (this->file != nullptr)
+      this->file->release((std::size_t)(chunk - this->begin));
+  }
+
+  this->validated = true;
+}
+
+// Lets the pages of a mapped file go once the cursor is RELEASE_SIZE bytes past the last
+// release. Tokens copy their text, so nothing behind the cursor is read again.
+template <typename Policy> void BasicLexer<Policy>::release()
+{
+  if (this->file != nullptr && (std::size_t)(this->i - this->released) >= RELEASE_SIZE) {
+    this->file->release((std::size_t)(this->i - this->begin));
+    this->released = this->i;
+  }
+}
+
+// Moves the unread bytes to the front of the buffer and appends what the stream has next. The
+// bytes of a UTF-8 sequence that may still be incomplete are held back until the following
+// refill, so that [begin, end) is always validated and ends with the NUL sentinel.
+template <typename Policy> void BasicLexer<Policy>::refill()
+{
+  std::size_t offset = (std::size_t)(this->i - this->begin);
+  std::size_t kept   = (std::size_t)(this->end - this->i);
+  if (kept + this->held_size > this->capacity / 2)
+    this->capacity *= 2;
+
+  this->input.resize(this->capacity);
+  std::memmove(&this->input[0], &this->input[offset], kept);
+  std::memcpy(&this->input[kept], this->held, this->held_size);
+
+  std::size_t filled    = kept + this->held_size;
+  std::size_t requested = this->capacity - filled;
+  this->stream->read(&this->input[filled], (std::streamsize)requested);
+
+  std::size_t read = (std::size_t)this->stream->gcount();
+  this->exhausted  = read < requested;
+  filled += read;
+
+  std::size_t last = filled;
+  if (!this->exhausted) {
+    while (last > kept && last + 3 > filled && (this->input[last - 1] & 0xc0) == 0x80)
+      last--;
+    if (last > kept && (unsigned char)this->input[last - 1] >= 0xc0)
+      last--;
+    else
+      last = filled;
+  }
+
+  this->held_size = (unsigned int)(filled - last);
+  std::memcpy(this->held, &this->input[last], this->held_size);
+  this->input.resize(last);
+
+  this->begin = this->input.c_str();
+  this->end   = this->begin + last;
+  this->i     = this->begin;
+
+  std::size_t invalid = utf8_validate(this->begin + kept, last - kept);
+  if (invalid != last - kept)
+    this->invalid_utf8(this->begin + kept + invalid);
+}
+
+// Returns the next token, or T_EOF once the input is exhausted.
+//
+// A streamed input is refilled before each token once fewer than REFILL_SIZE bytes are left. A
+// token that still runs into the end of the buffer may have been cut short, as may an error
+// raised there, so the buffer is refilled and the token lexed again from where it started.
+template <typename Policy> Token BasicLexer<Policy>::next()
+{
+  if (this->stream == nullptr)
+    return this->lex();
+
+  for (;;) {
+    if (!this->exhausted && (std::size_t)(this->end - this->i) < REFILL_SIZE)
+      this->refill();
+
+    const char *start  = this->i;
+    std::uint64_t line = this->line;
+    std::uint64_t col  = this->col;
+
+    try {
+      Token token = this->lex();
+      if (this->exhausted || this->end - this->i > 3)
+        return token;
+    } catch (Error &) {
+      if (this->exhausted || this->end - this->i > 3)
+        throw;
+    }
+
+    this->i    = start;
+    this->line = line;
+    this->col  = col;
+    this->refill();
+  }
+}
+
+// The byte at `end` is always a readable NUL, which lets the single-byte lookaheads below go
+// without bounds checks.
+template <typename Policy> Token BasicLexer<Policy>::lex()
+{
+  TokenType type;
+  unsigned int length;
+
+  if (!this->validated)
+    this->validate();
+
+  while (this->i != this->end) {
+    this->release();
+
+    if constexpr (Policy::TRIVIA) {
+      if (lexer_is_space(*this->i)) {
+        const char *start = this->i;
+        SourceLoc loc     = this->loc(this->col);
+
+        for (; lexer_is_space(*this->i); this->i++) {
+          if (*this->i == '\n')
+            this->newline();
+          else
+            this->column(1);
+        }
+        return this->emit_trivia(TokenType::T_SPACE, start, loc);
+      }
+    }
+
     if (*this->i == '\n') {
       this->i++;
-      this->row++;
-      this->col = 1;
-    } else if (char_is_in(*this->i, WHITESPACES)) {
+      this->newline();
+    } else if (lexer_is_space(*this->i)) {
       this->i++;
-      this->col++;
-    } else if (char_is_in(*this->i, DIGITS)) {
-      output.push_back(this->lex_number());
-    } else if (char_is_in(*this->i, LETTERS) || *this->i == '_') {
-      std::string id("");
-      unsigned int pos = this->col;
-      while (char_is_in(*this->i, LETTERS) || char_is_in(*this->i, DIGITS) || *this->i == '_') {
-        id.push_back(*this->i++);
-        this->col++;
-      }
-      output.push_back(Token(TokenType::T_ID, id, this->row, pos));
+      this->column(1);
+    } else if (lexer_is_digit(*this->i)) {
+      return this->lex_number();
+    } else if (this->id_char(true) != 0) {
+      const char *start = this->i;
+      std::uint64_t pos = this->col;
+      for (; (length = this->id_char(false)) != 0; this->column(1))
+        this->i += length;
+
+      std::string_view id(start, (std::size_t)(this->i - start));
+      if ((type = lexer_keyword(id)) != TokenType::T_ID)
+        return Token(type, this->loc(pos));
+      return this->emit(TokenType::T_ID, Policy::VALUES ? std::string(id) : std::string(), pos);
     } else if (*this->i == '\'') {
-      unsigned int pos = this->col;
+      std::uint64_t pos = this->col;
       this->i++;
-      this->col++;
-      char ch = this->lex_char();
-      this->i++;
-      this->col++;
+      this->column(1);
+      char ch = this->i != this->end ? this->lex_char() : '\0';
+      if (this->i != this->end) {
+        this->i++;
+        this->column(1);
+      }
       if (*this->i != '\'')
-        throw Error(
-            this->filename, this->row, this->col, "Invalid character: \'%c%c\'.", ch, *this->i);
-      output.push_back(Token(TokenType::T_CHAR, std::string(1, ch), this->row, pos));
+        throw Error(this->loc(this->col), "Invalid character: \'%c%c\'.", ch, *this->i);
       this->i++;
-      this->col++;
+      this->column(1);
+      return this->emit(TokenType::T_CHAR, Policy::VALUES ? std::string(1, ch) : std::string(),
+                        pos);
     } else if (*this->i == '\"') {
-      unsigned int pos = this->col;
+      SourceLoc loc = this->loc(this->col);
       std::string str("");
-      while (this->col++, *++this->i != '\"')
-        str.push_back(this->lex_char());
-      output.push_back(Token(TokenType::T_STRING, str, this->row, pos));
-      this->i++;
-      this->col++;
-    } else if (*this->i == '+') {
-      if (*(this->i + 1) == '+') {
-        output.push_back(Token(TokenType::T_INCR, this->row, this->col));
-        this->i += 2;
-        this->col += 2;
-      } else if (*(this->i + 1) == '=') {
-        output.push_back(Token(TokenType::T_ADDASSIGN, this->row, this->col));
-        this->i += 2;
-        this->col += 2;
-      } else {
-        output.push_back(Token(TokenType::T_ADD, this->row, this->col++));
-        this->i++;
-      }
-    } else if (*this->i == '-') {
-      if (*(this->i + 1) == '-') {
-        output.push_back(Token(TokenType::T_DECR, this->row, this->col));
-        this->i += 2;
-        this->col += 2;
-      } else if (*(this->i + 1) == '=') {
-        output.push_back(Token(TokenType::T_SUBASSIGN, this->row, this->col));
-        this->i += 2;
-        this->col += 2;
-      } else {
-        output.push_back(Token(TokenType::T_SUB, this->row, this->col++));
-        this->i++;
-      }
-    } else if (*this->i == '*') {
-      if (*(this->i + 1) == '=') {
-        output.push_back(Token(TokenType::T_MULASSIGN, this->row, this->col));
-        this->i += 2;
-        this->col += 2;
-      } else {
-        output.push_back(Token(TokenType::T_MUL, this->row, this->col++));
-        this->i++;
+      this->column(1);
+      while (++this->i != this->end && *this->i != '\"') {
+        char ch = this->lex_char();
+        if constexpr (Policy::VALUES)
+          str.push_back(ch);
+        if (*this->i == '\n')
+          this->newline();
+        else if ((*this->i & 0xc0) != 0x80)
+          this->column(1);
       }
-    } else if (*this->i == '/') {
+      if (this->i == this->end)
+        throw Error(loc, "Unterminated string.");
+      this->i++;
+      this->column(1);
+      return Token(TokenType::T_STRING, std::move(str), loc);
+    } else if (*this->i == '/' && (*(this->i + 1) == '/' || *(this->i + 1) == '*')) {
+      const char *start = this->i;
+      SourceLoc loc     = Policy::TRIVIA ? this->loc(this->col) : SourceManager::NONE;
+
       if (*(this->i + 1) == '/') {
-        while (this->i != input.end() && *this->i != '\n') {
-          this->i++;
-          this->col++;
+        const char *newline = nullptr;
+        while (newline == nullptr && this->i != this->end) {
+          std::size_t size = (std::size_t)(this->end - this->i);
+          size             = size < RELEASE_SIZE ? size : RELEASE_SIZE;
+
+          newline = (const char *)std::memchr(this->i, '\n', size);
+          if (newline == nullptr) {
+            const char *last = this->i + size;
+            if constexpr (Policy::POSITIONS) {
+              for (; this->i != last; this->i++)
+                this->col += (*this->i & 0xc0) != 0x80;
+            }
+            this->i = last;
+            this->release();
+          }
+        }
+        if (newline != nullptr) {
+          if constexpr (Policy::POSITIONS) {
+            for (; this->i != newline; this->i++)
+              this->col += (*this->i & 0xc0) != 0x80;
+          }
+          this->i = newline;
         }
-      } else if (*(this->i + 1) == '*') {
+      } else {
         while (*this->i != '*' || *(this->i + 1) != '/') {
-          if (this->i == this->input.end())
-            throw Error(this->filename, this->row, this->col, "Unclosed comment.");
-          else if (*this->i == '\n') {
-            this->col = 1;
-            this->row++;
-          } else
-            this->col++;
+          if (this->i == this->end)
+            throw Error(this->loc(this->col), "Unclosed comment.");
+          else if (*this->i == '\n')
+            this->newline();
+          else if ((*this->i & 0xc0) != 0x80)
+            this->column(1);
           this->i++;
         }
-        this->col += 2;
-        this->i += 2;
-      } else if (*(this->i + 1) == '=') {
-        output.push_back(Token(TokenType::T_DIVASSIGN, this->row, this->col));
-        this->i += 2;
-        this->col += 2;
-      } else {
-        output.push_back(Token(TokenType::T_DIV, this->row, this->col++));
-        this->i++;
-      }
-    } else if (*this->i == '%') {
-      if (*(this->i + 1) == '=') {
-        output.push_back(Token(TokenType::T_MODASSIGN, this->row, this->col));
+        this->column(2);
         this->i += 2;
-        this->col += 2;
-      } else {
-        output.push_back(Token(TokenType::T_MOD, this->row, this->col++));
-        this->i++;
       }
-    } else if (*this->i == '&') {
-      if (*(this->i + 1) == '&') {
-        output.push_back(Token(TokenType::T_AND, this->row, this->col));
-        this->i += 2;
-        this->col += 2;
-      } else if (*(this->i + 1) == '=') {
-        output.push_back(Token(TokenType::T_ANDASSIGN, this->row, this->col));
-        this->i += 2;
-        this->col += 2;
-      } else {
-        output.push_back(Token(TokenType::T_BAND, this->row, this->col++));
-        this->i++;
-      }
-    } else if (*this->i == '|') {
-      if (*(this->i + 1) == '|') {
-        output.push_back(Token(TokenType::T_OR, this->row, this->col));
-        this->i += 2;
-        this->col += 2;
-      } else if (*(this->i + 1) == '=') {
-        output.push_back(Token(TokenType::T_ORASSIGN, this->row, this->col));
-        this->i += 2;
-        this->col += 2;
-      } else {
-        output.push_back(Token(TokenType::T_BOR, this->row, this->col++));
-        this->i++;
-      }
-    } else if (*this->i == '^') {
-      if (*(this->i + 1) == '=') {
-        output.push_back(Token(TokenType::T_XORASSIGN, this->row, this->col));
-        this->i += 2;
-        this->col += 2;
-      } else {
-        output.push_back(Token(TokenType::T_BXOR, this->row, this->col++));
-        this->i++;
-      }
-    } else if (*this->i == '~') {
-      output.push_back(Token(TokenType::T_BNOT, this->row, this->col++));
-      this->i++;
-    } else if (*this->i == '=') {
-      if (*(this->i + 1) == '=') {
-        output.push_back(Token(TokenType::T_EQ, this->row, this->col));
-        this->i += 2;
-        this->col += 2;
-      } else {
-        output.push_back(Token(TokenType::T_ASSIGN, this->row, this->col++));
-        this->i++;
-      }
-    } else if (*this->i == '!') {
-      if (*(this->i + 1) == '=') {
-        output.push_back(Token(TokenType::T_NEQ, this->row, this->col));
-        this->i += 2;
-        this->col += 2;
-      } else {
-        output.push_back(Token(TokenType::T_NOT, this->row, this->col++));
-        this->i++;
-      }
-    } else if (*this->i == '>') {
-      if (*(this->i + 1) == '=') {
-        output.push_back(Token(TokenType::T_GEQ, this->row, this->col));
-        this->i += 2;
-        this->col += 2;
-      } else {
-        output.push_back(Token(TokenType::T_GT, this->row, this->col++));
-        this->i++;
-      }
-    } else if (*this->i == '<') {
-      if (*(this->i + 1) == '=') {
-        output.push_back(Token(TokenType::T_LEQ, this->row, this->col));
-        this->i += 2;
-        this->col += 2;
-      } else {
-        output.push_back(Token(TokenType::T_LT, this->row, this->col++));
-        this->i++;
-      }
-    } else if (*this->i == '.') {
-      if (*(this->i + 1) == '.' && *(this->i + 2) == '.') {
-        output.push_back(Token(TokenType::T_ELLIPSIS, this->row, this->col));
-        this->i += 3;
-        this->col += 3;
-      } else {
-        output.push_back(Token(TokenType::T_POINT, this->row, this->col++));
-        this->i++;
-      }
-    } else if (*this->i == ',') {
-      output.push_back(Token(TokenType::T_COMMA, this->row, this->col++));
-      this->i++;
-    } else if (*this->i == ':') {
-      output.push_back(Token(TokenType::T_COLON, this->row, this->col++));
-      this->i++;
-    } else if (*this->i == ';') {
-      output.push_back(Token(TokenType::T_SEMICOLON, this->row, this->col++));
-      this->i++;
-    } else if (*this->i == '?') {
-      output.push_back(Token(TokenType::T_QMARK, this->row, this->col++));
-      this->i++;
-    } else if (*this->i == '(') {
-      output.push_back(Token(TokenType::T_LPAREN, this->row, this->col++));
-      this->i++;
-    } else if (*this->i == ')') {
-      output.push_back(Token(TokenType::T_RPAREN, this->row, this->col++));
-      this->i++;
-    } else if (*this->i == '{') {
-      output.push_back(Token(TokenType::T_LCURLY, this->row, this->col++));
-      this->i++;
-    } else if (*this->i == '}') {
-      output.push_back(Token(TokenType::T_RCURLY, this->row, this->col++));
-      this->i++;
-    } else if (*this->i == '[') {
-      output.push_back(Token(TokenType::T_LBRACKET, this->row, this->col++));
-      this->i++;
-    } else if (*this->i == ']') {
-      output.push_back(Token(TokenType::T_RBRACKET, this->row, this->col++));
-      this->i++;
+
+      if constexpr (Policy::TRIVIA)
+        return this->emit_trivia(TokenType::T_COMMENT, start, loc);
+    } else if ((type = lexer_operator(this->i, length)) != TokenType::T_EOF) {
+      return this->emit(type, length);
+    } else if (*this->i & 0x80) {
+      utf8_decode(this->i, length);
+      throw Error(this->loc(this->col), "Unexpected token: %s",
+                  std::string(this->i, this->i + length).c_str());
     } else
-      throw Error(this->filename, this->row, this->col, "Unexpected token: %c", *this->i);
+      throw Error(this->loc(this->col), "Unexpected token: %c", *this->i);
   }
 
-  output.push_back(Token(TokenType::T_EOF, this->row, this->col));
+  return Token(TokenType::T_EOF, this->loc(this->col));
+}
 
-  return output;
+template <typename Policy> SourceLoc BasicLexer<Policy>::location() { return this->loc(this->col); }
+
+template <typename Policy> SourceLoc BasicLexer<Policy>::loc(std::uint64_t col)
+{
+  if constexpr (!Policy::POSITIONS)
+    return SourceManager::NONE;
+  else if (this->stream != nullptr)
+    return this->sources.locate(this->source, this->line + 1, col);
+  else
+    return this->sources.locate(this->source, this->line + col - 1);
 }
 
-Token Lexer::lex_number()
+// Moves past a line break. Lines start at the code point after the break, and the source manager
+// learns about every one of them so that locations can be resolved later. A streamed source only
+// counts its lines instead, so that it is lexed in constant memory.
+template <typename Policy> void BasicLexer<Policy>::newline()
+{
+  if constexpr (Policy::POSITIONS) {
+    if (this->stream != nullptr) {
+      this->line++;
+    } else {
+      this->line += this->col;
+      this->sources.add_line(this->source, this->line);
+    }
+    this->col = 1;
+  }
+}
+
+// Moves the column `count` code points on, when positions are tracked.
+template <typename Policy> void BasicLexer<Policy>::column(std::uint64_t count)
+{
+  if constexpr (Policy::POSITIONS)
+    this->col += count;
+}
+
+template <typename Policy> Token BasicLexer<Policy>::emit(TokenType type, unsigned int length)
+{
+  Token token(type, this->loc(this->col));
+
+  this->i += length;
+  this->column(length);
+
+  return token;
+}
+
+// A token with a value, which is left empty by a lexer without values, starting at column `col`.
+template <typename Policy>
+Token BasicLexer<Policy>::emit(TokenType type, std::string value, std::uint64_t col)
+{
+  return Token(type, std::move(value), this->loc(col));
+}
+
+// The comment or whitespace from `start` to the cursor, found at `loc`.
+template <typename Policy>
+Token BasicLexer<Policy>::emit_trivia(TokenType type, const char *start, SourceLoc loc)
+{
+  if constexpr (Policy::VALUES)
+    return Token(type, std::string(start, this->i), loc);
+  else
+    return Token(type, loc);
+}
+
+template <typename Policy> Token BasicLexer<Policy>::lex_number()
 {
   std::string num("");
-  unsigned int pos = this->col;
+  std::uint64_t pos = this->col;
+
+  auto take = [&] {
+    if constexpr (Policy::VALUES)
+      num.push_back(*this->i);
+    this->i++;
+    this->column(1);
+  };
 
   if (*this->i == '0') {
     if (*(this->i + 1) == 'x') {
-      this->i += 2;
-      this->col += 2;
-
-      num = "0x";
+      take();
+      take();
 
       while (true) {
         if (*this->i == '\'') {
           this->i++;
-          this->col++;
-        } else if (char_is_in(*this->i, WHITESPACES) || this->i == this->input.end()) {
-          return Token(TokenType::T_NUMBER, num, this->row, pos);
-        } else if (char_is_in(*this->i, DIGITS) || char_is_in(*this->i, "ABCDEFabcdef")) {
-          num.push_back(*this->i++);
-          this->col++;
+          this->column(1);
+        } else if (lexer_is_hex_digit(*this->i)) {
+          take();
+        } else if (lexer_ends_number(*this->i) || this->i == this->end) {
+          return this->emit(TokenType::T_NUMBER, std::move(num), pos);
         } else
-          throw Error(this->filename, this->row, this->col, "Unexpected token: %c", *this->i);
+          throw Error(this->loc(this->col), "Unexpected token: %c", *this->i);
       }
     } else if (*(this->i + 1) == 'b') {
-      this->i += 2;
-      this->col += 2;
-
-      num = "0b";
+      take();
+      take();
 
       while (true) {
         if (*this->i == '\'') {
           this->i++;
-          this->col++;
-        } else if (char_is_in(*this->i, WHITESPACES) || this->i == this->input.end()) {
-          return Token(TokenType::T_NUMBER, num, this->row, pos);
+          this->column(1);
         } else if (*this->i == '0' || *this->i == '1') {
-          num.push_back(*this->i++);
-          this->col++;
+          take();
+        } else if (lexer_ends_number(*this->i) || this->i == this->end) {
+          return this->emit(TokenType::T_NUMBER, std::move(num), pos);
         } else
-          throw Error(this->filename, this->row, this->col, "Unexpected token: %c", *this->i);
+          throw Error(this->loc(this->col), "Unexpected token: %c", *this->i);
       }
     }
   }
@@ -301,69 +415,53 @@ Token Lexer::lex_number()
   while (true) {
     if (*this->i == '\'') {
       this->i++;
-      this->col++;
-    } else if (char_is_in(*this->i, WHITESPACES) || this->i == this->input.end()) {
-      return Token(TokenType::T_NUMBER, num, this->row, pos);
+      this->column(1);
+    } else if (lexer_ends_number(*this->i) || this->i == this->end) {
+      return this->emit(TokenType::T_NUMBER, std::move(num), pos);
     } else if (*this->i == '.') {
       if (has_p)
-        throw Error(this->filename, this->row, this->col, "Unexpected token: %c", *this->i);
+        throw Error(this->loc(this->col), "Unexpected token: %c", *this->i);
 
       has_p = true;
-      num.push_back(*this->i++);
-      this->col++;
-    } else if (char_is_in(*this->i, DIGITS)) {
-      num.push_back(*this->i++);
-      this->col++;
+      take();
+    } else if (lexer_is_digit(*this->i)) {
+      take();
     } else
-      throw Error(this->filename, this->row, this->col, "Unexpected token: %c", *this->i);
+      throw Error(this->loc(this->col), "Unexpected token: %c", *this->i);
   }
 
-  return Token(TokenType::T_NUMBER, num, row, pos);
+  return this->emit(TokenType::T_NUMBER, std::move(num), pos);
 }
 
-char Lexer::lex_char()
+template <typename Policy> char BasicLexer<Policy>::lex_char()
 {
-  if (*this->i == '\\') {
+  if (*this->i == '\\' && this->i + 1 != this->end) {
     this->i++;
-    this->col++;
-    switch (*this->i) {
-    case 'a':
-      return '\a';
-    case 'b':
-      return '\b';
-    case 'e':
-      return '\x1B';
-    case 'f':
-      return '\f';
-    case 'n':
-      return '\n';
-    case 'r':
-      return '\r';
-    case 't':
-      return '\t';
-    case 'v':
-      return '\v';
-    case '\\':
-      return '\\';
-    case '\'':
-      return '\'';
-    case '\"':
-      return '\"';
-    case '\?':
-      return '\?';
-    default:
-      return *this->i;
-    }
+    this->column(1);
+    return lexer_escape(*this->i);
   }
 
   return *this->i;
 }
 
-bool char_is_in(char c, const char *list)
+// Length of the identifier character at the current position, or 0 if there is none.
+template <typename Policy> unsigned int BasicLexer<Policy>::id_char(bool start)
 {
-  for (int i = 0; i < strlen(list); i++) {
-    if (c == list[i])
-      return true;
+  return lexer_id_char(this->i, this->end, start);
+}
+
+template <typename Policy> void BasicLexer<Policy>::invalid_utf8(const char *at)
+{
+  for (; this->i != at; this->i++) {
+    if (*this->i == '\n')
+      this->newline();
+    else if ((*this->i & 0xc0) != 0x80)
+      this->column(1);
   }
-  return false;
+
+  throw Error(this->loc(this->col), "Invalid UTF-8 sequence.");
 }
+
+template class BasicLexer<LexerPolicy>;
+template class BasicLexer<TriviaLexerPolicy>;
+template class BasicLexer<BareLexerPolicy>;
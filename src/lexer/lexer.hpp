@@ -2,28 +2,97 @@
 #define LEXER_HPP
 
 #include "error/error.hpp"
+#include "file/file.hpp"
+#include "source/source.hpp"
 #include "token/token.hpp"
+#include <cstdint>
+#include <istream>
 #include <string>
 #include <vector>
 
-class Lexer {
-  const char *filename;
+// What a lexer does besides finding the tokens, fixed at compile time so that every variant only
+// does the work its consumer needs. The default is what the compiler needs.
+struct LexerPolicy {
+  // Tokens carry their location, and the source manager learns where lines start. Without it,
+  // tokens and errors have no location.
+  static constexpr bool POSITIONS = true;
+  // Comments and runs of whitespace are kept as T_COMMENT and T_SPACE tokens, as for a formatter.
+  static constexpr bool TRIVIA = false;
+  // Identifiers and literals carry their decoded text. Keywords are told apart either way.
+  static constexpr bool VALUES = true;
+};
+
+// Keeps the comments and whitespace between the tokens.
+struct TriviaLexerPolicy : LexerPolicy {
+  static constexpr bool TRIVIA = true;
+};
+
+// Only finds the types of the tokens, such as to check that a source lexes.
+struct BareLexerPolicy : LexerPolicy {
+  static constexpr bool POSITIONS = false;
+  static constexpr bool VALUES    = false;
+};
+
+// The variants are instantiated in lexer.cpp for the policies above.
+template <typename Policy> class BasicLexer {
+  SourceManager &sources;
+  std::uint32_t source;
   std::string input;
+  const File *file;
+
+  std::istream *stream;
+  std::size_t capacity;
+  char held[4];
+  unsigned int held_size;
+  bool exhausted;
 
-  std::string::iterator i;
+  const char *begin;
+  const char *end;
+  const char *i;
+  const char *released;
+  bool validated;
 
-  unsigned int row;
-  unsigned int col;
+  // The offset at which the current line starts, or for a streamed source the number of lines
+  // before it.
+  std::uint64_t line;
+  std::uint64_t col;
 
   public:
-  Lexer(std::string filename, std::string input);
+  static constexpr std::size_t RELEASE_SIZE = 64 << 20;
+  static constexpr std::size_t BUFFER_SIZE  = 64 << 10;
+  static constexpr std::size_t REFILL_SIZE  = 4 << 10;
+
+  // Lexes a source of `sources` in place.
+  BasicLexer(SourceManager &sources, std::uint32_t source);
+  // Lexes `stream`, registered in `sources` with add_stream(), through a buffer of BUFFER_SIZE
+  // bytes, which only grows to hold a token or comment longer than that; the stream must
+  // outlive the lexer.
+  BasicLexer(SourceManager &sources, std::uint32_t source, std::istream &stream);
 
   std::vector<Token> tokenize();
+  Token next();
+  // Where the next token starts, which with trivia kept is where the last one ended.
+  SourceLoc location();
 
   private:
+  Token lex();
+  SourceLoc loc(std::uint64_t col);
+  void newline();
+  void column(std::uint64_t count);
+  Token emit(TokenType type, unsigned int length);
+  Token emit(TokenType type, std::string value, std::uint64_t col);
+  Token emit_trivia(TokenType type, const char *start, SourceLoc loc);
   Token lex_number();
 
   char lex_char();
+
+  void validate();
+  void release();
+  void refill();
+  unsigned int id_char(bool start);
+  [[noreturn]] void invalid_utf8(const char *at);
 };
 
+typedef BasicLexer<LexerPolicy> Lexer;
+
 #endif
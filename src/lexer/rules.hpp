@@ -0,0 +1,227 @@
+#ifndef RULES_HPP
+#define RULES_HPP
+
+#include "token/token.hpp"
+#include "utf8/utf8.hpp"
+#include "utf8/xid.hpp"
+#include <string_view>
+
+// The lexical rules of tela, shared by the lexer and by the snippets lexed at compile time. They
+// are all constexpr, and lookaheads past the current byte rely on the input ending with a NUL.
+
+struct LexerKeyword {
+  std::string_view str;
+  TokenType type;
+};
+
+inline constexpr LexerKeyword LEXER_KEYWORDS[] = {
+  { "fn", TokenType::T_FN },
+  { "let", TokenType::T_LET },
+  { "if", TokenType::T_IF },
+  { "else", TokenType::T_ELSE },
+  { "while", TokenType::T_WHILE },
+  { "return", TokenType::T_RETURN },
+  { "import", TokenType::T_IMPORT },
+};
+
+constexpr bool lexer_is_space(char c) { return c == ' ' || c == '\n' || c == '\t' || c == '\r'; }
+
+constexpr bool lexer_is_digit(char c) { return c >= '0' && c <= '9'; }
+
+constexpr bool lexer_is_hex_digit(char c)
+{
+  return lexer_is_digit(c) || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f');
+}
+
+constexpr bool lexer_is_letter(char c) { return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'); }
+
+constexpr bool lexer_ends_number(char c)
+{
+  return !lexer_is_letter(c) && !lexer_is_digit(c) && c != '_' && c != '.' && c != '\''
+      && !(c & 0x80);
+}
+
+// The keyword spelled `id`, or T_ID.
+constexpr TokenType lexer_keyword(std::string_view id)
+{
+  for (const LexerKeyword &keyword : LEXER_KEYWORDS) {
+    if (id == keyword.str)
+      return keyword.type;
+  }
+  return TokenType::T_ID;
+}
+
+// The character that `\c` stands for in a character or string literal.
+constexpr char lexer_escape(char c)
+{
+  switch (c) {
+  case 'a':
+    return '\a';
+  case 'b':
+    return '\b';
+  case 'e':
+    return '\x1B';
+  case 'f':
+    return '\f';
+  case 'n':
+    return '\n';
+  case 'r':
+    return '\r';
+  case 't':
+    return '\t';
+  case 'v':
+    return '\v';
+  default:
+    return c;
+  }
+}
+
+// Length of the identifier character at `at`, or 0 if there is none. ASCII is classified inline;
+// anything else, which must be valid UTF-8, is decoded and looked up in the XID tables.
+constexpr unsigned int lexer_id_char(const char *at, const char *end, bool start)
+{
+  if (at == end)
+    return 0;
+
+  char c = *at;
+  if (!(c & 0x80))
+    return lexer_is_letter(c) || c == '_' || (!start && lexer_is_digit(c)) ? 1 : 0;
+
+  unsigned int length = 0;
+  std::uint32_t cp    = utf8_decode(at, length);
+
+  if (start)
+    return utf8_in_ranges(XID_START, cp) ? length : 0;
+  return utf8_in_ranges(XID_CONTINUE, cp) ? length : 0;
+}
+
+// The operator or punctuation at `at`, taking the longest match, with its length stored in
+// `length`, or T_EOF if there is none. Comments are left to the caller.
+constexpr TokenType lexer_operator(const char *at, unsigned int &length)
+{
+  char next = at[0] != '\0' ? at[1] : '\0';
+  length    = 2;
+
+  switch (at[0]) {
+  case '+':
+    if (next == '+')
+      return TokenType::T_INCR;
+    if (next == '=')
+      return TokenType::T_ADDASSIGN;
+    break;
+  case '-':
+    if (next == '-')
+      return TokenType::T_DECR;
+    if (next == '=')
+      return TokenType::T_SUBASSIGN;
+    break;
+  case '*':
+    if (next == '=')
+      return TokenType::T_MULASSIGN;
+    break;
+  case '/':
+    if (next == '=')
+      return TokenType::T_DIVASSIGN;
+    break;
+  case '%':
+    if (next == '=')
+      return TokenType::T_MODASSIGN;
+    break;
+  case '&':
+    if (next == '&')
+      return TokenType::T_AND;
+    if (next == '=')
+      return TokenType::T_ANDASSIGN;
+    break;
+  case '|':
+    if (next == '|')
+      return TokenType::T_OR;
+    if (next == '=')
+      return TokenType::T_ORASSIGN;
+    break;
+  case '^':
+    if (next == '=')
+      return TokenType::T_XORASSIGN;
+    break;
+  case '=':
+    if (next == '=')
+      return TokenType::T_EQ;
+    break;
+  case '!':
+    if (next == '=')
+      return TokenType::T_NEQ;
+    break;
+  case '>':
+    if (next == '=')
+      return TokenType::T_GEQ;
+    break;
+  case '<':
+    if (next == '=')
+      return TokenType::T_LEQ;
+    break;
+  case '.':
+    if (next == '.' && at[2] == '.') {
+      length = 3;
+      return TokenType::T_ELLIPSIS;
+    }
+    break;
+  }
+
+  length = 1;
+
+  switch (at[0]) {
+  case '+':
+    return TokenType::T_ADD;
+  case '-':
+    return TokenType::T_SUB;
+  case '*':
+    return TokenType::T_MUL;
+  case '/':
+    return TokenType::T_DIV;
+  case '%':
+    return TokenType::T_MOD;
+  case '&':
+    return TokenType::T_BAND;
+  case '|':
+    return TokenType::T_BOR;
+  case '^':
+    return TokenType::T_BXOR;
+  case '~':
+    return TokenType::T_BNOT;
+  case '=':
+    return TokenType::T_ASSIGN;
+  case '!':
+    return TokenType::T_NOT;
+  case '>':
+    return TokenType::T_GT;
+  case '<':
+    return TokenType::T_LT;
+  case '.':
+    return TokenType::T_POINT;
+  case ',':
+    return TokenType::T_COMMA;
+  case ':':
+    return TokenType::T_COLON;
+  case ';':
+    return TokenType::T_SEMICOLON;
+  case '?':
+    return TokenType::T_QMARK;
+  case '(':
+    return TokenType::T_LPAREN;
+  case ')':
+    return TokenType::T_RPAREN;
+  case '{':
+    return TokenType::T_LCURLY;
+  case '}':
+    return TokenType::T_RCURLY;
+  case '[':
+    return TokenType::T_LBRACKET;
+  case ']':
+    return TokenType::T_RBRACKET;
+  default:
+    length = 0;
+    return TokenType::T_EOF;
+  }
+}
+
+#endif
@@ -0,0 +1,303 @@
+#ifndef SNIPPET_HPP
+#define SNIPPET_HPP
+
+#include "error/error.hpp"
+#include "rules.hpp"
+#include "source/source.hpp"
+#include "token/token.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A token lexed at compile time. Its value is `length` bytes at `value` in the text of its
+// snippet, and `offset` is the number of code points before it.
+struct SnippetToken {
+  TokenType type;
+  std::uint32_t value;
+  std::uint32_t length;
+  std::uint32_t offset;
+};
+
+struct SnippetSize {
+  std::size_t tokens;
+  std::size_t lines;
+};
+
+// The tokens of a string literal of M bytes, lexed at compile time by snippet_lex() with room for
+// N tokens and L lines after the first. Values are decoded as the lexer would, so they take at
+// most as many bytes as the literal.
+//
+// A snippet that failed to lex keeps its first error; it is raised by tokenize(), so a snippet
+// lexed at run time behaves like the lexer. TELA_SNIPPET() fails the build instead.
+template <std::size_t N, std::size_t L, std::size_t M> struct Snippet {
+  const char *source;
+  SnippetToken tokens[N > 0 ? N : 1];
+  std::uint32_t lines[L > 0 ? L : 1];
+  char text[M];
+  SnippetSize size;
+
+  const char *error;
+  std::uint32_t error_offset;
+
+  constexpr bool ok() const { return this->error == nullptr; }
+
+  // Registers the snippet in `sources` as `path`, so that errors in it can be located, and
+  // returns its tokens as the lexer would.
+  std::vector<Token> tokenize(SourceManager &sources, std::string path) const
+  {
+    std::uint32_t buffer = sources.add(std::move(path), std::string(this->source, M - 1));
+    std::vector<Token> output;
+
+    for (std::size_t i = 0; i < this->size.lines; i++)
+      sources.add_line(buffer, this->lines[i]);
+    if (this->error != nullptr)
+      throw Error(sources.locate(buffer, this->error_offset), "%s", this->error);
+
+    output.reserve(this->size.tokens);
+    for (std::size_t i = 0; i < this->size.tokens; i++) {
+      const SnippetToken &token = this->tokens[i];
+      output.emplace_back(token.type, std::string(this->text + token.value, token.length),
+                          sources.locate(buffer, token.offset));
+    }
+
+    return output;
+  }
+};
+
+// Follows Lexer::lex() over a literal, which ends with the NUL its lookaheads rely on. With N
+// and L of 0, tokens and lines are only counted.
+template <std::size_t N, std::size_t L, std::size_t M> class SnippetLexer {
+  Snippet<N, L, M> snippet;
+  const char *end;
+  const char *i;
+  std::uint32_t offset;
+  std::uint32_t text;
+
+  public:
+  constexpr SnippetLexer(const char (&source)[M])
+      : snippet{}, end(source + M - 1), i(source), offset(0), text(0)
+  {
+    this->snippet.source = source;
+  }
+
+  constexpr Snippet<N, L, M> tokenize()
+  {
+    if (this->validate()) {
+      while (this->snippet.ok()) {
+        TokenType type = this->lex();
+        if (type == TokenType::T_EOF)
+          break;
+      }
+    }
+
+    return this->snippet;
+  }
+
+  private:
+  constexpr bool validate()
+  {
+    for (const char *at = this->i; at != this->end;) {
+      unsigned int length = *at & 0x80 ? utf8_length(at, (std::size_t)(this->end - at)) : 1;
+      if (length == 0) {
+        this->skip(at);
+        return this->fail("Invalid UTF-8 sequence.");
+      }
+      at += length;
+    }
+
+    return true;
+  }
+
+  // Moves to `to`, counting code points and lines on the way.
+  constexpr void skip(const char *to)
+  {
+    for (; this->i != to; this->i++) {
+      if ((*this->i & 0xc0) != 0x80)
+        this->offset++;
+      if (*this->i == '\n')
+        this->newline();
+    }
+  }
+
+  constexpr void newline()
+  {
+    if (L != 0 && this->snippet.size.lines == L) {
+      this->fail("Too many lines.");
+      return;
+    }
+
+    if constexpr (L != 0) {
+      this->snippet.lines[this->snippet.size.lines] = this->offset;
+    }
+    this->snippet.size.lines++;
+  }
+
+  constexpr bool fail(const char *message)
+  {
+    if (this->snippet.error == nullptr) {
+      this->snippet.error        = message;
+      this->snippet.error_offset = this->offset;
+    }
+    return false;
+  }
+
+  // Adds a token starting at `start`, whose value is the text from `value` on.
+  constexpr TokenType emit(TokenType type, std::uint32_t start, std::uint32_t value)
+  {
+    if (N != 0 && this->snippet.size.tokens == N) {
+      this->fail("Too many tokens.");
+      return TokenType::T_EOF;
+    }
+
+    if constexpr (N != 0) {
+      this->snippet.tokens[this->snippet.size.tokens] = { type, value, this->text - value, start };
+    }
+    this->snippet.size.tokens++;
+
+    return type;
+  }
+
+  constexpr void append(char c) { this->snippet.text[this->text++] = c; }
+
+  constexpr TokenType lex()
+  {
+    while (this->i != this->end) {
+      std::uint32_t start = this->offset;
+      std::uint32_t value = this->text;
+      unsigned int length = 0;
+      TokenType type      = TokenType::T_EOF;
+
+      if (lexer_is_space(*this->i)) {
+        this->skip(this->i + 1);
+      } else if (lexer_is_digit(*this->i)) {
+        return this->lex_number();
+      } else if (lexer_id_char(this->i, this->end, true) != 0) {
+        while ((length = lexer_id_char(this->i, this->end, false)) != 0) {
+          for (unsigned int byte = 0; byte < length; byte++)
+            this->append(this->i[byte]);
+          this->skip(this->i + length);
+        }
+
+        type = lexer_keyword(std::string_view(this->snippet.text + value, this->text - value));
+        if (type != TokenType::T_ID)
+          this->text = value;
+        return this->emit(type, start, value);
+      } else if (*this->i == '\'') {
+        this->skip(this->i + 1);
+        this->append(this->i != this->end ? this->lex_char() : '\0');
+        if (this->i != this->end)
+          this->skip(this->i + 1);
+        if (*this->i != '\'') {
+          this->fail("Invalid character.");
+          return TokenType::T_EOF;
+        }
+        this->skip(this->i + 1);
+        return this->emit(TokenType::T_CHAR, start, value);
+      } else if (*this->i == '\"') {
+        this->skip(this->i + 1);
+        while (this->i != this->end && *this->i != '\"') {
+          this->append(this->lex_char());
+          this->skip(this->i + 1);
+        }
+        if (this->i == this->end) {
+          this->offset = start;
+          this->fail("Unterminated string.");
+          return TokenType::T_EOF;
+        }
+        this->skip(this->i + 1);
+        return this->emit(TokenType::T_STRING, start, value);
+      } else if (*this->i == '/' && this->i[1] == '/') {
+        while (this->i != this->end && *this->i != '\n')
+          this->skip(this->i + 1);
+      } else if (*this->i == '/' && this->i[1] == '*') {
+        while (*this->i != '*' || this->i[1] != '/') {
+          if (this->i == this->end) {
+            this->fail("Unclosed comment.");
+            return TokenType::T_EOF;
+          }
+          this->skip(this->i + 1);
+        }
+        this->skip(this->i + 2);
+      } else if ((type = lexer_operator(this->i, length)) != TokenType::T_EOF) {
+        this->skip(this->i + length);
+        return this->emit(type, start, value);
+      } else {
+        this->fail("Unexpected token.");
+        return TokenType::T_EOF;
+      }
+    }
+
+    this->emit(TokenType::T_EOF, this->offset, this->text);
+    return TokenType::T_EOF;
+  }
+
+  constexpr TokenType lex_number()
+  {
+    std::uint32_t start = this->offset;
+    std::uint32_t value = this->text;
+    bool hex            = this->i[0] == '0' && this->i[1] == 'x';
+    bool binary         = this->i[0] == '0' && this->i[1] == 'b';
+    bool point          = false;
+
+    if (hex || binary) {
+      this->append(this->i[0]);
+      this->append(this->i[1]);
+      this->skip(this->i + 2);
+    }
+
+    for (;;) {
+      char c = *this->i;
+
+      if (c == '\'') {
+        this->skip(this->i + 1);
+        continue;
+      } else if (lexer_ends_number(c) || this->i == this->end) {
+        return this->emit(TokenType::T_NUMBER, start, value);
+      } else if (hex ? lexer_is_hex_digit(c)
+                     : binary ? c == '0' || c == '1' : lexer_is_digit(c) || (c == '.' && !point)) {
+        point = point || c == '.';
+        this->append(c);
+        this->skip(this->i + 1);
+      } else {
+        this->fail("Unexpected token.");
+        return TokenType::T_EOF;
+      }
+    }
+  }
+
+  constexpr char lex_char()
+  {
+    if (*this->i == '\\' && this->i + 1 != this->end) {
+      this->skip(this->i + 1);
+      return lexer_escape(*this->i);
+    }
+
+    return *this->i;
+  }
+};
+
+// Lexes `source` at compile time, with room for N tokens and L lines.
+template <std::size_t N, std::size_t L, std::size_t M>
+constexpr Snippet<N, L, M> snippet_lex(const char (&source)[M])
+{
+  return SnippetLexer<N, L, M>(source).tokenize();
+}
+
+// The room that snippet_lex() needs for `source`.
+template <std::size_t M> constexpr SnippetSize snippet_size(const char (&source)[M])
+{
+  return SnippetLexer<0, 0, M>(source).tokenize().size;
+}
+
+// The tokens of a tela string literal, lexed at compile time. A lexical error fails the build.
+#define TELA_SNIPPET(source)                                                                   \
+  ([] {                                                                                        \
+    constexpr SnippetSize size = snippet_size(source);                                         \
+    constexpr auto snippet     = snippet_lex<size.tokens, size.lines>(source);                 \
+    static_assert(snippet.ok(), "Lexical error in tela snippet " #source);                     \
+    return snippet;                                                                            \
+  }())
+
+#endif
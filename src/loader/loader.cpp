@@ -0,0 +1,458 @@
+#include "loader.hpp"
+#include "error/error.hpp"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define TELA_URING 1
+#endif
+#endif
+
+#ifndef TELA_URING
+#define TELA_URING 0
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TELA_PREAD 1
+#else
+#define TELA_PREAD 0
+#endif
+
+#if TELA_URING
+enum Operation {
+  O_OPEN,
+  O_STATX,
+  O_READ,
+  O_CLOSE,
+};
+
+struct Loader::Ring {
+  struct Pending {
+    int fd;
+    unsigned int waiting;
+    const char *error;
+
+    struct statx stat;
+    std::string contents;
+    std::size_t done;
+    std::uint32_t asked;
+  };
+
+  int fd;
+  void *sq_ring;
+  std::size_t sq_size;
+  void *cq_ring;
+  std::size_t cq_size;
+  io_uring_sqe *sqes;
+  std::size_t sqes_size;
+
+  unsigned int *sq_head;
+  unsigned int *sq_tail;
+  unsigned int sq_mask;
+  unsigned int sq_entries;
+  unsigned int *sq_array;
+  unsigned int *cq_head;
+  unsigned int *cq_tail;
+  unsigned int cq_mask;
+  io_uring_cqe *cqes;
+
+  unsigned int queued;
+  unsigned int inflight;
+  unsigned int active;
+  std::vector<Pending> files;
+
+  Ring() : fd(-1), sq_ring(MAP_FAILED), cq_ring(MAP_FAILED), sqes((io_uring_sqe *)MAP_FAILED) { }
+
+  ~Ring()
+  {
+    if (this->sqes != MAP_FAILED)
+      munmap(this->sqes, this->sqes_size);
+    if (this->cq_ring != MAP_FAILED && this->cq_ring != this->sq_ring)
+      munmap(this->cq_ring, this->cq_size);
+    if (this->sq_ring != MAP_FAILED)
+      munmap(this->sq_ring, this->sq_size);
+    if (this->fd >= 0)
+      close(this->fd);
+  }
+
+  // Sets up a ring with room for two operations per file of the window. Rings that predate
+  // IORING_FEAT_FAST_POLL (Linux 5.7) are refused, since they may lack the openat, statx and
+  // close operations.
+  bool setup()
+  {
+    io_uring_params params = {};
+
+    this->fd = (int)syscall(__NR_io_uring_setup, 2 * WINDOW, &params);
+    if (this->fd < 0 || !(params.features & IORING_FEAT_FAST_POLL))
+      return false;
+
+    this->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    this->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+      this->sq_size = this->sq_size > this->cq_size ? this->sq_size : this->cq_size;
+      this->cq_size = this->sq_size;
+    }
+
+    this->sq_ring = mmap(nullptr, this->sq_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_SQ_RING);
+    if (this->sq_ring == MAP_FAILED)
+      return false;
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+      this->cq_ring = this->sq_ring;
+    else {
+      this->cq_ring = mmap(nullptr, this->cq_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_CQ_RING);
+      if (this->cq_ring == MAP_FAILED)
+        return false;
+    }
+
+    this->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    this->sqes      = (io_uring_sqe *)mmap(nullptr, this->sqes_size, PROT_READ | PROT_WRITE,
+                                           MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_SQES);
+    if (this->sqes == MAP_FAILED)
+      return false;
+
+    char *sq = (char *)this->sq_ring;
+    char *cq = (char *)this->cq_ring;
+
+    this->sq_head    = (unsigned int *)(sq + params.sq_off.head);
+    this->sq_tail    = (unsigned int *)(sq + params.sq_off.tail);
+    this->sq_mask    = *(unsigned int *)(sq + params.sq_off.ring_mask);
+    this->sq_entries = *(unsigned int *)(sq + params.sq_off.ring_entries);
+    this->sq_array   = (unsigned int *)(sq + params.sq_off.array);
+    this->cq_head    = (unsigned int *)(cq + params.cq_off.head);
+    this->cq_tail    = (unsigned int *)(cq + params.cq_off.tail);
+    this->cq_mask    = *(unsigned int *)(cq + params.cq_off.ring_mask);
+    this->cqes       = (io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    this->queued   = 0;
+    this->inflight = 0;
+    this->active   = 0;
+    return true;
+  }
+
+  // Takes the next entry of the submission queue. Entries that an earlier enter() left
+  // unsubmitted are still the kernel's, so while the queue is full they are submitted first.
+  io_uring_sqe *push(std::uint32_t file, Operation operation)
+  {
+    unsigned int tail = *this->sq_tail;
+
+    while (tail - __atomic_load_n(this->sq_head, __ATOMIC_ACQUIRE) >= this->sq_entries) {
+      unsigned int queued = this->queued;
+      if (!this->enter(0))
+        throw Error("Cannot submit reads: %s", std::strerror(errno));
+      if (this->queued == queued)
+        throw Error("Cannot submit reads: the submission queue is full.");
+    }
+
+    unsigned int slot = tail & this->sq_mask;
+
+    io_uring_sqe *sqe = &this->sqes[slot];
+    *sqe              = {};
+    sqe->user_data    = (std::uint64_t)file << 2 | operation;
+
+    this->sq_array[slot] = slot;
+    __atomic_store_n(this->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    this->queued++;
+    this->inflight++;
+    return sqe;
+  }
+
+  void read(std::uint32_t file, std::uint32_t chunk)
+  {
+    Pending &pending  = this->files[file];
+    io_uring_sqe *sqe = this->push(file, O_READ);
+    std::size_t left  = pending.contents.size() - pending.done;
+
+    pending.asked = left < chunk ? (std::uint32_t)left : chunk;
+    sqe->opcode   = IORING_OP_READ;
+    sqe->fd       = pending.fd;
+    sqe->addr     = (std::uint64_t)(&pending.contents[0] + pending.done);
+    sqe->len      = pending.asked;
+    sqe->off      = pending.done;
+  }
+
+  void close_file(std::uint32_t file)
+  {
+    io_uring_sqe *sqe = this->push(file, O_CLOSE);
+
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd     = this->files[file].fd;
+  }
+
+  // Submits the queued operations and waits for `wait` completions. A wait cut short by a
+  // signal returns early, which callers treat like an empty completion queue.
+  bool enter(unsigned int wait)
+  {
+    if (this->queued == 0 && wait == 0)
+      return true;
+
+    int result;
+    do
+      result = (int)syscall(__NR_io_uring_enter, this->fd, this->queued, wait,
+                            wait > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+    while (result < 0 && errno == EINTR);
+
+    if (result < 0)
+      return false;
+
+    this->queued -= (unsigned int)result;
+    return true;
+  }
+};
+#else
+struct Loader::Ring {
+};
+#endif
+
+Loader::Loader(std::vector<std::string> paths, bool batched, std::uint32_t chunk)
+    : paths(std::move(paths))
+{
+  this->started = 0;
+  this->chunk   = chunk;
+
+#if TELA_URING
+  if (batched && !this->paths.empty()) {
+    this->ring.reset(new Ring());
+    if (!this->ring->setup())
+      this->ring.reset();
+    else
+      this->ring->files.resize(this->paths.size());
+  }
+#else
+  (void)batched;
+#endif
+}
+
+// Operations still in flight write into buffers owned by the ring, so they are waited for.
+Loader::~Loader()
+{
+#if TELA_URING
+  if (this->ring != nullptr) {
+    this->started = this->paths.size();
+    while (this->ring->inflight > 0)
+      this->pump(true);
+  }
+#endif
+}
+
+bool Loader::next(Source &source)
+{
+#if TELA_URING
+  if (this->ring != nullptr) {
+    this->pump(false);
+    while (this->ready.empty()) {
+      if (this->ring->inflight == 0)
+        return false;
+      this->pump(true);
+    }
+
+    std::uint32_t file = this->ready.front();
+    this->ready.pop_front();
+
+    Ring::Pending &pending = this->ring->files[file];
+    if (pending.error != nullptr)
+      throw Error(pending.error, this->paths[file].c_str());
+
+    source.path     = this->paths[file];
+    source.contents = std::move(pending.contents);
+    return true;
+  }
+#endif
+
+  if (this->started == this->paths.size())
+    return false;
+
+  this->read((std::uint32_t)this->started++, source);
+  return true;
+}
+
+bool Loader::is_batched() const { return this->ring != nullptr; }
+
+// Opens a file and asks for its size at the same time; the read is queued once both are done.
+void Loader::start(std::uint32_t file)
+{
+#if TELA_URING
+  Ring::Pending &pending = this->ring->files[file];
+  pending.fd             = -1;
+  pending.waiting        = 2;
+  pending.error          = nullptr;
+  pending.done           = 0;
+
+  io_uring_sqe *open = this->ring->push(file, O_OPEN);
+  open->opcode       = IORING_OP_OPENAT;
+  open->fd           = AT_FDCWD;
+  open->addr         = (std::uint64_t)this->paths[file].c_str();
+  open->open_flags   = O_RDONLY | O_CLOEXEC;
+
+  io_uring_sqe *stat = this->ring->push(file, O_STATX);
+  stat->opcode       = IORING_OP_STATX;
+  stat->fd           = AT_FDCWD;
+  stat->addr         = (std::uint64_t)this->paths[file].c_str();
+  stat->len          = STATX_TYPE | STATX_SIZE;
+  stat->off          = (std::uint64_t)&pending.stat;
+
+  this->ring->active++;
+#else
+  (void)file;
+#endif
+}
+
+// Advances a file by one step. Reads ask for one byte more than the size statx reported, so a
+// short read of a regular file that reaches that size marks its end without another round trip.
+// Reads are also cut short by the chunk limit, so other files, files that grew in the meantime
+// and reads that stop before that size go on until the kernel returns nothing.
+void Loader::complete(std::uint64_t data, std::int32_t result)
+{
+#if TELA_URING
+  std::uint32_t file     = (std::uint32_t)(data >> 2);
+  Ring::Pending &pending = this->ring->files[file];
+  this->ring->inflight--;
+
+  switch ((Operation)(data & 3)) {
+  case O_OPEN:
+  case O_STATX:
+    if (result < 0)
+      pending.error = "Cannot open file: %s";
+    else if ((data & 3) == O_OPEN)
+      pending.fd = result;
+
+    if (--pending.waiting > 0)
+      return;
+
+    if (pending.error == nullptr) {
+      pending.contents.resize(pending.stat.stx_size + 1);
+      this->ring->read(file, this->chunk);
+      return;
+    }
+    break;
+  case O_READ:
+    if (result < 0) {
+      pending.error = "Cannot read file: %s";
+      break;
+    }
+
+    pending.done += (std::size_t)result;
+    if (result > 0
+        && !(S_ISREG(pending.stat.stx_mode) && (std::uint32_t)result < pending.asked
+             && pending.done >= pending.stat.stx_size)) {
+      if (pending.done == pending.contents.size())
+        pending.contents.resize(pending.contents.size() * 2);
+      this->ring->read(file, this->chunk);
+      return;
+    }
+
+    pending.contents.resize(pending.done);
+    break;
+  case O_CLOSE:
+    this->ring->active--;
+    return;
+  }
+
+  if (pending.error != nullptr)
+    std::string().swap(pending.contents);
+  this->ready.push_back(file);
+
+  if (pending.fd >= 0)
+    this->ring->close_file(file);
+  else
+    this->ring->active--;
+#else
+  (void)data;
+  (void)result;
+#endif
+}
+
+// Fills the window with new files, submits what was queued and reaps every completion, waiting
+// for at least one if `wait` is set. Operations queued while reaping are submitted right away
+// so that the kernel keeps working while the caller lexes.
+void Loader::pump(bool wait)
+{
+#if TELA_URING
+  Ring &ring = *this->ring;
+
+  for (int round = 0; round < 2; round++) {
+    while (this->started < this->paths.size() && ring.active < WINDOW)
+      this->start((std::uint32_t)this->started++);
+
+    if (!ring.enter(round == 0 && wait ? 1 : 0))
+      throw Error("Cannot submit reads: %s", std::strerror(errno));
+
+    unsigned int head = *ring.cq_head;
+    unsigned int tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+    if (head == tail)
+      return;
+
+    for (; head != tail; head++) {
+      io_uring_cqe &cqe = ring.cqes[head & ring.cq_mask];
+      this->complete(cqe.user_data, cqe.res);
+    }
+    __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+  }
+
+  if (!ring.enter(0))
+    throw Error("Cannot submit reads: %s", std::strerror(errno));
+#else
+  (void)wait;
+#endif
+}
+
+void Loader::read(std::uint32_t file, Source &source)
+{
+  const char *path = this->paths[file].c_str();
+
+  source.path = this->paths[file];
+  source.contents.clear();
+
+#if TELA_PREAD
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    throw Error("Cannot open file: %s", path);
+
+  struct stat st;
+  bool regular = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+  source.contents.resize(regular ? (std::size_t)st.st_size + 1 : 4096);
+
+  std::size_t done = 0;
+  for (;;) {
+    std::size_t left  = source.contents.size() - done;
+    std::size_t asked = left < this->chunk ? left : this->chunk;
+    ssize_t result    = pread(fd, &source.contents[done], asked, (off_t)done);
+    if (result < 0 && errno == EINTR)
+      continue;
+    if (result < 0) {
+      close(fd);
+      throw Error("Cannot read file: %s", path);
+    }
+
+    done += (std::size_t)result;
+    if (result == 0
+        || (regular && (std::size_t)result < asked && done >= (std::size_t)st.st_size))
+      break;
+    if (done == source.contents.size())
+      source.contents.resize(source.contents.size() * 2);
+  }
+
+  close(fd);
+  source.contents.resize(done);
+#else
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    throw Error("Cannot open file: %s", path);
+
+  std::stringstream input;
+  input << file.rdbuf();
+  source.contents = input.str();
+#endif
+}
@@ -0,0 +1,55 @@
+#ifndef LOADER_HPP
+#define LOADER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct Source {
+  std::string path;
+  std::string contents;
+};
+
+// Reads a set of files into memory and hands them out in the order their reads complete. On
+// Linux the open, statx, read and close operations of up to WINDOW files at a time are batched
+// through io_uring, so the kernel keeps loading while the caller is busy with the files it
+// already has; elsewhere, or when io_uring is unavailable, files are read one by one.
+class Loader {
+  struct Ring;
+
+  std::vector<std::string> paths;
+  std::size_t started;
+  std::uint32_t chunk;
+
+  std::unique_ptr<Ring> ring;
+  std::deque<std::uint32_t> ready;
+
+  public:
+  static constexpr std::uint32_t WINDOW = 32;
+  // The most a single read asks for, the largest int. The kernel returns at most 0x7ffff000
+  // bytes per read anyway, so larger files take several.
+  static constexpr std::uint32_t CHUNK = 0x7fffffff;
+
+  Loader(std::vector<std::string> paths, bool batched = true, std::uint32_t chunk = CHUNK);
+  Loader(const Loader &) = delete;
+  Loader &operator=(const Loader &) = delete;
+  ~Loader();
+
+  // Stores the next loaded file into `source` and returns true, or returns false once every
+  // file has been handed out. A file that cannot be read throws an Error, after which loading
+  // can go on with the remaining files.
+  bool next(Source &source);
+  bool is_batched() const;
+
+  private:
+  void start(std::uint32_t file);
+  void complete(std::uint64_t data, std::int32_t result);
+  void pump(bool wait);
+
+  void read(std::uint32_t file, Source &source);
+};
+
+#endif
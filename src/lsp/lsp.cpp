@@ -0,0 +1,576 @@
+#include "lsp.hpp"
+#include "error/error.hpp"
+#include "lexer/lexer.hpp"
+#include "source/source.hpp"
+#include <algorithm>
+#include <streambuf>
+
+// Reads a range of memory as a stream without copying it.
+class MemoryBuffer : public std::streambuf {
+  public:
+  MemoryBuffer(const char *data, std::size_t size)
+  {
+    char *begin = const_cast<char *>(data);
+    this->setg(begin, begin, begin + size);
+  }
+};
+
+// A position in the text of a document, as a byte offset and as the column of the lexer, in code
+// points from 1, and of the protocol, in UTF-16 code units from 0.
+struct Cursor {
+  std::uint32_t line;
+  std::size_t offset;
+  std::uint64_t col;
+  std::uint32_t unit;
+};
+
+Document::Document(std::string text) : contents(std::move(text))
+{
+  this->lines.push_back(0);
+  for (std::size_t i = 0; i < this->contents.size(); i++) {
+    if (this->contents[i] == '\n')
+      this->lines.push_back(i + 1);
+  }
+  this->clean.assign(this->lines.size(), false);
+
+  this->lex(0, (std::uint32_t)this->lines.size() - 1);
+}
+
+void Document::edit(std::uint32_t line, std::uint32_t col, std::uint32_t end_line,
+                    std::uint32_t end_col, const std::string &text)
+{
+  std::uint32_t last = (std::uint32_t)this->lines.size() - 1;
+  std::size_t start  = this->offset(line, col);
+  std::size_t end    = std::max(start, this->offset(end_line, end_col));
+  line               = std::min(line, last);
+  end_line           = std::max(line, std::min(end_line, last));
+
+  std::vector<std::size_t> added;
+  for (std::size_t i = 0; i < text.size(); i++) {
+    if (text[i] == '\n')
+      added.push_back(start + i + 1);
+  }
+
+  this->contents.replace(start, end - start, text);
+  for (std::size_t i = end_line + 1; i < this->lines.size(); i++)
+    this->lines[i] = this->lines[i] - end + start + text.size();
+
+  this->lines.erase(this->lines.begin() + line + 1, this->lines.begin() + end_line + 1);
+  this->lines.insert(this->lines.begin() + line + 1, added.begin(), added.end());
+  this->clean.erase(this->clean.begin() + line + 1, this->clean.begin() + end_line + 1);
+  this->clean.insert(this->clean.begin() + line + 1, added.size(), false);
+
+  // Tokens and errors on the lines of the edit are lexed again, and those after it move with
+  // their lines.
+  std::uint32_t shift = (std::uint32_t)added.size() - (end_line - line);
+  auto lower          = [](const Span &span, std::uint32_t line) { return span.line < line; };
+  auto first          = std::lower_bound(this->spans.begin(), this->spans.end(), line, lower);
+  auto after          = std::lower_bound(first, this->spans.end(), end_line + 1, lower);
+
+  after = this->spans.erase(first, after);
+  if (shift != 0) {
+    for (; after != this->spans.end(); after++)
+      after->line += shift;
+  }
+
+  auto edited = [line, end_line](const Diagnostic &diagnostic) {
+    return diagnostic.line >= line && diagnostic.line <= end_line;
+  };
+  this->diagnostics.erase(
+      std::remove_if(this->diagnostics.begin(), this->diagnostics.end(), edited),
+      this->diagnostics.end());
+  for (Diagnostic &diagnostic : this->diagnostics) {
+    if (diagnostic.line > end_line)
+      diagnostic.line += shift;
+  }
+
+  this->lex(line, line + (std::uint32_t)added.size());
+}
+
+const std::string &Document::text() const { return this->contents; }
+
+const std::vector<Document::Span> &Document::tokens() const { return this->spans; }
+
+const std::vector<Document::Diagnostic> &Document::errors() const { return this->diagnostics; }
+
+std::vector<std::uint32_t> Document::encode() const
+{
+  std::vector<std::uint32_t> data;
+  this->encode(data);
+  return data;
+}
+
+void Document::encode(std::vector<std::uint32_t> &data) const
+{
+  std::uint32_t line  = 0;
+  std::uint32_t start = 0;
+
+  data.resize(this->spans.size() * 5);
+  std::uint32_t *out = data.data();
+  for (const Span &span : this->spans) {
+    out[0] = span.line - line;
+    out[1] = span.line == line ? span.start - start : span.start;
+    out[2] = span.length;
+    out[3] = span.type;
+    out[4] = 0;
+    out += 5;
+
+    line  = span.line;
+    start = span.start;
+  }
+}
+
+std::uint32_t Document::semantic_type(TokenType type)
+{
+  const TokenType KEYWORDS = TokenType::T_FN | TokenType::T_LET | TokenType::T_IF
+                           | TokenType::T_ELSE | TokenType::T_WHILE | TokenType::T_RETURN
+                           | TokenType::T_IMPORT;
+
+  if ((bool)(type & KEYWORDS))
+    return 0;
+  if (type == TokenType::T_ID)
+    return 1;
+  if (type == TokenType::T_NUMBER)
+    return 2;
+  if (type == TokenType::T_STRING || type == TokenType::T_CHAR)
+    return 3;
+  if (type == TokenType::T_COMMENT)
+    return 4;
+  // Every operator from + to <=, and the ? of a conditional.
+  if ((long long)type >= (long long)TokenType::T_ADD
+      && (long long)type <= (long long)TokenType::T_LEQ)
+    return 5;
+  if (type == TokenType::T_QMARK)
+    return 5;
+
+  return NONE;
+}
+
+// Lexes again from the last line at or before `first` that the lexer can start from, through
+// `last`, and then until the new tokens meet the old ones at the start of a line, or the end.
+void Document::lex(std::uint32_t first, std::uint32_t last)
+{
+  std::uint32_t from = first;
+  while (from > 0 && !this->clean[from])
+    from--;
+
+  std::vector<Span> found;
+  std::vector<Diagnostic> errors;
+  std::uint32_t line = from;
+  std::uint32_t stop = (std::uint32_t)this->lines.size();
+  // Set once an error ran into the end of the document, which the lines after it depend on.
+  bool tail = false;
+
+  // Records whether the lexer can start at line `at`, and whether the old tokens hold from there.
+  auto boundary = [&](std::uint32_t at, bool clean) {
+    bool converged = at > last && !tail && clean && this->clean[at];
+    this->clean[at] = clean && !tail;
+    if (converged)
+      stop = at;
+    return converged;
+  };
+
+  // Moves `cursor` forward to the code point at `col` of line `row`.
+  auto advance = [this](Cursor &cursor, std::uint32_t row, std::uint64_t col) {
+    if (row > cursor.line)
+      cursor = { row, this->lines[row], 1, 0 };
+
+    for (; cursor.col < col && cursor.offset < this->contents.size(); cursor.col++) {
+      unsigned char c = (unsigned char)this->contents[cursor.offset];
+      unsigned int n  = c < 0x80 ? 1 : c < 0xe0 ? 2 : c < 0xf0 ? 3 : 4;
+      cursor.offset += n;
+      cursor.unit += n == 4 ? 2 : 1;
+    }
+  };
+
+  // Adds the spans of a token, one for each line it is on.
+  auto emit = [&](TokenType type, const Cursor &start, const Cursor &end) {
+    std::uint32_t semantic = Document::semantic_type(type);
+    if (semantic == NONE)
+      return;
+
+    for (std::uint32_t row = start.line; row <= end.line; row++) {
+      std::uint32_t begin = row == start.line ? start.unit : 0;
+      std::uint32_t until = row == end.line ? end.unit : (std::uint32_t)this->line_end(row);
+      if (until > begin)
+        found.push_back({ row, begin, until - begin, semantic });
+    }
+  };
+
+  while (line < this->lines.size() && stop == this->lines.size()) {
+    SourceManager sources;
+    MemoryBuffer buffer(this->contents.data() + this->lines[line],
+                        this->contents.size() - this->lines[line]);
+    std::istream stream(&buffer);
+    BasicLexer<TriviaLexerPolicy> lexer(sources, sources.add_stream("<document>"), stream);
+
+    Cursor at      = { line, this->lines[line], 1, 0 };
+    bool converged = boundary(line, true);
+
+    while (!converged) {
+      Cursor start = at;
+      Token token(TokenType::T_EOF, SourceManager::NONE);
+
+      try {
+        token = lexer.next();
+      } catch (Error &error) {
+        // The lines inside the token that failed are no place to start lexing either.
+        SourcePosition reached = sources.resolve(lexer.location());
+        Cursor end             = at;
+        advance(end, line + (std::uint32_t)reached.row - 1, reached.col);
+        for (std::uint32_t row = start.line + 1; row <= end.line; row++)
+          this->clean[row] = false;
+        tail = tail || end.offset == this->contents.size();
+
+        SourcePosition position = sources.resolve(error.loc);
+        advance(at, line + (std::uint32_t)position.row - 1, position.col);
+        errors.push_back({ at.line, at.unit, error.what() });
+        line = at.line + 1;
+        break;
+      }
+      if (token.type == TokenType::T_EOF) {
+        line = (std::uint32_t)this->lines.size();
+        break;
+      }
+
+      SourcePosition end = sources.resolve(lexer.location());
+      advance(at, line + (std::uint32_t)end.row - 1, end.col);
+      emit(token.type, start, at);
+
+      // Lines that start inside a comment or string are no place to start lexing.
+      bool space = token.type == TokenType::T_SPACE;
+      for (std::uint32_t row = start.line + 1; row <= at.line && !converged; row++)
+        converged = boundary(row, space || this->lines[row] == at.offset);
+    }
+  }
+
+  // Splices the new tokens and errors in place of the old ones of the lines that were lexed.
+  auto lower = [](const Span &span, std::uint32_t line) { return span.line < line; };
+  auto begin = std::lower_bound(this->spans.begin(), this->spans.end(), from, lower);
+  auto end   = std::lower_bound(begin, this->spans.end(), stop, lower);
+  begin      = this->spans.erase(begin, end);
+  this->spans.insert(begin, found.begin(), found.end());
+
+  auto below = [](const Diagnostic &diagnostic, std::uint32_t line) {
+    return diagnostic.line < line;
+  };
+  auto first_error = std::lower_bound(this->diagnostics.begin(), this->diagnostics.end(), from,
+                                      below);
+  auto last_error  = std::lower_bound(first_error, this->diagnostics.end(), stop, below);
+  first_error      = this->diagnostics.erase(first_error, last_error);
+  this->diagnostics.insert(first_error, std::make_move_iterator(errors.begin()),
+                           std::make_move_iterator(errors.end()));
+}
+
+// The offset of a position, which is clamped to the end of its line.
+std::size_t Document::offset(std::uint32_t line, std::uint32_t col) const
+{
+  if (line >= this->lines.size())
+    return this->contents.size();
+
+  std::size_t offset = this->lines[line];
+  std::size_t end    = line + 1 < this->lines.size() ? this->lines[line + 1] - 1
+                                                     : this->contents.size();
+
+  for (std::uint32_t unit = 0; unit < col && offset < end;) {
+    unsigned char c = (unsigned char)this->contents[offset];
+    unsigned int n  = c < 0x80 ? 1 : c < 0xe0 ? 2 : c < 0xf0 ? 3 : 4;
+    offset += n;
+    unit += n == 4 ? 2 : 1;
+  }
+
+  return offset;
+}
+
+// The length of a line in UTF-16 code units, without its line break.
+std::size_t Document::line_end(std::uint32_t line) const
+{
+  std::size_t offset = this->lines[line];
+  std::size_t end    = line + 1 < this->lines.size() ? this->lines[line + 1] - 1
+                                                     : this->contents.size();
+  std::size_t units  = 0;
+
+  while (offset < end) {
+    unsigned char c = (unsigned char)this->contents[offset];
+    unsigned int n  = c < 0x80 ? 1 : c < 0xe0 ? 2 : c < 0xf0 ? 3 : 4;
+    offset += n;
+    units += n == 4 ? 2 : 1;
+  }
+
+  return units;
+}
+
+LanguageServer::LanguageServer(std::istream &in, std::ostream &out) : in(in), out(out)
+{
+  this->results     = 0;
+  this->initialized = false;
+  this->shutdown    = false;
+  this->exited      = false;
+}
+
+int LanguageServer::serve()
+{
+  std::string body;
+
+  while (!this->exited && this->receive(body)) {
+    try {
+      this->handle(Json::parse(body));
+    } catch (Error &error) {
+      this->reject(Json(), -32700, error.what());
+    }
+  }
+
+  return this->exited && this->shutdown ? 0 : 1;
+}
+
+void LanguageServer::handle(const Json &message)
+{
+  const Json &id     = message["id"];
+  const Json &params = message["params"];
+  bool request       = !id.is_null();
+
+  if (message["method"].kind() != JsonKind::J_STRING)
+    return;
+  const std::string &method = message["method"].as_string();
+
+  try {
+    if (method == "exit") {
+      this->exited = true;
+    } else if (method == "initialize") {
+      this->initialized = true;
+      this->respond(id, this->initialize());
+    } else if (!this->initialized) {
+      if (request)
+        this->reject(id, -32002, "The server is not initialized.");
+    } else if (this->shutdown) {
+      if (request)
+        this->reject(id, -32600, "The server is shutting down.");
+    } else if (method == "shutdown") {
+      this->shutdown = true;
+      this->respond(id, Json());
+    } else if (method == "textDocument/didOpen") {
+      this->open(params);
+    } else if (method == "textDocument/didChange") {
+      this->change(params);
+    } else if (method == "textDocument/didClose") {
+      std::string uri = params["textDocument"]["uri"].as_string();
+      this->documents.erase(uri);
+      this->send(Json::object()
+                     .set("jsonrpc", "2.0")
+                     .set("method", "textDocument/publishDiagnostics")
+                     .set("params", Json::object().set("uri", uri).set("diagnostics",
+                                                                     Json::array())));
+    } else if (method == "textDocument/semanticTokens/full") {
+      this->respond(id, this->semantic_tokens(params, false));
+    } else if (method == "textDocument/semanticTokens/full/delta") {
+      this->respond(id, this->semantic_tokens(params, true));
+    } else if (request) {
+      this->reject(id, -32601, "Unknown method: " + method);
+    }
+  } catch (Error &error) {
+    if (request)
+      this->reject(id, -32602, error.what());
+  }
+}
+
+// Reads the body of the next message, after headers of which only the length matters.
+bool LanguageServer::receive(std::string &body)
+{
+  static const std::string LENGTH = "Content-Length:";
+  std::string header;
+  std::size_t length = 0;
+  bool known         = false;
+
+  for (;;) {
+    if (!std::getline(this->in, header))
+      return false;
+    if (!header.empty() && header.back() == '\r')
+      header.pop_back();
+    if (header.empty() && known)
+      break;
+
+    if (header.compare(0, LENGTH.size(), LENGTH) == 0) {
+      length = (std::size_t)std::strtoull(header.c_str() + LENGTH.size(), nullptr, 10);
+      known  = true;
+    }
+  }
+
+  body.resize(length);
+  this->in.read(&body[0], (std::streamsize)length);
+  return (std::size_t)this->in.gcount() == length;
+}
+
+void LanguageServer::send(const Json &message)
+{
+  std::string body = message.dump();
+
+  this->out << "Content-Length: " << body.size() << "\r\n\r\n" << body;
+  this->out.flush();
+}
+
+void LanguageServer::respond(const Json &id, Json result)
+{
+  this->send(Json::object().set("jsonrpc", "2.0").set("id", id).set("result", std::move(result)));
+}
+
+void LanguageServer::reject(const Json &id, int code, const std::string &message)
+{
+  this->send(Json::object().set("jsonrpc", "2.0").set("id", id).set(
+      "error", Json::object().set("code", code).set("message", message)));
+}
+
+void LanguageServer::publish(const std::string &uri, const Open &open)
+{
+  Json diagnostics = Json::array();
+
+  for (const Document::Diagnostic &diagnostic : open.document.errors()) {
+    Json start = Json::object().set("line", diagnostic.line).set("character", diagnostic.col);
+    Json end   = Json::object().set("line", diagnostic.line).set("character", diagnostic.col + 1);
+
+    diagnostics.push(Json::object()
+                         .set("range", Json::object().set("start", start).set("end", end))
+                         .set("severity", 1)
+                         .set("source", "tela")
+                         .set("message", diagnostic.message));
+  }
+
+  this->send(Json::object()
+                 .set("jsonrpc", "2.0")
+                 .set("method", "textDocument/publishDiagnostics")
+                 .set("params", Json::object()
+                                    .set("uri", uri)
+                                    .set("version", (long long)open.version)
+                                    .set("diagnostics", diagnostics)));
+}
+
+Json LanguageServer::initialize()
+{
+  Json types = Json::array();
+  for (const char *type : Document::TYPES)
+    types.push(type);
+
+  Json legend = Json::object().set("tokenTypes", types).set("tokenModifiers", Json::array());
+  Json tokens = Json::object().set("legend", legend).set("full",
+                                                         Json::object().set("delta", true));
+  Json sync   = Json::object().set("openClose", true).set("change", 2);
+
+  return Json::object()
+      .set("capabilities",
+           Json::object().set("textDocumentSync", sync).set("semanticTokensProvider", tokens))
+      .set("serverInfo", Json::object().set("name", "tela"));
+}
+
+void LanguageServer::open(const Json &params)
+{
+  const Json &document = params["textDocument"];
+  std::string uri      = document["uri"].as_string();
+
+  Open open{ Document(document["text"].as_string()),
+             (std::int64_t)document["version"].as_number(), "", {}, {} };
+
+  this->documents.erase(uri);
+  this->publish(uri, this->documents.emplace(uri, std::move(open)).first->second);
+}
+
+// Applies the changes in order, each to the text the previous one left.
+void LanguageServer::change(const Json &params)
+{
+  Open &open         = this->document(params);
+  const Json &changes = params["contentChanges"];
+
+  for (std::size_t i = 0; i < changes.size(); i++) {
+    const Json &range = changes[i]["range"];
+    const std::string &text = changes[i]["text"].as_string();
+
+    if (range.is_null()) {
+      open.document = Document(text);
+      continue;
+    }
+
+    open.document.edit((std::uint32_t)range["start"]["line"].as_number(),
+                       (std::uint32_t)range["start"]["character"].as_number(),
+                       (std::uint32_t)range["end"]["line"].as_number(),
+                       (std::uint32_t)range["end"]["character"].as_number(), text);
+  }
+  open.version = (std::int64_t)params["textDocument"]["version"].as_number();
+
+  this->publish(params["textDocument"]["uri"].as_string(), open);
+}
+
+// Answers with every token, or with the one run of them that changed since the tokens that the
+// client last got, if it still has those.
+Json LanguageServer::semantic_tokens(const Json &params, bool delta)
+{
+  Open &open                       = this->document(params);
+  std::vector<std::uint32_t> &data = open.next;
+  std::string result               = std::to_string(++this->results);
+  Json answer                      = Json::object().set("resultId", result);
+
+  open.document.encode(data);
+
+  const Json &previous = params["previousResultId"];
+  if (delta && previous.kind() == JsonKind::J_STRING && previous.as_string() == open.result) {
+    std::size_t prefix = 0;
+    std::size_t suffix = 0;
+    std::size_t common = std::min(data.size(), open.sent.size());
+
+    while (prefix < common && data[prefix] == open.sent[prefix])
+      prefix++;
+    while (suffix < common - prefix
+           && data[data.size() - suffix - 1] == open.sent[open.sent.size() - suffix - 1])
+      suffix++;
+
+    Json edits = Json::array();
+    if (prefix + suffix != data.size() || prefix + suffix != open.sent.size()) {
+      edits.push(Json::object()
+                     .set("start", (long long)prefix)
+                     .set("deleteCount", (long long)(open.sent.size() - prefix - suffix))
+                     .set("data", LanguageServer::tokens(data.data() + prefix,
+                                                         data.size() - prefix - suffix)));
+    }
+    answer.set("edits", edits);
+  } else {
+    answer.set("data", LanguageServer::tokens(data.data(), data.size()));
+  }
+
+  open.result = result;
+  open.sent.swap(data);
+  return answer;
+}
+
+LanguageServer::Open &LanguageServer::document(const Json &params)
+{
+  const std::string &uri = params["textDocument"]["uri"].as_string();
+
+  auto found = this->documents.find(uri);
+  if (found == this->documents.end())
+    throw Error("Unknown document: %s", uri.c_str());
+
+  return found->second;
+}
+
+// The numbers as a JSON array, written directly since there are five for every token.
+Json LanguageServer::tokens(const std::uint32_t *data, std::size_t size)
+{
+  std::string json;
+  char digits[10];
+
+  json.reserve(size * 4 + 2);
+  json += '[';
+  for (std::size_t i = 0; i < size; i++) {
+    if (i != 0)
+      json += ',';
+
+    std::uint32_t value = data[i];
+    unsigned int count  = 0;
+    do {
+      digits[count++] = (char)('0' + value % 10);
+      value /= 10;
+    } while (value != 0);
+    while (count > 0)
+      json += digits[--count];
+  }
+  json += ']';
+
+  return Json::raw(std::move(json));
+}
@@ -0,0 +1,127 @@
+#ifndef LSP_HPP
+#define LSP_HPP
+
+#include "json/json.hpp"
+#include "token/token.hpp"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The text of a document open in an editor, with its semantic tokens and lexical errors kept up
+// to date as it is edited. Positions are lines and UTF-16 code units from 0, as the Language
+// Server Protocol counts them.
+//
+// Tokens come from the lexer, which keeps trivia so that every token ends where the next one
+// starts. An edit is lexed again from the start of the first line it touches that the lexer can
+// start from, one that is not inside a comment or string, and only until a line after the edit
+// that both the old and the new tokens start cleanly, from where the old tokens still hold. A
+// lexical error ends its token, and lexing starts again on the next line, so that the rest of
+// the document still has tokens.
+class Document {
+  public:
+  static constexpr std::uint32_t NONE = 0xffffffff;
+
+  // The types of semantic tokens, by index.
+  static constexpr const char *TYPES[] = { "keyword", "variable", "number",
+                                           "string",  "comment",  "operator" };
+
+  struct Span {
+    std::uint32_t line;
+    std::uint32_t start;
+    std::uint32_t length;
+    std::uint32_t type;
+  };
+
+  struct Diagnostic {
+    std::uint32_t line;
+    std::uint32_t col;
+    std::string message;
+  };
+
+  private:
+  std::string contents;
+  // The offset of the start of every line, and whether the lexer can start there.
+  std::vector<std::size_t> lines;
+  std::vector<bool> clean;
+  std::vector<Span> spans;
+  std::vector<Diagnostic> diagnostics;
+
+  public:
+  Document(std::string text);
+
+  // Replaces the text from (line, col) up to (end_line, end_col).
+  void edit(std::uint32_t line, std::uint32_t col, std::uint32_t end_line, std::uint32_t end_col,
+            const std::string &text);
+
+  const std::string &text() const;
+  const std::vector<Span> &tokens() const;
+  const std::vector<Diagnostic> &errors() const;
+
+  // The tokens in the relative encoding of textDocument/semanticTokens, into `data` so that its
+  // memory can be used again.
+  std::vector<std::uint32_t> encode() const;
+  void encode(std::vector<std::uint32_t> &data) const;
+
+  // The index in TYPES of the tokens of `type`, or NONE for those left to the editor.
+  static std::uint32_t semantic_type(TokenType type);
+
+  private:
+  void lex(std::uint32_t first, std::uint32_t last);
+  std::size_t offset(std::uint32_t line, std::uint32_t col) const;
+  std::size_t line_end(std::uint32_t line) const;
+};
+
+// Serves the Language Server Protocol on a pair of streams, as an editor runs `tela --lsp` with
+// its standard input and output. Open documents are kept in memory and answer
+// textDocument/semanticTokens/full and its /delta from their tokens, and the lexical errors of a
+// document are published whenever it changes.
+//
+// Messages are handled one at a time, in order.
+class LanguageServer {
+  struct Open {
+    Document document;
+    std::int64_t version;
+    // The tokens last sent, which a delta is taken against, and room for the next ones.
+    std::string result;
+    std::vector<std::uint32_t> sent;
+    std::vector<std::uint32_t> next;
+  };
+
+  std::istream &in;
+  std::ostream &out;
+  std::unordered_map<std::string, Open> documents;
+  std::uint64_t results;
+  bool initialized;
+  bool shutdown;
+  bool exited;
+
+  public:
+  LanguageServer(std::istream &in, std::ostream &out);
+
+  // Serves messages until the client exits or the input ends, and returns the exit status that the
+  // protocol asks for.
+  int serve();
+
+  // Handles one message, as serve() does with each message it reads.
+  void handle(const Json &message);
+
+  private:
+  bool receive(std::string &body);
+  void send(const Json &message);
+  void respond(const Json &id, Json result);
+  void reject(const Json &id, int code, const std::string &message);
+  void publish(const std::string &uri, const Open &open);
+
+  Json initialize();
+  void open(const Json &params);
+  void change(const Json &params);
+  Json semantic_tokens(const Json &params, bool delta);
+
+  Open &document(const Json &params);
+  static Json tokens(const std::uint32_t *data, std::size_t size);
+};
+
+#endif
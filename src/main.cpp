@@ -1,23 +1,456 @@
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "cache/cache.hpp"
+#include "checker/checker.hpp"
+#include "codegen/codegen.hpp"
 #include "error/error.hpp"
+#include "file/file.hpp"
+#include "irgen/irgen.hpp"
+#include "lexer/lexer.hpp"
+#include "loader/loader.hpp"
+#include "lsp/lsp.hpp"
+#include "module/module.hpp"
+#include "optimizer/optimizer.hpp"
+#include "parser/parser.hpp"
+#include "prelude/prelude.hpp"
+#include "query/query.hpp"
+#include "server/server.hpp"
+#include "source/source.hpp"
+#include "vm/vm.hpp"
+#include "watcher/watcher.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
-int main(int argc, char **argv)
+static const std::string_view prelude(PRELUDE_SNAPSHOT, PRELUDE_SNAPSHOT_SIZE);
+
+static void report(const char *program, const SourceManager& sources, Error& error, FILE *err)
+{
+  SourcePosition position = sources.resolve(error.loc);
+
+  if (position.path != nullptr)
+  {
+    fprintf(err, "%s:%llu:%llu: %s\n", position.path, (unsigned long long)position.row,
+            (unsigned long long)position.col, error.what());
+  }
+  else
+  {
+    fprintf(err, "%s: %s\n", program, error.what());
+  }
+}
+
+// Parses and checks every file, in whatever order their reads complete, and reports the errors
+// of all of them rather than stopping at the first one. The modules a file imports are built
+// into interfaces first, so that calls into them are checked against what they export.
+static int check(const char *program, SourceManager& sources, std::vector<std::string> paths,
+                 unsigned int jobs, FILE *err)
+{
+  Loader loader(std::move(paths));
+  Source source;
+  TypeTable types;
+  std::vector<Bytecode::Function> functions =
+      Interface(prelude.data(), prelude.size(), "<prelude>").exports();
+  int status = 0;
+
+  for (;;)
+  {
+    try
+    {
+      if (!loader.next(source))
+        break;
+
+      Lexer lexer(sources, sources.add(source.path, std::move(source.contents)));
+      Parser parser(lexer.tokenize());
+      Ast ast = parser.parse();
+
+      Modules modules(sources, jobs, nullptr, prelude);
+      Compiler::Exports exports = modules.interfaces(ast, source.path);
+      Checker checker(ast, types, jobs, &exports, &functions);
+
+      for (Checker::Diagnostic& diagnostic : checker.check())
+      {
+        Error error(diagnostic.loc, "%s", diagnostic.message.c_str());
+        report(program, sources, error, err);
+        status = 1;
+      }
+    }
+    catch (Error& error)
+    {
+      report(program, sources, error, err);
+      status = 1;
+    }
+  }
+
+  return status;
+}
+
+// Checks the sources under `root` and then checks them again as they are saved, until killed.
+// Sources live in a query database, so only the parts of a saved file that changed are checked
+// again; the files that import it, directly or not, are checked again too, from memory, which
+// only runs their checks again when what it exports changed. Removed files are dropped from the
+// database, and their importers checked again.
+static void watch(const char *program, SourceManager& sources, const std::string& root, FILE *err)
+{
+  std::vector<Bytecode::Function> functions =
+      Interface(prelude.data(), prelude.size(), "<prelude>").exports();
+  QueryDatabase queries(sources, &functions);
+  Watcher watcher(root);
+  std::vector<std::string> paths;
+  std::vector<std::string> changed = watcher.sources();
+
+  for (;;)
+  {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> checked;
+    std::vector<std::string> removed;
+
+    for (const std::string& path : changed)
+    {
+      auto known = std::lower_bound(paths.begin(), paths.end(), path);
+      std::error_code code;
+
+      if (std::filesystem::is_regular_file(path, code))
+      {
+        try
+        {
+          File file(path);
+          queries.set_source(path, std::string(file.data(), file.size()));
+        }
+        catch (Error& error)
+        {
+          report(program, sources, error, err);
+          continue;
+        }
+
+        if (known == paths.end() || *known != path)
+          paths.insert(known, path);
+        checked.push_back(path);
+      }
+      else if (known != paths.end() && *known == path)
+      {
+        paths.erase(known);
+        queries.remove_source(path);
+        removed.push_back(path);
+      }
+    }
+
+    // The importers of a checked or removed file are checked after it, until none is left.
+    std::vector<std::string> dirty = removed;
+    dirty.insert(dirty.end(), checked.begin(), checked.end());
+    for (std::size_t i = 0; i < dirty.size(); i++)
+    {
+      for (const std::string& path : paths)
+      {
+        if (std::find(checked.begin(), checked.end(), path) != checked.end())
+          continue;
+
+        try
+        {
+          for (const std::string& name : queries.imports(path))
+          {
+            if (Modules::module_path(path, name) == dirty[i])
+            {
+              checked.push_back(path);
+              dirty.push_back(path);
+              break;
+            }
+          }
+        }
+        catch (Error&)
+        {
+          // Reported when the file itself was checked.
+        }
+      }
+    }
+
+    for (const std::string& path : checked)
+    {
+      try
+      {
+        for (Checker::Diagnostic& diagnostic : queries.check(path))
+        {
+          Error error(diagnostic.loc, "%s", diagnostic.message.c_str());
+          report(program, sources, error, err);
+        }
+      }
+      catch (Error& error)
+      {
+        // An error in a module that the file imports is reported with that module.
+        SourcePosition position = sources.resolve(error.loc);
+        if (position.path == nullptr || position.path == path)
+          report(program, sources, error, err);
+      }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    fprintf(err, "checked %zu files in %.3fs\n", checked.size(), elapsed.count());
+    fflush(err);
+
+    changed = watcher.wait();
+  }
+}
+
+// Prints where the time of a build went, to the error output so that it does not mix with the
+// program's own output.
+static void print_timings(const Scheduler::Report& report, FILE *err)
+{
+  std::string path;
+  for (const std::string& task : report.path)
+    path += (path.empty() ? "" : " -> ") + task;
+
+  fprintf(err, "wall %.3fs on %u workers, busy %.3fs, idle %.3fs\n", report.wall,
+          report.workers, report.busy, report.idle);
+  fprintf(err, "critical path %.3fs: %s\n", report.critical, path.c_str());
+}
+
+// Runs every program without superinstructions and writes the pairs of instructions that ran one
+// after the other, most frequent first, as the profile that tela-superinstructions reads. Only
+// the pairs that could make a superinstruction are written.
+static void profile_ops(SourceManager& sources, ParseCache& cache, const std::string& output,
+                        const std::vector<std::string>& paths)
+{
+  std::vector<std::uint64_t> pairs;
+
+  for (const std::string& path : paths)
+  {
+    Modules modules(sources, 1, &cache, prelude);
+    std::shared_ptr<Ast> ast = cache.parse(path);
+    Bytecode bytecode        = modules.build(*ast, path);
+
+    Vm vm(bytecode, stdout);
+    vm.profile(pairs);
+  }
+
+  std::vector<std::size_t> order;
+  for (std::size_t i = 0; i < pairs.size(); i++)
+  {
+    Op first = (Op)(i / Bytecode::OP_COUNT), second = (Op)(i % Bytecode::OP_COUNT);
+    if (pairs[i] != 0 && (unsigned int)first < Bytecode::BASE_OP_COUNT
+        && (unsigned int)second < Bytecode::BASE_OP_COUNT && !Bytecode::op_branches(first))
+      order.push_back(i);
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&pairs](std::size_t a, std::size_t b) { return pairs[a] > pairs[b]; });
+
+  std::string text = "# Generated by tela --profile-ops: <count> <first> <second>.\n";
+  for (std::size_t i : order)
+  {
+    text += std::to_string(pairs[i]) + " " + Bytecode::op_name((Op)(i / Bytecode::OP_COUNT)) + " "
+            + Bytecode::op_name((Op)(i % Bytecode::OP_COUNT)) + "\n";
+  }
+
+  FILE *file = fopen(output.c_str(), "wb");
+  bool written = file != nullptr && fwrite(text.data(), 1, text.size(), file) == text.size();
+  if (file == nullptr || fclose(file) != 0 || !written)
+    throw Error("Cannot write file: %s", output.c_str());
+}
+
+// Prints one token per line. Tokens are pulled from the lexer one at a time, so a streamed
+// input never has to be held in memory as a whole.
+static void emit_tokens(const SourceManager& sources, Lexer& lexer, FILE *out)
 {
+  for (;;)
+  {
+    Token token = lexer.next();
+    SourcePosition position = sources.resolve(token.loc);
+    fprintf(out, "%llu:%llu %s\n", (unsigned long long)position.row,
+            (unsigned long long)position.col, token.str());
+
+    if (token.type == TokenType::T_EOF)
+      break;
+  }
+}
+
+// Runs one command line, either the process's own or one forwarded to a server, in which case
+// there is no standard input to read from. Sources are parsed through `cache`, so a server only
+// parses again the files that changed since an earlier request.
+static int invoke(const char *program, SourceManager& sources, ParseCache& cache,
+                  const std::vector<std::string>& args, std::istream *in, FILE *out, FILE *err)
+{
+  std::vector<std::string> paths;
+  bool emit_bytecode = false;
+  bool emit_asm = false;
+  bool emit_ir = false;
+  bool emit_tokens_only = false;
+  bool check_only = false;
+  bool timings = false;
+  unsigned int jobs = std::thread::hardware_concurrency();
+
   try
   {
-    fprintf(stdout, "Hello world!\n");
+    for (std::size_t i = 0; i < args.size(); i++)
+    {
+      if (args[i] == "--emit-bytecode")
+        emit_bytecode = true;
+      else if (args[i] == "--emit-asm")
+        emit_asm = true;
+      else if (args[i] == "--emit-ir")
+        emit_ir = true;
+      else if (args[i] == "--emit-tokens")
+        emit_tokens_only = true;
+      else if (args[i] == "--check")
+        check_only = true;
+      else if (args[i] == "--timings")
+        timings = true;
+      else if (args[i] == "--jobs" || args[i] == "-j")
+      {
+        char *end = nullptr;
+        if (i + 1 == args.size()
+            || (jobs = (unsigned int)std::strtoul(args[i + 1].c_str(), &end, 10)) == 0
+            || *end != '\0')
+          throw Error("Invalid job count: %s", i + 1 == args.size() ? "" : args[i + 1].c_str());
+        i++;
+      }
+      else if (args[i].compare(0, 2, "--") == 0)
+        throw Error("Unknown option: %s", args[i].c_str());
+      else
+        paths.push_back(args[i]);
+    }
+
+    if (check_only && !paths.empty())
+      return check(program, sources, std::move(paths), jobs, err);
+
+    if (paths.size() != 1)
+      throw Error("Usage: %s [--emit-tokens | --emit-bytecode | --emit-asm | --emit-ir] <file>\n"
+                  "       %s [--jobs <n>] [--timings] [--emit-bytecode] <file>\n"
+                  "       %s --emit-tokens -\n"
+                  "       %s --check <file>...\n"
+                  "       %s --watch <directory>\n"
+                  "       %s --lsp\n"
+                  "       %s --profile-ops <profile> <file>...\n"
+                  "       %s --server <socket>\n"
+                  "       %s --client <socket> <arguments>...", program, program, program, program,
+                  program, program, program, program, program);
+
+    if (emit_tokens_only && paths[0] == "-")
+    {
+      if (in == nullptr)
+        throw Error("Standard input cannot be read through a server.");
+
+      Lexer lexer(sources, sources.add_stream(paths[0]), *in);
+      emit_tokens(sources, lexer, out);
+      return 0;
+    }
+
+    if (emit_tokens_only)
+    {
+      Lexer lexer(sources, sources.load(paths[0]));
+      emit_tokens(sources, lexer, out);
+      return 0;
+    }
+
+    std::shared_ptr<Ast> parsed = cache.parse(paths[0]);
+    Ast& ast                    = *parsed;
+
+    if (emit_ir)
+    {
+      IrGen irgen(ast);
+      Ir ir = irgen.generate();
+
+      Optimizer optimizer(ir);
+      optimizer.optimize();
+
+      fputs(ir.dump().c_str(), out);
+      return 0;
+    }
+
+    if (emit_asm)
+    {
+      Codegen codegen(ast);
+      fputs(codegen.generate().c_str(), out);
+      return 0;
+    }
+
+    Modules modules(sources, jobs, &cache, prelude);
+    Bytecode bytecode = modules.build(ast, paths[0]);
+
+    if (timings)
+      print_timings(modules.timings(), err);
+
+    if (emit_bytecode)
+    {
+      fputs(bytecode.disassemble().c_str(), out);
+      return 0;
+    }
+
+    Vm vm(bytecode, out);
+    Value result = vm.run();
+
+    return result.is_integral() ? (int)result.as_int() : 0;
   }
   catch (Error& error)
   {
-    if (error.filename != nullptr)
+    report(program, sources, error, err);
+  }
+
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  SourceManager sources;
+  ParseCache cache(sources, std::thread::hardware_concurrency() > 1);
+  std::vector<std::string> args(argv + 1, argv + argc);
+
+  try
+  {
+    if (!args.empty() && args[0] == "--server")
+    {
+      if (args.size() != 2)
+        throw Error("Usage: %s --server <socket>", argv[0]);
+
+      Server server(args[1]);
+      server.serve([&](Request& request) {
+        return invoke(argv[0], sources, cache, request.args, nullptr, request.out, request.err);
+      });
+    }
+
+    if (!args.empty() && args[0] == "--watch")
+    {
+      if (args.size() != 2)
+        throw Error("Usage: %s --watch <directory>", argv[0]);
+
+      watch(argv[0], sources, args[1], stderr);
+    }
+
+    if (!args.empty() && args[0] == "--lsp")
     {
-      fprintf(stderr, "%s:%d:%d: %s\n", error.filename, error.row, error.col, error.what());
+      if (args.size() != 1)
+        throw Error("Usage: %s --lsp", argv[0]);
+
+      std::ios::sync_with_stdio(false);
+      LanguageServer server(std::cin, std::cout);
+      return server.serve();
     }
-    else
+
+    if (!args.empty() && args[0] == "--profile-ops")
     {
-      fprintf(stderr, "%s: %s\n", argv[0], error.what());
+      if (args.size() < 3)
+        throw Error("Usage: %s --profile-ops <profile> <file>...", argv[0]);
+
+      profile_ops(sources, cache, args[1], std::vector<std::string>(args.begin() + 2, args.end()));
+      return 0;
     }
+
+    if (!args.empty() && args[0] == "--client")
+    {
+      if (args.size() < 2)
+        throw Error("Usage: %s --client <socket> <arguments>...", argv[0]);
+
+      return Server::forward(args[1], std::vector<std::string>(args.begin() + 2, args.end()));
+    }
+  }
+  catch (Error& error)
+  {
+    report(argv[0], sources, error, stderr);
+    return 1;
   }
 
-  return 0;
+  return invoke(argv[0], sources, cache, args, &std::cin, stdout, stderr);
 }
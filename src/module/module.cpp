@@ -0,0 +1,481 @@
+#include "module.hpp"
+#include "error/error.hpp"
+#include "folder/folder.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+
+Modules::Modules(SourceManager &sources, unsigned int jobs, ParseCache *cache,
+                 std::string_view prelude)
+    : sources(sources)
+{
+  this->cache    = cache;
+  this->jobs     = jobs;
+  this->snapshot = prelude;
+  this->prelude  = NONE;
+  this->rebuilt  = 0;
+  this->exported = nullptr;
+  this->report   = {};
+}
+
+Bytecode Modules::build(Ast &ast, const std::string &path)
+{
+  std::uint32_t decls       = ast.lhs(0);
+  const std::uint32_t *item = ast.list_items(decls);
+  std::vector<SourceLoc> locs;
+
+  std::unique_ptr<Module> root(new Module());
+  root->path     = path;
+  root->importer = SourceManager::NONE;
+  root->ast      = &ast;
+
+  for (std::uint32_t i = 0; i < ast.list_size(decls); i++) {
+    if (ast.kind(item[i]) == AstKind::N_IMPORT) {
+      root->names.push_back(ast.token(item[i]).value);
+      locs.push_back(ast.token(item[i]).loc);
+    }
+  }
+
+  if (locs.empty() && this->snapshot.empty()) {
+    if (this->exported != nullptr)
+      return Bytecode();
+
+    Compiler compiler(ast);
+    return compiler.compile();
+  }
+
+  this->modules.clear();
+  this->paths.clear();
+  this->prelude = NONE;
+  this->rebuilt = 0;
+
+  this->paths[path] = 0;
+  this->modules.push_back(std::move(root));
+
+  if (!this->snapshot.empty()) {
+    std::unique_ptr<Module> prelude(new Module());
+    prelude->path      = "<prelude>";
+    prelude->importer  = SourceManager::NONE;
+    prelude->ast       = nullptr;
+    prelude->stamp     = { 0, 0 };
+    prelude->compile   = 0;
+    prelude->interface.reset(
+        new Interface(this->snapshot.data(), this->snapshot.size(), prelude->path));
+
+    this->prelude = (std::uint32_t)this->modules.size();
+    this->modules.push_back(std::move(prelude));
+  }
+
+  // Only the prelude is linked in, which is already compiled, so there is nothing to schedule.
+  if (locs.empty()) {
+    this->compile(0);
+    return this->exported != nullptr ? Bytecode()
+                                     : this->link(std::move(this->program), *this->modules[0]);
+  }
+
+  Scheduler scheduler(this->jobs);
+  this->modules[0]->compile = scheduler.add("compile " + path, (double)ast.size(), [this] {
+    this->compile(0);
+  });
+  this->add_imports(scheduler, 0, std::move(locs));
+
+  scheduler.run();
+  this->report = scheduler.report();
+
+  return this->exported != nullptr ? Bytecode()
+                                   : this->link(std::move(this->program), *this->modules[0]);
+}
+
+Compiler::Exports Modules::interfaces(Ast &ast, const std::string &path)
+{
+  Compiler::Exports exports;
+
+  this->exported = &exports;
+  try {
+    this->build(ast, path);
+  } catch (...) {
+    this->exported = nullptr;
+    throw;
+  }
+  this->exported = nullptr;
+
+  return exports;
+}
+
+std::uint32_t Modules::rebuilds() const { return this->rebuilt; }
+
+const Scheduler::Report &Modules::timings() const { return this->report; }
+
+// Registers the module at `path` if it is new, with a task that scans it and one that compiles
+// it after the scan. Called with the mutex locked.
+std::uint32_t Modules::require(Scheduler &scheduler, const std::string &path, SourceLoc importer)
+{
+  auto found = this->paths.find(path);
+  if (found != this->paths.end())
+    return found->second;
+
+  std::uint32_t index = (std::uint32_t)this->modules.size();
+  std::unique_ptr<Module> module(new Module());
+  module->path     = path;
+  module->importer = importer;
+  module->ast      = nullptr;
+  module->stamp    = { 0, 0 };
+
+  Interface::stamp(path, module->stamp);
+  double cost = (double)module->stamp.size;
+
+  std::uint32_t scan = scheduler.add("scan " + path, cost, [this, &scheduler, index] {
+    this->scan(scheduler, index);
+  });
+  module->compile = scheduler.add("compile " + path, cost, [this, index] {
+    this->compile(index);
+  }, { scan });
+
+  this->paths[path] = index;
+  this->modules.push_back(std::move(module));
+
+  return index;
+}
+
+Modules::Module &Modules::module(std::uint32_t index)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  return *this->modules[index];
+}
+
+// Finds the imports of a module from its interface if that is up to date with the source, or
+// else by parsing the source. An interface whose source is missing is used as is, so that
+// modules can be shipped as interfaces alone.
+void Modules::scan(Scheduler &scheduler, std::uint32_t index)
+{
+  Module &module = this->module(index);
+  std::vector<SourceLoc> locs;
+
+  try {
+    std::unique_ptr<Interface> interface;
+    try {
+      interface.reset(new Interface(module.path + "i"));
+    } catch (Error &) {
+    }
+
+    bool source = Interface::stamp(module.path, module.stamp);
+
+    if (interface != nullptr && (!source || module.stamp == interface->source())) {
+      for (std::uint32_t i = 0; i < interface->dependency_count(); i++) {
+        Interface::Dependency dependency = interface->dependency(i);
+        module.names.push_back(dependency.name);
+        module.hashes.push_back(dependency.hash);
+        locs.push_back(SourceManager::NONE);
+      }
+      module.interface = std::move(interface);
+    } else {
+      this->parse(module);
+
+      std::uint32_t decls       = module.ast->lhs(0);
+      const std::uint32_t *item = module.ast->list_items(decls);
+
+      for (std::uint32_t i = 0; i < module.ast->list_size(decls); i++) {
+        if (module.ast->kind(item[i]) == AstKind::N_IMPORT) {
+          module.names.push_back(module.ast->token(item[i]).value);
+          locs.push_back(module.ast->token(item[i]).loc);
+        }
+      }
+    }
+  } catch (Error &error) {
+    if (error.loc == SourceManager::NONE)
+      error.loc = module.importer;
+    throw;
+  }
+
+  this->add_imports(scheduler, index, std::move(locs));
+}
+
+// Registers the imports of a scanned module and makes its compilation wait for theirs.
+void Modules::add_imports(Scheduler &scheduler, std::uint32_t index, std::vector<SourceLoc> locs)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  Module &module = *this->modules[index];
+
+  for (std::uint32_t i = 0; i < module.names.size(); i++) {
+    if (this->prelude != NONE && module.names[i] == Compiler::PRELUDE) {
+      module.imports.push_back(this->prelude);
+      continue;
+    }
+
+    std::string path     = module_path(module.path, module.names[i]);
+    std::uint32_t import = this->require(scheduler, path, locs[i]);
+
+    if (this->reaches(import, index))
+      throw Error(locs[i], "Import cycle through %s", path.c_str());
+
+    module.imports.push_back(import);
+    scheduler.depend(module.compile, this->modules[import]->compile);
+  }
+}
+
+// Rebuilds the interface of a module unless it is up to date with those of its imports, or
+// compiles the program itself for module 0, or only keeps the exports of its imports when
+// called through interfaces().
+void Modules::compile(std::uint32_t index)
+{
+  Module &module = this->module(index);
+  bool current   = module.interface != nullptr;
+
+  std::vector<const Interface *> interfaces;
+  std::vector<Interface::Dependency> dependencies;
+
+  for (std::uint32_t i = 0; i < module.imports.size(); i++) {
+    interfaces.push_back(this->module(module.imports[i]).interface.get());
+    dependencies.push_back({ module.names[i], interfaces[i]->hash() });
+    current = current && module.hashes[i] == interfaces[i]->hash();
+  }
+  if (current)
+    return;
+
+  Compiler::Exports exports;
+  for (std::uint32_t i = 0; i < module.imports.size(); i++)
+    exports[module.names[i]] = interfaces[i]->exports();
+  if (this->prelude != NONE && exports.count(Compiler::PRELUDE) == 0)
+    exports[Compiler::PRELUDE] = this->modules[this->prelude]->interface->exports();
+
+  if (index == 0 && this->exported != nullptr) {
+    *this->exported = std::move(exports);
+    return;
+  }
+
+  if (module.ast == nullptr) {
+    try {
+      this->parse(module);
+    } catch (Error &error) {
+      if (error.loc == SourceManager::NONE)
+        error.loc = module.importer;
+      throw;
+    }
+  }
+
+  Compiler compiler(*module.ast);
+  Bytecode program = compiler.compile_module(exports);
+  if (compiler.uses_prelude())
+    this->use_prelude(module, dependencies);
+
+  if (index == 0) {
+    this->program = std::move(program);
+    return;
+  }
+
+  Interface::write(module.path + "i", program, module.stamp, dependencies);
+  module.interface.reset(new Interface(module.path + "i"));
+  module.parsed.reset();
+  module.ast = nullptr;
+  this->rebuilt++;
+}
+
+// Records that a module calls the prelude without importing it, so that it is linked with the
+// prelude and rebuilt when the prelude changes.
+void Modules::use_prelude(Module &module, std::vector<Interface::Dependency> &dependencies)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  for (const std::string &name : module.names) {
+    if (name == Compiler::PRELUDE)
+      return;
+  }
+
+  module.names.push_back(Compiler::PRELUDE);
+  module.imports.push_back(this->prelude);
+  dependencies.push_back({ Compiler::PRELUDE, this->modules[this->prelude]->interface->hash() });
+}
+
+void Modules::parse(Module &module)
+{
+  if (this->cache != nullptr) {
+    module.parsed = this->cache->parse(module.path);
+    module.ast    = module.parsed.get();
+    return;
+  }
+
+  Lexer lexer(this->sources, this->sources.load(module.path));
+  Parser parser(lexer.tokenize());
+  module.parsed.reset(new Ast(parser.parse()));
+  module.ast = module.parsed.get();
+
+  Folder folder(*module.ast);
+  folder.fold();
+}
+
+// Whether module `to` is reachable from module `from` through the imports registered so far.
+// Called with the mutex locked.
+bool Modules::reaches(std::uint32_t from, std::uint32_t to) const
+{
+  std::vector<bool> seen(this->modules.size(), false);
+  std::vector<std::uint32_t> stack = { from };
+
+  while (!stack.empty()) {
+    std::uint32_t module = stack.back();
+    stack.pop_back();
+
+    if (module == to)
+      return true;
+    if (seen[module])
+      continue;
+    seen[module] = true;
+
+    for (std::uint32_t import : this->modules[module]->imports)
+      stack.push_back(import);
+  }
+
+  return false;
+}
+
+// Lays out the modules that `module` depends on, dependencies first, followed by `root`, the
+// code compiled from `module` itself. The entry code runs their initializers in the same order
+// and then calls main.
+Bytecode Modules::link(Bytecode root, const Module &module)
+{
+  std::vector<bool> seen(this->modules.size(), false);
+  std::vector<std::uint32_t> order;
+  for (std::uint32_t import : module.imports)
+    this->order(import, seen, order);
+
+  Bytecode program;
+  std::vector<std::unordered_map<std::string, std::uint32_t>> exports(this->modules.size());
+  std::vector<std::uint32_t> inits;
+
+  for (std::uint32_t index : order) {
+    const Module &dependency = *this->modules[index];
+    inits.push_back(this->append(program, dependency.interface->program(), dependency, exports,
+                                 exports[index]));
+  }
+
+  std::unordered_map<std::string, std::uint32_t> defined;
+  inits.push_back(this->append(program, root, module, exports, defined));
+
+  program.entry = (std::uint32_t)program.code.size();
+  for (std::uint32_t init : inits) {
+    program.emit(Op::O_CALL);
+    program.emit_u32(init);
+    program.emit_u8(0);
+    program.emit(Op::O_POP);
+  }
+
+  auto main = defined.find("main");
+  if (main != defined.end()) {
+    if (program.functions[main->second].params != 0)
+      throw Error("Function 'main' must not take parameters.");
+
+    program.emit(Op::O_CALL);
+    program.emit_u32(main->second);
+    program.emit_u8(0);
+  } else {
+    program.emit(Op::O_CONST);
+    program.emit_u32((std::uint32_t)program.constants.size());
+    program.constants.push_back(Value());
+  }
+  program.emit(Op::O_HALT);
+
+  program.max_stack = 1;
+
+  return program;
+}
+
+void Modules::order(std::uint32_t module, std::vector<bool> &seen,
+                    std::vector<std::uint32_t> &out)
+{
+  if (seen[module])
+    return;
+  seen[module] = true;
+
+  for (std::uint32_t import : this->modules[module]->imports)
+    this->order(import, seen, out);
+  out.push_back(module);
+}
+
+// Appends the code, constants, globals and functions of `unit` to `program`, relocating the
+// operands that refer to them, and returns the index of a function running its initializer.
+// External functions are resolved by name among the exports of the modules `module` imports.
+std::uint32_t Modules::append(Bytecode &program, const Bytecode &unit, const Module &module,
+                              std::vector<std::unordered_map<std::string, std::uint32_t>> &exports,
+                              std::unordered_map<std::string, std::uint32_t> &defined)
+{
+  std::uint32_t code_base     = (std::uint32_t)program.code.size();
+  std::uint32_t constant_base = (std::uint32_t)program.constants.size();
+  std::uint32_t global_base   = program.globals;
+
+  std::vector<std::uint32_t> functions;
+  for (const Bytecode::Function &function : unit.functions) {
+    if (function.entry != Bytecode::EXTERN) {
+      defined[function.name] = (std::uint32_t)program.functions.size();
+      functions.push_back(defined[function.name]);
+      program.functions.push_back(function);
+      program.functions.back().entry += code_base;
+      continue;
+    }
+
+    std::uint32_t target = Bytecode::EXTERN;
+    for (std::uint32_t import : module.imports) {
+      auto found = exports[import].find(function.name);
+      if (found != exports[import].end())
+        target = found->second;
+    }
+    if (target == Bytecode::EXTERN)
+      throw Error("Undefined function: %s", function.name.c_str());
+    functions.push_back(target);
+  }
+
+  for (Value constant : unit.constants) {
+    if (constant.is_string()) {
+      if (constant.as_string() >= unit.strings.size())
+        throw Error("Invalid bytecode in module: %s", module.path.c_str());
+      constant = Value::from_string(program.strings.intern(unit.strings.get(constant.as_string())));
+    }
+    program.constants.push_back(constant);
+  }
+
+  program.code.insert(program.code.end(), unit.code.begin(), unit.code.end());
+
+  for (std::uint32_t pc = 0; pc < unit.code.size();) {
+    Op op = (Op)unit.code[pc];
+    if (op > Op::O_HALT || pc + 1 + Bytecode::op_size(op) > unit.code.size())
+      throw Error("Invalid bytecode in module: %s", module.path.c_str());
+
+    std::uint32_t at      = code_base + pc + 1;
+    std::uint32_t operand = Bytecode::op_size(op) >= 4 ? program.read_u32(at) : 0;
+    std::uint32_t limit   = 0;
+
+    switch (op) {
+    case Op::O_CONST:
+      limit = (std::uint32_t)unit.constants.size();
+      program.patch_u32(at, constant_base + operand);
+      break;
+    case Op::O_LOAD_GLOBAL:
+    case Op::O_STORE_GLOBAL:
+      limit = unit.globals;
+      program.patch_u32(at, global_base + operand);
+      break;
+    case Op::O_CALL:
+      limit = (std::uint32_t)functions.size();
+      program.patch_u32(at, operand < limit ? functions[operand] : 0);
+      break;
+    default:
+      limit = Bytecode::EXTERN;
+      break;
+    }
+
+    if (operand >= limit)
+      throw Error("Invalid bytecode in module: %s", module.path.c_str());
+    pc += 1 + Bytecode::op_size(op);
+  }
+
+  for (const Bytecode::Location &location : unit.locations)
+    program.locations.push_back({ code_base + location.pc, location.loc });
+  program.globals += unit.globals;
+
+  program.functions.push_back({ "<init>", code_base + unit.entry, 0, 0, unit.max_stack, false });
+
+  return (std::uint32_t)program.functions.size() - 1;
+}
+
+std::string Modules::module_path(const std::string &importer, const std::string &name)
+{
+  return importer.substr(0, importer.find_last_of("/\\") + 1) + name + ".tl";
+}
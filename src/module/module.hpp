@@ -0,0 +1,108 @@
+#ifndef MODULE_HPP
+#define MODULE_HPP
+
+#include "ast/ast.hpp"
+#include "bytecode/bytecode.hpp"
+#include "cache/cache.hpp"
+#include "compiler/compiler.hpp"
+#include "interface/interface.hpp"
+#include "scheduler/scheduler.hpp"
+#include "source/source.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Builds the modules that a program imports and links them into a single Bytecode. `import m;`
+// in a file of directory `dir` names the source `dir/m.tl`, which is compiled into the interface
+// file `dir/m.tli` next to it. An existing interface is used as is, without reading the module's
+// source, unless the source has changed since it was written or the interface hash of one of the
+// modules it was compiled against has.
+//
+// Every module is scanned for its imports, by parsing it or by reading its interface, and then
+// compiled once the interfaces of its imports are ready. Both phases run as tasks of a Scheduler,
+// so independent modules are built in parallel, and the import graph is discovered as the scans
+// complete.
+//
+// Sources are parsed through `cache` when one is given, so that a server does not parse a module
+// again while its contents stay the same.
+//
+// With a `prelude`, the interface image of the standard prelude, every module may call the
+// functions of Compiler::PRELUDE without importing it, and `import prelude;` names that image
+// rather than a source. It is used in place and linked only into programs that call it.
+class Modules {
+  struct Module {
+    std::string path;
+    SourceLoc importer;
+
+    Ast *ast;
+    std::shared_ptr<Ast> parsed;
+    std::unique_ptr<Interface> interface;
+    Interface::Stamp stamp;
+
+    std::vector<std::string> names;
+    std::vector<std::uint64_t> hashes;
+    std::vector<std::uint32_t> imports;
+    std::uint32_t compile;
+  };
+
+  static constexpr std::uint32_t NONE = 0xffffffff;
+
+  SourceManager &sources;
+  ParseCache *cache;
+  unsigned int jobs;
+  std::string_view snapshot;
+  std::uint32_t prelude;
+
+  std::vector<std::unique_ptr<Module>> modules;
+  std::unordered_map<std::string, std::uint32_t> paths;
+  std::mutex mutex;
+
+  std::atomic<std::uint32_t> rebuilt;
+  Compiler::Exports *exported;
+  Bytecode program;
+  Scheduler::Report report;
+
+  public:
+  Modules(SourceManager &sources, unsigned int jobs = 1, ParseCache *cache = nullptr,
+          std::string_view prelude = {});
+
+  // Compiles `ast`, parsed from the source at `path`, and links it with the modules it imports,
+  // directly or not, building them on `jobs` threads. A program without imports is compiled
+  // exactly as by Compiler::compile() when there is no prelude.
+  Bytecode build(Ast &ast, const std::string &path);
+  // Builds the interfaces of the modules that `ast` imports, directly or not, as build() does,
+  // but returns what its imports export, by the names they are imported as, instead of compiling
+  // `ast` itself. For checking a program against the modules it imports.
+  Compiler::Exports interfaces(Ast &ast, const std::string &path);
+
+  // The number of interfaces that had to be rebuilt from their sources.
+  std::uint32_t rebuilds() const;
+  // How the tasks of the last build were scheduled. Empty for a program without imports.
+  const Scheduler::Report &timings() const;
+
+  // The path of the module `name` imported by the source at `importer`.
+  static std::string module_path(const std::string &importer, const std::string &name);
+
+  private:
+  std::uint32_t require(Scheduler &scheduler, const std::string &path, SourceLoc importer);
+  Module &module(std::uint32_t index);
+  void scan(Scheduler &scheduler, std::uint32_t index);
+  void add_imports(Scheduler &scheduler, std::uint32_t index, std::vector<SourceLoc> locs);
+  void compile(std::uint32_t index);
+  void use_prelude(Module &module, std::vector<Interface::Dependency> &dependencies);
+  void parse(Module &module);
+  bool reaches(std::uint32_t from, std::uint32_t to) const;
+
+  Bytecode link(Bytecode root, const Module &module);
+  void order(std::uint32_t module, std::vector<bool> &seen, std::vector<std::uint32_t> &out);
+  std::uint32_t append(Bytecode &program, const Bytecode &unit, const Module &module,
+                       std::vector<std::unordered_map<std::string, std::uint32_t>> &exports,
+                       std::unordered_map<std::string, std::uint32_t> &defined);
+};
+
+#endif
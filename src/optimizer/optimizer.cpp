@@ -0,0 +1,456 @@
+#include "optimizer.hpp"
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+struct InstrHash {
+  std::size_t operator()(const Ir::Instr &instr) const
+  {
+    std::uint64_t hash = (std::uint64_t)instr.op;
+    hash = hash * 0x9e3779b97f4a7c15 + instr.a;
+    hash = hash * 0x9e3779b97f4a7c15 + instr.b;
+    hash = hash * 0x9e3779b97f4a7c15 + (std::uint64_t)instr.imm;
+    return (std::size_t)(hash ^ hash >> 32);
+  }
+};
+
+struct InstrEqual {
+  bool operator()(const Ir::Instr &x, const Ir::Instr &y) const
+  {
+    return x.op == y.op && x.a == y.a && x.b == y.b && x.imm == y.imm;
+  }
+};
+}
+
+static bool is_pure(IrOp op)
+{
+  return (op >= IrOp::I_CONST && op <= IrOp::I_PARAM) || (op >= IrOp::I_ADD && op <= IrOp::I_DECR);
+}
+
+static bool is_commutative(IrOp op)
+{
+  switch (op) {
+  case IrOp::I_ADD:
+  case IrOp::I_MUL:
+  case IrOp::I_AND:
+  case IrOp::I_OR:
+  case IrOp::I_XOR:
+  case IrOp::I_EQ:
+  case IrOp::I_NEQ:
+    return true;
+  default:
+    return false;
+  }
+}
+
+Optimizer::Optimizer(Ir &ir) : ir(ir) {}
+
+void Optimizer::optimize()
+{
+  this->remove_unreachable();
+  this->propagate_copies();
+  this->eliminate_common_subexpressions();
+  this->propagate_copies();
+  this->eliminate_dead_code();
+  this->ir.compact();
+}
+
+// Marks the blocks that can't be reached from the entry of their function as dead and drops
+// the corresponding predecessors and phi operands from the live ones.
+void Optimizer::remove_unreachable()
+{
+  for (const Ir::Function &function : this->ir.functions) {
+    Bitset reachable(function.end - function.first);
+    std::vector<std::uint32_t> stack = { function.first };
+    reachable.set(0);
+
+    while (!stack.empty()) {
+      std::uint32_t succs[2];
+      std::uint32_t count = this->ir.successors(stack.back(), succs);
+      stack.pop_back();
+
+      for (std::uint32_t i = 0; i < count; i++) {
+        if (!reachable.test(succs[i] - function.first)) {
+          reachable.set(succs[i] - function.first);
+          stack.push_back(succs[i]);
+        }
+      }
+    }
+
+    for (std::uint32_t block = function.first; block < function.end; block++) {
+      Ir::Block &range = this->ir.blocks[block];
+
+      if (!reachable.test(block - function.first)) {
+        for (std::uint32_t i = range.first; i < range.end; i++)
+          this->ir.instrs[i].op = IrOp::I_NOP;
+        range.preds = Ir::NONE;
+        continue;
+      }
+
+      std::uint32_t *preds = this->ir.list_items(range.preds);
+      std::uint32_t count  = this->ir.list_size(range.preds);
+
+      auto keep = [&](std::uint32_t list) {
+        std::uint32_t *items = this->ir.list_items(list);
+        std::uint32_t kept   = 0;
+
+        for (std::uint32_t i = 0; i < count; i++) {
+          if (reachable.test(preds[i] - function.first))
+            items[kept++] = items[i];
+        }
+        this->ir.extra[list] = kept;
+      };
+
+      for (std::uint32_t i = range.first; i < range.end; i++) {
+        if (this->ir.instrs[i].op == IrOp::I_PHI)
+          keep(this->ir.instrs[i].b);
+      }
+      keep(range.preds);
+    }
+  }
+}
+
+// Forwards copies to their source and removes phis whose operands are all the same value. Each
+// value keeps the list of phis using it; when a phi is replaced, its users are rechecked and
+// merged into the users of the replacement, smaller list into larger.
+void Optimizer::propagate_copies()
+{
+  this->reset_forward();
+
+  for (std::uint32_t i = 0; i < this->ir.instrs.size(); i++) {
+    if (this->ir.instrs[i].op == IrOp::I_COPY)
+      this->forward[i] = this->ir.instrs[i].a;
+  }
+
+  std::vector<std::vector<std::uint32_t>> users(this->ir.instrs.size());
+  std::vector<std::uint32_t> worklist;
+
+  for (std::uint32_t i = 0; i < this->ir.instrs.size(); i++) {
+    Ir::Instr &instr = this->ir.instrs[i];
+    if (instr.op != IrOp::I_PHI)
+      continue;
+
+    for (std::uint32_t k = 0; k < this->ir.list_size(instr.b); k++)
+      users[this->resolve(this->ir.list_items(instr.b)[k])].push_back(i);
+    worklist.push_back(i);
+  }
+
+  while (!worklist.empty()) {
+    std::uint32_t phi = worklist.back();
+    worklist.pop_back();
+
+    if (this->forward[phi] != phi)
+      continue;
+
+    Ir::Instr &instr   = this->ir.instrs[phi];
+    std::uint32_t same = Ir::NONE;
+    bool trivial       = true;
+
+    for (std::uint32_t k = 0; k < this->ir.list_size(instr.b) && trivial; k++) {
+      std::uint32_t operand = this->resolve(this->ir.list_items(instr.b)[k]);
+      if (operand == phi || operand == same)
+        continue;
+
+      if (same != Ir::NONE)
+        trivial = false;
+      same = operand;
+    }
+
+    if (!trivial || same == Ir::NONE)
+      continue;
+
+    this->forward[phi] = same;
+    worklist.insert(worklist.end(), users[phi].begin(), users[phi].end());
+
+    if (users[same].size() < users[phi].size())
+      users[same].swap(users[phi]);
+    users[same].insert(users[same].end(), users[phi].begin(), users[phi].end());
+    users[phi] = std::vector<std::uint32_t>();
+  }
+
+  this->rewrite();
+}
+
+// Hash-conses the pure instructions of every function while walking its dominator tree, so an
+// instruction is replaced by an identical one that dominates it. The table is scoped: entries
+// added in a subtree are undone when the walk leaves it.
+void Optimizer::eliminate_common_subexpressions()
+{
+  this->reset_forward();
+
+  std::unordered_map<Ir::Instr, std::uint32_t, InstrHash, InstrEqual> table;
+  std::vector<Ir::Instr> undo;
+  std::vector<std::uint32_t> order;
+  std::vector<std::uint32_t> idom;
+
+  for (const Ir::Function &function : this->ir.functions) {
+    this->dominators(function, order, idom);
+
+    std::uint32_t count = function.end - function.first;
+    std::vector<std::uint32_t> children(count + 1, 0);
+    std::vector<std::uint32_t> child(count);
+
+    for (std::uint32_t block : order) {
+      if (block != 0)
+        children[idom[block] + 1]++;
+    }
+    for (std::uint32_t i = 0; i < count; i++)
+      children[i + 1] += children[i];
+
+    std::vector<std::uint32_t> next(children.begin(), children.end() - 1);
+    for (std::uint32_t block : order) {
+      if (block != 0)
+        child[next[idom[block]]++] = block;
+    }
+
+    std::vector<std::pair<std::uint32_t, std::size_t>> stack = { { 0, (std::size_t)-1 } };
+    while (!stack.empty()) {
+      std::uint32_t block = stack.back().first;
+      std::size_t mark    = stack.back().second;
+      stack.pop_back();
+
+      if (mark != (std::size_t)-1) {
+        for (; undo.size() > mark; undo.pop_back())
+          table.erase(undo.back());
+        continue;
+      }
+
+      stack.push_back({ block, undo.size() });
+
+      Ir::Block &range = this->ir.blocks[function.first + block];
+      for (std::uint32_t i = range.first; i < range.end; i++) {
+        Ir::Instr &instr = this->ir.instrs[i];
+        if (instr.op == IrOp::I_PHI)
+          continue;
+
+        this->ir.each_operand(instr, [&](std::uint32_t &value) { value = this->resolve(value); });
+        if (!is_pure(instr.op))
+          continue;
+
+        Ir::Instr key = instr;
+        if (is_commutative(key.op) && key.a > key.b)
+          std::swap(key.a, key.b);
+
+        auto found = table.find(key);
+        if (found != table.end())
+          this->forward[i] = found->second;
+        else {
+          table.emplace(key, i);
+          undo.push_back(key);
+        }
+      }
+
+      for (std::uint32_t k = children[block]; k < children[block + 1]; k++)
+        stack.push_back({ child[k], (std::size_t)-1 });
+    }
+  }
+
+  this->rewrite();
+}
+
+// Removes every instruction whose value is unused and that has no effect. Arithmetic counts as
+// an effect when it may raise a runtime error, which is the case for division and for the
+// operators whose operands may be strings; a value may be a string unless it comes from a
+// constant or an operator, possibly through phis.
+void Optimizer::eliminate_dead_code()
+{
+  Bitset strings(this->ir.instrs.size());
+
+  for (bool changed = true; changed;) {
+    changed = false;
+
+    for (std::uint32_t i = 0; i < this->ir.instrs.size(); i++) {
+      Ir::Instr &instr = this->ir.instrs[i];
+      if (strings.test(i))
+        continue;
+
+      bool string = false;
+      switch (instr.op) {
+      case IrOp::I_STRING:
+      case IrOp::I_PARAM:
+      case IrOp::I_LOAD_GLOBAL:
+      case IrOp::I_CALL:
+        string = true;
+        break;
+      case IrOp::I_PHI:
+      case IrOp::I_COPY:
+        this->ir.each_operand(instr, [&](std::uint32_t &value) { string |= strings.test(value); });
+        break;
+      default:
+        break;
+      }
+
+      if (string) {
+        strings.set(i);
+        changed = true;
+      }
+    }
+  }
+
+  Bitset live(this->ir.instrs.size());
+  std::vector<std::uint32_t> worklist;
+
+  for (std::uint32_t i = 0; i < this->ir.instrs.size(); i++) {
+    if (this->ir.instrs[i].op != IrOp::I_NOP && this->has_effect(this->ir.instrs[i], strings)) {
+      live.set(i);
+      worklist.push_back(i);
+    }
+  }
+
+  while (!worklist.empty()) {
+    Ir::Instr &instr = this->ir.instrs[worklist.back()];
+    worklist.pop_back();
+
+    this->ir.each_operand(instr, [&](std::uint32_t &value) {
+      if (!live.test(value)) {
+        live.set(value);
+        worklist.push_back(value);
+      }
+    });
+  }
+
+  for (std::uint32_t i = 0; i < this->ir.instrs.size(); i++) {
+    if (!live.test(i))
+      this->ir.instrs[i].op = IrOp::I_NOP;
+  }
+}
+
+void Optimizer::reset_forward()
+{
+  this->forward.resize(this->ir.instrs.size());
+  for (std::uint32_t i = 0; i < this->forward.size(); i++)
+    this->forward[i] = i;
+}
+
+std::uint32_t Optimizer::resolve(std::uint32_t value)
+{
+  std::uint32_t root = value;
+  while (this->forward[root] != root)
+    root = this->forward[root];
+
+  while (this->forward[value] != root) {
+    std::uint32_t next   = this->forward[value];
+    this->forward[value] = root;
+    value                = next;
+  }
+
+  return root;
+}
+
+void Optimizer::rewrite()
+{
+  for (std::uint32_t i = 0; i < this->ir.instrs.size(); i++) {
+    Ir::Instr &instr = this->ir.instrs[i];
+
+    if (this->forward[i] != i)
+      instr.op = IrOp::I_NOP;
+    else
+      this->ir.each_operand(instr, [&](std::uint32_t &value) { value = this->resolve(value); });
+  }
+}
+
+// Immediate dominators of the reachable blocks of a function (numbered from 0 within it) with
+// the algorithm of Cooper, Harvey and Kennedy. `order` receives the blocks in reverse postorder.
+void Optimizer::dominators(const Ir::Function &function, std::vector<std::uint32_t> &order,
+                           std::vector<std::uint32_t> &idom)
+{
+  std::uint32_t count = function.end - function.first;
+  std::vector<std::uint32_t> index(count, Ir::NONE);
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> stack = { { 0, 0 } };
+
+  order.clear();
+  index[0] = 0;
+
+  while (!stack.empty()) {
+    std::uint32_t succs[2];
+    std::uint32_t block = stack.back().first;
+    std::uint32_t succ_count = this->ir.successors(function.first + block, succs);
+
+    if (stack.back().second < succ_count) {
+      std::uint32_t succ = succs[stack.back().second++] - function.first;
+      if (index[succ] == Ir::NONE) {
+        index[succ] = 0;
+        stack.push_back({ succ, 0 });
+      }
+      continue;
+    }
+
+    order.push_back(block);
+    stack.pop_back();
+  }
+
+  std::reverse(order.begin(), order.end());
+  for (std::uint32_t i = 0; i < order.size(); i++)
+    index[order[i]] = i;
+
+  idom.assign(count, Ir::NONE);
+  idom[0] = 0;
+
+  auto intersect = [&](std::uint32_t a, std::uint32_t b) {
+    while (a != b) {
+      while (index[a] > index[b])
+        a = idom[a];
+      while (index[b] > index[a])
+        b = idom[b];
+    }
+    return a;
+  };
+
+  for (bool changed = true; changed;) {
+    changed = false;
+
+    for (std::uint32_t i = 1; i < order.size(); i++) {
+      Ir::Block &range    = this->ir.blocks[function.first + order[i]];
+      std::uint32_t dom   = Ir::NONE;
+
+      for (std::uint32_t k = 0; k < this->ir.list_size(range.preds); k++) {
+        std::uint32_t pred = this->ir.list_items(range.preds)[k] - function.first;
+        if (idom[pred] == Ir::NONE)
+          continue;
+        dom = dom == Ir::NONE ? pred : intersect(pred, dom);
+      }
+
+      if (dom != idom[order[i]]) {
+        idom[order[i]] = dom;
+        changed        = true;
+      }
+    }
+  }
+}
+
+bool Optimizer::has_effect(const Ir::Instr &instr, const Bitset &strings) const
+{
+  switch (instr.op) {
+  case IrOp::I_ADD:
+  case IrOp::I_SUB:
+  case IrOp::I_MUL:
+  case IrOp::I_EQ:
+  case IrOp::I_NEQ:
+  case IrOp::I_GT:
+  case IrOp::I_LT:
+  case IrOp::I_GEQ:
+  case IrOp::I_LEQ:
+    return strings.test(instr.a) || strings.test(instr.b);
+  case IrOp::I_NEG:
+  case IrOp::I_INCR:
+  case IrOp::I_DECR:
+    return strings.test(instr.a);
+  case IrOp::I_DIV:
+  case IrOp::I_MOD:
+  case IrOp::I_AND:
+  case IrOp::I_OR:
+  case IrOp::I_XOR:
+  case IrOp::I_BNOT:
+  case IrOp::I_INDEX:
+  case IrOp::I_STORE_GLOBAL:
+  case IrOp::I_CALL:
+  case IrOp::I_PRINT:
+  case IrOp::I_JUMP:
+  case IrOp::I_BRANCH:
+  case IrOp::I_RETURN:
+    return true;
+  default:
+    return false;
+  }
+}
@@ -0,0 +1,37 @@
+#ifndef OPTIMIZER_HPP
+#define OPTIMIZER_HPP
+
+#include "bitset/bitset.hpp"
+#include "ir/ir.hpp"
+#include <cstdint>
+#include <vector>
+
+// Optimization passes over the SSA form. Each pass records the values it replaces in `forward`
+// and rewrites all operands in a single sweep at the end, so the work done is proportional to
+// the size of the IR rather than to the number of replacements.
+class Optimizer {
+  Ir &ir;
+
+  std::vector<std::uint32_t> forward;
+
+  public:
+  Optimizer(Ir &ir);
+
+  void optimize();
+
+  void remove_unreachable();
+  void propagate_copies();
+  void eliminate_common_subexpressions();
+  void eliminate_dead_code();
+
+  private:
+  void reset_forward();
+  std::uint32_t resolve(std::uint32_t value);
+  void rewrite();
+
+  void dominators(const Ir::Function &function, std::vector<std::uint32_t> &order,
+                  std::vector<std::uint32_t> &idom);
+  bool has_effect(const Ir::Instr &instr, const Bitset &strings) const;
+};
+
+#endif
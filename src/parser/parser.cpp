@@ -0,0 +1,423 @@
+#include "parser.hpp"
+
+Parser::Parser(std::vector<Token> tokens) : ast(std::move(tokens))
+{
+  this->i        = 0;
+  this->pipeline = nullptr;
+
+  if (this->ast.tokens.empty() || this->ast.tokens.back().type != TokenType::T_EOF)
+    this->ast.tokens.push_back(Token(TokenType::T_EOF, SourceManager::NONE));
+}
+
+Parser::Parser(TokenPipeline &pipeline) : ast(std::vector<Token>())
+{
+  this->i        = 0;
+  this->pipeline = &pipeline;
+}
+
+Ast Parser::parse()
+{
+  std::uint32_t root = this->ast.add_node(AstKind::N_PROGRAM, 0, Ast::NONE, Ast::NONE);
+  std::uint32_t top  = (std::uint32_t)this->scratch.size();
+
+  while (this->peek().type != TokenType::T_EOF) {
+    if (this->peek().type == TokenType::T_IMPORT)
+      this->scratch.push_back(this->parse_import());
+    else if (this->peek().type == TokenType::T_FN)
+      this->scratch.push_back(this->parse_fn());
+    else if (this->peek().type == TokenType::T_LET)
+      this->scratch.push_back(this->parse_let());
+    else
+      this->unexpected();
+  }
+
+  this->ast.data[root].lhs = this->make_list(top);
+
+  return std::move(this->ast);
+}
+
+std::uint32_t Parser::parse_import()
+{
+  this->expect(TokenType::T_IMPORT);
+  std::uint32_t name = this->expect(TokenType::T_ID);
+  this->expect(TokenType::T_SEMICOLON);
+
+  return this->ast.add_node(AstKind::N_IMPORT, name, Ast::NONE, Ast::NONE);
+}
+
+std::uint32_t Parser::parse_fn()
+{
+  this->expect(TokenType::T_FN);
+  std::uint32_t name = this->expect(TokenType::T_ID);
+  this->expect(TokenType::T_LPAREN);
+
+  std::uint32_t top = (std::uint32_t)this->scratch.size();
+  while (this->peek().type != TokenType::T_RPAREN) {
+    if (this->peek().type == TokenType::T_ELLIPSIS) {
+      std::uint32_t token = this->advance();
+      this->scratch.push_back(
+          this->ast.add_node(AstKind::N_VARIADIC, token, Ast::NONE, Ast::NONE));
+      break;
+    }
+
+    this->scratch.push_back(this->parse_param());
+
+    if (this->peek().type != TokenType::T_COMMA)
+      break;
+    this->advance();
+  }
+  this->expect(TokenType::T_RPAREN);
+  std::uint32_t params = this->make_list(top);
+
+  std::uint32_t ret = Ast::NONE;
+  if (this->peek().type == TokenType::T_COLON) {
+    this->advance();
+    ret = this->parse_type();
+  }
+
+  std::uint32_t proto = this->ast.add_extra(params, ret);
+  std::uint32_t body  = this->parse_block();
+
+  return this->ast.add_node(AstKind::N_FN, name, proto, body);
+}
+
+std::uint32_t Parser::parse_param()
+{
+  std::uint32_t name = this->expect(TokenType::T_ID);
+  this->expect(TokenType::T_COLON);
+  std::uint32_t type = this->parse_type();
+
+  return this->ast.add_node(AstKind::N_PARAM, name, type, Ast::NONE);
+}
+
+std::uint32_t Parser::parse_type()
+{
+  std::uint32_t name = this->expect(TokenType::T_ID);
+
+  return this->ast.add_node(AstKind::N_TYPE, name, Ast::NONE, Ast::NONE);
+}
+
+std::uint32_t Parser::parse_stmt()
+{
+  switch (this->peek().type) {
+  case TokenType::T_LCURLY:
+    return this->parse_block();
+  case TokenType::T_LET:
+    return this->parse_let();
+  case TokenType::T_IF:
+    return this->parse_if();
+  case TokenType::T_WHILE:
+    return this->parse_while();
+  case TokenType::T_RETURN:
+    return this->parse_return();
+  default:
+    break;
+  }
+
+  std::uint32_t expr = this->parse_expr();
+  this->expect(TokenType::T_SEMICOLON);
+
+  return this->ast.add_node(AstKind::N_EXPR, this->ast.main_tokens[expr], expr, Ast::NONE);
+}
+
+std::uint32_t Parser::parse_block()
+{
+  std::uint32_t lcurly = this->expect(TokenType::T_LCURLY);
+
+  std::uint32_t top = (std::uint32_t)this->scratch.size();
+  while (this->peek().type != TokenType::T_RCURLY) {
+    if (this->peek().type == TokenType::T_EOF)
+      this->unexpected();
+    this->scratch.push_back(this->parse_stmt());
+  }
+  this->expect(TokenType::T_RCURLY);
+
+  return this->ast.add_node(AstKind::N_BLOCK, lcurly, this->make_list(top), Ast::NONE);
+}
+
+std::uint32_t Parser::parse_let()
+{
+  this->expect(TokenType::T_LET);
+  std::uint32_t name = this->expect(TokenType::T_ID);
+
+  std::uint32_t type = Ast::NONE;
+  if (this->peek().type == TokenType::T_COLON) {
+    this->advance();
+    type = this->parse_type();
+  }
+
+  std::uint32_t init = Ast::NONE;
+  if (this->peek().type == TokenType::T_ASSIGN) {
+    this->advance();
+    init = this->parse_expr();
+  }
+  this->expect(TokenType::T_SEMICOLON);
+
+  return this->ast.add_node(AstKind::N_LET, name, type, init);
+}
+
+std::uint32_t Parser::parse_if()
+{
+  std::uint32_t keyword = this->expect(TokenType::T_IF);
+  this->expect(TokenType::T_LPAREN);
+  std::uint32_t cond = this->parse_expr();
+  this->expect(TokenType::T_RPAREN);
+
+  std::uint32_t then = this->parse_stmt();
+  std::uint32_t other = Ast::NONE;
+  if (this->peek().type == TokenType::T_ELSE) {
+    this->advance();
+    other = this->parse_stmt();
+  }
+
+  return this->ast.add_node(AstKind::N_IF, keyword, cond, this->ast.add_extra(then, other));
+}
+
+std::uint32_t Parser::parse_while()
+{
+  std::uint32_t keyword = this->expect(TokenType::T_WHILE);
+  this->expect(TokenType::T_LPAREN);
+  std::uint32_t cond = this->parse_expr();
+  this->expect(TokenType::T_RPAREN);
+  std::uint32_t body = this->parse_stmt();
+
+  return this->ast.add_node(AstKind::N_WHILE, keyword, cond, body);
+}
+
+std::uint32_t Parser::parse_return()
+{
+  std::uint32_t keyword = this->expect(TokenType::T_RETURN);
+
+  std::uint32_t value = Ast::NONE;
+  if (this->peek().type != TokenType::T_SEMICOLON)
+    value = this->parse_expr();
+  this->expect(TokenType::T_SEMICOLON);
+
+  return this->ast.add_node(AstKind::N_RETURN, keyword, value, Ast::NONE);
+}
+
+std::uint32_t Parser::parse_expr(int precedence)
+{
+  std::uint32_t lhs = this->parse_prefix();
+
+  while (true) {
+    int op_precedence = infix_precedence(this->peek().type);
+    if (op_precedence == P_NONE || op_precedence < precedence)
+      break;
+
+    std::uint32_t op = this->advance();
+
+    if (op_precedence == P_ASSIGN) {
+      this->check_assignable(lhs, op);
+      std::uint32_t rhs = this->parse_expr(P_ASSIGN);
+      lhs               = this->ast.add_node(AstKind::N_ASSIGN, op, lhs, rhs);
+    } else if (op_precedence == P_TERNARY) {
+      std::uint32_t then = this->parse_expr();
+      this->expect(TokenType::T_COLON);
+      std::uint32_t other = this->parse_expr(P_TERNARY);
+      lhs = this->ast.add_node(AstKind::N_TERNARY, op, lhs, this->ast.add_extra(then, other));
+    } else {
+      std::uint32_t rhs = this->parse_expr(op_precedence + 1);
+      lhs               = this->ast.add_node(AstKind::N_BINARY, op, lhs, rhs);
+    }
+  }
+
+  return lhs;
+}
+
+std::uint32_t Parser::parse_prefix()
+{
+  if (this->peek().is_in(TokenType::T_ADD | TokenType::T_SUB | TokenType::T_NOT
+                         | TokenType::T_BNOT | TokenType::T_INCR | TokenType::T_DECR)) {
+    std::uint32_t op      = this->advance();
+    std::uint32_t operand = this->parse_expr(P_UNARY);
+
+    if (this->ast.tokens[op].is_in(TokenType::T_INCR | TokenType::T_DECR))
+      this->check_assignable(operand, op);
+
+    return this->ast.add_node(AstKind::N_UNARY, op, operand, Ast::NONE);
+  }
+
+  return this->parse_postfix(this->parse_primary());
+}
+
+std::uint32_t Parser::parse_postfix(std::uint32_t lhs)
+{
+  while (true) {
+    if (this->peek().type == TokenType::T_LPAREN) {
+      std::uint32_t op = this->advance();
+
+      std::uint32_t top = (std::uint32_t)this->scratch.size();
+      while (this->peek().type != TokenType::T_RPAREN) {
+        this->scratch.push_back(this->parse_expr());
+
+        if (this->peek().type != TokenType::T_COMMA)
+          break;
+        this->advance();
+      }
+      this->expect(TokenType::T_RPAREN);
+
+      lhs = this->ast.add_node(AstKind::N_CALL, op, lhs, this->make_list(top));
+    } else if (this->peek().type == TokenType::T_LBRACKET) {
+      std::uint32_t op    = this->advance();
+      std::uint32_t index = this->parse_expr();
+      this->expect(TokenType::T_RBRACKET);
+
+      lhs = this->ast.add_node(AstKind::N_INDEX, op, lhs, index);
+    } else if (this->peek().type == TokenType::T_POINT) {
+      std::uint32_t op = this->advance();
+      this->expect(TokenType::T_ID);
+
+      lhs = this->ast.add_node(AstKind::N_MEMBER, op, lhs, Ast::NONE);
+    } else if (this->peek().is_in(TokenType::T_INCR | TokenType::T_DECR)) {
+      std::uint32_t op = this->advance();
+      this->check_assignable(lhs, op);
+
+      lhs = this->ast.add_node(AstKind::N_POSTFIX, op, lhs, Ast::NONE);
+    } else
+      return lhs;
+  }
+}
+
+std::uint32_t Parser::parse_primary()
+{
+  AstKind kind;
+
+  switch (this->peek().type) {
+  case TokenType::T_NUMBER:
+    kind = AstKind::N_NUMBER;
+    break;
+  case TokenType::T_CHAR:
+    kind = AstKind::N_CHAR;
+    break;
+  case TokenType::T_STRING:
+    kind = AstKind::N_STRING;
+    break;
+  case TokenType::T_ID:
+    kind = AstKind::N_ID;
+    break;
+  case TokenType::T_LPAREN: {
+    this->advance();
+    std::uint32_t expr = this->parse_expr();
+    this->expect(TokenType::T_RPAREN);
+    return expr;
+  }
+  default:
+    this->unexpected();
+  }
+
+  return this->ast.add_node(kind, this->advance(), Ast::NONE, Ast::NONE);
+}
+
+std::uint32_t Parser::make_list(std::uint32_t scratch_top)
+{
+  std::uint32_t list = this->ast.add_list(
+      this->scratch.data() + scratch_top, (std::uint32_t)this->scratch.size() - scratch_top);
+  this->scratch.resize(scratch_top);
+
+  return list;
+}
+
+void Parser::check_assignable(std::uint32_t node, std::uint32_t op)
+{
+  AstKind kind = this->ast.kind(node);
+  if (kind == AstKind::N_ID || kind == AstKind::N_INDEX || kind == AstKind::N_MEMBER)
+    return;
+
+  Token &token = this->ast.tokens[op];
+  throw Error(token.loc, "Invalid operand of '%s'.", token.str());
+}
+
+int Parser::infix_precedence(TokenType type)
+{
+  switch (type) {
+  case TokenType::T_ASSIGN:
+  case TokenType::T_ADDASSIGN:
+  case TokenType::T_SUBASSIGN:
+  case TokenType::T_MULASSIGN:
+  case TokenType::T_DIVASSIGN:
+  case TokenType::T_MODASSIGN:
+  case TokenType::T_ANDASSIGN:
+  case TokenType::T_ORASSIGN:
+  case TokenType::T_XORASSIGN:
+    return P_ASSIGN;
+
+  case TokenType::T_QMARK:
+    return P_TERNARY;
+
+  case TokenType::T_OR:
+    return P_OR;
+  case TokenType::T_AND:
+    return P_AND;
+
+  case TokenType::T_BOR:
+    return P_BOR;
+  case TokenType::T_BXOR:
+    return P_BXOR;
+  case TokenType::T_BAND:
+    return P_BAND;
+
+  case TokenType::T_EQ:
+  case TokenType::T_NEQ:
+    return P_EQUALITY;
+
+  case TokenType::T_GT:
+  case TokenType::T_LT:
+  case TokenType::T_GEQ:
+  case TokenType::T_LEQ:
+    return P_RELATIONAL;
+
+  case TokenType::T_ADD:
+  case TokenType::T_SUB:
+    return P_ADDITIVE;
+
+  case TokenType::T_MUL:
+  case TokenType::T_DIV:
+  case TokenType::T_MOD:
+    return P_MULTIPLICATIVE;
+
+  default:
+    return P_NONE;
+  }
+}
+
+// Tokens from a pipeline are taken a batch at a time, when the parser reaches the end of those it
+// has; the last batch ends with T_EOF, past which the parser never moves.
+Token &Parser::peek()
+{
+  if (this->i == this->ast.tokens.size())
+    this->pipeline->next(this->ast.tokens);
+
+  return this->ast.tokens[this->i];
+}
+
+std::uint32_t Parser::advance()
+{
+  std::uint32_t token = this->i;
+  if (this->peek().type != TokenType::T_EOF)
+    this->i++;
+
+  return token;
+}
+
+std::uint32_t Parser::expect(TokenType type)
+{
+  if (this->peek().type != type) {
+    Token &token = this->peek();
+    throw Error(token.loc, "Expected '%s', got '%s'.",
+                type == TokenType::T_ID ? "identifier" : Token(type, SourceManager::NONE).str(),
+                token.str());
+  }
+
+  return this->advance();
+}
+
+void Parser::unexpected()
+{
+  Token &token = this->peek();
+
+  if (token.type == TokenType::T_EOF)
+    throw Error(token.loc, "Unexpected end of file.");
+
+  throw Error(token.loc, "Unexpected token: %s", token.str());
+}
@@ -0,0 +1,72 @@
+#ifndef PARSER_HPP
+#define PARSER_HPP
+
+#include "ast/ast.hpp"
+#include "error/error.hpp"
+#include "pipeline/pipeline.hpp"
+#include "token/token.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Parser {
+  enum Precedence {
+    P_NONE,
+    P_ASSIGN,
+    P_TERNARY,
+    P_OR,
+    P_AND,
+    P_BOR,
+    P_BXOR,
+    P_BAND,
+    P_EQUALITY,
+    P_RELATIONAL,
+    P_ADDITIVE,
+    P_MULTIPLICATIVE,
+    P_UNARY,
+  };
+
+  Ast ast;
+
+  std::uint32_t i;
+  TokenPipeline *pipeline;
+
+  std::vector<std::uint32_t> scratch;
+
+  public:
+  Parser(std::vector<Token> tokens);
+  // Parses the tokens of `pipeline` as they arrive, while the rest of the source is being lexed.
+  Parser(TokenPipeline &pipeline);
+
+  Ast parse();
+
+  private:
+  std::uint32_t parse_import();
+  std::uint32_t parse_fn();
+  std::uint32_t parse_param();
+  std::uint32_t parse_type();
+
+  std::uint32_t parse_stmt();
+  std::uint32_t parse_block();
+  std::uint32_t parse_let();
+  std::uint32_t parse_if();
+  std::uint32_t parse_while();
+  std::uint32_t parse_return();
+
+  std::uint32_t parse_expr(int precedence = P_ASSIGN);
+  std::uint32_t parse_prefix();
+  std::uint32_t parse_postfix(std::uint32_t lhs);
+  std::uint32_t parse_primary();
+
+  std::uint32_t make_list(std::uint32_t scratch_top);
+  void check_assignable(std::uint32_t node, std::uint32_t op);
+
+  static int infix_precedence(TokenType type);
+
+  Token &peek();
+  std::uint32_t advance();
+  std::uint32_t expect(TokenType type);
+  [[noreturn]] void unexpected();
+};
+
+#endif
@@ -0,0 +1,64 @@
+#include "pipeline.hpp"
+#include <iterator>
+
+TokenPipeline::TokenPipeline(Lexer &lexer) : closed(false)
+{
+  this->thread = std::thread([this, &lexer] { this->lex(lexer); });
+}
+
+TokenPipeline::~TokenPipeline()
+{
+  this->closed.store(true, std::memory_order_relaxed);
+  this->thread.join();
+}
+
+void TokenPipeline::next(std::vector<Token> &tokens)
+{
+  Batch batch;
+  while (!this->ring.try_pop(batch))
+    std::this_thread::yield();
+
+  if (batch.error)
+    std::rethrow_exception(batch.error);
+
+  tokens.insert(tokens.end(), std::make_move_iterator(batch.tokens.begin()),
+                std::make_move_iterator(batch.tokens.end()));
+}
+
+void TokenPipeline::lex(Lexer &lexer)
+{
+  Batch batch;
+  batch.tokens.reserve(BATCH_SIZE);
+
+  try {
+    for (;;) {
+      Token token = lexer.next();
+      bool end    = token.type == TokenType::T_EOF;
+
+      batch.tokens.push_back(std::move(token));
+      if (end || batch.tokens.size() == BATCH_SIZE) {
+        if (!this->publish(batch) || end)
+          return;
+        batch.tokens.reserve(BATCH_SIZE);
+      }
+    }
+  } catch (...) {
+    batch.tokens.clear();
+    batch.error = std::current_exception();
+    this->publish(batch);
+  }
+}
+
+// Waits for room in the ring and moves `batch` into it, leaving it empty. Returns false when the
+// consumer is gone.
+bool TokenPipeline::publish(Batch &batch)
+{
+  while (!this->ring.try_push(batch)) {
+    if (this->closed.load(std::memory_order_relaxed))
+      return false;
+    std::this_thread::yield();
+  }
+
+  batch.tokens.clear();
+  return true;
+}
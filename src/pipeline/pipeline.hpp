@@ -0,0 +1,47 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include "lexer/lexer.hpp"
+#include "ring/ring.hpp"
+#include "token/token.hpp"
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Runs a lexer on a thread of its own, publishing its tokens in batches through a ring that the
+// parser consumes on the calling thread, so that lexing and parsing a large source overlap. The
+// lexer waits while the ring is full, so it runs at most RING_SIZE batches ahead.
+//
+// The last batch ends with T_EOF, or carries the error that stopped the lexer, which next()
+// rethrows on the consumer's thread. A pipeline destroyed early, such as when the parser fails,
+// stops the lexer at its next batch.
+class TokenPipeline {
+  struct Batch {
+    std::vector<Token> tokens;
+    std::exception_ptr error;
+  };
+
+  static constexpr std::size_t RING_SIZE = 16;
+
+  Ring<Batch, RING_SIZE> ring;
+  std::atomic<bool> closed;
+  std::thread thread;
+
+  public:
+  static constexpr std::size_t BATCH_SIZE = 4096;
+
+  // Starts lexing with `lexer`, which must outlive the pipeline.
+  TokenPipeline(Lexer &lexer);
+  ~TokenPipeline();
+
+  // Appends the next batch of tokens to `tokens`, waiting for the lexer if it is behind.
+  void next(std::vector<Token> &tokens);
+
+  private:
+  void lex(Lexer &lexer);
+  bool publish(Batch &batch);
+};
+
+#endif
@@ -0,0 +1,19 @@
+#include "prelude.hpp"
+#include "compiler/compiler.hpp"
+#include "folder/folder.hpp"
+#include "interface/interface.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+
+std::string prelude_image(SourceManager &sources, std::uint32_t buffer)
+{
+  Lexer lexer(sources, buffer);
+  Parser parser(lexer.tokenize());
+  Ast ast = parser.parse();
+
+  Folder folder(ast);
+  folder.fold();
+
+  Compiler compiler(ast);
+  return Interface::image(compiler.compile_module({}), { 0, 0 }, {});
+}
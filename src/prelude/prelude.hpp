@@ -0,0 +1,23 @@
+#ifndef PRELUDE_HPP
+#define PRELUDE_HPP
+
+#include "source/source.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// The standard prelude, prelude.tl, holds the functions that every program may call without an
+// import. It is compiled once, when tela is built, into an interface image that is linked into
+// the executable as read-only data and used in place, so running a program never lexes, parses
+// or compiles it.
+
+// The image linked into the tela executable, aligned to 8 bytes. It is defined by the source
+// that tela-snapshot generates, so other executables, such as the tests, build their own.
+extern const char PRELUDE_SNAPSHOT[];
+extern const std::size_t PRELUDE_SNAPSHOT_SIZE;
+
+// Compiles the prelude in the source `buffer` of `sources` into an interface image, throwing an
+// Error when it does not compile.
+std::string prelude_image(SourceManager &sources, std::uint32_t buffer);
+
+#endif
@@ -0,0 +1,524 @@
+#include "query.hpp"
+#include "error/error.hpp"
+#include "lexer/lexer.hpp"
+#include "module/module.hpp"
+#include "parser/parser.hpp"
+#include <algorithm>
+#include <unordered_set>
+
+QueryDatabase::QueryDatabase(SourceManager &sources,
+                             const std::vector<Bytecode::Function> *prelude)
+    : sources(sources)
+{
+  this->prelude  = prelude;
+  this->revision = 1;
+  this->runs.resize((std::size_t)Kind::Q_CHECK + 1);
+}
+
+void QueryDatabase::set_source(const std::string &path, std::string contents)
+{
+  Slot &slot         = this->slots[this->slot(Kind::Q_SOURCE, path, "")];
+  std::uint64_t hash = QueryDatabase::hash(contents);
+
+  this->collect(path);
+  this->revision++;
+  if (!slot.computed || !slot.present || slot.hash != hash) {
+    slot.text    = std::move(contents);
+    slot.present = true;
+    slot.hash    = hash;
+    slot.changed = this->revision;
+  }
+  slot.computed = true;
+  slot.verified = this->revision;
+}
+
+// The results of the other queries of the source are dropped along with the buffers they refer
+// to, but not its exports, which its importers compare with the exports they had.
+void QueryDatabase::remove_source(const std::string &path)
+{
+  Slot &slot = this->slots[this->slot(Kind::Q_SOURCE, path, "")];
+
+  this->revision++;
+  if (!slot.computed || slot.present) {
+    slot.text    = std::string();
+    slot.present = false;
+    slot.hash    = 0;
+    slot.changed = this->revision;
+  }
+  slot.computed = true;
+  slot.verified = this->revision;
+
+  for (std::uint32_t index : this->files[path].slots) {
+    Slot &query = this->slots[index];
+    if (query.kind == Kind::Q_SOURCE || query.kind == Kind::Q_EXPORTS)
+      continue;
+
+    query.computed    = false;
+    query.tokens      = std::vector<Token>();
+    query.ast         = nullptr;
+    query.checker     = nullptr;
+    query.exports     = Compiler::Exports();
+    query.diagnostics = std::vector<Checker::Diagnostic>();
+  }
+  this->collect(path);
+}
+
+const std::vector<Token> &QueryDatabase::tokens(const std::string &path)
+{
+  return this->require(Kind::Q_TOKENS, path).tokens;
+}
+
+Ast &QueryDatabase::parse(const std::string &path)
+{
+  return *this->require(Kind::Q_PARSE, path).ast;
+}
+
+const std::string &QueryDatabase::signature(const std::string &path, const std::string &name)
+{
+  return this->require(Kind::Q_SIGNATURE, path, name).text;
+}
+
+std::vector<std::string> QueryDatabase::imports(const std::string &path)
+{
+  const std::string &text = this->require(Kind::Q_IMPORTS, path).text;
+  std::vector<std::string> names;
+
+  for (std::size_t start = 0, end; start < text.size(); start = end + 1) {
+    end = text.find('\n', start);
+    names.push_back(text.substr(start, end - start));
+  }
+
+  return names;
+}
+
+const std::vector<Bytecode::Function> &QueryDatabase::exports(const std::string &path)
+{
+  return this->require(Kind::Q_EXPORTS, path).functions;
+}
+
+const std::vector<Checker::Diagnostic> &QueryDatabase::check(const std::string &path,
+                                                             const std::string &name)
+{
+  return this->require(Kind::Q_CHECK, path, name).diagnostics;
+}
+
+std::vector<Checker::Diagnostic> QueryDatabase::check(const std::string &path)
+{
+  std::vector<Checker::Diagnostic> diagnostics =
+      this->require(Kind::Q_DECLARATIONS, path).diagnostics;
+  Ast &ast = this->parse(path);
+
+  std::uint32_t decls       = ast.lhs(0);
+  const std::uint32_t *item = ast.list_items(decls);
+  std::unordered_set<std::string> checked;
+
+  for (std::uint32_t i = 0; i < ast.list_size(decls); i++) {
+    const std::string &name = ast.token(item[i]).value;
+    if (ast.kind(item[i]) != AstKind::N_FN || !checked.insert(name).second)
+      continue;
+
+    for (const Checker::Diagnostic &diagnostic : this->check(path, name))
+      diagnostics.push_back(diagnostic);
+  }
+
+  std::stable_sort(diagnostics.begin(), diagnostics.end(),
+                   [this](const Checker::Diagnostic &a, const Checker::Diagnostic &b) {
+                     SourcePosition x = this->sources.resolve(a.loc);
+                     SourcePosition y = this->sources.resolve(b.loc);
+                     return x.row != y.row ? x.row < y.row : x.col < y.col;
+                   });
+
+  return diagnostics;
+}
+
+std::uint32_t QueryDatabase::executions(Kind kind) const
+{
+  return this->runs[(std::size_t)kind];
+}
+
+std::uint32_t QueryDatabase::slot(Kind kind, const std::string &path, const std::string &name)
+{
+  std::string key = (char)kind + path + '\0' + name;
+
+  auto found = this->keys.find(key);
+  if (found != this->keys.end())
+    return found->second;
+
+  std::uint32_t index = (std::uint32_t)this->slots.size();
+  this->slots.emplace_back();
+
+  Slot &slot    = this->slots.back();
+  slot.kind     = kind;
+  slot.path     = path;
+  slot.name     = name;
+  slot.computed = false;
+  slot.active   = false;
+  slot.present  = false;
+  slot.hash     = 0;
+  slot.changed  = 0;
+  slot.verified = 0;
+
+  this->keys.emplace(std::move(key), index);
+  this->files[path].slots.push_back(index);
+  return index;
+}
+
+// Brings the query up to date, as a dependency of the query that is running if there is one.
+QueryDatabase::Slot &QueryDatabase::require(Kind kind, const std::string &path,
+                                            const std::string &name)
+{
+  std::uint32_t index = this->slot(kind, path, name);
+
+  if (!this->running.empty())
+    this->slots[this->running.back()].dependencies.push_back(index);
+  this->update(index);
+
+  return this->slots[index];
+}
+
+void QueryDatabase::update(std::uint32_t index)
+{
+  Slot &slot = this->slots[index];
+
+  if (slot.computed && slot.verified == this->revision)
+    return;
+  if (slot.active)
+    throw Error("Cyclic query for '%s'.", slot.path.c_str());
+  // A source that was never set is not present, as one that was removed.
+  if (slot.kind == Kind::Q_SOURCE) {
+    if (!slot.computed)
+      slot.changed = this->revision;
+    slot.computed = true;
+    slot.verified = this->revision;
+    return;
+  }
+
+  // The result stands if none of the queries it read changed since it was last verified, which
+  // they are first brought up to date to find out.
+  if (slot.computed) {
+    bool changed = false;
+
+    for (std::size_t i = 0; i < slot.dependencies.size() && !changed; i++) {
+      this->update(slot.dependencies[i]);
+      changed = this->slots[slot.dependencies[i]].changed > slot.verified;
+    }
+
+    if (!changed) {
+      slot.verified = this->revision;
+      return;
+    }
+  }
+
+  this->execute(index);
+}
+
+// Releases the buffers of a source that no memoized result refers to: those of earlier contents
+// whose tokens, AST and diagnostics have all been computed again since. The tokens of one lexing
+// all come from the same buffer.
+void QueryDatabase::collect(const std::string &path)
+{
+  File &file = this->files[path];
+  std::unordered_set<std::uint32_t> used;
+
+  auto use = [&used](SourceLoc loc) {
+    if (loc != SourceManager::NONE)
+      used.insert(SourceManager::source(loc));
+  };
+
+  for (std::uint32_t index : file.slots) {
+    Slot &slot = this->slots[index];
+
+    if (!slot.tokens.empty())
+      use(slot.tokens.front().loc);
+    if (slot.ast != nullptr && !slot.ast->tokens.empty())
+      use(slot.ast->tokens.front().loc);
+    for (const Checker::Diagnostic &diagnostic : slot.diagnostics)
+      use(diagnostic.loc);
+  }
+
+  auto unused = std::partition(file.buffers.begin(), file.buffers.end(),
+                               [&used](std::uint32_t buffer) { return used.count(buffer) != 0; });
+  for (auto buffer = unused; buffer != file.buffers.end(); buffer++)
+    this->sources.release(*buffer);
+  file.buffers.erase(unused, file.buffers.end());
+}
+
+void QueryDatabase::execute(std::uint32_t index)
+{
+  Slot &slot = this->slots[index];
+  std::uint64_t hash;
+
+  slot.dependencies.clear();
+  slot.active = true;
+  this->running.push_back(index);
+  this->runs[(std::size_t)slot.kind]++;
+
+  try {
+    hash = this->compute(slot);
+  } catch (...) {
+    slot.computed = false;
+    slot.active   = false;
+    this->running.pop_back();
+    throw;
+  }
+
+  slot.active = false;
+  this->running.pop_back();
+
+  if (slot.changed == 0 || slot.hash != hash) {
+    slot.hash    = hash;
+    slot.changed = this->revision;
+  }
+  slot.computed = true;
+  slot.verified = this->revision;
+}
+
+std::uint64_t QueryDatabase::compute(Slot &slot)
+{
+  switch (slot.kind) {
+  case Kind::Q_TOKENS:
+    return this->compute_tokens(slot);
+  case Kind::Q_PARSE:
+    return this->compute_parse(slot);
+  case Kind::Q_ITEM:
+    return this->compute_item(slot);
+  case Kind::Q_SIGNATURE:
+    return this->compute_signature(slot);
+  case Kind::Q_IMPORTS:
+    return this->compute_imports(slot);
+  case Kind::Q_EXPORTS:
+    return this->compute_exports(slot);
+  case Kind::Q_DECLARATIONS:
+    return this->compute_declarations(slot);
+  case Kind::Q_CHECK:
+    return this->compute_check(slot);
+  default:
+    throw Error("Unknown query.");
+  }
+}
+
+std::uint64_t QueryDatabase::compute_tokens(Slot &slot)
+{
+  Slot &source = this->require(Kind::Q_SOURCE, slot.path);
+  if (!source.present)
+    throw Error("Unknown source: %s", slot.path.c_str());
+
+  std::uint32_t buffer = this->sources.add(slot.path, source.text);
+  Lexer lexer(this->sources, buffer);
+  std::string key;
+
+  this->files[slot.path].buffers.push_back(buffer);
+  slot.tokens = lexer.tokenize();
+  for (Token &token : slot.tokens) {
+    key += std::to_string((long long)token.type) + ' ' + this->position(token.loc) + ' ';
+    key += token.value;
+    key += '\0';
+  }
+
+  return QueryDatabase::hash(key);
+}
+
+// The checker of Q_DECLARATIONS refers to the AST, so a new one always counts as a change.
+std::uint64_t QueryDatabase::compute_parse(Slot &slot)
+{
+  Parser parser(this->require(Kind::Q_TOKENS, slot.path).tokens);
+  slot.ast.reset(new Ast(parser.parse()));
+
+  return this->revision;
+}
+
+std::uint64_t QueryDatabase::compute_item(Slot &slot)
+{
+  Ast &ast                  = *this->require(Kind::Q_PARSE, slot.path).ast;
+  std::uint32_t decls       = ast.lhs(0);
+  const std::uint32_t *item = ast.list_items(decls);
+  std::uint32_t first       = 1;
+  std::string key;
+
+  // The nodes of a declaration are added right before the declaration itself.
+  slot.nodes.clear();
+  for (std::uint32_t i = 0; i < ast.list_size(decls); first = item[i++] + 1) {
+    if (ast.token(item[i]).value != slot.name)
+      continue;
+
+    slot.nodes.push_back(first);
+    slot.nodes.push_back(item[i]);
+
+    key += ast.dump(item[i]);
+    for (std::uint32_t node = first; node <= item[i]; node++)
+      key += this->position(ast.token(node).loc) + ' ';
+  }
+
+  return QueryDatabase::hash(key);
+}
+
+std::uint64_t QueryDatabase::compute_signature(Slot &slot)
+{
+  Ast &ast = *this->require(Kind::Q_PARSE, slot.path).ast;
+  std::vector<std::uint32_t> &nodes = this->require(Kind::Q_ITEM, slot.path, slot.name).nodes;
+
+  auto type = [&ast](std::uint32_t node) {
+    return node == Ast::NONE ? std::string("any") : ast.token(node).value;
+  };
+
+  slot.text.clear();
+  for (std::size_t i = 1; i < nodes.size() && slot.text.empty(); i += 2) {
+    std::uint32_t node = nodes[i];
+
+    if (ast.kind(node) == AstKind::N_FN) {
+      std::uint32_t params = ast.extra[ast.lhs(node)];
+
+      slot.text = "fn(";
+      for (std::uint32_t j = 0; j < ast.list_size(params); j++) {
+        std::uint32_t param = ast.list_items(params)[j];
+        slot.text += ast.kind(param) == AstKind::N_VARIADIC ? "..." : type(ast.lhs(param));
+        slot.text += j + 1 < ast.list_size(params) ? ", " : "";
+      }
+      slot.text += "): " + type(ast.extra[ast.lhs(node) + 1]);
+    } else if (ast.kind(node) == AstKind::N_LET) {
+      slot.text = "let: " + type(ast.lhs(node));
+    }
+  }
+
+  return QueryDatabase::hash(slot.text);
+}
+
+std::uint64_t QueryDatabase::compute_imports(Slot &slot)
+{
+  Ast &ast                  = *this->require(Kind::Q_PARSE, slot.path).ast;
+  std::uint32_t decls       = ast.lhs(0);
+  const std::uint32_t *item = ast.list_items(decls);
+
+  slot.text.clear();
+  for (std::uint32_t i = 0; i < ast.list_size(decls); i++) {
+    if (ast.kind(item[i]) == AstKind::N_IMPORT)
+      slot.text += ast.token(item[i]).value + '\n';
+  }
+
+  return QueryDatabase::hash(slot.text);
+}
+
+// Functions are compared by what an importer's checker sees of them: their names and arities.
+std::uint64_t QueryDatabase::compute_exports(Slot &slot)
+{
+  slot.functions.clear();
+  slot.present = this->require(Kind::Q_SOURCE, slot.path).present;
+  if (!slot.present)
+    return QueryDatabase::hash("-");
+
+  Ast &ast                  = *this->require(Kind::Q_PARSE, slot.path).ast;
+  std::uint32_t decls       = ast.lhs(0);
+  const std::uint32_t *item = ast.list_items(decls);
+  std::string key           = "+";
+
+  for (std::uint32_t i = 0; i < ast.list_size(decls); i++) {
+    if (ast.kind(item[i]) != AstKind::N_FN)
+      continue;
+
+    std::uint32_t params        = ast.extra[ast.lhs(item[i])];
+    Bytecode::Function function = { ast.token(item[i]).value, 0, 0, 0, 0, false };
+
+    for (std::uint32_t j = 0; j < ast.list_size(params); j++) {
+      if (ast.kind(ast.list_items(params)[j]) == AstKind::N_VARIADIC)
+        function.variadic = true;
+      else
+        function.params++;
+    }
+
+    key += function.name + ' ' + std::to_string(function.params);
+    key += function.variadic ? "...\n" : "\n";
+    slot.functions.push_back(std::move(function));
+  }
+
+  return QueryDatabase::hash(key);
+}
+
+std::uint64_t QueryDatabase::compute_declarations(Slot &slot)
+{
+  Ast &ast = *this->require(Kind::Q_PARSE, slot.path).ast;
+
+  slot.exports.clear();
+  this->import(slot.path, slot.exports);
+  slot.checker.reset(new Checker(ast, this->types, 1, &slot.exports, this->prelude));
+  slot.diagnostics = slot.checker->check_declarations();
+
+  return this->hash(slot.diagnostics);
+}
+
+// A function is checked against the signatures of the names it mentions and the exports of the
+// imported modules, so it only depends on those and not on the other declarations. Node indices change as
+// other declarations do, so the checker is read without depending on it.
+std::uint64_t QueryDatabase::compute_check(Slot &slot)
+{
+  std::vector<std::uint32_t> &nodes = this->require(Kind::Q_ITEM, slot.path, slot.name).nodes;
+  Compiler::Exports exports;
+  this->import(slot.path, exports);
+  this->require(Kind::Q_SIGNATURE, slot.path, slot.name);
+
+  std::uint32_t index = this->slot(Kind::Q_DECLARATIONS, slot.path, "");
+  this->update(index);
+  Checker &checker = *this->slots[index].checker;
+  Ast &ast         = *this->slots[this->slot(Kind::Q_PARSE, slot.path, "")].ast;
+
+  slot.diagnostics.clear();
+  for (std::size_t i = 1; i < nodes.size(); i += 2) {
+    if (ast.kind(nodes[i]) != AstKind::N_FN)
+      continue;
+
+    for (std::uint32_t node = nodes[i - 1]; node < nodes[i]; node++) {
+      if (ast.kind(node) == AstKind::N_ID)
+        this->require(Kind::Q_SIGNATURE, slot.path, ast.token(node).value);
+    }
+
+    for (Checker::Diagnostic &diagnostic : checker.check_function(nodes[i]))
+      slot.diagnostics.push_back(std::move(diagnostic));
+  }
+
+  return this->hash(slot.diagnostics);
+}
+
+// The exports of the modules that the source at `path` imports, by the names they are imported
+// as, which the running query comes to depend on. Missing modules are left out, for the checker
+// to report, and the prelude is the one of the database.
+void QueryDatabase::import(const std::string &path, Compiler::Exports &exports)
+{
+  for (const std::string &name : this->imports(path)) {
+    if (name == Compiler::PRELUDE && this->prelude != nullptr) {
+      exports[name] = *this->prelude;
+      continue;
+    }
+
+    Slot &module = this->require(Kind::Q_EXPORTS, Modules::module_path(path, name));
+    if (module.present)
+      exports[name] = module.functions;
+  }
+}
+
+std::string QueryDatabase::position(SourceLoc loc) const
+{
+  SourcePosition position = this->sources.resolve(loc);
+  return std::to_string(position.row) + ':' + std::to_string(position.col);
+}
+
+std::uint64_t QueryDatabase::hash(const std::vector<Checker::Diagnostic> &diagnostics) const
+{
+  std::string key;
+
+  for (const Checker::Diagnostic &diagnostic : diagnostics)
+    key += this->position(diagnostic.loc) + ' ' + diagnostic.message + '\0';
+
+  return QueryDatabase::hash(key);
+}
+
+// FNV-1a.
+std::uint64_t QueryDatabase::hash(std::string_view data)
+{
+  std::uint64_t hash = 0xcbf29ce484222325;
+
+  for (char c : data) {
+    hash ^= (unsigned char)c;
+    hash *= 0x100000001b3;
+  }
+
+  return hash;
+}
@@ -0,0 +1,160 @@
+#ifndef QUERY_HPP
+#define QUERY_HPP
+
+#include "ast/ast.hpp"
+#include "bytecode/bytecode.hpp"
+#include "checker/checker.hpp"
+#include "compiler/compiler.hpp"
+#include "source/source.hpp"
+#include "token/token.hpp"
+#include "types/types.hpp"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// The phases of the compiler as memoized queries over a set of sources, for a long-running tool
+// that checks the same files again as they are edited. Every query records the queries it reads
+// while it runs, and its result is kept along with a hash of it and the revisions at which it
+// last changed and was last known to be up to date.
+//
+// Setting a source starts a new revision. A query asked for again is only run again if one of
+// its dependencies changed since it was last verified, which is found by verifying those first,
+// and a result that hashes equal to the previous one does not count as a change, so the queries
+// that depend on it are cut off early: editing the body of a function only checks that function
+// again, unless its signature changed, in which case the functions that mention it are checked
+// again as well. Hashes cover the positions of tokens, so that memoized diagnostics keep pointing
+// at the right rows and columns.
+//
+// The queries of a source are:
+//   Q_SOURCE        its contents, set from outside;
+//   Q_TOKENS        its tokens, as lexed by Lexer::tokenize();
+//   Q_PARSE         its AST;
+//   Q_ITEM          the top-level declarations of a name;
+//   Q_SIGNATURE     the signature of the first of them, which the checker sees of the name;
+//   Q_IMPORTS       the modules it imports;
+//   Q_EXPORTS       the functions it exports as a module, as its importers see them;
+//   Q_DECLARATIONS  the diagnostics of the top-level declarations and the global initializers;
+//   Q_CHECK         the diagnostics of the functions of a name.
+//
+// Modules are looked up among the sources of the database, by the path Modules::module_path()
+// gives them. The checks of a source depend on the exports of the modules it imports, so
+// removing or renaming a function of a module, or removing the module, checks its importers
+// again; editing the bodies of its functions does not.
+//
+// Errors thrown by the lexer or the parser go to the caller and are not memoized, so the query
+// runs again when it is next asked for. A database is used by one thread at a time.
+//
+// Every lexing of a source takes a buffer of the SourceManager. Memoized results keep referring
+// to the buffers they were computed from, so the buffers of a source that none of them refers
+// to any more are released when the source is next set.
+class QueryDatabase {
+  public:
+  enum class Kind : std::uint8_t {
+    Q_SOURCE,
+    Q_TOKENS,
+    Q_PARSE,
+    Q_ITEM,
+    Q_SIGNATURE,
+    Q_IMPORTS,
+    Q_EXPORTS,
+    Q_DECLARATIONS,
+    Q_CHECK,
+  };
+
+  private:
+  struct Slot {
+    Kind kind;
+    std::string path;
+    std::string name;
+
+    bool computed;
+    bool active;
+    std::uint64_t hash;
+    std::uint64_t changed;
+    std::uint64_t verified;
+    std::vector<std::uint32_t> dependencies;
+
+    // The result, in the fields that the kind of query uses. The nodes of a Q_ITEM are pairs of
+    // the first node of a declaration and the declaration itself. A Q_SOURCE or a Q_EXPORTS is
+    // not present when there is no source at its path.
+    std::string text;
+    bool present;
+    std::vector<Token> tokens;
+    std::unique_ptr<Ast> ast;
+    std::vector<std::uint32_t> nodes;
+    std::vector<Bytecode::Function> functions;
+    Compiler::Exports exports;
+    std::unique_ptr<Checker> checker;
+    std::vector<Checker::Diagnostic> diagnostics;
+  };
+
+  // The queries of a source and the buffers it was lexed into.
+  struct File {
+    std::vector<std::uint32_t> slots;
+    std::vector<std::uint32_t> buffers;
+  };
+
+  SourceManager &sources;
+  const std::vector<Bytecode::Function> *prelude;
+  TypeTable types;
+
+  std::deque<Slot> slots;
+  std::unordered_map<std::string, std::uint32_t> keys;
+  std::unordered_map<std::string, File> files;
+  std::vector<std::uint32_t> running;
+  std::uint64_t revision;
+  std::vector<std::uint32_t> runs;
+
+  public:
+  // The functions of `prelude` are in scope in every source, as for the Checker.
+  QueryDatabase(SourceManager &sources,
+                const std::vector<Bytecode::Function> *prelude = nullptr);
+
+  // Sets the contents of the source at `path`, starting a new revision.
+  void set_source(const std::string &path, std::string contents);
+  // Removes the source at `path`, starting a new revision. Its queries fail as for a source that
+  // was never set, and its importers are checked as if the module did not exist.
+  void remove_source(const std::string &path);
+
+  const std::vector<Token> &tokens(const std::string &path);
+  Ast &parse(const std::string &path);
+  const std::string &signature(const std::string &path, const std::string &name);
+  std::vector<std::string> imports(const std::string &path);
+  const std::vector<Bytecode::Function> &exports(const std::string &path);
+  const std::vector<Checker::Diagnostic> &check(const std::string &path, const std::string &name);
+  // Every diagnostic of the source, in source order.
+  std::vector<Checker::Diagnostic> check(const std::string &path);
+
+  // How many times queries of `kind` have run.
+  std::uint32_t executions(Kind kind) const;
+
+  private:
+  std::uint32_t slot(Kind kind, const std::string &path, const std::string &name);
+  Slot &require(Kind kind, const std::string &path, const std::string &name = "");
+  void update(std::uint32_t index);
+  void collect(const std::string &path);
+  void execute(std::uint32_t index);
+  std::uint64_t compute(Slot &slot);
+  std::uint64_t compute_parse(Slot &slot);
+
+  std::uint64_t compute_tokens(Slot &slot);
+  std::uint64_t compute_item(Slot &slot);
+  std::uint64_t compute_signature(Slot &slot);
+  std::uint64_t compute_imports(Slot &slot);
+  std::uint64_t compute_exports(Slot &slot);
+  std::uint64_t compute_declarations(Slot &slot);
+  std::uint64_t compute_check(Slot &slot);
+
+  void import(const std::string &path, Compiler::Exports &exports);
+  std::string position(SourceLoc loc) const;
+  std::uint64_t hash(const std::vector<Checker::Diagnostic> &diagnostics) const;
+  static std::uint64_t hash(std::string_view data);
+};
+
+typedef QueryDatabase::Kind QueryKind;
+
+#endif
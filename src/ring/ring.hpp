@@ -0,0 +1,63 @@
+#ifndef RING_HPP
+#define RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Bounded queue of N items, N a power of two, between one producer thread and one consumer
+// thread, without locks. Positions only ever grow and wrap around the slots, so the queue is full
+// when they are N apart. Each side keeps the last position of the other side that it read, and
+// only reads the shared one again when that copy says the queue is full or empty, so the two
+// threads rarely touch the same cache line.
+template <typename T, std::size_t N> class Ring {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "The size of a ring must be a power of two.");
+
+  T slots[N];
+
+  alignas(64) std::atomic<std::size_t> head;
+  std::size_t cached_tail;
+
+  alignas(64) std::atomic<std::size_t> tail;
+  std::size_t cached_head;
+
+  public:
+  Ring() : slots(), head(0), cached_tail(0), tail(0), cached_head(0) {}
+
+  Ring(const Ring &)            = delete;
+  Ring &operator=(const Ring &) = delete;
+
+  // Moves `item` in, unless the ring is full. Only called by the producer.
+  bool try_push(T &item)
+  {
+    std::size_t tail = this->tail.load(std::memory_order_relaxed);
+
+    if (tail - this->cached_head == N) {
+      this->cached_head = this->head.load(std::memory_order_acquire);
+      if (tail - this->cached_head == N)
+        return false;
+    }
+
+    this->slots[tail % N] = std::move(item);
+    this->tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Moves the oldest item out into `item`, unless the ring is empty. Only called by the consumer.
+  bool try_pop(T &item)
+  {
+    std::size_t head = this->head.load(std::memory_order_relaxed);
+
+    if (head == this->cached_tail) {
+      this->cached_tail = this->tail.load(std::memory_order_acquire);
+      if (head == this->cached_tail)
+        return false;
+    }
+
+    item = std::move(this->slots[head % N]);
+    this->head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+};
+
+#endif
@@ -0,0 +1,251 @@
+#include "scheduler.hpp"
+#include <algorithm>
+#include <thread>
+
+// Index of the worker running on this thread, so that tasks made ready by a worker stay on it.
+static thread_local std::uint32_t current = Scheduler::NONE;
+
+Scheduler::Scheduler(unsigned int workers)
+{
+  for (unsigned int i = 0; i < std::max(workers, 1u); i++)
+    this->workers.emplace_back(new Worker());
+
+  this->queued     = 0;
+  this->unfinished = 0;
+  this->failed     = false;
+  this->running    = false;
+  this->elapsed    = 0;
+}
+
+std::uint32_t Scheduler::add(std::string name, double cost, std::function<void()> run,
+                             const std::vector<std::uint32_t> &dependencies)
+{
+  std::lock_guard<std::mutex> lock(this->graph);
+
+  std::uint32_t task = (std::uint32_t)this->tasks.size();
+  this->tasks.push_back({ std::move(name), std::move(run), cost, {}, {}, 0, false, 0, 0 });
+  this->unfinished++;
+
+  for (std::uint32_t on : dependencies)
+    this->link(task, on);
+
+  if (this->running && this->tasks[task].waiting == 0)
+    this->submit(task);
+
+  return task;
+}
+
+void Scheduler::depend(std::uint32_t task, std::uint32_t on)
+{
+  std::lock_guard<std::mutex> lock(this->graph);
+
+  this->link(task, on);
+}
+
+void Scheduler::run()
+{
+  this->began = std::chrono::steady_clock::now();
+  this->busy.assign(this->workers.size(), 0);
+
+  {
+    std::lock_guard<std::mutex> lock(this->graph);
+
+    this->running = true;
+    for (std::uint32_t task = 0; task < this->tasks.size(); task++) {
+      if (!this->tasks[task].done && this->tasks[task].waiting == 0)
+        this->submit(task);
+    }
+  }
+
+  std::vector<std::thread> threads;
+  for (std::uint32_t worker = 1; worker < this->workers.size(); worker++)
+    threads.emplace_back(&Scheduler::work, this, worker);
+  this->work(0);
+
+  for (std::thread &thread : threads)
+    thread.join();
+
+  current       = NONE;
+  this->running = false;
+  this->elapsed = this->now();
+
+  if (this->failure)
+    std::rethrow_exception(this->failure);
+}
+
+Scheduler::Report Scheduler::report() const
+{
+  Report report;
+  report.workers = (unsigned int)this->workers.size();
+  report.wall    = this->elapsed;
+  report.busy    = 0;
+
+  for (double busy : this->busy)
+    report.busy += busy;
+  report.idle = report.wall * report.workers - report.busy;
+
+  // Longest chain of measured task times ending at each task, and the predecessor it came from.
+  std::vector<double> length(this->tasks.size(), -1);
+  std::vector<std::uint32_t> from(this->tasks.size(), NONE);
+
+  std::function<double(std::uint32_t)> measure = [&](std::uint32_t task) {
+    if (length[task] >= 0)
+      return length[task];
+
+    double longest = 0;
+    for (std::uint32_t predecessor : this->tasks[task].predecessors) {
+      double chain = measure(predecessor);
+      if (chain > longest) {
+        longest    = chain;
+        from[task] = predecessor;
+      }
+    }
+
+    return length[task] = longest + this->tasks[task].finish - this->tasks[task].start;
+  };
+
+  std::uint32_t last = NONE;
+  report.critical    = 0;
+
+  for (std::uint32_t task = 0; task < this->tasks.size(); task++) {
+    if (measure(task) > report.critical || last == NONE) {
+      report.critical = length[task];
+      last            = task;
+    }
+  }
+
+  for (std::uint32_t task = last; task != NONE; task = from[task])
+    report.path.push_back(this->tasks[task].name);
+  std::reverse(report.path.begin(), report.path.end());
+
+  return report;
+}
+
+void Scheduler::work(std::uint32_t worker)
+{
+  current = worker;
+
+  for (;;) {
+    std::uint32_t task;
+
+    if (!this->failed && this->take(worker, task)) {
+      std::function<void()> run;
+      double start = this->now();
+      {
+        std::lock_guard<std::mutex> lock(this->graph);
+        run                     = std::move(this->tasks[task].run);
+        this->tasks[task].start = start;
+      }
+
+      try {
+        run();
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(this->sleep);
+        if (!this->failed)
+          this->failure = std::current_exception();
+        this->failed = true;
+        this->wake.notify_all();
+      }
+
+      double finish = this->now();
+      this->busy[worker] += finish - start;
+
+      std::lock_guard<std::mutex> lock(this->graph);
+      this->tasks[task].finish = finish;
+      this->finish(task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(this->sleep);
+    this->wake.wait(lock, [&] {
+      return this->queued > 0 || this->unfinished == 0 || this->failed;
+    });
+
+    if (this->unfinished == 0 || this->failed)
+      return;
+  }
+}
+
+// Takes the most urgent task of the worker's own queue, or else steals the most urgent task of
+// the first other worker that has one.
+bool Scheduler::take(std::uint32_t worker, std::uint32_t &task)
+{
+  for (std::uint32_t i = 0; i < this->workers.size(); i++) {
+    Worker &victim = *this->workers[(worker + i) % this->workers.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+
+    if (!victim.queue.empty()) {
+      std::pop_heap(victim.queue.begin(), victim.queue.end());
+      task = victim.queue.back().second;
+      victim.queue.pop_back();
+
+      this->queued--;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Queues a ready task on the worker that made it ready. Called with the graph locked.
+void Scheduler::submit(std::uint32_t task)
+{
+  std::vector<double> memo(this->tasks.size(), -1);
+  double urgency = this->priority(task, memo);
+
+  std::uint32_t worker = current < this->workers.size() ? current : task % this->workers.size();
+  {
+    std::lock_guard<std::mutex> lock(this->workers[worker]->mutex);
+    this->workers[worker]->queue.push_back({ urgency, task });
+    std::push_heap(this->workers[worker]->queue.begin(), this->workers[worker]->queue.end());
+  }
+
+  this->queued++;
+  std::lock_guard<std::mutex> lock(this->sleep);
+  this->wake.notify_one();
+}
+
+// Marks a task as finished and submits the successors it was the last dependency of. Called with
+// the graph locked.
+void Scheduler::finish(std::uint32_t task)
+{
+  this->tasks[task].done = true;
+
+  for (std::uint32_t successor : this->tasks[task].successors) {
+    if (--this->tasks[successor].waiting == 0)
+      this->submit(successor);
+  }
+
+  if (--this->unfinished == 0) {
+    std::lock_guard<std::mutex> lock(this->sleep);
+    this->wake.notify_all();
+  }
+}
+
+void Scheduler::link(std::uint32_t task, std::uint32_t on)
+{
+  this->tasks[task].predecessors.push_back(on);
+
+  if (!this->tasks[on].done) {
+    this->tasks[on].successors.push_back(task);
+    this->tasks[task].waiting++;
+  }
+}
+
+// The estimated cost of the longest chain of tasks from `task` to the end of the graph.
+double Scheduler::priority(std::uint32_t task, std::vector<double> &memo)
+{
+  if (memo[task] >= 0)
+    return memo[task];
+
+  double longest = 0;
+  for (std::uint32_t successor : this->tasks[task].successors)
+    longest = std::max(longest, this->priority(successor, memo));
+
+  return memo[task] = this->tasks[task].cost + longest;
+}
+
+double Scheduler::now() const
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - this->began).count();
+}
@@ -0,0 +1,98 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Runs a graph of tasks on a pool of worker threads. Every worker keeps a queue of the tasks it
+// made ready and takes the most urgent of them; a worker whose queue runs dry steals the most
+// urgent task of another one. A task is as urgent as the longest chain of estimated costs from
+// it to the end of the graph, so the critical path is started first.
+//
+// Tasks may add further tasks and dependencies while the graph runs, as long as a dependency is
+// added before the dependent task can become ready, e.g. by a task it already depends on.
+class Scheduler {
+  struct Task {
+    std::string name;
+    std::function<void()> run;
+    double cost;
+    std::vector<std::uint32_t> successors;
+    std::vector<std::uint32_t> predecessors;
+    std::uint32_t waiting;
+    bool done;
+
+    double start;
+    double finish;
+  };
+
+  struct Worker {
+    std::mutex mutex;
+    std::vector<std::pair<double, std::uint32_t>> queue;
+  };
+
+  std::deque<Task> tasks;
+  std::mutex graph;
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::mutex sleep;
+  std::condition_variable wake;
+  std::atomic<std::uint32_t> queued;
+  std::atomic<std::uint32_t> unfinished;
+  bool running;
+
+  std::exception_ptr failure;
+  std::atomic<bool> failed;
+
+  std::chrono::steady_clock::time_point began;
+  std::vector<double> busy;
+  double elapsed;
+
+  public:
+  struct Report {
+    unsigned int workers;
+    double wall;
+    double busy;
+    double idle;
+    double critical;
+    std::vector<std::string> path;
+  };
+
+  static constexpr std::uint32_t NONE = 0xffffffff;
+
+  Scheduler(unsigned int workers);
+
+  // Adds a task that runs once all of `dependencies` have finished. `cost` is only an estimate,
+  // in any unit, used to find the critical path.
+  std::uint32_t add(std::string name, double cost, std::function<void()> run,
+                    const std::vector<std::uint32_t> &dependencies = {});
+  void depend(std::uint32_t task, std::uint32_t on);
+
+  // Runs every task, and rethrows the first exception thrown by one once the workers are done.
+  // Tasks that were not started by then are skipped.
+  void run();
+
+  // Measured wall time, busy and idle time of the workers, and the chain of dependent tasks that
+  // took longest, first task first. Times are in seconds.
+  Report report() const;
+
+  private:
+  void work(std::uint32_t worker);
+  bool take(std::uint32_t worker, std::uint32_t &task);
+  void submit(std::uint32_t task);
+  void finish(std::uint32_t task);
+  void link(std::uint32_t task, std::uint32_t on);
+  double priority(std::uint32_t task, std::vector<double> &memo);
+  double now() const;
+};
+
+#endif
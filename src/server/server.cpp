@@ -0,0 +1,272 @@
+#include "server.hpp"
+#include "error/error.hpp"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define TELA_SOCKETS 1
+#else
+#define TELA_SOCKETS 0
+#endif
+
+#if TELA_SOCKETS
+static sockaddr_un socket_address(const std::string &path)
+{
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+
+  if (path.empty() || path.size() >= sizeof(address.sun_path))
+    throw Error("Invalid socket path: %s", path.c_str());
+  std::memcpy(address.sun_path, path.c_str(), path.size());
+
+  return address;
+}
+
+static bool write_all(int fd, const void *data, std::size_t size)
+{
+  const char *bytes = (const char *)data;
+
+  while (size > 0) {
+    ssize_t written = write(fd, bytes, size);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written <= 0)
+      return false;
+
+    bytes += written;
+    size -= (std::size_t)written;
+  }
+
+  return true;
+}
+
+static bool read_all(int fd, void *data, std::size_t size)
+{
+  char *bytes = (char *)data;
+
+  while (size > 0) {
+    ssize_t got = read(fd, bytes, size);
+    if (got < 0 && errno == EINTR)
+      continue;
+    if (got <= 0)
+      return false;
+
+    bytes += got;
+    size -= (std::size_t)got;
+  }
+
+  return true;
+}
+
+// Strings are sent as their length followed by their bytes, in host byte order since both ends
+// run on the same machine.
+static bool write_string(int fd, const std::string &str)
+{
+  std::uint32_t size = (std::uint32_t)str.size();
+
+  return write_all(fd, &size, sizeof(size)) && write_all(fd, str.data(), str.size());
+}
+
+static bool read_string(int fd, std::string &str, std::size_t &budget)
+{
+  std::uint32_t size;
+  if (!read_all(fd, &size, sizeof(size)) || size > budget)
+    return false;
+
+  budget -= size;
+  str.resize(size);
+  return read_all(fd, &str[0], size);
+}
+#endif
+
+Server::Server(const std::string &path) : path(path)
+{
+#if TELA_SOCKETS
+  sockaddr_un address = socket_address(path);
+
+  int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (probe >= 0 && connect(probe, (const sockaddr *)&address, sizeof(address)) == 0) {
+    close(probe);
+    throw Error("A server is already listening on: %s", path.c_str());
+  }
+  if (probe >= 0)
+    close(probe);
+
+  struct stat st;
+  if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+    unlink(path.c_str());
+
+  this->listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (this->listener < 0 || bind(this->listener, (const sockaddr *)&address, sizeof(address)) != 0
+      || listen(this->listener, SOMAXCONN) != 0) {
+    if (this->listener >= 0)
+      close(this->listener);
+    throw Error("Cannot listen on socket: %s", path.c_str());
+  }
+  fcntl(this->listener, F_SETFD, FD_CLOEXEC);
+#else
+  throw Error("Unix domain sockets are not supported on this platform: %s", path.c_str());
+#endif
+}
+
+Server::~Server()
+{
+#if TELA_SOCKETS
+  close(this->listener);
+  unlink(this->path.c_str());
+#endif
+}
+
+void Server::serve(const Handler &handler)
+{
+#if TELA_SOCKETS
+  // A client that goes away must not take the server down with it.
+  std::signal(SIGPIPE, SIG_IGN);
+
+  for (;;) {
+    int client = accept(this->listener, nullptr, nullptr);
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      throw Error("Cannot accept on socket: %s", this->path.c_str());
+    }
+
+    this->answer(client, handler);
+    close(client);
+  }
+#else
+  (void)handler;
+#endif
+}
+
+// Reads a request, whose first bytes carry the client's standard output and error, runs it and
+// writes back its exit status.
+void Server::answer(int client, const Handler &handler)
+{
+#if TELA_SOCKETS
+  std::uint32_t count = 0;
+  int fds[2]          = { -1, -1 };
+
+  iovec data = { &count, sizeof(count) };
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))];
+  msghdr message;
+  std::memset(&message, 0, sizeof(message));
+  message.msg_iov        = &data;
+  message.msg_iovlen     = 1;
+  message.msg_control    = control;
+  message.msg_controllen = sizeof(control);
+
+  ssize_t received = recvmsg(client, &message, 0);
+  if (received > 0) {
+    for (cmsghdr *header = CMSG_FIRSTHDR(&message); header != nullptr;
+         header         = CMSG_NXTHDR(&message, header)) {
+      if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS)
+        continue;
+
+      std::size_t passed = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      for (std::size_t i = 0; i < passed; i++) {
+        int fd;
+        std::memcpy(&fd, CMSG_DATA(header) + i * sizeof(int), sizeof(int));
+        if (i < 2 && fds[i] < 0)
+          fds[i] = fd;
+        else
+          close(fd);
+      }
+    }
+  }
+
+  Request request;
+  std::size_t budget = MAX_REQUEST;
+  bool valid = received == sizeof(count) && fds[0] >= 0 && fds[1] >= 0 && count <= budget;
+
+  request.args.resize(valid ? count : 0);
+  for (std::string &arg : request.args)
+    valid = valid && read_string(client, arg, budget);
+  valid = valid && read_string(client, request.cwd, budget);
+
+  request.out = valid ? fdopen(fds[0], "w") : nullptr;
+  request.err = valid ? fdopen(fds[1], "w") : nullptr;
+
+  std::int32_t status = 1;
+  if (request.out != nullptr && request.err != nullptr && chdir(request.cwd.c_str()) == 0)
+    status = handler(request);
+
+  if (request.out != nullptr)
+    std::fclose(request.out);
+  else if (fds[0] >= 0)
+    close(fds[0]);
+  if (request.err != nullptr)
+    std::fclose(request.err);
+  else if (fds[1] >= 0)
+    close(fds[1]);
+
+  if (valid)
+    write_all(client, &status, sizeof(status));
+#else
+  (void)client;
+  (void)handler;
+#endif
+}
+
+int Server::forward(const std::string &path, const std::vector<std::string> &args)
+{
+#if TELA_SOCKETS
+  sockaddr_un address = socket_address(path);
+
+  int server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server < 0 || connect(server, (const sockaddr *)&address, sizeof(address)) != 0) {
+    if (server >= 0)
+      close(server);
+    throw Error("Cannot connect to server: %s", path.c_str());
+  }
+
+  std::error_code error;
+  std::string cwd = std::filesystem::current_path(error).string();
+
+  std::uint32_t count = (std::uint32_t)args.size();
+  int fds[2]          = { STDOUT_FILENO, STDERR_FILENO };
+  std::fflush(stdout);
+  std::fflush(stderr);
+
+  iovec data = { &count, sizeof(count) };
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))];
+  std::memset(control, 0, sizeof(control));
+  msghdr message;
+  std::memset(&message, 0, sizeof(message));
+  message.msg_iov        = &data;
+  message.msg_iovlen     = 1;
+  message.msg_control    = control;
+  message.msg_controllen = sizeof(control);
+
+  cmsghdr *header    = CMSG_FIRSTHDR(&message);
+  header->cmsg_level = SOL_SOCKET;
+  header->cmsg_type  = SCM_RIGHTS;
+  header->cmsg_len   = CMSG_LEN(sizeof(fds));
+  std::memcpy(CMSG_DATA(header), fds, sizeof(fds));
+
+  bool sent = !error && sendmsg(server, &message, 0) == (ssize_t)sizeof(count);
+  for (const std::string &arg : args)
+    sent = sent && write_string(server, arg);
+  sent = sent && write_string(server, cwd);
+
+  std::int32_t status = 1;
+  bool answered       = sent && read_all(server, &status, sizeof(status));
+  close(server);
+
+  if (!answered)
+    throw Error("Lost connection to server: %s", path.c_str());
+  return status;
+#else
+  (void)args;
+  throw Error("Unix domain sockets are not supported on this platform: %s", path.c_str());
+#endif
+}
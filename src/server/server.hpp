@@ -0,0 +1,51 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// A command line forwarded by a client, with the working directory it was run from and the
+// client's own standard output and error.
+struct Request {
+  std::vector<std::string> args;
+  std::string cwd;
+  std::FILE *out;
+  std::FILE *err;
+};
+
+// Serves command lines on a Unix domain socket so that state kept by the handler, such as parsed
+// sources, outlives a single invocation. A client sends its arguments and working directory and
+// passes its standard output and error along, so the handler writes to them directly, and gets
+// back the exit status of the command.
+//
+// Requests are served one at a time, in the client's working directory. Only platforms with Unix
+// domain sockets are supported.
+class Server {
+  int listener;
+  std::string path;
+
+  public:
+  typedef std::function<int(Request &)> Handler;
+
+  static constexpr std::size_t MAX_REQUEST = 1 << 20;
+
+  // Listens on the socket at `path`, replacing a stale socket file left by a server that is no
+  // longer running.
+  Server(const std::string &path);
+  Server(const Server &) = delete;
+  Server &operator=(const Server &) = delete;
+  ~Server();
+
+  // Serves requests forever. A request that cannot be read is dropped.
+  void serve(const Handler &handler);
+
+  // Runs `args` on the server listening at `path`, and returns its exit status.
+  static int forward(const std::string &path, const std::vector<std::string> &args);
+
+  private:
+  void answer(int client, const Handler &handler);
+};
+
+#endif
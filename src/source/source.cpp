@@ -0,0 +1,155 @@
+#include "source.hpp"
+#include "error/error.hpp"
+#include "file/file.hpp"
+#include <algorithm>
+
+static_assert(SourceManager::CHUNK_SIZE * SourceManager::MAX_CHUNKS
+                  <= (SourceLoc)1 << (64 - SourceManager::OFFSET_BITS),
+              "Buffer numbers must fit above the offsets of locations");
+
+SourceManager::SourceManager() : chunks(new std::unique_ptr<Buffer[]>[MAX_CHUNKS])
+{
+  this->count = 0;
+}
+
+SourceManager::~SourceManager() { }
+
+std::uint32_t SourceManager::add(std::string path, std::string contents)
+{
+  return this->add_buffer(std::move(path), std::move(contents), nullptr, false);
+}
+
+std::uint32_t SourceManager::load(std::string path)
+{
+  std::unique_ptr<File> file(new File(path));
+
+  return this->add(std::move(path), std::move(file));
+}
+
+std::uint32_t SourceManager::add(std::string path, std::unique_ptr<File> file)
+{
+  return this->add_buffer(std::move(path), std::string(), std::move(file), false);
+}
+
+std::uint32_t SourceManager::add_stream(std::string path)
+{
+  return this->add_buffer(std::move(path), std::string(), nullptr, true);
+}
+
+std::uint32_t SourceManager::add_buffer(std::string path, std::string contents,
+                                        std::unique_ptr<File> file, bool streamed)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  std::uint32_t id = this->count;
+  if (!this->unused.empty()) {
+    id = this->unused.back();
+    this->unused.pop_back();
+  } else if (id == CHUNK_SIZE * MAX_CHUNKS) {
+    throw Error("Too many sources: %s", path.c_str());
+  } else {
+    if (id % CHUNK_SIZE == 0)
+      this->chunks[id / CHUNK_SIZE].reset(new Buffer[CHUNK_SIZE]);
+    this->count++;
+  }
+
+  Buffer &buffer  = this->buffer(id);
+  buffer.path     = std::move(path);
+  buffer.contents = std::move(contents);
+  buffer.file     = std::move(file);
+  buffer.streamed = streamed;
+  buffer.released = false;
+
+  return id;
+}
+
+void SourceManager::release(std::uint32_t buffer)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  Buffer &source  = this->buffer(buffer);
+  source.path     = std::string();
+  source.contents = std::string();
+  source.file     = nullptr;
+  source.lines    = std::vector<std::uint64_t>();
+  source.released = true;
+
+  this->unused.push_back(buffer);
+}
+
+SourceManager::Buffer &SourceManager::buffer(std::uint32_t buffer) const
+{
+  return this->chunks[buffer / CHUNK_SIZE][buffer % CHUNK_SIZE];
+}
+
+const char *SourceManager::path(std::uint32_t buffer) const
+{
+  return this->buffer(buffer).path.c_str();
+}
+
+const char *SourceManager::data(std::uint32_t buffer) const
+{
+  const Buffer &source = this->buffer(buffer);
+  return source.file != nullptr ? source.file->data() : source.contents.c_str();
+}
+
+std::size_t SourceManager::size(std::uint32_t buffer) const
+{
+  const Buffer &source = this->buffer(buffer);
+  return source.file != nullptr ? source.file->size() : source.contents.size();
+}
+
+const File *SourceManager::file(std::uint32_t buffer) const
+{
+  return this->buffer(buffer).file.get();
+}
+
+// Returns the location of the code point at `offset` in a source. The last offset of the last
+// source would make NONE, which no source can reach anyway.
+SourceLoc SourceManager::locate(std::uint32_t buffer, std::uint64_t offset)
+{
+  if (offset >= ((SourceLoc)1 << OFFSET_BITS) - 1)
+    throw Error("Source too large for locations: %s", this->buffer(buffer).path.c_str());
+
+  return (SourceLoc)buffer << OFFSET_BITS | offset;
+}
+
+// The largest column is kept one short of all ones so that no location makes NONE.
+SourceLoc SourceManager::locate(std::uint32_t buffer, std::uint64_t row, std::uint64_t col)
+{
+  row = std::min(row, ((std::uint64_t)1 << (OFFSET_BITS - COL_BITS)) - 1);
+  col = std::min(col, ((std::uint64_t)1 << COL_BITS) - 2);
+
+  return (SourceLoc)buffer << OFFSET_BITS | row << COL_BITS | col;
+}
+
+void SourceManager::add_line(std::uint32_t buffer, std::uint64_t offset)
+{
+  std::vector<std::uint64_t> &lines = this->buffer(buffer).lines;
+  if (lines.empty() || offset > lines.back())
+    lines.push_back(offset);
+}
+
+std::uint32_t SourceManager::source(SourceLoc loc) { return (std::uint32_t)(loc >> OFFSET_BITS); }
+
+SourcePosition SourceManager::resolve(SourceLoc loc) const
+{
+  std::uint32_t buffer = (std::uint32_t)(loc >> OFFSET_BITS);
+  std::uint64_t offset = loc & (((SourceLoc)1 << OFFSET_BITS) - 1);
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (loc == NONE || buffer >= this->count || this->buffer(buffer).released)
+      return { nullptr, 0, 0 };
+  }
+
+  const Buffer &source = this->buffer(buffer);
+  if (source.streamed)
+    return { source.path.c_str(), offset >> COL_BITS, offset & (((SourceLoc)1 << COL_BITS) - 1) };
+
+  auto line = std::upper_bound(source.lines.begin(), source.lines.end(), offset);
+  std::uint64_t start = line == source.lines.begin() ? 0 : *(line - 1);
+
+  return { source.path.c_str(), (std::uint64_t)(line - source.lines.begin()) + 1,
+           offset - start + 1 };
+}
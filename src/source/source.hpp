@@ -0,0 +1,93 @@
+#ifndef SOURCE_HPP
+#define SOURCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class File;
+
+// A position in any of the sources of a SourceManager.
+typedef std::uint64_t SourceLoc;
+
+struct SourcePosition {
+  const char *path;
+  std::uint64_t row;
+  std::uint64_t col;
+};
+
+// Owns every source of a compilation and maps positions in them to a single 64-bit location
+// space, so that a token or a diagnostic only has to carry one SourceLoc.
+//
+// A location is the number of its source above OFFSET_BITS bits of code point offset, so every
+// source has room for 16 Ti code points however many other sources there are or however dense
+// their tokens are. Lexers record where lines start while they go, and locations are only turned
+// into a path, a row and a column by resolve(), which never has to read the source again.
+//
+// Streamed sources are read once and keep no line table, so that they are lexed in constant
+// memory. Their locations hold the row above COL_BITS bits of column instead, and rows and
+// columns too large for those are clamped, so positions past them are lossy.
+//
+// Sources can be added and lexed from several threads at once, as long as each source is lexed
+// by one thread at a time. Buffers live in fixed chunks that never move, so locating a token
+// never takes the lock.
+class SourceManager {
+  struct Buffer {
+    std::string path;
+    std::string contents;
+    std::unique_ptr<File> file;
+    std::vector<std::uint64_t> lines;
+    bool streamed;
+    bool released;
+  };
+
+  std::unique_ptr<std::unique_ptr<Buffer[]>[]> chunks;
+  std::uint32_t count;
+  std::vector<std::uint32_t> unused;
+  mutable std::mutex mutex;
+
+  public:
+  static constexpr SourceLoc NONE           = 0xffffffffffffffff;
+  static constexpr unsigned int OFFSET_BITS = 44;
+  static constexpr unsigned int COL_BITS    = 18;
+  static constexpr std::uint32_t CHUNK_SIZE = 1 << 10;
+  static constexpr std::uint32_t MAX_CHUNKS = 1 << 10;
+
+  SourceManager();
+  SourceManager(const SourceManager &) = delete;
+  SourceManager &operator=(const SourceManager &) = delete;
+  ~SourceManager();
+
+  std::uint32_t add(std::string path, std::string contents);
+  std::uint32_t load(std::string path);
+  std::uint32_t add(std::string path, std::unique_ptr<File> file);
+  // Registers a source whose contents are read by a streaming lexer and never kept.
+  std::uint32_t add_stream(std::string path);
+  // Frees a source once nothing refers to its locations any more. Its number goes to a later
+  // source, so long-lived processes that keep replacing sources do not run out of them.
+  void release(std::uint32_t buffer);
+
+  const char *path(std::uint32_t buffer) const;
+  const char *data(std::uint32_t buffer) const;
+  std::size_t size(std::uint32_t buffer) const;
+  const File *file(std::uint32_t buffer) const;
+
+  SourceLoc locate(std::uint32_t buffer, std::uint64_t offset);
+  // The location of a code point of a streamed source, by its row and column.
+  SourceLoc locate(std::uint32_t buffer, std::uint64_t row, std::uint64_t col);
+  void add_line(std::uint32_t buffer, std::uint64_t offset);
+
+  SourcePosition resolve(SourceLoc loc) const;
+  // The buffer that a location other than NONE is in.
+  static std::uint32_t source(SourceLoc loc);
+
+  private:
+  std::uint32_t add_buffer(std::string path, std::string contents, std::unique_ptr<File> file,
+                           bool streamed);
+  Buffer &buffer(std::uint32_t buffer) const;
+};
+
+#endif
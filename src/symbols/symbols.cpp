@@ -0,0 +1,103 @@
+#include "symbols.hpp"
+
+SymbolTable::SymbolTable()
+{
+  this->table.assign(16, { NONE, NONE, NONE });
+  this->used = 0;
+}
+
+void SymbolTable::enter() { this->scopes.push_back((std::uint32_t)this->undo.size()); }
+
+void SymbolTable::leave()
+{
+  for (std::uint32_t i = (std::uint32_t)this->undo.size(); i-- > this->scopes.back();) {
+    const Entry &old   = this->undo[i];
+    std::uint32_t slot = this->probe(old.name);
+
+    if (old.depth == NONE)
+      this->erase(slot);
+    else
+      this->table[slot] = old;
+  }
+
+  this->undo.resize(this->scopes.back());
+  this->scopes.pop_back();
+}
+
+std::uint32_t SymbolTable::depth() const { return (std::uint32_t)this->scopes.size(); }
+
+void SymbolTable::declare(std::uint32_t name, std::uint32_t value)
+{
+  std::uint32_t slot = this->probe(name);
+  Entry &entry       = this->table[slot];
+
+  if (!this->scopes.empty())
+    this->undo.push_back(entry.name == NONE ? Entry{ name, NONE, NONE } : entry);
+
+  if (entry.name == NONE)
+    this->used++;
+  entry = { name, value, this->depth() };
+
+  // Keep the load factor under 3/4.
+  if ((std::uint64_t)this->used * 4 >= (std::uint64_t)this->table.size() * 3)
+    this->grow();
+}
+
+std::uint32_t SymbolTable::find(std::uint32_t name) const
+{
+  return this->table[this->probe(name)].value;
+}
+
+bool SymbolTable::declared(std::uint32_t name) const
+{
+  const Entry &entry = this->table[this->probe(name)];
+
+  return entry.name != NONE && entry.depth == this->depth();
+}
+
+std::uint32_t SymbolTable::size() const { return this->used; }
+
+// The slot holding `name`, or the empty slot where it would go. Interned ids are dense and
+// handed out in order of first use, so they are their own hash: names that appear together land
+// in neighbouring slots, and ids below the table size never collide.
+std::uint32_t SymbolTable::probe(std::uint32_t name) const
+{
+  std::uint32_t mask = (std::uint32_t)this->table.size() - 1;
+
+  for (std::uint32_t slot = name & mask;; slot = (slot + 1) & mask) {
+    if (this->table[slot].name == name || this->table[slot].name == NONE)
+      return slot;
+  }
+}
+
+// Empties a slot, moving back the entries after it that could no longer be found otherwise, so
+// that the table never needs tombstones.
+void SymbolTable::erase(std::uint32_t slot)
+{
+  std::uint32_t mask = (std::uint32_t)this->table.size() - 1;
+
+  for (std::uint32_t next = (slot + 1) & mask; this->table[next].name != NONE;
+       next               = (next + 1) & mask) {
+    std::uint32_t home = this->table[next].name & mask;
+
+    // The entry stays if its home lies cyclically in (slot, next].
+    if (slot < next ? (home <= slot || home > next) : (home <= slot && home > next)) {
+      this->table[slot] = this->table[next];
+      slot              = next;
+    }
+  }
+
+  this->table[slot] = { NONE, NONE, NONE };
+  this->used--;
+}
+
+void SymbolTable::grow()
+{
+  std::vector<Entry> old = std::move(this->table);
+  this->table.assign(old.size() * 2, { NONE, NONE, NONE });
+
+  for (const Entry &entry : old) {
+    if (entry.name != NONE)
+      this->table[this->probe(entry.name)] = entry;
+  }
+}
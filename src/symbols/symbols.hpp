@@ -0,0 +1,50 @@
+#ifndef SYMBOLS_HPP
+#define SYMBOLS_HPP
+
+#include <cstdint>
+#include <vector>
+
+// Binds interned names to 32-bit values in nested scopes. All scopes share one open-addressing
+// table holding the innermost binding of every name, and declarations log the binding they
+// replace, so entering a scope is free and leaving it undoes exactly its own declarations.
+class SymbolTable {
+  struct Entry {
+    std::uint32_t name;
+    std::uint32_t value;
+    std::uint32_t depth;
+  };
+
+  std::vector<Entry> table;
+  std::uint32_t used;
+
+  // Previous binding of every name declared in an open scope, with a depth of NONE for names
+  // that were unbound, and where the log of each open scope starts.
+  std::vector<Entry> undo;
+  std::vector<std::uint32_t> scopes;
+
+  public:
+  static constexpr std::uint32_t NONE = 0xffffffff;
+
+  SymbolTable();
+
+  void enter();
+  void leave();
+  // The number of open scopes. Names declared outside of any scope have a depth of 0.
+  std::uint32_t depth() const;
+
+  // Binds `name` in the innermost scope, shadowing any outer binding until the scope is left.
+  void declare(std::uint32_t name, std::uint32_t value);
+  // The value of the innermost binding of `name`, or NONE.
+  std::uint32_t find(std::uint32_t name) const;
+  // Whether `name` is bound in the innermost scope itself.
+  bool declared(std::uint32_t name) const;
+
+  std::uint32_t size() const;
+
+  private:
+  std::uint32_t probe(std::uint32_t name) const;
+  void erase(std::uint32_t slot);
+  void grow();
+};
+
+#endif
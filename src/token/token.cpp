@@ -1,21 +1,19 @@
 #include "token.hpp"
 
-Token::Token(Type type, unsigned int row, unsigned int col)
+Token::Token(Type type, SourceLoc loc)
 {
   this->type  = type;
   this->value = "";
 
-  this->row   = row;
-  this->col   = col;
+  this->loc   = loc;
 }
 
-Token::Token(Type type, std::string value, unsigned int row, unsigned int col)
+Token::Token(Type type, std::string value, SourceLoc loc)
 {
   this->type  = type;
   this->value = value;
 
-  this->row   = row;
-  this->col   = col;
+  this->loc   = loc;
 }
 
 const char *Token::str()
@@ -25,6 +23,8 @@ const char *Token::str()
   case Type::T_CHAR:
   case Type::T_STRING:
   case Type::T_ID:
+  case Type::T_COMMENT:
+  case Type::T_SPACE:
     return this->value.c_str();
 
   case Type::T_ADD:
@@ -118,6 +118,21 @@ const char *Token::str()
   case Type::T_RBRACKET:
     return "]";
 
+  case Type::T_FN:
+    return "fn";
+  case Type::T_LET:
+    return "let";
+  case Type::T_IF:
+    return "if";
+  case Type::T_ELSE:
+    return "else";
+  case Type::T_WHILE:
+    return "while";
+  case Type::T_RETURN:
+    return "return";
+  case Type::T_IMPORT:
+    return "import";
+
   case Type::T_EOF:
     return "<EOF>";
   default:
@@ -1,6 +1,8 @@
 #ifndef TOKEN_HPP
 #define TOKEN_HPP
 
+#include "source/source.hpp"
+#include <cstdint>
 #include <string>
 
 class Token {
@@ -61,15 +63,25 @@ class Token {
     T_LBRACKET  = 0x0000080000000000, // [
     T_RBRACKET  = 0x0000100000000000, // ]
 
-    T_EOF       = 0x0000200000000000,
+    T_FN        = 0x0000200000000000, // fn
+    T_LET       = 0x0000400000000000, // let
+    T_IF        = 0x0000800000000000, // if
+    T_ELSE      = 0x0001000000000000, // else
+    T_WHILE     = 0x0002000000000000, // while
+    T_RETURN    = 0x0004000000000000, // return
+    T_IMPORT    = 0x0008000000000000, // import
+
+    T_EOF       = 0x0010000000000000,
+
+    T_COMMENT   = 0x0020000000000000, // Only kept by lexers with trivia.
+    T_SPACE     = 0x0040000000000000,
   } type;
   std::string value;
 
-  unsigned int row;
-  unsigned int col;
+  SourceLoc loc;
 
-  Token(Type type, unsigned int row, unsigned int col);
-  Token(Type type, std::string value, unsigned int row, unsigned int col);
+  Token(Type type, SourceLoc loc);
+  Token(Type type, std::string value, SourceLoc loc);
 
   const char *str();
   bool is_in(Type types);
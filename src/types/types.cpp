@@ -0,0 +1,150 @@
+#include "types.hpp"
+#include "error/error.hpp"
+
+// Ids of compound types start after the primitives, and interleave the shards: the low bits of
+// `id - FIRST` pick the shard and the others index its records.
+static constexpr TypeId FIRST = TypeTable::STRING + 1;
+
+static const char *const NAMES[] = { "?", "any", "nil", "int", "float", "char", "string" };
+
+TypeTable::TypeTable() : shards(new Shard[SHARDS])
+{
+  for (std::uint32_t i = 0; i < SHARDS; i++) {
+    this->shards[i].chunks.reset(new std::unique_ptr<Record[]>[MAX_CHUNKS]);
+    this->shards[i].count = 0;
+    this->shards[i].table.assign(16, NONE);
+  }
+}
+
+TypeTable::~TypeTable() { }
+
+TypeId TypeTable::function(TypeId result, const std::vector<TypeId> &params, bool variadic)
+{
+  std::uint32_t hash  = TypeTable::hash(result, params, variadic);
+  std::uint32_t which = hash % SHARDS;
+  Shard &shard        = this->shards[which];
+
+  std::lock_guard<std::mutex> lock(shard.mutex);
+
+  std::uint32_t mask = (std::uint32_t)shard.table.size() - 1;
+  std::uint32_t slot = (hash / SHARDS) & mask;
+
+  for (;; slot = (slot + 1) & mask) {
+    std::uint32_t local = shard.table[slot];
+    if (local == NONE)
+      break;
+
+    const Record &record = shard.chunks[local / CHUNK_SIZE][local % CHUNK_SIZE];
+    if (record.hash == hash && record.kind == Kind::K_FUNCTION && record.result == result
+        && record.variadic == variadic && record.params == params)
+      return FIRST + local * SHARDS + which;
+  }
+
+  std::uint32_t local = shard.count;
+  if (local == CHUNK_SIZE * MAX_CHUNKS)
+    throw Error("Too many types.");
+  if (local % CHUNK_SIZE == 0)
+    shard.chunks[local / CHUNK_SIZE].reset(new Record[CHUNK_SIZE]);
+
+  Record &record  = shard.chunks[local / CHUNK_SIZE][local % CHUNK_SIZE];
+  record.kind     = Kind::K_FUNCTION;
+  record.variadic = variadic;
+  record.result   = result;
+  record.params   = params;
+  record.hash     = hash;
+
+  shard.table[slot] = local;
+  shard.count++;
+
+  // Keep the load factor under 3/4.
+  if ((std::uint64_t)shard.count * 4 >= (std::uint64_t)shard.table.size() * 3) {
+    shard.table.assign(shard.table.size() * 2, NONE);
+    mask = (std::uint32_t)shard.table.size() - 1;
+
+    for (std::uint32_t i = 0; i < shard.count; i++) {
+      std::uint32_t at = (shard.chunks[i / CHUNK_SIZE][i % CHUNK_SIZE].hash / SHARDS) & mask;
+      while (shard.table[at] != NONE)
+        at = (at + 1) & mask;
+      shard.table[at] = i;
+    }
+  }
+
+  return FIRST + local * SHARDS + which;
+}
+
+TypeKind TypeTable::kind(TypeId type) const
+{
+  return type < FIRST ? (Kind)type : this->record(type).kind;
+}
+
+TypeId TypeTable::result(TypeId type) const { return this->record(type).result; }
+
+const std::vector<TypeId> &TypeTable::params(TypeId type) const
+{
+  return this->record(type).params;
+}
+
+bool TypeTable::variadic(TypeId type) const { return this->record(type).variadic; }
+
+std::uint32_t TypeTable::size()
+{
+  std::uint32_t size = 0;
+
+  for (std::uint32_t i = 0; i < SHARDS; i++) {
+    std::lock_guard<std::mutex> lock(this->shards[i].mutex);
+    size += this->shards[i].count;
+  }
+
+  return size;
+}
+
+std::string TypeTable::str(TypeId type) const
+{
+  if (type < FIRST)
+    return NAMES[type];
+
+  std::string str = "fn(";
+  for (std::size_t i = 0; i < this->params(type).size(); i++)
+    str += (i > 0 ? ", " : "") + this->str(this->params(type)[i]);
+  if (this->variadic(type))
+    str += this->params(type).empty() ? "..." : ", ...";
+
+  return str + "): " + this->str(this->result(type));
+}
+
+TypeId TypeTable::primitive(std::string_view name)
+{
+  for (TypeId type = ANY; type < FIRST; type++) {
+    if (name == NAMES[type])
+      return type;
+  }
+
+  return NONE;
+}
+
+const TypeTable::Record &TypeTable::record(TypeId type) const
+{
+  std::uint32_t index = type - FIRST;
+  std::uint32_t local = index / SHARDS;
+
+  return this->shards[index % SHARDS].chunks[local / CHUNK_SIZE][local % CHUNK_SIZE];
+}
+
+// FNV-1a over the words of the type.
+std::uint32_t TypeTable::hash(TypeId result, const std::vector<TypeId> &params, bool variadic)
+{
+  std::uint32_t hash = 2166136261u;
+  auto mix           = [&](std::uint32_t word) {
+    for (int shift = 0; shift < 32; shift += 8) {
+      hash ^= (word >> shift) & 0xff;
+      hash *= 16777619u;
+    }
+  };
+
+  mix(result);
+  mix(variadic);
+  for (TypeId param : params)
+    mix(param);
+
+  return hash;
+}
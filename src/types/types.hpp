@@ -0,0 +1,98 @@
+#ifndef TYPES_HPP
+#define TYPES_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+typedef std::uint32_t TypeId;
+
+// Hash-conses types, so that every distinct type is stored once and named by a 32-bit TypeId,
+// and two types are equal exactly when their ids are. Primitive types have fixed ids, and
+// compound types are built from the ids of their parts, so interning one only hashes and compares
+// a handful of words.
+//
+// The table can be shared by several threads. It is split into shards by hash, each with its own
+// lock, and records live in fixed chunks that never move, so the parts of a type can be read
+// without locking by any thread that was handed its id.
+class TypeTable {
+  public:
+  enum class Kind : std::uint8_t {
+    K_UNKNOWN,
+    K_ANY,
+    K_NIL,
+    K_INT,
+    K_FLOAT,
+    K_CHAR,
+    K_STRING,
+    K_FUNCTION,
+  };
+
+  private:
+  struct Record {
+    Kind kind;
+    bool variadic;
+    TypeId result;
+    std::vector<TypeId> params;
+    std::uint32_t hash;
+  };
+
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    std::unique_ptr<std::unique_ptr<Record[]>[]> chunks;
+    std::uint32_t count;
+    std::vector<std::uint32_t> table;
+  };
+
+  std::unique_ptr<Shard[]> shards;
+
+  public:
+  static constexpr TypeId NONE = 0xffffffff;
+
+  // The type of expressions that failed to check, compatible with every type so that one error
+  // is not reported again by every expression around it.
+  static constexpr TypeId UNKNOWN = 0;
+  // The type of variables declared without one, which may hold any value.
+  static constexpr TypeId ANY    = 1;
+  static constexpr TypeId NIL    = 2;
+  static constexpr TypeId INT    = 3;
+  static constexpr TypeId FLOAT  = 4;
+  static constexpr TypeId CHAR   = 5;
+  static constexpr TypeId STRING = 6;
+
+  static constexpr std::uint32_t SHARDS     = 16;
+  static constexpr std::uint32_t CHUNK_SIZE = 1 << 10;
+  static constexpr std::uint32_t MAX_CHUNKS = 1 << 12;
+
+  TypeTable();
+  TypeTable(const TypeTable &) = delete;
+  TypeTable &operator=(const TypeTable &) = delete;
+  ~TypeTable();
+
+  TypeId function(TypeId result, const std::vector<TypeId> &params, bool variadic);
+
+  Kind kind(TypeId type) const;
+  // The result, parameters and variadicity of a function type.
+  TypeId result(TypeId type) const;
+  const std::vector<TypeId> &params(TypeId type) const;
+  bool variadic(TypeId type) const;
+
+  // The number of compound types interned so far.
+  std::uint32_t size();
+  std::string str(TypeId type) const;
+
+  // The primitive type written as `name` in a program, or NONE.
+  static TypeId primitive(std::string_view name);
+
+  private:
+  const Record &record(TypeId type) const;
+
+  static std::uint32_t hash(TypeId result, const std::vector<TypeId> &params, bool variadic);
+};
+
+typedef TypeTable::Kind TypeKind;
+
+#endif
@@ -0,0 +1,68 @@
+#include "utf8.hpp"
+#include "xid.hpp"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TELA_SSE2 1
+#include <emmintrin.h>
+#else
+#define TELA_SSE2 0
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static unsigned int lowest_bit(std::uint32_t mask)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (unsigned int)index;
+#else
+  return (unsigned int)__builtin_ctz(mask);
+#endif
+}
+
+// ASCII is skipped a vector (or a word) at a time; only the bytes with the high bit set go
+// through the scalar decoder.
+std::size_t utf8_validate(const char *data, std::size_t size)
+{
+  const unsigned char *bytes = (const unsigned char *)data;
+  std::size_t i              = 0;
+
+  while (i < size) {
+#if TELA_SSE2
+    for (; i + 16 <= size; i += 16) {
+      int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(bytes + i)));
+      if (mask != 0) {
+        i += lowest_bit((std::uint32_t)mask);
+        break;
+      }
+    }
+#else
+    for (; i + 8 <= size; i += 8) {
+      std::uint64_t word;
+      std::memcpy(&word, bytes + i, sizeof(word));
+      if (word & 0x8080808080808080)
+        break;
+    }
+#endif
+
+    for (; i < size && bytes[i] < 0x80; i++)
+      ;
+    if (i == size)
+      break;
+
+    unsigned int length = utf8_length(data + i, size - i);
+    if (length == 0)
+      return i;
+    i += length;
+  }
+
+  return size;
+}
+
+bool utf8_is_xid_start(std::uint32_t cp) { return utf8_in_ranges(XID_START, cp); }
+
+bool utf8_is_xid_continue(std::uint32_t cp) { return utf8_in_ranges(XID_CONTINUE, cp); }
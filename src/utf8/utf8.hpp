@@ -0,0 +1,102 @@
+#ifndef UTF8_HPP
+#define UTF8_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+struct Utf8Range {
+  std::uint32_t first;
+  std::uint32_t last;
+};
+
+// Length of the well-formed non-ASCII sequence at `data`, of at most `size` bytes, or 0,
+// following table 3-7 of the Unicode standard.
+constexpr unsigned int utf8_length(const char *data, std::size_t size)
+{
+  unsigned char lead = (unsigned char)data[0];
+  unsigned char low  = 0x80;
+  unsigned char high = 0xbf;
+  unsigned int length = 0;
+
+  if (lead >= 0xc2 && lead <= 0xdf)
+    length = 2;
+  else if (lead >= 0xe0 && lead <= 0xef) {
+    length = 3;
+    if (lead == 0xe0)
+      low = 0xa0;
+    else if (lead == 0xed)
+      high = 0x9f;
+  } else if (lead >= 0xf0 && lead <= 0xf4) {
+    length = 4;
+    if (lead == 0xf0)
+      low = 0x90;
+    else if (lead == 0xf4)
+      high = 0x8f;
+  } else
+    return 0;
+
+  if (size < length || (unsigned char)data[1] < low || (unsigned char)data[1] > high)
+    return 0;
+  for (unsigned int i = 2; i < length; i++) {
+    if (((unsigned char)data[i] & 0xc0) != 0x80)
+      return 0;
+  }
+
+  return length;
+}
+
+// Returns the offset of the first byte that doesn't belong to a well-formed UTF-8 sequence
+// (no overlong forms, surrogates or code points past U+10FFFF), or `size` if there is none.
+std::size_t utf8_validate(const char *data, std::size_t size);
+
+// Decodes the sequence starting at `data`, which must be valid, and stores its length in bytes.
+constexpr std::uint32_t utf8_decode(const char *data, unsigned int &length)
+{
+  std::uint32_t lead = (unsigned char)data[0];
+
+  if (lead < 0x80) {
+    length = 1;
+    return lead;
+  }
+
+  std::uint32_t cp = 0;
+  if (lead < 0xe0) {
+    length = 2;
+    cp     = lead & 0x1f;
+  } else if (lead < 0xf0) {
+    length = 3;
+    cp     = lead & 0x0f;
+  } else {
+    length = 4;
+    cp     = lead & 0x07;
+  }
+
+  for (unsigned int i = 1; i < length; i++)
+    cp = cp << 6 | ((unsigned char)data[i] & 0x3f);
+
+  return cp;
+}
+
+// Whether `cp` is in one of `ranges`, which are sorted and disjoint.
+template <std::size_t N>
+constexpr bool utf8_in_ranges(const Utf8Range (&ranges)[N], std::uint32_t cp)
+{
+  std::size_t low  = 0;
+  std::size_t high = N;
+
+  while (low < high) {
+    std::size_t middle = low + (high - low) / 2;
+    if (cp < ranges[middle].first)
+      high = middle;
+    else
+      low = middle + 1;
+  }
+
+  return low != 0 && cp <= ranges[low - 1].last;
+}
+
+// Identifier properties of non-ASCII code points, from the tables generated by tools/xid.py.
+bool utf8_is_xid_start(std::uint32_t cp);
+bool utf8_is_xid_continue(std::uint32_t cp);
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef VALUE_HPP
+#define VALUE_HPP
+
+#include <cstdint>
+#include <cstring>
+
+// Runtime value of the interpreter, NaN-boxed into 64 bits. Doubles are stored as themselves
+// (every NaN is canonicalized to a positive quiet NaN), and the negative quiet NaN space carries
+// the other types in its top 16 bits with a 48-bit payload: integers (48-bit two's complement),
+// chars and interned string ids. Accessors are defined inline since they sit on the hot path of
+// every instruction.
+class Value {
+  static constexpr std::uint64_t TAG_MASK      = 0xffff000000000000;
+  static constexpr std::uint64_t PAYLOAD_MASK  = 0x0000ffffffffffff;
+  static constexpr std::uint64_t BOXED         = 0xfff8000000000000;
+  static constexpr std::uint64_t TAG_INT       = 0xfff9000000000000;
+  static constexpr std::uint64_t TAG_CHAR      = 0xfffa000000000000;
+  static constexpr std::uint64_t TAG_STRING    = 0xfffb000000000000;
+  static constexpr std::uint64_t CANONICAL_NAN = 0x7ff8000000000000;
+
+  std::uint64_t bits;
+
+  public:
+  enum class Type : std::uint8_t {
+    V_INT,
+    V_FLOAT,
+    V_CHAR,
+    V_STRING,
+  };
+
+  static constexpr std::int64_t MIN_INT = -((std::int64_t)1 << 47);
+  static constexpr std::int64_t MAX_INT = ((std::int64_t)1 << 47) - 1;
+
+  Value() : bits(TAG_INT) {}
+
+  static Value from_int(std::int64_t i)
+  {
+    Value value;
+    value.bits = TAG_INT | ((std::uint64_t)i & PAYLOAD_MASK);
+    return value;
+  }
+
+  static Value from_float(double f)
+  {
+    Value value;
+    std::memcpy(&value.bits, &f, sizeof(f));
+    if (f != f)
+      value.bits = CANONICAL_NAN;
+    return value;
+  }
+
+  static Value from_char(char c)
+  {
+    Value value;
+    value.bits = TAG_CHAR | (unsigned char)c;
+    return value;
+  }
+
+  static Value from_string(std::uint32_t id)
+  {
+    Value value;
+    value.bits = TAG_STRING | id;
+    return value;
+  }
+
+  Type type() const
+  {
+    switch (this->bits & TAG_MASK) {
+    case TAG_INT:
+      return Type::V_INT;
+    case TAG_CHAR:
+      return Type::V_CHAR;
+    case TAG_STRING:
+      return Type::V_STRING;
+    default:
+      return Type::V_FLOAT;
+    }
+  }
+
+  bool is_int() const { return (this->bits & TAG_MASK) == TAG_INT; }
+  bool is_float() const { return this->bits < BOXED; }
+  bool is_char() const { return (this->bits & TAG_MASK) == TAG_CHAR; }
+  bool is_string() const { return (this->bits & TAG_MASK) == TAG_STRING; }
+  bool is_integral() const { return (this->bits & TAG_MASK) - TAG_INT <= TAG_CHAR - TAG_INT; }
+
+  std::int64_t as_int() const { return (std::int64_t)(this->bits << 16) >> 16; }
+  char as_char() const { return (char)this->bits; }
+  std::uint32_t as_string() const { return (std::uint32_t)this->bits; }
+
+  double as_float() const
+  {
+    if (!this->is_float())
+      return (double)this->as_int();
+
+    double f;
+    std::memcpy(&f, &this->bits, sizeof(f));
+    return f;
+  }
+
+  bool truthy() const
+  {
+    if (this->is_float())
+      return this->as_float() != 0.0;
+    return this->is_string() || (this->bits & PAYLOAD_MASK) != 0;
+  }
+
+  bool identical(Value other) const { return this->bits == other.bits; }
+
+  // Fast paths for the interpreter. Integer payloads share the same tag, so wrapping addition,
+  // subtraction, multiplication and bitwise operations work directly on the boxed bits.
+  static bool both_int(Value a, Value b)
+  {
+    return ((a.bits & TAG_MASK) == TAG_INT) & ((b.bits & TAG_MASK) == TAG_INT);
+  }
+
+  static bool both_float(Value a, Value b) { return (a.bits < BOXED) & (b.bits < BOXED); }
+
+  static Value int_add(Value a, Value b)
+  {
+    Value value;
+    value.bits = TAG_INT | ((a.bits + b.bits) & PAYLOAD_MASK);
+    return value;
+  }
+
+  static Value int_sub(Value a, Value b)
+  {
+    Value value;
+    value.bits = TAG_INT | ((a.bits - b.bits) & PAYLOAD_MASK);
+    return value;
+  }
+
+  static Value int_mul(Value a, Value b)
+  {
+    Value value;
+    value.bits = TAG_INT | ((a.bits * b.bits) & PAYLOAD_MASK);
+    return value;
+  }
+
+  static Value int_and(Value a, Value b)
+  {
+    Value value;
+    value.bits = a.bits & b.bits;
+    return value;
+  }
+
+  static Value int_or(Value a, Value b)
+  {
+    Value value;
+    value.bits = a.bits | b.bits;
+    return value;
+  }
+
+  static Value int_xor(Value a, Value b)
+  {
+    Value value;
+    value.bits = TAG_INT | (a.bits ^ b.bits);
+    return value;
+  }
+
+  static Value int_incr(Value a, std::int64_t delta)
+  {
+    Value value;
+    value.bits = TAG_INT | ((a.bits + (std::uint64_t)delta) & PAYLOAD_MASK);
+    return value;
+  }
+};
+
+static_assert(sizeof(Value) == 8, "Value must stay NaN-boxed into 64 bits");
+
+typedef Value::Type ValueType;
+
+#endif
@@ -0,0 +1,85 @@
+# Generated by tela --profile-ops: <count> <first> <second>.
+7782221 O_LOAD_LOCAL O_CONST
+5788644 O_STORE_LOCAL O_POP
+3139726 O_CONST O_LT
+3111115 O_POP O_LOAD_LOCAL
+2821316 O_LT O_JUMP_IF_FALSE
+2807420 O_POP O_JUMP
+2535368 O_LOAD_LOCAL O_LOAD_LOCAL
+2403589 O_LOAD_LOCAL O_DUP
+2403589 O_POP O_POP
+2402951 O_DUP O_INCR
+2402951 O_INCR O_STORE_LOCAL
+2125718 O_CONST O_MOD
+2100000 O_CONST O_MUL
+2000001 O_CONST O_BAND
+1619999 O_ADD O_STORE_LOCAL
+1605714 O_MOD O_CONST
+1492356 O_CONST O_EQ
+1020799 O_CONST O_ADD
+1000001 O_LOAD_LOCAL O_ADD
+1000000 O_MUL O_CONST
+866667 O_EQ O_AND
+685077 O_BOOL O_JUMP_IF_FALSE
+573308 O_EQ O_JUMP_IF_FALSE
+539416 O_CONST O_SUB
+520000 O_ADD O_CONST
+500000 O_LOAD_LOCAL O_BNOT
+500000 O_MUL O_BXOR
+500000 O_BAND O_CONST
+500000 O_BAND O_STORE_LOCAL
+500000 O_BAND O_BOR
+500000 O_BAND O_BXOR
+500000 O_BOR O_STORE_LOCAL
+500000 O_BXOR O_CONST
+500000 O_BXOR O_LOAD_LOCAL
+500000 O_BNOT O_CONST
+329899 O_STORE_GLOBAL O_POP
+329898 O_LOAD_GLOBAL O_CONST
+319999 O_LOAD_LOCAL O_CALL
+319048 O_CONST O_GT
+319048 O_GT O_AND
+318410 O_LT O_BOOL
+300302 O_SUB O_CONST
+300005 O_MOD O_RETURN
+300000 O_MUL O_LOAD_LOCAL
+300000 O_MUL O_ADD
+291135 O_CONST O_NEQ
+208938 O_LOAD_LOCAL O_STORE_LOCAL
+200000 O_LOAD_GLOBAL O_RETURN
+200000 O_POP O_LOAD_GLOBAL
+200000 O_MOD O_STORE_GLOBAL
+168212 O_SUB O_CALL
+166667 O_NEQ O_BOOL
+166667 O_BOOL O_OR
+149637 O_CONST O_DIV
+149637 O_DIV O_STORE_LOCAL
+129897 O_ADD O_STORE_GLOBAL
+124468 O_NEQ O_JUMP_IF_FALSE
+119558 O_ADD O_RETURN
+104469 O_LOAD_LOCAL O_MOD
+104469 O_MOD O_STORE_LOCAL
+90901 O_SUB O_LOAD_LOCAL
+52381 O_EQ O_NOT
+52381 O_NOT O_BOOL
+52381 O_BOOL O_BOOL
+41595 O_LOAD_LOCAL O_JUMP
+40302 O_CONST O_CALL
+38309 O_LOAD_LOCAL O_RETURN
+19999 O_CONST O_LOAD_LOCAL
+19999 O_LOAD_LOCAL O_GT
+19999 O_ADD O_ADD
+19999 O_MOD O_SUB
+19999 O_GT O_JUMP_IF_FALSE
+8750 O_LOAD_LOCAL O_NEG
+8750 O_NEG O_JUMP
+2012 O_CONST O_STORE_LOCAL
+638 O_DUP O_DECR
+638 O_DECR O_STORE_LOCAL
+8 O_POP O_CONST
+7 O_CONST O_RETURN
+7 O_POP O_CALL
+2 O_CONST O_STORE_GLOBAL
+1 O_CONST O_CONST
+1 O_ADD O_LOAD_LOCAL
+1 O_BAND O_RETURN
@@ -0,0 +1,563 @@
+#include "vm.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(TELA_NO_COMPUTED_GOTO)
+#define TELA_COMPUTED_GOTO 1
+#else
+#define TELA_COMPUTED_GOTO 0
+#endif
+
+static inline std::uint16_t read_u16(const std::uint8_t *p)
+{
+  return (std::uint16_t)(p[0] | p[1] << 8);
+}
+
+static inline std::uint32_t read_u32(const std::uint8_t *p)
+{
+  return (std::uint32_t)p[0] | (std::uint32_t)p[1] << 8 | (std::uint32_t)p[2] << 16
+       | (std::uint32_t)p[3] << 24;
+}
+
+static const char *op_symbol(Op op)
+{
+  switch (op) {
+  case Op::O_ADD:
+    return "+";
+  case Op::O_SUB:
+  case Op::O_NEG:
+    return "-";
+  case Op::O_MUL:
+    return "*";
+  case Op::O_DIV:
+    return "/";
+  case Op::O_MOD:
+    return "%";
+  case Op::O_BAND:
+    return "&";
+  case Op::O_BOR:
+    return "|";
+  case Op::O_BXOR:
+    return "^";
+  case Op::O_BNOT:
+    return "~";
+  case Op::O_EQ:
+    return "==";
+  case Op::O_NEQ:
+    return "!=";
+  case Op::O_GT:
+    return ">";
+  case Op::O_LT:
+    return "<";
+  case Op::O_GEQ:
+    return ">=";
+  case Op::O_LEQ:
+    return "<=";
+  case Op::O_INCR:
+    return "++";
+  case Op::O_DECR:
+    return "--";
+  default:
+    return Bytecode::op_name(op);
+  }
+}
+
+Vm::Vm(const Bytecode &program, std::FILE *out) : program(program), code(program.fused())
+{
+  this->out    = out;
+  this->origin = this->code.data();
+  this->stack.resize(STACK_SIZE);
+  this->frames.reserve(256);
+}
+
+Value Vm::run() { return this->execute<false>(this->code.data(), nullptr); }
+
+Value Vm::profile(std::vector<std::uint64_t> &pairs)
+{
+  pairs.resize(Bytecode::OP_COUNT * Bytecode::OP_COUNT);
+  return this->execute<true>(this->program.code.data(), pairs.data());
+}
+
+template <bool PROFILE> Value Vm::execute(const std::uint8_t *code, std::uint64_t *pairs)
+{
+  const Value *constants              = this->program.constants.data();
+  const Bytecode::Function *functions = this->program.functions.data();
+
+  const std::uint8_t *pc   = code + this->program.entry;
+  const std::uint8_t *last = nullptr;
+  Value *base              = this->stack.data();
+  Value *sp                = base;
+  Value *stack_end         = base + this->stack.size();
+
+  this->origin = code;
+  this->globals.assign(this->program.globals, Value());
+  Value *globals = this->globals.data();
+  this->frames.clear();
+
+  if (base + this->program.max_stack > stack_end)
+    this->error(pc, "Stack overflow.");
+
+  // Counts the instruction at `pc` as following the one at `last` when it comes right after it.
+#define VM_PROFILE()                                                                         \
+  if constexpr (PROFILE) {                                                                   \
+    if (last != nullptr && last + 1 + Bytecode::op_size((Op)*last) == pc)                    \
+      pairs[*last * Bytecode::OP_COUNT + *pc]++;                                             \
+    last = pc;                                                                               \
+  }
+
+#if TELA_COMPUTED_GOTO
+#define VM_LABEL(name, size, effect) &&L_##name,
+#define VM_FUSED_LABEL(name, first, second) &&L_##name,
+  static void *const labels[] = { TELA_OPCODES(VM_LABEL) TELA_SUPERINSTRUCTIONS(VM_FUSED_LABEL) };
+#undef VM_FUSED_LABEL
+#undef VM_LABEL
+#define VM_CASE(name) L_##name:
+#define VM_NEXT()              \
+  {                            \
+    VM_PROFILE()               \
+    goto *labels[*pc++];       \
+  }
+  VM_NEXT();
+#else
+#define VM_CASE(name) case Op::name:
+#define VM_NEXT() continue
+  for (;;) {
+    VM_PROFILE()
+    switch ((Op)*pc++) {
+#endif
+
+  // The code of every instruction, which starts with `pc` on its operands and leaves it on the
+  // next instruction, and which reports errors at pc - 1. A superinstruction runs the code of its
+  // first part, steps over the opcode of the second, and runs the code of that.
+
+#define VM_ARITH(name, fast, op)                                     \
+  {                                                                  \
+    Value b = *--sp;                                                 \
+    Value a = sp[-1];                                                \
+    if (Value::both_int(a, b))                                       \
+      sp[-1] = Value::fast(a, b);                                    \
+    else if (Value::both_float(a, b))                                \
+      sp[-1] = Value::from_float(a.as_float() op b.as_float());      \
+    else                                                             \
+      sp[-1] = this->binary(Op::name, a, b, pc - 1);                 \
+  }
+
+#define VM_BITWISE(name, fast)                         \
+  {                                                    \
+    Value b = *--sp;                                   \
+    Value a = sp[-1];                                  \
+    if (Value::both_int(a, b))                         \
+      sp[-1] = Value::fast(a, b);                      \
+    else                                               \
+      sp[-1] = this->binary(Op::name, a, b, pc - 1);   \
+  }
+
+#define VM_COMPARE(name, cmp)                                                  \
+  {                                                                            \
+    Value b = *--sp;                                                           \
+    Value a = sp[-1];                                                          \
+    if (Value::both_int(a, b))                                                 \
+      sp[-1] = Value::from_int(a.as_int() cmp b.as_int());                     \
+    else if (Value::both_float(a, b))                                          \
+      sp[-1] = Value::from_int(a.as_float() cmp b.as_float());                 \
+    else                                                                       \
+      sp[-1] = this->binary(Op::name, a, b, pc - 1);                           \
+  }
+
+#define VM_O_CONST                     \
+  {                                    \
+    *sp++ = constants[read_u32(pc)];   \
+    pc += 4;                           \
+  }
+
+#define VM_O_LOAD_LOCAL            \
+  {                                \
+    *sp++ = base[read_u16(pc)];    \
+    pc += 2;                       \
+  }
+
+#define VM_O_STORE_LOCAL              \
+  {                                   \
+    base[read_u16(pc)] = sp[-1];      \
+    pc += 2;                          \
+  }
+
+#define VM_O_LOAD_GLOBAL              \
+  {                                   \
+    *sp++ = globals[read_u32(pc)];    \
+    pc += 4;                          \
+  }
+
+#define VM_O_STORE_GLOBAL                \
+  {                                      \
+    globals[read_u32(pc)] = sp[-1];      \
+    pc += 4;                             \
+  }
+
+#define VM_O_POP \
+  {              \
+    sp--;        \
+  }
+
+#define VM_O_DUP      \
+  {                   \
+    *sp = sp[-1];     \
+    sp++;             \
+  }
+
+#define VM_O_ADD VM_ARITH(O_ADD, int_add, +)
+#define VM_O_SUB VM_ARITH(O_SUB, int_sub, -)
+#define VM_O_MUL VM_ARITH(O_MUL, int_mul, *)
+#define VM_O_BAND VM_BITWISE(O_BAND, int_and)
+#define VM_O_BOR VM_BITWISE(O_BOR, int_or)
+#define VM_O_BXOR VM_BITWISE(O_BXOR, int_xor)
+
+#define VM_O_DIV                                                \
+  {                                                             \
+    Value b = *--sp;                                            \
+    Value a = sp[-1];                                           \
+    if (Value::both_int(a, b) && b.as_int() != 0)               \
+      sp[-1] = Value::from_int(a.as_int() / b.as_int());        \
+    else                                                        \
+      sp[-1] = this->binary(Op::O_DIV, a, b, pc - 1);           \
+  }
+
+#define VM_O_MOD                                                \
+  {                                                             \
+    Value b = *--sp;                                            \
+    Value a = sp[-1];                                           \
+    if (Value::both_int(a, b) && b.as_int() != 0)               \
+      sp[-1] = Value::from_int(a.as_int() % b.as_int());        \
+    else                                                        \
+      sp[-1] = this->binary(Op::O_MOD, a, b, pc - 1);           \
+  }
+
+#define VM_O_EQ VM_COMPARE(O_EQ, ==)
+#define VM_O_NEQ VM_COMPARE(O_NEQ, !=)
+#define VM_O_GT VM_COMPARE(O_GT, >)
+#define VM_O_LT VM_COMPARE(O_LT, <)
+#define VM_O_GEQ VM_COMPARE(O_GEQ, >=)
+#define VM_O_LEQ VM_COMPARE(O_LEQ, <=)
+
+#define VM_O_NEG                                                \
+  {                                                             \
+    if (sp[-1].is_int())                                        \
+      sp[-1] = Value::int_sub(Value::from_int(0), sp[-1]);      \
+    else                                                        \
+      sp[-1] = this->unary(Op::O_NEG, sp[-1], pc - 1);          \
+  }
+
+#define VM_O_NOT                                     \
+  {                                                  \
+    sp[-1] = Value::from_int(!sp[-1].truthy());      \
+  }
+
+#define VM_O_BNOT                                               \
+  {                                                             \
+    if (sp[-1].is_int())                                        \
+      sp[-1] = Value::from_int(~sp[-1].as_int());               \
+    else                                                        \
+      sp[-1] = this->unary(Op::O_BNOT, sp[-1], pc - 1);         \
+  }
+
+#define VM_O_BOOL                                   \
+  {                                                 \
+    sp[-1] = Value::from_int(sp[-1].truthy());      \
+  }
+
+#define VM_O_INCR                                               \
+  {                                                             \
+    if (sp[-1].is_int())                                        \
+      sp[-1] = Value::int_incr(sp[-1], 1);                      \
+    else                                                        \
+      sp[-1] = this->unary(Op::O_INCR, sp[-1], pc - 1);         \
+  }
+
+#define VM_O_DECR                                               \
+  {                                                             \
+    if (sp[-1].is_int())                                        \
+      sp[-1] = Value::int_incr(sp[-1], -1);                     \
+    else                                                        \
+      sp[-1] = this->unary(Op::O_DECR, sp[-1], pc - 1);         \
+  }
+
+#define VM_O_INDEX                                  \
+  {                                                 \
+    Value b = *--sp;                                \
+    sp[-1]  = this->index(sp[-1], b, pc - 1);       \
+  }
+
+#define VM_O_JUMP                                         \
+  {                                                       \
+    std::int32_t offset = (std::int32_t)read_u32(pc);     \
+    pc += 4 + offset;                                     \
+  }
+
+#define VM_O_JUMP_IF_FALSE                                \
+  {                                                       \
+    std::int32_t offset = (std::int32_t)read_u32(pc);     \
+    pc += 4;                                              \
+    if (!(*--sp).truthy())                                \
+      pc += offset;                                       \
+  }
+
+#define VM_O_AND                                          \
+  {                                                       \
+    std::int32_t offset = (std::int32_t)read_u32(pc);     \
+    pc += 4;                                              \
+    if (!sp[-1].truthy()) {                               \
+      sp[-1] = Value::from_int(0);                        \
+      pc += offset;                                       \
+    } else                                                \
+      sp--;                                               \
+  }
+
+#define VM_O_OR                                           \
+  {                                                       \
+    std::int32_t offset = (std::int32_t)read_u32(pc);     \
+    pc += 4;                                              \
+    if (sp[-1].truthy()) {                                \
+      sp[-1] = Value::from_int(1);                        \
+      pc += offset;                                       \
+    } else                                                \
+      sp--;                                               \
+  }
+
+#define VM_O_CALL                                                                \
+  {                                                                              \
+    const Bytecode::Function &function = functions[read_u32(pc)];                \
+    Value *callee_base                 = sp - pc[4];                             \
+                                                                                 \
+    if (callee_base + function.slots + function.max_stack > stack_end)           \
+      this->error(pc - 1, "Stack overflow.");                                    \
+                                                                                 \
+    for (; sp < callee_base + function.slots; sp++)                              \
+      *sp = Value();                                                             \
+                                                                                 \
+    this->frames.push_back({ pc + 5, base });                                    \
+    base = callee_base;                                                          \
+    pc   = code + function.entry;                                                \
+  }
+
+#define VM_O_CALL_NATIVE                                          \
+  {                                                               \
+    unsigned int argc = pc[1];                                    \
+    Value result      = this->native(pc[0], sp - argc, argc);     \
+                                                                  \
+    sp -= argc;                                                   \
+    *sp++ = result;                                               \
+    pc += 2;                                                      \
+  }
+
+#define VM_O_RETURN                            \
+  {                                            \
+    Value result = sp[-1];                     \
+    Frame frame  = this->frames.back();        \
+    this->frames.pop_back();                   \
+                                               \
+    sp    = base;                              \
+    *sp++ = result;                            \
+    base  = frame.base;                        \
+    pc    = frame.ret;                         \
+  }
+
+#define VM_O_HALT { return sp[-1]; }
+
+#define VM_INSTRUCTION(name, size, effect) \
+  VM_CASE(name)                            \
+  {                                        \
+    VM_##name                              \
+    VM_NEXT();                             \
+  }
+
+#define VM_SUPERINSTRUCTION(name, first, second) \
+  VM_CASE(name)                                  \
+  {                                              \
+    VM_##first                                   \
+    pc++;                                        \
+    VM_##second                                  \
+    VM_NEXT();                                   \
+  }
+
+  TELA_OPCODES(VM_INSTRUCTION)
+  TELA_SUPERINSTRUCTIONS(VM_SUPERINSTRUCTION)
+
+#undef VM_SUPERINSTRUCTION
+#undef VM_INSTRUCTION
+#undef VM_COMPARE
+#undef VM_BITWISE
+#undef VM_ARITH
+#undef VM_NEXT
+#undef VM_CASE
+#undef VM_PROFILE
+
+#if !TELA_COMPUTED_GOTO
+    }
+  }
+#endif
+}
+
+Value Vm::binary(Op op, Value a, Value b, const std::uint8_t *pc)
+{
+  if (a.is_integral() && b.is_integral()) {
+    std::int64_t x = a.as_int();
+    std::int64_t y = b.as_int();
+
+    switch (op) {
+    case Op::O_ADD:
+      return Value::from_int((std::int64_t)((std::uint64_t)x + (std::uint64_t)y));
+    case Op::O_SUB:
+      return Value::from_int((std::int64_t)((std::uint64_t)x - (std::uint64_t)y));
+    case Op::O_MUL:
+      return Value::from_int((std::int64_t)((std::uint64_t)x * (std::uint64_t)y));
+    case Op::O_DIV:
+      if (y == 0)
+        this->error(pc, "Division by zero.");
+      return Value::from_int(y == -1 ? (std::int64_t)(0 - (std::uint64_t)x) : x / y);
+    case Op::O_MOD:
+      if (y == 0)
+        this->error(pc, "Division by zero.");
+      return Value::from_int(y == -1 ? 0 : x % y);
+    case Op::O_BAND:
+      return Value::from_int(x & y);
+    case Op::O_BOR:
+      return Value::from_int(x | y);
+    case Op::O_BXOR:
+      return Value::from_int(x ^ y);
+    case Op::O_EQ:
+      return Value::from_int(x == y);
+    case Op::O_NEQ:
+      return Value::from_int(x != y);
+    case Op::O_GT:
+      return Value::from_int(x > y);
+    case Op::O_LT:
+      return Value::from_int(x < y);
+    case Op::O_GEQ:
+      return Value::from_int(x >= y);
+    case Op::O_LEQ:
+      return Value::from_int(x <= y);
+    default:
+      break;
+    }
+  } else if (!a.is_string() && !b.is_string()) {
+    double x = a.as_float();
+    double y = b.as_float();
+
+    switch (op) {
+    case Op::O_ADD:
+      return Value::from_float(x + y);
+    case Op::O_SUB:
+      return Value::from_float(x - y);
+    case Op::O_MUL:
+      return Value::from_float(x * y);
+    case Op::O_DIV:
+      if (y == 0.0)
+        this->error(pc, "Division by zero.");
+      return Value::from_float(x / y);
+    case Op::O_EQ:
+      return Value::from_int(x == y);
+    case Op::O_NEQ:
+      return Value::from_int(x != y);
+    case Op::O_GT:
+      return Value::from_int(x > y);
+    case Op::O_LT:
+      return Value::from_int(x < y);
+    case Op::O_GEQ:
+      return Value::from_int(x >= y);
+    case Op::O_LEQ:
+      return Value::from_int(x <= y);
+    default:
+      break;
+    }
+  } else if (a.is_string() && b.is_string()) {
+    if (op == Op::O_EQ)
+      return Value::from_int(a.as_string() == b.as_string());
+    if (op == Op::O_NEQ)
+      return Value::from_int(a.as_string() != b.as_string());
+  }
+
+  this->error(pc, "Invalid operands to '%s'.", op_symbol(op));
+}
+
+Value Vm::unary(Op op, Value a, const std::uint8_t *pc)
+{
+  if (a.is_char() && (op == Op::O_INCR || op == Op::O_DECR))
+    return Value::from_char((char)(a.as_char() + (op == Op::O_INCR ? 1 : -1)));
+
+  if (a.is_integral()) {
+    std::uint64_t x = (std::uint64_t)a.as_int();
+
+    switch (op) {
+    case Op::O_NEG:
+      return Value::from_int((std::int64_t)(0 - x));
+    case Op::O_BNOT:
+      return Value::from_int((std::int64_t)~x);
+    case Op::O_INCR:
+      return Value::from_int((std::int64_t)(x + 1));
+    case Op::O_DECR:
+      return Value::from_int((std::int64_t)(x - 1));
+    default:
+      break;
+    }
+  } else if (a.is_float()) {
+    switch (op) {
+    case Op::O_NEG:
+      return Value::from_float(-a.as_float());
+    case Op::O_INCR:
+      return Value::from_float(a.as_float() + 1.0);
+    case Op::O_DECR:
+      return Value::from_float(a.as_float() - 1.0);
+    default:
+      break;
+    }
+  }
+
+  this->error(pc, "Invalid operand of '%s'.", op_symbol(op));
+}
+
+Value Vm::index(Value a, Value b, const std::uint8_t *pc)
+{
+  if (!a.is_string() || !b.is_integral())
+    this->error(pc, "Invalid operands to '[]'.");
+
+  std::string_view str = this->program.strings.get(a.as_string());
+  if (b.as_int() < 0 || (std::uint64_t)b.as_int() >= str.size())
+    this->error(pc, "Index out of range.");
+
+  return Value::from_char(str[(std::size_t)b.as_int()]);
+}
+
+Value Vm::native(std::uint8_t native, Value *args, unsigned int argc)
+{
+  switch ((Bytecode::Native)native) {
+  case Bytecode::Native::N_PRINT:
+    for (unsigned int i = 0; i < argc; i++) {
+      if (i > 0)
+        std::fputc(' ', this->out);
+
+      switch (args[i].type()) {
+      case ValueType::V_INT:
+        std::fprintf(this->out, "%lld", (long long)args[i].as_int());
+        break;
+      case ValueType::V_FLOAT:
+        std::fprintf(this->out, "%.15g", args[i].as_float());
+        break;
+      case ValueType::V_CHAR:
+        std::fputc(args[i].as_char(), this->out);
+        break;
+      case ValueType::V_STRING: {
+        std::string_view str = this->program.strings.get(args[i].as_string());
+        std::fwrite(str.data(), 1, str.size(), this->out);
+        break;
+      }
+      }
+    }
+    std::fputc('\n', this->out);
+    break;
+  }
+
+  return Value();
+}
+
+void Vm::error(const std::uint8_t *pc, const char *format, const char *arg)
+{
+  throw Error(this->program.locate((std::uint32_t)(pc - this->origin)), format, arg);
+}
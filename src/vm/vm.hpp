@@ -0,0 +1,47 @@
+#ifndef VM_HPP
+#define VM_HPP
+
+#include "bytecode/bytecode.hpp"
+#include "error/error.hpp"
+#include "value/value.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+class Vm {
+  struct Frame {
+    const std::uint8_t *ret;
+    Value *base;
+  };
+
+  const Bytecode &program;
+  std::vector<std::uint8_t> code;
+  const std::uint8_t *origin;
+  std::FILE *out;
+
+  std::vector<Value> stack;
+  std::vector<Value> globals;
+  std::vector<Frame> frames;
+
+  public:
+  static const std::size_t STACK_SIZE = 1 << 18;
+
+  Vm(const Bytecode &program, std::FILE *out = stdout);
+
+  Value run();
+  // Runs the program without superinstructions, and counts in pairs[first * OP_COUNT + second]
+  // how many times each instruction went on to the one after it.
+  Value profile(std::vector<std::uint64_t> &pairs);
+
+  private:
+  template <bool PROFILE> Value execute(const std::uint8_t *code, std::uint64_t *pairs);
+
+  Value binary(Op op, Value a, Value b, const std::uint8_t *pc);
+  Value unary(Op op, Value a, const std::uint8_t *pc);
+  Value index(Value a, Value b, const std::uint8_t *pc);
+  Value native(std::uint8_t native, Value *args, unsigned int argc);
+
+  [[noreturn]] void error(const std::uint8_t *pc, const char *format, const char *arg = "");
+};
+
+#endif
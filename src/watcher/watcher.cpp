@@ -0,0 +1,157 @@
+#include "watcher.hpp"
+#include "error/error.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define TELA_INOTIFY 1
+#else
+#define TELA_INOTIFY 0
+#endif
+
+#if TELA_INOTIFY
+static const std::uint32_t EVENTS =
+    IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+#endif
+
+static bool is_source(const std::filesystem::path &path)
+{
+  return path.extension() == ".tl";
+}
+
+Watcher::Watcher(const std::string &root) : root(root)
+{
+#if TELA_INOTIFY
+  std::error_code error;
+  if (!std::filesystem::is_directory(root, error))
+    throw Error("Cannot watch directory: %s", root.c_str());
+
+  this->fd = inotify_init1(IN_CLOEXEC);
+  if (this->fd < 0)
+    throw Error("Cannot watch directory: %s", root.c_str());
+
+  try {
+    this->watch(root, this->found);
+  } catch (...) {
+    close(this->fd);
+    throw;
+  }
+  std::sort(this->found.begin(), this->found.end());
+#else
+  this->fd = -1;
+  throw Error("Watching directories is not supported on this platform: %s", root.c_str());
+#endif
+}
+
+Watcher::~Watcher()
+{
+#if TELA_INOTIFY
+  close(this->fd);
+#endif
+}
+
+const std::vector<std::string> &Watcher::sources() const { return this->found; }
+
+std::vector<std::string> Watcher::wait(int settle)
+{
+  std::vector<std::string> changed;
+
+  while (changed.empty()) {
+    this->read(-1, changed);
+    while (this->read(settle, changed))
+      continue;
+  }
+
+  std::sort(changed.begin(), changed.end());
+  changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+  return changed;
+}
+
+// Watches `directory` and the directories under it, adding the sources in them to `sources`. The
+// directory is watched before it is listed, so that no source created meanwhile is missed.
+void Watcher::watch(const std::string &directory, std::vector<std::string> &sources)
+{
+#if TELA_INOTIFY
+  int wd = inotify_add_watch(this->fd, directory.c_str(), EVENTS | IN_ONLYDIR);
+  if (wd < 0)
+    throw Error("Cannot watch directory: %s", directory.c_str());
+  this->directories[wd] = directory;
+
+  std::error_code error;
+  for (const auto &entry : std::filesystem::directory_iterator(directory, error)) {
+    std::string path = entry.path().string();
+
+    if (entry.is_directory(error))
+      this->watch(path, sources);
+    else if (is_source(entry.path()))
+      sources.push_back(path);
+  }
+#else
+  (void)directory;
+  (void)sources;
+#endif
+}
+
+// Reads the events that come within `timeout` milliseconds, or -1 to wait for them, and adds the
+// sources they are about to `changed`. Returns whether there were any.
+bool Watcher::read(int timeout, std::vector<std::string> &changed)
+{
+#if TELA_INOTIFY
+  alignas(inotify_event) char buffer[4096];
+  pollfd poller = { this->fd, POLLIN, 0 };
+
+  int ready = poll(&poller, 1, timeout);
+  if (ready < 0 && errno == EINTR)
+    return true;
+  if (ready < 0)
+    throw Error("Cannot watch directory: %s", this->root.c_str());
+  if (ready == 0)
+    return false;
+
+  ssize_t size = ::read(this->fd, buffer, sizeof(buffer));
+  if (size < 0 && errno == EINTR)
+    return true;
+  if (size <= 0)
+    throw Error("Cannot watch directory: %s", this->root.c_str());
+
+  for (ssize_t i = 0; i < size;) {
+    const inotify_event *event = (const inotify_event *)(buffer + i);
+    i += sizeof(inotify_event) + event->len;
+
+    // Events were dropped, so any source may have changed. Watching a directory again keeps
+    // its watch descriptor.
+    if (event->mask & IN_Q_OVERFLOW) {
+      this->watch(this->root, changed);
+      continue;
+    }
+
+    auto directory = this->directories.find(event->wd);
+    if (directory == this->directories.end())
+      continue;
+    if (event->mask & IN_IGNORED) {
+      this->directories.erase(directory);
+      continue;
+    }
+    if (event->len == 0)
+      continue;
+
+    std::filesystem::path path = std::filesystem::path(directory->second) / event->name;
+    if (event->mask & IN_ISDIR && event->mask & (IN_CREATE | IN_MOVED_TO))
+      this->watch(path.string(), changed);
+    else if (!(event->mask & IN_ISDIR) && is_source(path))
+      changed.push_back(path.string());
+  }
+
+  return true;
+#else
+  (void)timeout;
+  (void)changed;
+  return false;
+#endif
+}
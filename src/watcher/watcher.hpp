@@ -0,0 +1,40 @@
+#ifndef WATCHER_HPP
+#define WATCHER_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Watches the tela sources under a directory, including those of directories created later, so
+// that a resident process hears about the files that are saved instead of reading them all again.
+// Sources are the files ending in ".tl", and their paths are those of the directory they are in
+// joined with their name.
+//
+// Only Linux, with inotify, is supported.
+class Watcher {
+  int fd;
+  std::string root;
+  // The directory of every watch descriptor.
+  std::unordered_map<int, std::string> directories;
+  std::vector<std::string> found;
+
+  public:
+  Watcher(const std::string &root);
+  Watcher(const Watcher &) = delete;
+  Watcher &operator=(const Watcher &) = delete;
+  ~Watcher();
+
+  // The sources under the directory when the watch started, in order.
+  const std::vector<std::string> &sources() const;
+
+  // Waits for sources to be written, created, moved or removed, and returns each of them once, in
+  // order. Editors save in several steps, so changes are collected until none came for `settle`
+  // milliseconds.
+  std::vector<std::string> wait(int settle = 20);
+
+  private:
+  void watch(const std::string &directory, std::vector<std::string> &sources);
+  bool read(int timeout, std::vector<std::string> &changed);
+};
+
+#endif
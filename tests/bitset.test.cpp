@@ -0,0 +1,72 @@
+#include "bitset/bitset.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+TEST_CASE("Bitset class tests", "[bitset]")
+{
+  Bitset set(200);
+
+  SECTION("Setting and resetting bits")
+  {
+    set.set(0);
+    set.set(63);
+    set.set(64);
+    set.set(199);
+
+    REQUIRE(set.size() == 200);
+    REQUIRE(set.test(0));
+    REQUIRE(set.test(63));
+    REQUIRE(set.test(64));
+    REQUIRE(!set.test(65));
+    REQUIRE(set.count() == 4);
+
+    set.reset(63);
+    REQUIRE(!set.test(63));
+    REQUIRE(set.count() == 3);
+
+    set.clear();
+    REQUIRE(set.count() == 0);
+  }
+
+  SECTION("Resetting ranges across words")
+  {
+    for (std::uint32_t i = 0; i < 200; i++)
+      set.set(i);
+
+    set.reset_range(10, 150);
+    REQUIRE(set.count() == 60);
+    REQUIRE(set.test(9));
+    REQUIRE(!set.test(10));
+    REQUIRE(!set.test(149));
+    REQUIRE(set.test(150));
+  }
+
+  SECTION("Union reports changes")
+  {
+    Bitset other(200);
+    other.set(5);
+    other.set(130);
+
+    REQUIRE(set.unite(other));
+    REQUIRE(!set.unite(other));
+    REQUIRE(set == other);
+
+    set.set(7);
+    set.subtract(other);
+    REQUIRE(set.count() == 1);
+    REQUIRE(set != other);
+  }
+
+  SECTION("Iteration in increasing order")
+  {
+    set.set(3);
+    set.set(64);
+    set.set(128);
+    set.set(190);
+
+    std::vector<std::uint32_t> bits;
+    set.each([&](std::uint32_t bit) { bits.push_back(bit); });
+
+    REQUIRE(bits == std::vector<std::uint32_t>{ 3, 64, 128, 190 });
+  }
+}
@@ -0,0 +1,103 @@
+#include "cache/cache.hpp"
+#include "error/error.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+
+static void write_file(const std::string &path, const std::string &contents)
+{
+  std::ofstream file(path, std::ios::binary);
+  file << contents;
+}
+
+TEST_CASE("ParseCache class tests", "[cache]")
+{
+  SourceManager sources;
+  ParseCache cache(sources);
+
+  SECTION("Unchanged files are parsed once")
+  {
+    write_file("tela_cache.tl", "fn f(): int { return 1 + 2; }\n");
+
+    std::shared_ptr<Ast> first = cache.parse("tela_cache.tl");
+    REQUIRE(first->dump() == "(program (fn f () int (block (return 3))))");
+    REQUIRE(cache.parse("tela_cache.tl") == first);
+    REQUIRE(cache.hits() == 1);
+
+    write_file("tela_cache.tl", "fn g() {}\n");
+    REQUIRE(cache.parse("tela_cache.tl")->dump() == "(program (fn g () (block)))");
+    REQUIRE(cache.hits() == 1);
+  }
+
+  SECTION("Superseded ASTs stay valid while held and release their sources after")
+  {
+    write_file("tela_cache.tl", "fn f() {}\n");
+    std::shared_ptr<Ast> old = cache.parse("tela_cache.tl");
+    SourceLoc loc            = old->token(old->list_items(old->lhs(0))[0]).loc;
+
+    write_file("tela_cache.tl", "fn g() {}\n");
+    std::shared_ptr<Ast> latest = cache.parse("tela_cache.tl");
+    REQUIRE(old->dump() == "(program (fn f () (block)))");
+    REQUIRE(std::string(sources.resolve(loc).path) == "tela_cache.tl");
+
+    old.reset();
+    REQUIRE(sources.resolve(loc).path == nullptr);
+
+    // Editing a file over and over reuses the buffers of the versions nobody holds.
+    for (int i = 0; i < 100; i++) {
+      write_file("tela_cache.tl", "fn f" + std::to_string(i) + "() {}\n");
+      cache.parse("tela_cache.tl");
+    }
+    std::uint32_t buffer = sources.add("tela_cache_probe.tl", "");
+    REQUIRE(buffer < 4);
+    REQUIRE(latest->dump() == "(program (fn g () (block)))");
+  }
+
+  SECTION("Locations of cached ASTs stay valid")
+  {
+    write_file("tela_cache.tl", "\n  fn f() {}\n");
+
+    cache.parse("tela_cache.tl");
+    std::shared_ptr<Ast> ast = cache.parse("tela_cache.tl");
+
+    SourcePosition position = sources.resolve(ast->token(ast->list_items(ast->lhs(0))[0]).loc);
+    REQUIRE(std::string(position.path) == "tela_cache.tl");
+    REQUIRE(position.row == 2);
+    REQUIRE(position.col == 6);
+  }
+
+  SECTION("Large files are lexed and parsed in a pipeline")
+  {
+    std::string input;
+    while (input.size() < ParseCache::PIPELINE_SIZE)
+      input += "fn f" + std::to_string(input.size()) + "(a: int): int { return a * 2 + 1; }\n";
+    write_file("tela_cache.tl", input);
+
+    SourceManager pipelined_sources;
+    ParseCache pipelined(pipelined_sources, true);
+    REQUIRE(pipelined.parse("tela_cache.tl")->dump() == cache.parse("tela_cache.tl")->dump());
+
+    write_file("tela_cache.tl", input + "fn g( {}\n");
+    REQUIRE_THROWS_AS(pipelined.parse("tela_cache.tl"), Error);
+  }
+
+  SECTION("Errors")
+  {
+    REQUIRE_THROWS_AS(cache.parse("tela_cache_missing.tl"), Error);
+
+    write_file("tela_cache.tl", "fn f( {}\n");
+    REQUIRE_THROWS_AS(cache.parse("tela_cache.tl"), Error);
+    try {
+      cache.parse("tela_cache.tl");
+    } catch (Error &error) {
+      REQUIRE(std::string(sources.resolve(error.loc).path) == "tela_cache.tl");
+    }
+
+    write_file("tela_cache.tl", "fn f() {}\n");
+    REQUIRE(cache.parse("tela_cache.tl")->dump() == "(program (fn f () (block)))");
+  }
+
+  std::remove("tela_cache.tl");
+}
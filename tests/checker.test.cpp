@@ -0,0 +1,131 @@
+#include "checker/checker.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+// Every diagnostic as "<row>:<col>: <message>".
+static std::vector<std::string> check(const std::string &input, unsigned int jobs = 1)
+{
+  SourceManager sources;
+  Lexer lexer(sources, sources.add("test.tl", input));
+  Parser parser(lexer.tokenize());
+  Ast ast = parser.parse();
+  TypeTable types;
+
+  Checker checker(ast, types, jobs);
+  std::vector<std::string> messages;
+  for (Checker::Diagnostic &diagnostic : checker.check()) {
+    SourcePosition position = sources.resolve(diagnostic.loc);
+    messages.push_back(std::to_string(position.row) + ":" + std::to_string(position.col) + ": "
+                       + diagnostic.message);
+  }
+
+  return messages;
+}
+
+TEST_CASE("Checking of well-typed programs", "[checker]")
+{
+  REQUIRE(check("fn main() { let a = 1; let b = a + 2.5; print(\"%s\", b); }").empty());
+  REQUIRE(check("fn f(a: int, b: float): float { return a * b; }"
+                "fn main(): int { let c: char = 'x'; let i: int = c; return f(i, c) > 1.0; }")
+              .empty());
+  REQUIRE(check("let limit: int = 10;"
+                "fn g(s: string): char { return s[limit - 9]; }"
+                "fn main() { let n = 0; while (n < limit) n++; return g(\"ab\") == 'b'; }")
+              .empty());
+  REQUIRE(check("fn first(a: int, ...): int { return a; }"
+                "fn main() { return first(1, 2.0, \"x\"); }")
+              .empty());
+}
+
+TEST_CASE("Checking of ill-typed programs", "[checker]")
+{
+  SECTION("Mismatched types")
+  {
+    REQUIRE(check("fn f(): int { return 1.5; }")
+            == std::vector<std::string>{ "1:22: Type mismatch: expected int, found float." });
+    REQUIRE(check("fn f(): string { return; }")
+            == std::vector<std::string>{ "1:18: Type mismatch: expected string, found nil." });
+    REQUIRE(check("fn f() { let s: string = 1; s = 'c'; }")
+            == std::vector<std::string>{ "1:26: Type mismatch: expected string, found int.",
+                                         "1:33: Type mismatch: expected string, found char." });
+  }
+
+  SECTION("Invalid operands")
+  {
+    REQUIRE(check("fn f(s: string) { return s + 1; }")
+            == std::vector<std::string>{ "1:28: Invalid operands to '+'." });
+    REQUIRE(check("fn f(x: float) { return x % 2; }")
+            == std::vector<std::string>{ "1:27: Invalid operands to '%'." });
+    REQUIRE(check("fn f(s: string) { return -s + ~1.5; }")
+            == std::vector<std::string>{ "1:26: Invalid operand of '-'.",
+                                         "1:31: Invalid operand of '~'." });
+  }
+
+  SECTION("Integer constants out of range")
+  {
+    REQUIRE(check("fn f() { return 140737488355328 + 99999999999999999999; }")
+            == std::vector<std::string>{
+                "1:17: Integer constant out of range: 140737488355328",
+                "1:35: Integer constant out of range: 99999999999999999999" });
+  }
+
+  SECTION("Errors do not cascade")
+  {
+    REQUIRE(check("fn f(): int { let a = b + 1; return a * 2.0 + undefined; }")
+            == std::vector<std::string>{ "1:23: Undefined identifier: b",
+                                         "1:47: Undefined identifier: undefined" });
+    REQUIRE(check("fn f(x: number): int { return x; }")
+            == std::vector<std::string>{ "1:9: Unknown type: number" });
+  }
+
+  SECTION("Calls")
+  {
+    REQUIRE(check("fn f(a: int) {} fn main() { f(); f(1, 2); f(\"a\"); }")
+            == std::vector<std::string>{ "1:30: Wrong number of arguments to 'f'.",
+                                         "1:35: Wrong number of arguments to 'f'.",
+                                         "1:45: Type mismatch: expected int, found string." });
+    REQUIRE(check("let g = 1; fn main(h: int) { g(); h(); k(); }")
+            == std::vector<std::string>{ "1:30: 'g' is not a function.",
+                                         "1:35: 'h' is not a function.",
+                                         "1:40: Undefined function: k" });
+    REQUIRE(check("import util; fn main() { return helper(1); }").empty());
+  }
+
+  SECTION("Redefinitions")
+  {
+    REQUIRE(check("fn f() {} let f = 1; fn g(a: int, a: int) { let b; { let b; } let b; }")
+            == std::vector<std::string>{ "1:15: Redefinition of 'f'.",
+                                         "1:35: Redefinition of 'a'.",
+                                         "1:67: Redefinition of 'b'." });
+  }
+
+  SECTION("Globals are checked before the functions that use them")
+  {
+    REQUIRE(check("fn f(): string { return x; } let x: int = 'a' + 1.0;")
+            == std::vector<std::string>{ "1:25: Type mismatch: expected string, found int.",
+                                         "1:47: Type mismatch: expected int, found float." });
+  }
+}
+
+TEST_CASE("Checking in parallel", "[checker]")
+{
+  std::string input;
+  for (int i = 0; i < 500; i++) {
+    std::string n = std::to_string(i);
+    input += "fn f" + n + "(a: int): int {\n"
+             "  let b: float = a * " + n + ";\n"
+             "  return " + (i % 7 == 0 ? "b" : "a + f" + std::to_string(i / 2) + "(a)") + ";\n"
+             "}\n";
+  }
+
+  std::vector<std::string> serial = check(input, 1);
+
+  REQUIRE(serial.size() == 72);
+  REQUIRE(serial.front() == "3:10: Type mismatch: expected int, found float.");
+  REQUIRE(serial.back() == "1991:10: Type mismatch: expected int, found float.");
+  for (unsigned int jobs : { 2u, 4u, 16u })
+    REQUIRE(check(input, jobs) == serial);
+}
@@ -0,0 +1,215 @@
+#include "codegen/codegen.hpp"
+#include "compiler/compiler.hpp"
+#include "error/error.hpp"
+#include "folder/folder.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include "vm/vm.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#if defined(__linux__) && defined(__x86_64__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+static std::string generate(const char *input)
+{
+  SourceManager sources;
+  Lexer lexer(sources, sources.add("test.tl", input));
+  Parser parser(lexer.tokenize());
+  Ast ast = parser.parse();
+
+  Folder folder(ast);
+  folder.fold();
+
+  Codegen codegen(ast);
+  return codegen.generate();
+}
+
+TEST_CASE("Generation of assembly", "[codegen]")
+{
+  SECTION("Functions and the entry point")
+  {
+    std::string assembly = generate("fn f(a: int): int { return a; } fn main() { return f(1); }");
+
+    REQUIRE(assembly.find("tela_f:\n") != std::string::npos);
+    REQUIRE(assembly.find("tela_main:\n") != std::string::npos);
+    REQUIRE(assembly.find("\t.globl main\n") != std::string::npos);
+    REQUIRE(assembly.find("\tcall tela_f\n") != std::string::npos);
+    REQUIRE(assembly.find("\tcall tela_main\n") != std::string::npos);
+  }
+
+  SECTION("Comparisons are fused with branches and constants become immediates")
+  {
+    std::string assembly = generate("fn main() { let i = 0; while (i < 1000) i++; return i; }");
+
+    REQUIRE(assembly.find("\tcmpq $1000, ") != std::string::npos);
+    REQUIRE(assembly.find("\tjge .L") != std::string::npos);
+    REQUIRE(assembly.find("setl") == std::string::npos);
+    REQUIRE(assembly.find("(%rbp)") == std::string::npos);
+  }
+
+  SECTION("Globals and print formats")
+  {
+    std::string assembly = generate("let g = 2; fn main() { print(\"g =\", g, '%'); }");
+
+    REQUIRE(assembly.find("tela_g:\n\t.zero 8\n") != std::string::npos);
+    REQUIRE(assembly.find("\t.string \"g = %lld %%\\n\"\n") != std::string::npos);
+    REQUIRE(assembly.find("\tcall printf@PLT\n") != std::string::npos);
+  }
+
+  SECTION("Unsupported programs")
+  {
+    REQUIRE_THROWS_AS(generate("fn main() { let a = 1.5; }"), Error);
+    REQUIRE_THROWS_AS(generate("fn main() { let s = \"a\"; }"), Error);
+    REQUIRE_THROWS_AS(generate("fn main() { return f(); }"), Error);
+    REQUIRE_THROWS_AS(generate("fn f(a: int) { } fn main() { return f(); }"), Error);
+    REQUIRE_THROWS_AS(generate("fn main(a: int) { }"), Error);
+  }
+}
+
+#if defined(__linux__) && defined(__x86_64__)
+
+struct Native {
+  std::string output;
+  int status;
+};
+
+// Assembles and links the generated code with the system compiler, runs it and compares its
+// behavior with the bytecode interpreter.
+static Native run_native(const char *input)
+{
+  static int counter = 0;
+  std::string base
+      = "/tmp/tela-codegen-" + std::to_string(getpid()) + "-" + std::to_string(counter++);
+
+  std::FILE *file = std::fopen((base + ".s").c_str(), "w");
+  std::fputs(generate(input).c_str(), file);
+  std::fclose(file);
+
+  Native native = { "", -1 };
+  if (std::system(("cc -o " + base + " " + base + ".s").c_str()) == 0) {
+    std::FILE *pipe = popen(base.c_str(), "r");
+    for (int c; (c = std::fgetc(pipe)) != EOF;)
+      native.output.push_back((char)c);
+    int status = pclose(pipe);
+    native.status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  }
+
+  std::remove((base + ".s").c_str());
+  std::remove(base.c_str());
+
+  return native;
+}
+
+static Native run_vm(const char *input)
+{
+  SourceManager sources;
+  Lexer lexer(sources, sources.add("test.tl", input));
+  Parser parser(lexer.tokenize());
+  Ast ast = parser.parse();
+
+  Folder folder(ast);
+  folder.fold();
+
+  Compiler compiler(ast);
+  Bytecode program = compiler.compile();
+
+  std::FILE *out = std::tmpfile();
+  Vm vm(program, out);
+  Value result = vm.run();
+
+  Native native = { "", (int)(result.as_int() & 0xff) };
+  std::rewind(out);
+  for (int c; (c = std::fgetc(out)) != EOF;)
+    native.output.push_back((char)c);
+  std::fclose(out);
+
+  return native;
+}
+
+static void check(const char *input)
+{
+  Native native = run_native(input);
+  Native vm     = run_vm(input);
+
+  REQUIRE(native.output == vm.output);
+  REQUIRE(native.status == vm.status);
+}
+
+TEST_CASE("Execution of native code", "[codegen]")
+{
+  if (std::system("cc --version > /dev/null 2>&1") != 0)
+    SKIP("No system C compiler available");
+
+  SECTION("Arithmetic and bitwise operators")
+  {
+    check("fn main() { let a = 7; let b = -2; print(a + b, a - b, a * b, a / b, a % b);"
+          "  print(a & b, a | b, a ^ b, ~a, -a, +a); return a * 6; }");
+  }
+
+  SECTION("Integers wrap at 48 bits")
+  {
+    check("fn main() { let a = 140737488355327; let b = -140737488355327 - 1; let c = -1;"
+          "  print(a + 1 > 0, 140737488355327 + 1 > 0, a + 1, b - 1, -b, b / c, b % c);"
+          "  print(a * 2, a * a, b * b, a * -3, b + b, a - b, ~a, ~b);"
+          "  let i = a; i++; let j = b; j--; let k = a; k += a; k *= 3;"
+          "  print(i, j, k, i == b, j == a); return a + 2; }");
+  }
+
+  SECTION("Comparison and logical operators")
+  {
+    check("fn t() { print(\"t\"); return 1; }"
+          "fn main() { let a = 1; let b = 2;"
+          "  print(a < b, a > b, a <= 1, a >= 2, a == b, a != b, !a, !0);"
+          "  print(a && b, 0 && t(), b || t(), 0 || 0, a > 0 ? 10 : 20); }");
+  }
+
+  SECTION("Assignment and increment operators")
+  {
+    check("fn main() { let a = 10; a += 5; a -= 3; a *= 2; a /= 4; a %= 4;"
+          "  let b = 12; b &= 10; b |= 1; b ^= 3; let c = a++; let d = --b;"
+          "  print(a, b, c, d); return a + b; }");
+  }
+
+  SECTION("Control flow")
+  {
+    check("fn main() { let i = 0; let s = 0;"
+          "  while (i < 100) { let j = 0;"
+          "    while (j < i) { if (j % 3 == 0) s += j; else s -= 1; j++; }"
+          "    i++; } print(s); return s; }");
+  }
+
+  SECTION("Calls, recursion and stack arguments")
+  {
+    check("fn fib(n: int): int { return n < 2 ? n : fib(n - 1) + fib(n - 2); }"
+          "fn sum(a: int, b: int, c: int, d: int, e: int, f: int, g: int, h: int, i: int): int {"
+          "  return a + b * 2 + c * 3 + d * 4 + e * 5 + f * 6 + g * 7 + h * 8 + i * 9; }"
+          "fn first(a: int, ...) { return a; }"
+          "fn main() { print(fib(20), sum(1, 2, 3, 4, 5, 6, 7, 8, 9), first(4, 5, 6));"
+          "  print(1, 2, 3, 4, 5, 6, 7); }");
+  }
+
+  SECTION("Globals")
+  {
+    check("let g = 2; let h = g * 10; fn bump() { g += 1; return g; }"
+          "fn main() { bump(); bump(); print(g, h); return g; }");
+  }
+
+  SECTION("Register pressure")
+  {
+    check("fn id(x: int): int { return x; }"
+          "fn main() {"
+          "  let a = 1; let b = 2; let c = 3; let d = 4; let e = 5; let f = 6; let g = 7;"
+          "  let h = 8; let i = 9; let j = 10; let k = 11; let l = 12; let m = 13; let n = 14;"
+          "  let t = 0;"
+          "  while (t < 5) { a += b; b += c; c += d; d += e; e += f; f += g; g += h; h += i;"
+          "    i += j; j += k; k += l; l += m; m += n; n += id(a); t++; }"
+          "  print(a, b, c, d, e, f, g, h, i, j, k, l, m, n); }");
+  }
+}
+
+#endif
@@ -0,0 +1,101 @@
+#include "compiler/compiler.hpp"
+#include "error/error.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+static Bytecode compile(const char *input)
+{
+  SourceManager sources;
+  Lexer lexer(sources, sources.add("test.tl", input));
+  Parser parser(lexer.tokenize());
+  Ast ast = parser.parse();
+
+  Compiler compiler(ast);
+  return compiler.compile();
+}
+
+TEST_CASE("Compilation of expressions", "[compiler]")
+{
+  SECTION("Operands are pushed before the operator")
+  {
+    Bytecode program = compile("fn main() { return 1 + 2 * 3; }");
+
+    REQUIRE(program.disassemble()
+            == "main:\n"
+               "0000 O_CONST 1\n"
+               "0005 O_CONST 2\n"
+               "0010 O_CONST 3\n"
+               "0015 O_MUL\n"
+               "0016 O_ADD\n"
+               "0017 O_RETURN\n"
+               "0018 O_CONST 0\n"
+               "0023 O_RETURN\n"
+               "0024 O_CALL main 0\n"
+               "0030 O_HALT\n");
+  }
+
+  SECTION("Compound assignment loads, operates and stores")
+  {
+    Bytecode program = compile("fn f(a: int) { a -= 2; }");
+
+    REQUIRE(program.disassemble().find("O_LOAD_LOCAL 0\n"
+                                       "0003 O_CONST 2\n"
+                                       "0008 O_SUB\n"
+                                       "0009 O_STORE_LOCAL 0\n"
+                                       "0012 O_POP\n")
+            != std::string::npos);
+  }
+
+  SECTION("Short-circuit operators jump over the right operand")
+  {
+    Bytecode program = compile("fn f(a: int, b: int) { return a && b; }");
+
+    REQUIRE(program.disassemble().find("0003 O_AND 0012\n"
+                                       "0008 O_LOAD_LOCAL 1\n"
+                                       "0011 O_BOOL\n"
+                                       "0012 O_RETURN\n")
+            != std::string::npos);
+  }
+}
+
+TEST_CASE("Compilation of functions", "[compiler]")
+{
+  SECTION("Locals reuse the slots of closed scopes")
+  {
+    Bytecode program = compile("fn f(a: int, b: int) { let c = a; { let d = b; } let e; }");
+
+    REQUIRE(program.functions.size() == 1);
+    REQUIRE(program.functions[0].params == 2);
+    REQUIRE(program.functions[0].slots == 4);
+  }
+
+  SECTION("Stack depth is tracked per function")
+  {
+    Bytecode program = compile("fn f(a: int) { return a + (a + (a + a)); }");
+
+    REQUIRE(program.functions[0].max_stack == 4);
+  }
+
+  SECTION("Globals are initialized before main runs")
+  {
+    Bytecode program = compile("let g = 5; fn main() { return g; }");
+
+    REQUIRE(program.globals == 1);
+    REQUIRE(program.disassemble().find("O_STORE_GLOBAL 0") != std::string::npos);
+  }
+}
+
+TEST_CASE("Compilation errors", "[compiler]")
+{
+  REQUIRE_THROWS_AS(compile("fn f() { return x; }"), Error);
+  REQUIRE_THROWS_AS(compile("fn f() { g(); }"), Error);
+  REQUIRE_THROWS_AS(compile("fn f(a: int) {} fn g() { f(); }"), Error);
+  REQUIRE_THROWS_AS(compile("fn f() {} fn f() {}"), Error);
+  REQUIRE_THROWS_AS(compile("fn f() { let a; let a; }"), Error);
+  REQUIRE_THROWS_AS(compile("let a; fn f() { a(); }"), Error);
+  REQUIRE_THROWS_AS(compile("fn main(a: int) {}"), Error);
+  REQUIRE_THROWS_AS(compile("fn f() { f()(); }"), Error);
+  REQUIRE_THROWS_AS(compile("fn f() { a.b; }"), Error);
+}
@@ -0,0 +1,48 @@
+#include "constant/constant.hpp"
+#include "error/error.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <string>
+
+TEST_CASE("Constant class tests", "[constant]")
+{
+  SECTION("Parsing of integer literals")
+  {
+    REQUIRE(Constant::parse("10000").type == ConstantType::C_INT);
+    REQUIRE(Constant::parse("10000").i == 10000);
+    REQUIRE(Constant::parse("0xaB00").i == 0xab00);
+    REQUIRE(Constant::parse("0b1000").i == 8);
+    REQUIRE(Constant::parse("-5").i == -5);
+    REQUIRE(Constant::parse("9223372036854775807").i == INT64_MAX);
+    REQUIRE(Constant::parse("0x7fffffffffffffff").i == INT64_MAX);
+    REQUIRE_THROWS_AS(Constant::parse("9223372036854775808"), Error);
+    REQUIRE_THROWS_AS(Constant::parse("18446744073709551616"), Error);
+    REQUIRE_THROWS_AS(Constant::parse("0xffffffffffffffff"), Error);
+    REQUIRE_THROWS_AS(Constant::parse("0b1" + std::string(64, '0')), Error);
+  }
+
+  SECTION("Integers in the range of the runtime")
+  {
+    REQUIRE(Constant::wrap(((std::int64_t)1 << 47) - 1) == ((std::int64_t)1 << 47) - 1);
+    REQUIRE(Constant::wrap((std::int64_t)1 << 47) == -((std::int64_t)1 << 47));
+    REQUIRE(Constant::wrap(-1) == -1);
+    REQUIRE(Constant::parse("140737488355327").in_range());
+    REQUIRE(!Constant::parse("140737488355328").in_range());
+    REQUIRE(Constant::parse("1e300").in_range());
+  }
+
+  SECTION("Parsing of floating-point literals")
+  {
+    REQUIRE(Constant::parse("1.5").type == ConstantType::C_FLOAT);
+    REQUIRE(Constant::parse("1.5").f == 1.5);
+  }
+
+  SECTION("Formatting round-trips")
+  {
+    REQUIRE(Constant((std::int64_t)-42).str() == "-42");
+    REQUIRE(Constant(2.0).str() == "2.0");
+    REQUIRE(Constant(0.1).str() == "0.1");
+    REQUIRE(Constant::parse(Constant(1e300).str()).type == ConstantType::C_FLOAT);
+    REQUIRE(Constant::parse(Constant(1.0 / 3.0).str()).f == 1.0 / 3.0);
+  }
+}
@@ -4,22 +4,19 @@
 
 TEST_CASE("Error class tests", "[error]")
 {
-  SECTION("Error without filename and position in file")
+  SECTION("Error without location")
   {
     Error e("Hello world!");
 
-    REQUIRE(e.filename == nullptr);
-    REQUIRE(e.row == 0);
-    REQUIRE(e.col == 0);
+    REQUIRE(e.loc == SourceManager::NONE);
   }
 
-  SECTION("Error with filename and position in file")
+  SECTION("Error with location")
   {
-    Error e("main.tela", 1, 1, "Hello world!");
+    Error e(5, "Hello world!");
 
-    REQUIRE_FALSE(strcmp(e.filename, "main.tela"));
-    REQUIRE(e.row == 1);
-    REQUIRE(e.col == 1);
+    REQUIRE(e.loc == 5);
+    REQUIRE_FALSE(strcmp(e.what(), "Hello world!"));
   }
 
   SECTION("Error with no arguments in format")
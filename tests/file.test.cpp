@@ -0,0 +1,107 @@
+#include "file/file.hpp"
+#include "error/error.hpp"
+#include "lexer/lexer.hpp"
+#include "source/source.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+static std::string write_file(const char *name, const std::string &contents)
+{
+  std::string path = std::string("tela-") + name;
+
+  std::ofstream file(path, std::ios::binary);
+  file << contents;
+
+  return path;
+}
+
+TEST_CASE("Reading of files", "[file]")
+{
+  SECTION("Small files are read into memory")
+  {
+    std::string path = write_file("small.tl", "let x = 1;");
+    File file(path);
+
+    REQUIRE(!file.is_mapped());
+    REQUIRE(file.size() == 10);
+    REQUIRE(std::string(file.data(), file.size()) == "let x = 1;");
+    REQUIRE(file.data()[file.size()] == '\0');
+
+    std::remove(path.c_str());
+  }
+
+  SECTION("Large files are terminated by a zero byte")
+  {
+    for (std::size_t size : { File::MAP_THRESHOLD, File::MAP_THRESHOLD + 123 }) {
+      std::string path = write_file("large.tl", std::string(size, 'x'));
+      File file(path);
+
+      REQUIRE(file.size() == size);
+      REQUIRE(file.data()[0] == 'x');
+      REQUIRE(file.data()[size - 1] == 'x');
+      REQUIRE(file.data()[size] == '\0');
+
+      std::remove(path.c_str());
+    }
+  }
+
+  SECTION("Missing files")
+  {
+    try {
+      File file("tela-missing.tl");
+      FAIL("Expected an error");
+    } catch (Error &e) {
+      REQUIRE(std::string(e.what()) == "Cannot open file: tela-missing.tl");
+    }
+  }
+}
+
+TEST_CASE("Tokenization of files", "[file]")
+{
+  std::string source = "let x = 1;\n" + std::string(File::MAP_THRESHOLD, ' ') + "\nx";
+  std::string path   = write_file("lexer.tl", source);
+  SourceManager sources;
+
+  Lexer lexer(sources, sources.load(path));
+  auto tokens = lexer.tokenize();
+
+  REQUIRE(sources.file(0)->is_mapped());
+  REQUIRE(tokens.size() == 7);
+  REQUIRE(tokens[5].type == TokenType::T_ID);
+  REQUIRE(sources.resolve(tokens[5].loc).row == 3);
+  REQUIRE(sources.resolve(tokens[5].loc).col == 1);
+
+  std::remove(path.c_str());
+}
+
+// Writes a sparse file of more than 4 GiB, so it is hidden from the default run.
+TEST_CASE("Tokenization of files larger than 4 GiB", "[file][.]")
+{
+  const std::uint64_t size = (std::uint64_t)9 << 29;
+  std::string path         = "tela-huge.tl";
+
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << "//";
+    file.seekp((std::streamoff)size);
+    file << "\n\n  x";
+  }
+
+  File file(path);
+  REQUIRE(file.is_mapped());
+  REQUIRE(file.size() == size + 5);
+
+  SourceManager sources;
+  Lexer lexer(sources, sources.load(path));
+  Token x = lexer.next();
+
+  REQUIRE(x.value == "x");
+  REQUIRE(sources.resolve(x.loc).row == 3);
+  REQUIRE(sources.resolve(x.loc).col == 3);
+  REQUIRE(lexer.next().type == TokenType::T_EOF);
+
+  std::remove(path.c_str());
+}
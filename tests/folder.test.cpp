@@ -0,0 +1,131 @@
+#include "folder/folder.hpp"
+#include "error/error.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+static Ast fold_ast(const char *input)
+{
+  SourceManager sources;
+  Lexer lexer(sources, sources.add("test.tl", input));
+  Parser parser(lexer.tokenize());
+  Ast ast = parser.parse();
+
+  Folder folder(ast);
+  folder.fold();
+
+  return ast;
+}
+
+static std::string fold(const char *input) { return fold_ast(input).dump(); }
+
+static std::string fold_expr(const char *input)
+{
+  std::string source = std::string("fn f() { ") + input + "; }";
+  Ast ast            = fold_ast(source.c_str());
+
+  std::uint32_t fn    = ast.list_items(ast.lhs(0))[0];
+  std::uint32_t block = ast.rhs(fn);
+
+  return ast.dump(ast.list_items(ast.lhs(block))[0]);
+}
+
+TEST_CASE("Folding of integer constants", "[folder]")
+{
+  REQUIRE(fold_expr("1 + 2 * 3") == "7");
+  REQUIRE(fold_expr("(1 + 2) * 3 - 4") == "5");
+  REQUIRE(fold_expr("7 / 2") == "3");
+  REQUIRE(fold_expr("-7 % 3") == "-1");
+  REQUIRE(fold_expr("0xff & 0b1010 | 1 ^ 3") == "10");
+  REQUIRE(fold_expr("~0") == "-1");
+  REQUIRE(fold_expr("!5") == "0");
+  REQUIRE(fold_expr("2 < 3") == "1");
+  REQUIRE(fold_expr("2 == 3") == "0");
+  REQUIRE(fold_expr("x + (2 * 3)") == "(+ x 6)");
+}
+
+TEST_CASE("Folding of floating-point constants", "[folder]")
+{
+  REQUIRE(fold_expr("1.5 * 2") == "3.0");
+  REQUIRE(fold_expr("1 / 4.0") == "0.25");
+  REQUIRE(fold_expr("-0.5 + 1") == "0.5");
+  REQUIRE(fold_expr("1.5 >= 1.5") == "1");
+  REQUIRE(fold_expr("1.5 % 2") == "(% 1.5 2)");
+}
+
+TEST_CASE("Folding of logical and conditional operators", "[folder]")
+{
+  REQUIRE(fold_expr("1 && 2") == "1");
+  REQUIRE(fold_expr("0 || 0") == "0");
+  REQUIRE(fold_expr("0 && f()") == "0");
+  REQUIRE(fold_expr("1 || f()") == "1");
+  REQUIRE(fold_expr("1 && f()") == "(&& 1 (call f))");
+  REQUIRE(fold_expr("1 + 1 ? a : b") == "a");
+  REQUIRE(fold_expr("0 ? a : b") == "b");
+}
+
+TEST_CASE("Integer overflow wraps around", "[folder]")
+{
+  REQUIRE(fold_expr("0x7fffffffffff + 1") == "-140737488355328");
+  REQUIRE(fold_expr("(-0x7fffffffffff - 1) / -1") == "-140737488355328");
+  REQUIRE(fold_expr("140737488355327 + 1 > 0") == "0");
+  REQUIRE(fold_expr("140737488355327 * 1024 / 1024") == "-1");
+  REQUIRE(fold_expr("-(-0x7fffffffffff - 1)") == "-140737488355328");
+  REQUIRE(fold_expr("~0x7fffffffffff") == "-140737488355328");
+  REQUIRE(fold_expr("140737488355328 - 1") == "(- 140737488355328 1)");
+  REQUIRE_THROWS_AS(fold_expr("18446744073709551616 - 1"), Error);
+}
+
+TEST_CASE("Algebraic simplifications", "[folder]")
+{
+  REQUIRE(fold_expr("(a < b) * 1") == "(< a b)");
+  REQUIRE(fold_expr("1 * (a & b)") == "(& a b)");
+  REQUIRE(fold_expr("(a == b) + 0") == "(== a b)");
+  REQUIRE(fold_expr("0 + !x") == "(! x)");
+  REQUIRE(fold_expr("~x - 0") == "(~ x)");
+  REQUIRE(fold_expr("(a | b) / 1") == "(| a b)");
+  REQUIRE(fold_expr("- -(a ^ b)") == "(^ a b)");
+  REQUIRE(fold_expr("~~(a && b)") == "(&& a b)");
+  REQUIRE(fold_expr("+(a > 1)") == "(> a 1)");
+  REQUIRE(fold_expr("((a < b) + 0) * (2 - 1) + (c & d) * 1") == "(+ (< a b) (& c d))");
+  REQUIRE(fold_expr("f(!x * 1, 2 + 2)") == "(call f (! x) 4)");
+  REQUIRE(fold_expr("(a < b) * 1.0") == "(* (< a b) 1.0)");
+  REQUIRE(fold_expr("!!x") == "(! (! x))");
+}
+
+TEST_CASE("Simplifications keep the types of operands", "[folder]")
+{
+  REQUIRE(fold_expr("x * 1") == "(* x 1)");
+  REQUIRE(fold_expr("0 + x") == "(+ 0 x)");
+  REQUIRE(fold_expr("'a' + 0") == "(+ 'a' 0)");
+  REQUIRE(fold_expr("'a' * 1") == "(* 'a' 1)");
+  REQUIRE(fold_expr("- -'a'") == "(- (- 'a'))");
+  REQUIRE(fold_expr("+'a'") == "(+ 'a')");
+  REQUIRE(fold_expr("2.5 | 0") == "(| 2.5 0)");
+  REQUIRE(fold_expr("2.5 ^ 0") == "(^ 2.5 0)");
+  REQUIRE(fold_expr("(a * 2.5) - 0") == "(- (* a 2.5) 0)");
+  REQUIRE(fold_expr("~~2.5") == "(~ (~ 2.5))");
+  REQUIRE(fold_expr("\"s\" + 0") == "(+ \"s\" 0)");
+  REQUIRE(fold_expr("\"s\" / 1") == "(/ \"s\" 1)");
+  REQUIRE(fold_expr("(a + 'b') * 1") == "(* (+ a 'b') 1)");
+  REQUIRE(fold_expr("((a < b) + 'b') * 1") == "(* (+ (< a b) 'b') 1)");
+}
+
+TEST_CASE("Folding of statements", "[folder]")
+{
+  REQUIRE(fold("let a = 2 * 21;") == "(program (let a 42))");
+  REQUIRE(fold("fn f() { if (1 - 1) a(); else b(); }") == "(program (fn f () (block (call b))))");
+  REQUIRE(fold("fn f() { if (0) a(); }") == "(program (fn f () (block (block))))");
+  REQUIRE(fold("fn f() { while (0) a(); }") == "(program (fn f () (block (block))))");
+  REQUIRE(fold("fn f() { while (x > 1 - 1) x = (x < 2) - 0; }")
+          == "(program (fn f () (block (while (> x 0) (= x (< x 2))))))");
+}
+
+TEST_CASE("Division by zero", "[folder]")
+{
+  REQUIRE_THROWS_AS(fold_expr("1 / 0"), Error);
+  REQUIRE_THROWS_AS(fold_expr("x % (2 - 2)"), Error);
+  REQUIRE_THROWS_AS(fold_expr("x /= 0"), Error);
+  REQUIRE_THROWS_AS(fold_expr("1.0 / 0.0"), Error);
+}
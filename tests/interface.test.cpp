@@ -0,0 +1,78 @@
+#include "interface/interface.hpp"
+#include "compiler/compiler.hpp"
+#include "error/error.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+static Bytecode compile_module(const char *input, const Compiler::Exports &exports)
+{
+  SourceManager sources;
+  Lexer lexer(sources, sources.add("test.tl", input));
+  Parser parser(lexer.tokenize());
+  Ast ast = parser.parse();
+
+  Compiler compiler(ast);
+  return compiler.compile_module(exports);
+}
+
+TEST_CASE("Interface files", "[interface]")
+{
+  std::string path = "tela-interface.tli";
+
+  SECTION("Round trip")
+  {
+    Compiler::Exports exports;
+    exports["util"] = { { "twice", 0, 1, 1, 2, false } };
+
+    Bytecode program
+        = compile_module("import util; let s = \"hi\"; fn f(a: int, ...) { return twice(a); }",
+                         exports);
+    Interface::write(path, program, { 10, 20 }, { { "util", 42 } });
+
+    Interface interface(path);
+    REQUIRE(interface.source() == Interface::Stamp{ 10, 20 });
+    REQUIRE(interface.dependency_count() == 1);
+    REQUIRE(interface.dependency(0).name == "util");
+    REQUIRE(interface.dependency(0).hash == 42);
+
+    std::vector<Bytecode::Function> functions = interface.exports();
+    REQUIRE(functions.size() == 1);
+    REQUIRE(functions[0].name == "f");
+    REQUIRE(functions[0].params == 1);
+    REQUIRE(functions[0].variadic);
+    REQUIRE(interface.hash() == Interface::hash(functions));
+
+    Bytecode loaded = interface.program();
+    REQUIRE(loaded.disassemble() == program.disassemble());
+    REQUIRE(loaded.functions[0].entry == Bytecode::EXTERN);
+    REQUIRE(loaded.globals == 1);
+    REQUIRE(loaded.entry == program.entry);
+  }
+
+  SECTION("The hash only covers signatures")
+  {
+    Compiler::Exports none;
+    Interface::write(path, compile_module("fn f(a: int) { return a; }", none), { 0, 0 }, {});
+    std::uint64_t hash = Interface(path).hash();
+
+    Interface::write(path, compile_module("fn f(b: int) { return b * 2; }", none), { 0, 0 }, {});
+    REQUIRE(Interface(path).hash() == hash);
+
+    Interface::write(path, compile_module("fn f(a: int, b: int) {}", none), { 0, 0 }, {});
+    REQUIRE(Interface(path).hash() != hash);
+  }
+
+  SECTION("Malformed files")
+  {
+    REQUIRE_THROWS_AS(Interface("tela-missing.tli"), Error);
+
+    std::ofstream(path, std::ios::binary) << "TELI but not really an interface";
+    REQUIRE_THROWS_AS(Interface(path), Error);
+  }
+
+  std::remove(path.c_str());
+}
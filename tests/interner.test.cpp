@@ -0,0 +1,50 @@
+#include "interner/interner.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+TEST_CASE("Interner class tests", "[interner]")
+{
+  Interner interner;
+
+  SECTION("Equal strings share an id")
+  {
+    std::uint32_t a = interner.intern("hello");
+    std::uint32_t b = interner.intern("world");
+
+    REQUIRE(a != b);
+    REQUIRE(interner.intern(std::string("hel") + "lo") == a);
+    REQUIRE(interner.get(a) == "hello");
+    REQUIRE(interner.get(b) == "world");
+    REQUIRE(interner.size() == 2);
+  }
+
+  SECTION("Empty strings and embedded NULs")
+  {
+    std::uint32_t empty = interner.intern("");
+    std::uint32_t nul   = interner.intern(std::string_view("a\0b", 3));
+
+    REQUIRE(interner.get(empty).empty());
+    REQUIRE(interner.get(nul).size() == 3);
+    REQUIRE(interner.intern("a") != nul);
+  }
+
+  SECTION("Lookup without interning")
+  {
+    interner.intern("x");
+
+    REQUIRE(interner.find("x") == 0);
+    REQUIRE(interner.find("y") == Interner::NONE);
+    REQUIRE(interner.size() == 1);
+  }
+
+  SECTION("Ids stay stable while the table grows")
+  {
+    for (int i = 0; i < 10000; i++)
+      REQUIRE(interner.intern(std::to_string(i)) == (std::uint32_t)i);
+
+    for (int i = 0; i < 10000; i++) {
+      REQUIRE(interner.find(std::to_string(i)) == (std::uint32_t)i);
+      REQUIRE(interner.get((std::uint32_t)i) == std::to_string(i));
+    }
+  }
+}
@@ -0,0 +1,101 @@
+#include "ir/ir.hpp"
+#include "irgen/irgen.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+static Ir generate(const char *input)
+{
+  SourceManager sources;
+  Lexer lexer(sources, sources.add("test.tl", input));
+  Parser parser(lexer.tokenize());
+  Ast ast = parser.parse();
+
+  IrGen irgen(ast);
+  return irgen.generate();
+}
+
+static std::vector<std::uint32_t> bits(const Bitset &set)
+{
+  std::vector<std::uint32_t> bits;
+  set.each([&](std::uint32_t bit) { bits.push_back(bit); });
+  return bits;
+}
+
+static const char *const LOOP
+    = "fn f(a: int): int { let s = 0; while (a) { s += a; a--; } return s; }";
+
+TEST_CASE("Control flow queries", "[ir]")
+{
+  Ir ir = generate(LOOP);
+  std::uint32_t succs[2];
+
+  REQUIRE(ir.functions[0].first == 0);
+  REQUIRE(ir.functions[0].end == 5);
+  REQUIRE(ir.block_of(0) == 0);
+  REQUIRE(ir.block_of(3) == 1);
+  REQUIRE(ir.block_of(8) == 2);
+  REQUIRE(ir.block_of(9) == 3);
+
+  REQUIRE(ir.successors(0, succs) == 1);
+  REQUIRE(succs[0] == 1);
+  REQUIRE(ir.successors(1, succs) == 2);
+  REQUIRE(succs[0] == 2);
+  REQUIRE(succs[1] == 3);
+  REQUIRE(ir.successors(3, succs) == 0);
+}
+
+TEST_CASE("Liveness analysis", "[ir]")
+{
+  Ir ir = generate(LOOP);
+  std::vector<Bitset> live_in, live_out;
+
+  ir.liveness(0, live_in, live_out);
+
+  REQUIRE(live_in.size() == 5);
+  REQUIRE(bits(live_in[0]).empty());
+  REQUIRE(bits(live_out[0]) == std::vector<std::uint32_t>{ 0, 1 });
+  REQUIRE(bits(live_in[1]).empty());
+  REQUIRE(bits(live_out[1]) == std::vector<std::uint32_t>{ 3, 4 });
+  REQUIRE(bits(live_in[2]) == std::vector<std::uint32_t>{ 3, 4 });
+  REQUIRE(bits(live_out[2]) == std::vector<std::uint32_t>{ 6, 7 });
+  REQUIRE(bits(live_in[3]) == std::vector<std::uint32_t>{ 4 });
+  REQUIRE(bits(live_out[3]).empty());
+}
+
+TEST_CASE("Compaction of the instruction arena", "[ir]")
+{
+  Ir ir = generate(LOOP);
+
+  // Drop the constant the accumulator starts from and the unreachable block after the return.
+  std::uint32_t operands[] = { 0, 6 };
+  ir.instrs[1].op          = IrOp::I_NOP;
+  ir.instrs[4].b           = ir.add_list(operands, 2);
+  ir.blocks[4].preds       = Ir::NONE;
+
+  ir.compact();
+
+  REQUIRE(ir.functions[0].end == 4);
+  REQUIRE(ir.functions[1].first == 4);
+  REQUIRE(ir.dump()
+          == "fn f(1)\n"
+             "b0:\n"
+             "  %0 = param 0\n"
+             "  jump b1\n"
+             "b1: ; preds = b0, b2\n"
+             "  %2 = phi %0, %6\n"
+             "  %3 = phi %0, %5\n"
+             "  branch %2, b2, b3\n"
+             "b2: ; preds = b1\n"
+             "  %5 = add %3, %2\n"
+             "  %6 = decr %2\n"
+             "  jump b1\n"
+             "b3: ; preds = b1\n"
+             "  return %3\n"
+             "fn <entry>(0)\n"
+             "b4:\n"
+             "  %9 = const 0\n"
+             "  return %9\n");
+}
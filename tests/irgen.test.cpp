@@ -0,0 +1,113 @@
+#include "irgen/irgen.hpp"
+#include "error/error.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+static std::string generate(const std::string &input)
+{
+  SourceManager sources;
+  Lexer lexer(sources, sources.add("test.tl", input));
+  Parser parser(lexer.tokenize());
+  Ast ast = parser.parse();
+
+  IrGen irgen(ast);
+  return irgen.generate().dump();
+}
+
+TEST_CASE("Generation of SSA form", "[irgen]")
+{
+  SECTION("Straight-line code")
+  {
+    REQUIRE(generate("fn f(a: int, b: int): int { let x = a * b; return x + 1; }")
+            == "fn f(2)\n"
+               "b0:\n"
+               "  %0 = param 0\n"
+               "  %1 = param 1\n"
+               "  %2 = mul %0, %1\n"
+               "  %3 = const 1\n"
+               "  %4 = add %2, %3\n"
+               "  return %4\n"
+               "b1:\n"
+               "  %6 = const 0\n"
+               "  return %6\n"
+               "fn <entry>(0)\n"
+               "b2:\n"
+               "  %8 = const 0\n"
+               "  return %8\n");
+  }
+
+  SECTION("Phis at join points")
+  {
+    REQUIRE(generate("fn main() { let x = 1; if (x) x = 2; return x; }")
+            == "fn main(0)\n"
+               "b0:\n"
+               "  %0 = const 1\n"
+               "  branch %0, b1, b2\n"
+               "b1: ; preds = b0\n"
+               "  %2 = const 2\n"
+               "  jump b2\n"
+               "b2: ; preds = b0, b1\n"
+               "  %4 = phi %0, %2\n"
+               "  return %4\n"
+               "b3:\n"
+               "  %6 = const 0\n"
+               "  return %6\n"
+               "fn <entry>(0)\n"
+               "b4:\n"
+               "  %8 = call main()\n"
+               "  return %8\n");
+  }
+
+  SECTION("Phis in loop headers")
+  {
+    std::string ir = generate("fn main() { let i = 0; let n = 5; while (i < n) i++; return i; }");
+
+    REQUIRE(ir.find("b1: ; preds = b0, b2\n  %3 = phi %0, %7\n") != std::string::npos);
+    REQUIRE(ir.find("  %4 = copy %1\n  %5 = lt %3, %4\n") != std::string::npos);
+    REQUIRE(ir.find("  %7 = incr %3\n") != std::string::npos);
+    REQUIRE(ir.find("return %3\n") != std::string::npos);
+  }
+
+  SECTION("Short-circuit operators")
+  {
+    std::string ir = generate("fn f(a: int, b: int): int { return a && b; }");
+
+    REQUIRE(ir.find("  %2 = bool %0\n  branch %2, b1, b2\n") != std::string::npos);
+    REQUIRE(ir.find("b2: ; preds = b0, b1\n  %6 = phi %2, %4\n") != std::string::npos);
+  }
+
+  SECTION("Globals, strings and calls")
+  {
+    std::string ir = generate("let g = 1; fn main() { g += 2; print(\"g\", g); }");
+
+    REQUIRE(ir.find("load_global g\n") != std::string::npos);
+    REQUIRE(ir.find("store_global g, %2\n") != std::string::npos);
+    REQUIRE(ir.find("string \"g\"\n") != std::string::npos);
+    REQUIRE(ir.find("print(%4, %5)\n") != std::string::npos);
+    REQUIRE(ir.find("fn <entry>(0)\nb1:\n  %9 = const 1\n  store_global g, %9\n")
+            != std::string::npos);
+  }
+
+  SECTION("Long chains of blocks")
+  {
+    std::string input = "fn f(a: int): int { let x = a;";
+    for (int i = 0; i < 50000; i++)
+      input += " if (a) a++;";
+    input += " return x; }";
+
+    std::string ir = generate(input);
+    REQUIRE(ir.find("  return %0\n") != std::string::npos);
+  }
+}
+
+TEST_CASE("Errors in SSA generation", "[irgen]")
+{
+  REQUIRE_THROWS_AS(generate("fn main() { return x; }"), Error);
+  REQUIRE_THROWS_AS(generate("fn main() { let x = 1; let x = 2; }"), Error);
+  REQUIRE_THROWS_AS(generate("fn f(a: int) {} fn main() { f(); }"), Error);
+  REQUIRE_THROWS_AS(generate("fn main() { nope(); }"), Error);
+  REQUIRE_THROWS_AS(generate("fn main() { 1 = 2; }"), Error);
+  REQUIRE_THROWS_AS(generate("fn main() { return 140737488355328; }"), Error);
+}
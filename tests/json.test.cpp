@@ -0,0 +1,47 @@
+#include "json/json.hpp"
+#include "error/error.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+TEST_CASE("JSON values", "[json]")
+{
+  SECTION("Parsing")
+  {
+    Json value = Json::parse(" {\"id\": 1, \"params\": {\"list\": [true, false, null, -2.5e1],"
+                             " \"text\": \"a\\\"\\n\\u00f1\\ud83d\\ude00\"}} ");
+
+    REQUIRE(value["id"].as_number() == 1);
+    REQUIRE(value["params"]["list"].size() == 4);
+    REQUIRE(value["params"]["list"][0].as_bool());
+    REQUIRE(value["params"]["list"][2].is_null());
+    REQUIRE(value["params"]["list"][3].as_number() == -25);
+    REQUIRE(value["params"]["text"].as_string() == "a\"\n\xc3\xb1\xf0\x9f\x98\x80");
+    REQUIRE(value["missing"]["deeper"].is_null());
+    REQUIRE(Json::parse("\"\\ud800\"").as_string() == "\xef\xbf\xbd");
+  }
+
+  SECTION("Dumping")
+  {
+    Json value = Json::object()
+                     .set("jsonrpc", "2.0")
+                     .set("id", 7)
+                     .set("result", Json::array().push(1.5).push(true).push(Json()))
+                     .set("data", Json::raw("[1,2]"))
+                     .set("text", "tab\there \"quoted\" \x01");
+
+    REQUIRE(value.dump()
+            == "{\"jsonrpc\":\"2.0\",\"id\":7,\"result\":[1.5,true,null],\"data\":[1,2],"
+               "\"text\":\"tab\\there \\\"quoted\\\" \\u0001\"}");
+    REQUIRE(Json::parse(value.dump())["text"].as_string() == "tab\there \"quoted\" \x01");
+  }
+
+  SECTION("Errors")
+  {
+    for (const char *text : { "", "{", "[1,]", "{\"a\" 1}", "01", "1.", "\"\n\"", "tru",
+                              "\"\\x\"", "1 2", "\"\xff\"" })
+      REQUIRE_THROWS_AS(Json::parse(text), Error);
+
+    REQUIRE_THROWS_AS(Json::parse(std::string(1000, '[')), Error);
+    REQUIRE_THROWS_AS(Json::parse("1").as_string(), Error);
+  }
+}
@@ -1,138 +1,153 @@
 #include "lexer/lexer.hpp"
 #include "error/error.hpp"
+#include "source/source.hpp"
 #include <catch2/catch_test_macros.hpp>
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
 
+static SourceManager sources;
+
+static std::uint32_t source(const std::string &input)
+{
+  return sources.add("test.tl", input);
+}
+
+static SourcePosition position(SourceLoc loc)
+{
+  return sources.resolve(loc);
+}
+
 TEST_CASE("Tokenization of number", "[lexer]")
 {
   SECTION("Decimal integer")
   {
-    Lexer lexer("test.tl", "10000");
+    Lexer lexer(sources, source("10000"));
     auto tokens = lexer.tokenize();
 
     REQUIRE(tokens.size() == 2);
     REQUIRE(tokens[0].type == TokenType::T_NUMBER);
     REQUIRE(tokens[0].value == "10000");
-    REQUIRE(tokens[0].row == 1);
-    REQUIRE(tokens[0].col == 1);
+    REQUIRE(position(tokens[0].loc).row == 1);
+    REQUIRE(position(tokens[0].loc).col == 1);
 
     REQUIRE(tokens[1].type == TokenType::T_EOF);
-    REQUIRE(tokens[1].row == 1);
-    REQUIRE(tokens[1].col == 6);
+    REQUIRE(position(tokens[1].loc).row == 1);
+    REQUIRE(position(tokens[1].loc).col == 6);
   }
 
   SECTION("Integer with apostrophe")
   {
-    Lexer lexer("test.tl", "10'000");
+    Lexer lexer(sources, source("10'000"));
     auto tokens = lexer.tokenize();
 
     REQUIRE(tokens.size() == 2);
     REQUIRE(tokens[0].type == TokenType::T_NUMBER);
     REQUIRE(tokens[0].value == "10000");
-    REQUIRE(tokens[0].row == 1);
-    REQUIRE(tokens[0].col == 1);
+    REQUIRE(position(tokens[0].loc).row == 1);
+    REQUIRE(position(tokens[0].loc).col == 1);
 
     REQUIRE(tokens[1].type == TokenType::T_EOF);
-    REQUIRE(tokens[1].row == 1);
-    REQUIRE(tokens[1].col == 7);
+    REQUIRE(position(tokens[1].loc).row == 1);
+    REQUIRE(position(tokens[1].loc).col == 7);
   }
 
   SECTION("Binary integer")
   {
-    Lexer lexer("test.tl", "0b1000");
+    Lexer lexer(sources, source("0b1000"));
     auto tokens = lexer.tokenize();
 
     REQUIRE(tokens.size() == 2);
     REQUIRE(tokens[0].type == TokenType::T_NUMBER);
     REQUIRE(tokens[0].value == "0b1000");
-    REQUIRE(tokens[0].row == 1);
-    REQUIRE(tokens[0].col == 1);
+    REQUIRE(position(tokens[0].loc).row == 1);
+    REQUIRE(position(tokens[0].loc).col == 1);
 
     REQUIRE(tokens[1].type == TokenType::T_EOF);
-    REQUIRE(tokens[1].row == 1);
-    REQUIRE(tokens[1].col == 7);
+    REQUIRE(position(tokens[1].loc).row == 1);
+    REQUIRE(position(tokens[1].loc).col == 7);
   }
 
   SECTION("Hexadecimal integer without higher-value digits")
   {
-    Lexer lexer("test.tl", "0x1000");
+    Lexer lexer(sources, source("0x1000"));
     auto tokens = lexer.tokenize();
 
     REQUIRE(tokens.size() == 2);
     REQUIRE(tokens[0].type == TokenType::T_NUMBER);
     REQUIRE(tokens[0].value == "0x1000");
-    REQUIRE(tokens[0].row == 1);
-    REQUIRE(tokens[0].col == 1);
+    REQUIRE(position(tokens[0].loc).row == 1);
+    REQUIRE(position(tokens[0].loc).col == 1);
 
     REQUIRE(tokens[1].type == TokenType::T_EOF);
-    REQUIRE(tokens[1].row == 1);
-    REQUIRE(tokens[1].col == 7);
+    REQUIRE(position(tokens[1].loc).row == 1);
+    REQUIRE(position(tokens[1].loc).col == 7);
   }
 
   SECTION("Hexadecimal integer with higher-value digits")
   {
-    Lexer lexer("test.tl", "0xaB00");
+    Lexer lexer(sources, source("0xaB00"));
     auto tokens = lexer.tokenize();
 
     REQUIRE(tokens.size() == 2);
     REQUIRE(tokens[0].type == TokenType::T_NUMBER);
     REQUIRE(tokens[0].value == "0xaB00");
-    REQUIRE(tokens[0].row == 1);
-    REQUIRE(tokens[0].col == 1);
+    REQUIRE(position(tokens[0].loc).row == 1);
+    REQUIRE(position(tokens[0].loc).col == 1);
 
     REQUIRE(tokens[1].type == TokenType::T_EOF);
-    REQUIRE(tokens[1].row == 1);
-    REQUIRE(tokens[1].col == 7);
+    REQUIRE(position(tokens[1].loc).row == 1);
+    REQUIRE(position(tokens[1].loc).col == 7);
   }
 
   SECTION("Floating-point number")
   {
-    Lexer lexer("test.tl", "1.0");
+    Lexer lexer(sources, source("1.0"));
     auto tokens = lexer.tokenize();
 
     REQUIRE(tokens.size() == 2);
     REQUIRE(tokens[0].type == TokenType::T_NUMBER);
     REQUIRE(tokens[0].value == "1.0");
-    REQUIRE(tokens[0].row == 1);
-    REQUIRE(tokens[0].col == 1);
+    REQUIRE(position(tokens[0].loc).row == 1);
+    REQUIRE(position(tokens[0].loc).col == 1);
 
     REQUIRE(tokens[1].type == TokenType::T_EOF);
-    REQUIRE(tokens[1].row == 1);
-    REQUIRE(tokens[1].col == 4);
+    REQUIRE(position(tokens[1].loc).row == 1);
+    REQUIRE(position(tokens[1].loc).col == 4);
   }
 
   SECTION("Integer with illegal character")
   {
-    Lexer lexer("test.tl", "0g000");
+    Lexer lexer(sources, source("0g000"));
 
     REQUIRE_THROWS_AS(lexer.tokenize(), Error);
   }
 
   SECTION("Binary integer with illegal character")
   {
-    Lexer lexer("test.tl", "0b2000");
+    Lexer lexer(sources, source("0b2000"));
 
     REQUIRE_THROWS_AS(lexer.tokenize(), Error);
   }
 
   SECTION("Hexadecimal integer with illegal character")
   {
-    Lexer lexer("test.tl", "0xg000");
+    Lexer lexer(sources, source("0xg000"));
 
     REQUIRE_THROWS_AS(lexer.tokenize(), Error);
   }
 
   SECTION("Float with illegal character")
   {
-    Lexer lexer("test.tl", "1.0.1");
+    Lexer lexer(sources, source("1.0.1"));
 
     REQUIRE_THROWS_AS(lexer.tokenize(), Error);
   }
 
   SECTION("Non-decimal float")
   {
-    Lexer lexer("test.tl", "0x0.1");
+    Lexer lexer(sources, source("0x0.1"));
 
     REQUIRE_THROWS_AS(lexer.tokenize(), Error);
   }
@@ -142,39 +157,39 @@ TEST_CASE("Tokenization of characters", "[lexer]")
 {
   SECTION("Normal character")
   {
-    Lexer lexer("test.tl", "\'a\'");
+    Lexer lexer(sources, source("\'a\'"));
     auto tokens = lexer.tokenize();
 
     REQUIRE(tokens.size() == 2);
     REQUIRE(tokens[0].type == TokenType::T_CHAR);
     REQUIRE(tokens[0].value == "a");
-    REQUIRE(tokens[0].row == 1);
-    REQUIRE(tokens[0].col == 1);
+    REQUIRE(position(tokens[0].loc).row == 1);
+    REQUIRE(position(tokens[0].loc).col == 1);
 
     REQUIRE(tokens[1].type == TokenType::T_EOF);
-    REQUIRE(tokens[1].row == 1);
-    REQUIRE(tokens[1].col == 4);
+    REQUIRE(position(tokens[1].loc).row == 1);
+    REQUIRE(position(tokens[1].loc).col == 4);
   }
 
   SECTION("Escaped character")
   {
-    Lexer lexer("test.tl", "\'\\a\'");
+    Lexer lexer(sources, source("\'\\a\'"));
     auto tokens = lexer.tokenize();
 
     REQUIRE(tokens.size() == 2);
     REQUIRE(tokens[0].type == TokenType::T_CHAR);
     REQUIRE(tokens[0].value == "\a");
-    REQUIRE(tokens[0].row == 1);
-    REQUIRE(tokens[0].col == 1);
+    REQUIRE(position(tokens[0].loc).row == 1);
+    REQUIRE(position(tokens[0].loc).col == 1);
 
     REQUIRE(tokens[1].type == TokenType::T_EOF);
-    REQUIRE(tokens[1].row == 1);
-    REQUIRE(tokens[1].col == 5);
+    REQUIRE(position(tokens[1].loc).row == 1);
+    REQUIRE(position(tokens[1].loc).col == 5);
   }
 
   SECTION("Unclosed character")
   {
-    Lexer lexer("test.tl", "\'a");
+    Lexer lexer(sources, source("\'a"));
 
     REQUIRE_THROWS_AS(lexer.tokenize(), Error);
   }
@@ -184,39 +199,54 @@ TEST_CASE("Tokenization of strings", "[lexer]")
 {
   SECTION("Normal string")
   {
-    Lexer lexer("test.tl", "\"Hello\"");
+    Lexer lexer(sources, source("\"Hello\""));
     auto tokens = lexer.tokenize();
 
     REQUIRE(tokens.size() == 2);
     REQUIRE(tokens[0].type == TokenType::T_STRING);
     REQUIRE(tokens[0].value == "Hello");
-    REQUIRE(tokens[0].row == 1);
-    REQUIRE(tokens[0].col == 1);
+    REQUIRE(position(tokens[0].loc).row == 1);
+    REQUIRE(position(tokens[0].loc).col == 1);
 
     REQUIRE(tokens[1].type == TokenType::T_EOF);
-    REQUIRE(tokens[1].row == 1);
-    REQUIRE(tokens[1].col == 8);
+    REQUIRE(position(tokens[1].loc).row == 1);
+    REQUIRE(position(tokens[1].loc).col == 8);
   }
 
   SECTION("String with escaped character")
   {
-    Lexer lexer("test.tl", "\"Hello\\n\"");
+    Lexer lexer(sources, source("\"Hello\\n\""));
     auto tokens = lexer.tokenize();
 
     REQUIRE(tokens.size() == 2);
     REQUIRE(tokens[0].type == TokenType::T_STRING);
     REQUIRE(tokens[0].value == "Hello\n");
-    REQUIRE(tokens[0].row == 1);
-    REQUIRE(tokens[0].col == 1);
+    REQUIRE(position(tokens[0].loc).row == 1);
+    REQUIRE(position(tokens[0].loc).col == 1);
 
     REQUIRE(tokens[1].type == TokenType::T_EOF);
-    REQUIRE(tokens[1].row == 1);
-    REQUIRE(tokens[1].col == 10);
+    REQUIRE(position(tokens[1].loc).row == 1);
+    REQUIRE(position(tokens[1].loc).col == 10);
+  }
+
+  SECTION("String over two lines")
+  {
+    Lexer lexer(sources, source("\"one\ntwo\" x"));
+    auto tokens = lexer.tokenize();
+
+    REQUIRE(tokens.size() == 3);
+    REQUIRE(tokens[0].value == "one\ntwo");
+    REQUIRE(position(tokens[0].loc).row == 1);
+    REQUIRE(position(tokens[0].loc).col == 1);
+
+    REQUIRE(tokens[1].type == TokenType::T_ID);
+    REQUIRE(position(tokens[1].loc).row == 2);
+    REQUIRE(position(tokens[1].loc).col == 6);
   }
 
   SECTION("Unclosed string")
   {
-    Lexer lexer("test.tl", "\'a");
+    Lexer lexer(sources, source("\'a"));
 
     REQUIRE_THROWS_AS(lexer.tokenize(), Error);
   }
@@ -226,55 +256,55 @@ TEST_CASE("Tokenization of identifiers", "[lexer]")
 {
   SECTION("Identifier with letters")
   {
-    Lexer lexer("test.tl", "abc");
+    Lexer lexer(sources, source("abc"));
     auto tokens = lexer.tokenize();
 
     REQUIRE(tokens.size() == 2);
     REQUIRE(tokens[0].type == TokenType::T_ID);
     REQUIRE(tokens[0].value == "abc");
-    REQUIRE(tokens[0].row == 1);
-    REQUIRE(tokens[0].col == 1);
+    REQUIRE(position(tokens[0].loc).row == 1);
+    REQUIRE(position(tokens[0].loc).col == 1);
 
     REQUIRE(tokens[1].type == TokenType::T_EOF);
-    REQUIRE(tokens[1].row == 1);
-    REQUIRE(tokens[1].col == 4);
+    REQUIRE(position(tokens[1].loc).row == 1);
+    REQUIRE(position(tokens[1].loc).col == 4);
   }
 
   SECTION("Identifier with numbers")
   {
-    Lexer lexer("test.tl", "a123");
+    Lexer lexer(sources, source("a123"));
     auto tokens = lexer.tokenize();
 
     REQUIRE(tokens.size() == 2);
     REQUIRE(tokens[0].type == TokenType::T_ID);
     REQUIRE(tokens[0].value == "a123");
-    REQUIRE(tokens[0].row == 1);
-    REQUIRE(tokens[0].col == 1);
+    REQUIRE(position(tokens[0].loc).row == 1);
+    REQUIRE(position(tokens[0].loc).col == 1);
 
     REQUIRE(tokens[1].type == TokenType::T_EOF);
-    REQUIRE(tokens[1].row == 1);
-    REQUIRE(tokens[1].col == 5);
+    REQUIRE(position(tokens[1].loc).row == 1);
+    REQUIRE(position(tokens[1].loc).col == 5);
   }
 
   SECTION("Identifier with underscore")
   {
-    Lexer lexer("test.tl", "_a");
+    Lexer lexer(sources, source("_a"));
     auto tokens = lexer.tokenize();
 
     REQUIRE(tokens.size() == 2);
     REQUIRE(tokens[0].type == TokenType::T_ID);
     REQUIRE(tokens[0].value == "_a");
-    REQUIRE(tokens[0].row == 1);
-    REQUIRE(tokens[0].col == 1);
+    REQUIRE(position(tokens[0].loc).row == 1);
+    REQUIRE(position(tokens[0].loc).col == 1);
 
     REQUIRE(tokens[1].type == TokenType::T_EOF);
-    REQUIRE(tokens[1].row == 1);
-    REQUIRE(tokens[1].col == 3);
+    REQUIRE(position(tokens[1].loc).row == 1);
+    REQUIRE(position(tokens[1].loc).col == 3);
   }
 
   SECTION("Identifier with invalid character")
   {
-    Lexer lexer("test.tl", "a$");
+    Lexer lexer(sources, source("a$"));
 
     REQUIRE_THROWS_AS(lexer.tokenize(), Error);
   }
@@ -282,647 +312,985 @@ TEST_CASE("Tokenization of identifiers", "[lexer]")
 
 TEST_CASE("Tokenization of addition operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "+");
+  Lexer lexer(sources, source("+"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_ADD);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of subtraction operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "-");
+  Lexer lexer(sources, source("-"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_SUB);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of multiplication operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "*");
+  Lexer lexer(sources, source("*"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_MUL);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of division operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "/");
+  Lexer lexer(sources, source("/"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_DIV);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of modulo operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "%");
+  Lexer lexer(sources, source("%"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_MOD);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of assignment operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "=");
+  Lexer lexer(sources, source("="));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_ASSIGN);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of addition assignment operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "+=");
+  Lexer lexer(sources, source("+="));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_ADDASSIGN);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 3);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 3);
 }
 
 TEST_CASE("Tokenization of subtraction assignment operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "-=");
+  Lexer lexer(sources, source("-="));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_SUBASSIGN);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 3);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 3);
 }
 
 TEST_CASE("Tokenization of multiplication assignment operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "*=");
+  Lexer lexer(sources, source("*="));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_MULASSIGN);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 3);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 3);
 }
 
 TEST_CASE("Tokenization of division assignment operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "/=");
+  Lexer lexer(sources, source("/="));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_DIVASSIGN);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 3);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 3);
 }
 
 TEST_CASE("Tokenization of modulo assignment operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "%=");
+  Lexer lexer(sources, source("%="));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_MODASSIGN);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 3);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 3);
 }
 
 TEST_CASE("Tokenization of bitwise and operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "&");
+  Lexer lexer(sources, source("&"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_BAND);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of bitwise or operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "|");
+  Lexer lexer(sources, source("|"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_BOR);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of bitwise xor operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "^");
+  Lexer lexer(sources, source("^"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_BXOR);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of bitwise not operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "~");
+  Lexer lexer(sources, source("~"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_BNOT);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of bitwise and assignment operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "&=");
+  Lexer lexer(sources, source("&="));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_ANDASSIGN);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 3);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 3);
 }
 
 TEST_CASE("Tokenization of bitwise or assignment operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "|=");
+  Lexer lexer(sources, source("|="));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_ORASSIGN);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 3);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 3);
 }
 
 TEST_CASE("Tokenization of bitwise xor assignment operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "^=");
+  Lexer lexer(sources, source("^="));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_XORASSIGN);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 3);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 3);
 }
 
 TEST_CASE("Tokenization of incrementation operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "++");
+  Lexer lexer(sources, source("++"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_INCR);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 3);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 3);
 }
 
 TEST_CASE("Tokenization of decrementation operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "--");
+  Lexer lexer(sources, source("--"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_DECR);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 3);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 3);
 }
 
 TEST_CASE("Tokenization of boolean and operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "&&");
+  Lexer lexer(sources, source("&&"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_AND);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 3);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 3);
 }
 
 TEST_CASE("Tokenization of boolean or operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "||");
+  Lexer lexer(sources, source("||"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_OR);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 3);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 3);
 }
 
 TEST_CASE("Tokenization of boolean not operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "!");
+  Lexer lexer(sources, source("!"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_NOT);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of equality operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "==");
+  Lexer lexer(sources, source("=="));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_EQ);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 3);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 3);
 }
 
 TEST_CASE("Tokenization of inequality operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "!=");
+  Lexer lexer(sources, source("!="));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_NEQ);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 3);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 3);
 }
 
 TEST_CASE("Tokenization of greater than operator", "[lexer]")
 {
-  Lexer lexer("test.tl", ">");
+  Lexer lexer(sources, source(">"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_GT);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of lesser than operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "<");
+  Lexer lexer(sources, source("<"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_LT);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of greater than equality operator", "[lexer]")
 {
-  Lexer lexer("test.tl", ">=");
+  Lexer lexer(sources, source(">="));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_GEQ);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 3);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 3);
 }
 
 TEST_CASE("Tokenization of lesser than equality operator", "[lexer]")
 {
-  Lexer lexer("test.tl", "<=");
+  Lexer lexer(sources, source("<="));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_LEQ);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 3);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 3);
 }
 
 TEST_CASE("Tokenization of point", "[lexer]")
 {
-  Lexer lexer("test.tl", ".");
+  Lexer lexer(sources, source("."));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_POINT);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of comma", "[lexer]")
 {
-  Lexer lexer("test.tl", ",");
+  Lexer lexer(sources, source(","));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_COMMA);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of colon", "[lexer]")
 {
-  Lexer lexer("test.tl", ":");
+  Lexer lexer(sources, source(":"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_COLON);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of semicolon", "[lexer]")
 {
-  Lexer lexer("test.tl", ";");
+  Lexer lexer(sources, source(";"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_SEMICOLON);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of ellipsis", "[lexer]")
 {
-  Lexer lexer("test.tl", "...");
+  Lexer lexer(sources, source("..."));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_ELLIPSIS);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 4);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 4);
 }
 
 TEST_CASE("Tokenization of question mark", "[lexer]")
 {
-  Lexer lexer("test.tl", "?");
+  Lexer lexer(sources, source("?"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_QMARK);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of left parenthesis", "[lexer]")
 {
-  Lexer lexer("test.tl", "(");
+  Lexer lexer(sources, source("("));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_LPAREN);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of right parenthesis", "[lexer]")
 {
-  Lexer lexer("test.tl", ")");
+  Lexer lexer(sources, source(")"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_RPAREN);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of left curly bracket", "[lexer]")
 {
-  Lexer lexer("test.tl", "{");
+  Lexer lexer(sources, source("{"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_LCURLY);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of right curly bracket", "[lexer]")
 {
-  Lexer lexer("test.tl", "}");
+  Lexer lexer(sources, source("}"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_RCURLY);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of left square bracket", "[lexer]")
 {
-  Lexer lexer("test.tl", "[");
+  Lexer lexer(sources, source("["));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_LBRACKET);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of right square bracket", "[lexer]")
 {
-  Lexer lexer("test.tl", "]");
+  Lexer lexer(sources, source("]"));
   auto tokens = lexer.tokenize();
 
   REQUIRE(tokens.size() == 2);
   REQUIRE(tokens[0].type == TokenType::T_RBRACKET);
-  REQUIRE(tokens[0].row == 1);
-  REQUIRE(tokens[0].col == 1);
+  REQUIRE(position(tokens[0].loc).row == 1);
+  REQUIRE(position(tokens[0].loc).col == 1);
 
   REQUIRE(tokens[1].type == TokenType::T_EOF);
-  REQUIRE(tokens[1].row == 1);
-  REQUIRE(tokens[1].col == 2);
+  REQUIRE(position(tokens[1].loc).row == 1);
+  REQUIRE(position(tokens[1].loc).col == 2);
 }
 
 TEST_CASE("Tokenization of comments", "[lexer]")
 {
   SECTION("Single-line comment")
   {
-    Lexer lexer("test.tl", "// Hello!");
+    Lexer lexer(sources, source("// Hello!"));
     auto tokens = lexer.tokenize();
 
     REQUIRE(tokens.size() == 1);
     REQUIRE(tokens[0].type == TokenType::T_EOF);
-    REQUIRE(tokens[0].row == 1);
-    REQUIRE(tokens[0].col == 10);
+    REQUIRE(position(tokens[0].loc).row == 1);
+    REQUIRE(position(tokens[0].loc).col == 10);
   }
 
   SECTION("Multi-line comment")
   {
-    Lexer lexer("test.tl", "/* Hello\nworld! */");
+    Lexer lexer(sources, source("/* Hello\nworld! */"));
     auto tokens = lexer.tokenize();
 
     REQUIRE(tokens.size() == 1);
     REQUIRE(tokens[0].type == TokenType::T_EOF);
-    REQUIRE(tokens[0].row == 2);
-    REQUIRE(tokens[0].col == 10);
+    REQUIRE(position(tokens[0].loc).row == 2);
+    REQUIRE(position(tokens[0].loc).col == 10);
   }
 
   SECTION("Unclosed multi-line comment")
   {
-    Lexer lexer("test.tl", "/* Hello");
+    Lexer lexer(sources, source("/* Hello"));
 
     REQUIRE_THROWS_AS(lexer.tokenize(), Error);
   }
 }
+
+TEST_CASE("Tokenization of keywords", "[lexer]")
+{
+  SECTION("Keywords")
+  {
+    Lexer lexer(sources, source("fn let if else while return"));
+    auto tokens = lexer.tokenize();
+
+    REQUIRE(tokens.size() == 7);
+    REQUIRE(tokens[0].type == TokenType::T_FN);
+    REQUIRE(tokens[1].type == TokenType::T_LET);
+    REQUIRE(tokens[2].type == TokenType::T_IF);
+    REQUIRE(tokens[3].type == TokenType::T_ELSE);
+    REQUIRE(tokens[4].type == TokenType::T_WHILE);
+    REQUIRE(tokens[5].type == TokenType::T_RETURN);
+    REQUIRE(position(tokens[5].loc).row == 1);
+    REQUIRE(position(tokens[5].loc).col == 22);
+  }
+
+  SECTION("Identifier starting with a keyword")
+  {
+    Lexer lexer(sources, source("iffy"));
+    auto tokens = lexer.tokenize();
+
+    REQUIRE(tokens.size() == 2);
+    REQUIRE(tokens[0].type == TokenType::T_ID);
+    REQUIRE(tokens[0].value == "iffy");
+  }
+}
+
+TEST_CASE("Tokenization of numbers followed by punctuation", "[lexer]")
+{
+  Lexer lexer(sources, source("f(1,2.5);"));
+  auto tokens = lexer.tokenize();
+
+  REQUIRE(tokens.size() == 8);
+  REQUIRE(tokens[2].type == TokenType::T_NUMBER);
+  REQUIRE(tokens[2].value == "1");
+  REQUIRE(tokens[3].type == TokenType::T_COMMA);
+  REQUIRE(position(tokens[3].loc).col == 4);
+  REQUIRE(tokens[4].type == TokenType::T_NUMBER);
+  REQUIRE(tokens[4].value == "2.5");
+  REQUIRE(tokens[5].type == TokenType::T_RPAREN);
+  REQUIRE(tokens[6].type == TokenType::T_SEMICOLON);
+}
+
+TEST_CASE("Tokenization of UTF-8 source", "[lexer]")
+{
+  SECTION("Identifiers")
+  {
+    Lexer lexer(sources, source("let été = π2 + 変数_1 + Ωmega;"));
+    auto tokens = lexer.tokenize();
+
+    REQUIRE(tokens.size() == 10);
+    REQUIRE(tokens[1].type == TokenType::T_ID);
+    REQUIRE(tokens[1].value == "été");
+    REQUIRE(position(tokens[1].loc).col == 5);
+    REQUIRE(position(tokens[2].loc).col == 9);
+    REQUIRE(tokens[3].value == "π2");
+    REQUIRE(tokens[5].value == "変数_1");
+    REQUIRE(position(tokens[5].loc).col == 16);
+    REQUIRE(tokens[7].value == "Ωmega");
+  }
+
+  SECTION("Combining marks continue identifiers but don't start them")
+  {
+    Lexer lexer(sources, source("e\xcc\x81t\xc3\xa9"));
+    auto tokens = lexer.tokenize();
+
+    REQUIRE(tokens.size() == 2);
+    REQUIRE(tokens[0].value == "e\xcc\x81t\xc3\xa9");
+
+    Lexer invalid(sources, source("\xcc\x81x"));
+    REQUIRE_THROWS_AS(invalid.tokenize(), Error);
+  }
+
+  SECTION("Strings and comments")
+  {
+    Lexer lexer(sources, source("/* ü */ \"naïve – ok\" x // ✓"));
+    auto tokens = lexer.tokenize();
+
+    REQUIRE(tokens.size() == 3);
+    REQUIRE(tokens[0].type == TokenType::T_STRING);
+    REQUIRE(tokens[0].value == "naïve – ok");
+    REQUIRE(position(tokens[0].loc).col == 9);
+    REQUIRE(position(tokens[1].loc).col == 22);
+  }
+
+  SECTION("Symbols that aren't identifier characters")
+  {
+    Lexer lexer(sources, source("let x = 1 ≠ 2;"));
+
+    try {
+      lexer.tokenize();
+      FAIL("Expected an error");
+    } catch (Error &e) {
+      REQUIRE(std::string(e.what()) == "Unexpected token: ≠");
+      REQUIRE(position(e.loc).col == 11);
+    }
+  }
+
+  SECTION("Malformed input")
+  {
+    const char *inputs[] = {
+      "let x\xff = 1;",
+      "\"\xc0\xaf\"",
+      "\"\xed\xa0\x80\"",
+      "\"\xf4\x90\x80\x80\"",
+      "\"\xe2\x82\"",
+      "x // \x80",
+      "\"0123456789abcdef\xc3\"",
+    };
+
+    for (const char *input : inputs) {
+      Lexer lexer(sources, source(input));
+      REQUIRE_THROWS_AS(lexer.tokenize(), Error);
+    }
+  }
+
+  SECTION("Position of malformed input")
+  {
+    Lexer lexer(sources, source("let a = 1;\nlet é = \"\xe2\x28\xa1\";"));
+
+    try {
+      lexer.tokenize();
+      FAIL("Expected an error");
+    } catch (Error &e) {
+      REQUIRE(std::string(e.what()) == "Invalid UTF-8 sequence.");
+      REQUIRE(position(e.loc).row == 2);
+      REQUIRE(position(e.loc).col == 10);
+    }
+  }
+}
+
+TEST_CASE("Tokenization on demand", "[lexer]")
+{
+  SECTION("Tokens are produced one at a time")
+  {
+    Lexer lexer(sources, source("a\n  b"));
+
+    Token a = lexer.next();
+    REQUIRE(a.value == "a");
+    REQUIRE(position(a.loc).row == 1);
+
+    Token b = lexer.next();
+    REQUIRE(b.value == "b");
+    REQUIRE(position(b.loc).row == 2);
+    REQUIRE(position(b.loc).col == 3);
+
+    REQUIRE(lexer.next().type == TokenType::T_EOF);
+    REQUIRE(lexer.next().type == TokenType::T_EOF);
+  }
+
+  SECTION("Unterminated literals")
+  {
+    for (const char *input : { "\"abc", "\"abc\\", "'a", "'\\" }) {
+      Lexer lexer(sources, source(input));
+      REQUIRE_THROWS_AS(lexer.tokenize(), Error);
+    }
+  }
+}
+
+static bool same_tokens(const std::string &input)
+{
+  SourceManager sources;
+  Lexer whole(sources, sources.add("test.tl", input));
+  std::istringstream stream(input);
+  Lexer streamed(sources, sources.add_stream("test.tl"), stream);
+
+  for (;;) {
+    Token expected = whole.next();
+    Token token    = streamed.next();
+
+    SourcePosition got  = sources.resolve(token.loc);
+    SourcePosition want = sources.resolve(expected.loc);
+    if (token.type != expected.type || token.value != expected.value || got.row != want.row
+        || got.col != want.col)
+      return false;
+    if (expected.type == TokenType::T_EOF)
+      return true;
+  }
+}
+
+// A stream of `count` lines of "x = 1;", made as it is read rather than held in memory.
+class LineStream : public std::streambuf {
+  std::uint64_t count;
+  std::string buffer;
+
+  public:
+  LineStream(std::uint64_t count) : count(count) { }
+
+  protected:
+  int_type underflow() override
+  {
+    if (this->count == 0)
+      return traits_type::eof();
+
+    this->buffer.clear();
+    for (; this->count != 0 && this->buffer.size() < 4096; this->count--)
+      this->buffer += "x = 1;\n";
+    this->setg(&this->buffer[0], &this->buffer[0], &this->buffer[0] + this->buffer.size());
+    return traits_type::to_int_type(this->buffer[0]);
+  }
+};
+
+// The resident memory of the process in bytes, or 0 where it cannot be read.
+static std::uint64_t resident()
+{
+  std::ifstream statm("/proc/self/statm");
+  std::uint64_t size = 0, pages = 0;
+  statm >> size >> pages;
+  return pages * 4096;
+}
+
+TEST_CASE("Tokenization of streams", "[lexer]")
+{
+  SECTION("Millions of lines in constant memory")
+  {
+    LineStream lines(5000000);
+    std::istream stream(&lines);
+    SourceManager streamed_sources;
+    Lexer lexer(streamed_sources, streamed_sources.add_stream("-"), stream);
+
+    std::uint64_t before = resident();
+    Token token          = lexer.next();
+    Token last           = token;
+    for (; token.type != TokenType::T_EOF; token = lexer.next())
+      last = token;
+
+    // A line table would take 8 bytes a line, 40 MB here.
+    REQUIRE(resident() - before < (8 << 20));
+
+    SourcePosition position = streamed_sources.resolve(last.loc);
+    REQUIRE(position.row == 5000000);
+    REQUIRE(position.col == 6);
+  }
+
+  SECTION("Tokens straddling refills")
+  {
+    std::string line = "let été_1 = \"naïve – ok\" + 'x' ... /* ü\n */ x += 1; // ✓\n";
+
+    for (std::size_t shift = 0; shift < line.size(); shift++) {
+      std::string input(shift, ' ');
+      while (input.size() < 2 * Lexer::BUFFER_SIZE)
+        input += line;
+
+      REQUIRE(same_tokens(input));
+    }
+  }
+
+  SECTION("Tokens longer than the buffer")
+  {
+    REQUIRE(same_tokens("a " + std::string(3 * Lexer::BUFFER_SIZE, 'b') + " c"));
+    REQUIRE(same_tokens("\"" + std::string(3 * Lexer::BUFFER_SIZE, 's') + "\" c"));
+    REQUIRE(same_tokens("/*" + std::string(3 * Lexer::BUFFER_SIZE, '\n') + "*/ c"));
+  }
+
+  SECTION("Errors")
+  {
+    std::string input = std::string(Lexer::BUFFER_SIZE - 1, '\n') + "let \xe2\x82 = 1;";
+    std::istringstream stream(input);
+    Lexer lexer(sources, sources.add_stream("test.tl"), stream);
+
+    try {
+      lexer.tokenize();
+      FAIL("Expected an error");
+    } catch (Error &e) {
+      REQUIRE(std::string(e.what()) == "Invalid UTF-8 sequence.");
+      REQUIRE(position(e.loc).row == Lexer::BUFFER_SIZE);
+      REQUIRE(position(e.loc).col == 5);
+    }
+
+    std::istringstream unterminated(std::string(Lexer::BUFFER_SIZE, ' ') + "\"abc");
+    Lexer string(sources, sources.add_stream("test.tl"), unterminated);
+    REQUIRE_THROWS_AS(string.tokenize(), Error);
+  }
+
+  SECTION("Empty stream")
+  {
+    std::istringstream stream("");
+    Lexer lexer(sources, sources.add_stream("test.tl"), stream);
+
+    REQUIRE(lexer.next().type == TokenType::T_EOF);
+  }
+}
+
+TEST_CASE("Tokenization with lexer policies", "[lexer]")
+{
+  const char *input = "fn f() { // one\n  return /* two\n */ 1'0 + \"a\\n\";\n}\n";
+
+  SECTION("Trivia are kept between the tokens")
+  {
+    BasicLexer<TriviaLexerPolicy> lexer(sources, source(input));
+    auto tokens = lexer.tokenize();
+    std::string text;
+
+    for (Token &token : tokens) {
+      if (token.type == TokenType::T_NUMBER)
+        text += "1'0";
+      else if (token.type == TokenType::T_STRING)
+        text += "\"a\\n\"";
+      else if (token.type != TokenType::T_EOF)
+        text += token.str();
+    }
+    REQUIRE(text == input);
+
+    REQUIRE(tokens[8].type == TokenType::T_COMMENT);
+    REQUIRE(tokens[8].value == "// one");
+    REQUIRE(position(tokens[8].loc).row == 1);
+    REQUIRE(position(tokens[8].loc).col == 10);
+
+    REQUIRE(tokens[9].type == TokenType::T_SPACE);
+    REQUIRE(tokens[9].value == "\n  ");
+    REQUIRE(position(tokens[9].loc).row == 1);
+    REQUIRE(position(tokens[9].loc).col == 16);
+    REQUIRE(tokens[12].type == TokenType::T_COMMENT);
+    REQUIRE(position(tokens[14].loc).row == 3);
+    REQUIRE(position(tokens[14].loc).col == 5);
+  }
+
+  SECTION("Bare tokens have neither values nor locations")
+  {
+    BasicLexer<BareLexerPolicy> bare(sources, source(input));
+    Lexer lexer(sources, source(input));
+    auto tokens   = lexer.tokenize();
+    auto expected = bare.tokenize();
+
+    REQUIRE(tokens.size() == expected.size());
+    for (std::size_t i = 0; i < tokens.size(); i++) {
+      REQUIRE(expected[i].type == tokens[i].type);
+      REQUIRE(expected[i].value.empty());
+      REQUIRE(expected[i].loc == SourceManager::NONE);
+    }
+
+    BasicLexer<BareLexerPolicy> error(sources, source("let s = \"open;"));
+    REQUIRE_THROWS_AS(error.tokenize(), Error);
+  }
+}
@@ -0,0 +1,118 @@
+#include "loader/loader.hpp"
+#include "error/error.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+static std::vector<std::string> write_files(unsigned int count)
+{
+  std::vector<std::string> paths;
+
+  for (unsigned int i = 0; i < count; i++) {
+    paths.push_back("tela-loader-" + std::to_string(i) + ".tl");
+
+    std::ofstream file(paths.back(), std::ios::binary);
+    file << std::string(i * 37, (char)('a' + i % 26));
+  }
+
+  return paths;
+}
+
+static void remove_files(const std::vector<std::string> &paths)
+{
+  for (const std::string &path : paths)
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Loading of files", "[loader]")
+{
+  for (bool batched : { true, false }) {
+    SECTION(batched ? "Batched" : "One by one")
+    {
+      std::vector<std::string> paths = write_files(3 * Loader::WINDOW + 5);
+      std::map<std::string, std::string> loaded;
+
+      {
+        Loader loader(paths, batched);
+        Source source;
+
+        while (loader.next(source)) {
+          REQUIRE(loaded.count(source.path) == 0);
+          loaded[source.path] = std::move(source.contents);
+        }
+        REQUIRE(!loader.next(source));
+      }
+
+      REQUIRE(loaded.size() == paths.size());
+      for (unsigned int i = 0; i < paths.size(); i++)
+        REQUIRE(loaded[paths[i]] == std::string(i * 37, (char)('a' + i % 26)));
+
+      remove_files(paths);
+    }
+
+    // Reads that return less than the rest of a file, as they do past 0x7ffff000 bytes, are
+    // scaled down to reads of a few bytes.
+    SECTION(batched ? "Batched in chunks" : "One by one in chunks")
+    {
+      std::vector<std::string> paths = write_files(20);
+
+      for (std::uint32_t chunk : { 1, 7, 37 }) {
+        Loader loader(paths, batched, chunk);
+        Source source;
+        unsigned int files = 0;
+
+        while (loader.next(source)) {
+          unsigned int i = (unsigned int)std::stoul(source.path.substr(12));
+          REQUIRE(source.contents == std::string(i * 37, (char)('a' + i % 26)));
+          files++;
+        }
+        REQUIRE(files == paths.size());
+      }
+
+      remove_files(paths);
+    }
+
+    SECTION(batched ? "Batched with missing files" : "One by one with missing files")
+    {
+      std::vector<std::string> paths = write_files(4);
+      paths.insert(paths.begin() + 2, "tela-loader-missing.tl");
+
+      Loader loader(paths, batched);
+      Source source;
+      unsigned int files = 0, errors = 0;
+
+      for (;;) {
+        try {
+          if (!loader.next(source))
+            break;
+          files++;
+        } catch (Error &e) {
+          REQUIRE(std::string(e.what()) == "Cannot open file: tela-loader-missing.tl");
+          errors++;
+        }
+      }
+
+      REQUIRE(files == 4);
+      REQUIRE(errors == 1);
+
+      remove_files(paths);
+    }
+  }
+
+  SECTION("Loading stops early")
+  {
+    std::vector<std::string> paths = write_files(2 * Loader::WINDOW);
+
+    {
+      Loader loader(paths);
+      Source source;
+      REQUIRE(loader.next(source));
+    }
+
+    remove_files(paths);
+  }
+}
@@ -0,0 +1,173 @@
+#include "lsp/lsp.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Each span as "<line>:<start>+<length> <type>", and each error as "<line>:<col> <message>".
+static std::vector<std::string> describe(const Document &document)
+{
+  std::vector<std::string> output;
+
+  for (const Document::Span &span : document.tokens()) {
+    output.push_back(std::to_string(span.line) + ":" + std::to_string(span.start) + "+"
+                     + std::to_string(span.length) + " " + Document::TYPES[span.type]);
+  }
+  for (const Document::Diagnostic &diagnostic : document.errors()) {
+    output.push_back(std::to_string(diagnostic.line) + ":" + std::to_string(diagnostic.col) + " "
+                     + diagnostic.message);
+  }
+
+  return output;
+}
+
+static std::string message(const std::string &body)
+{
+  return "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+// The messages that a server wrote.
+static std::vector<Json> messages(const std::string &output)
+{
+  std::vector<Json> parsed;
+
+  for (std::size_t at = 0; at < output.size();) {
+    std::size_t body   = output.find("\r\n\r\n", at) + 4;
+    std::size_t length = std::stoul(output.substr(at + 16, body - at - 20));
+    parsed.push_back(Json::parse(output.substr(body, length)));
+    at = body + length;
+  }
+
+  return parsed;
+}
+
+TEST_CASE("Semantic tokens of documents", "[lsp]")
+{
+  SECTION("Tokens follow the lexer, in UTF-16 code units")
+  {
+    Document document("fn main() {\n"
+                      "  let ñ = 'c' + 0x1f; // 😀 x\n"
+                      "  /* two\n"
+                      "     lines */ return \"😀\";\n"
+                      "}\n");
+
+    REQUIRE(describe(document)
+            == std::vector<std::string>{
+                "0:0+2 keyword", "0:3+4 variable", "1:2+3 keyword", "1:6+1 variable",
+                "1:8+1 operator", "1:10+3 string", "1:14+1 operator", "1:16+4 number",
+                "1:22+7 comment", "2:2+6 comment", "3:0+13 comment", "3:14+6 keyword",
+                "3:21+4 string" });
+    REQUIRE(document.encode()
+            == std::vector<std::uint32_t>{ 0, 0, 2, 0, 0, 0, 3, 4, 1, 0, 1, 2, 3, 0, 0,
+                                           0, 4, 1, 1, 0, 0, 2, 1, 5, 0, 0, 2, 3, 3, 0,
+                                           0, 4, 1, 5, 0, 0, 2, 4, 2, 0, 0, 6, 7, 4, 0,
+                                           1, 2, 6, 4, 0, 1, 0, 13, 4, 0, 0, 14, 6, 0, 0,
+                                           0, 7, 4, 3, 0 });
+  }
+
+  SECTION("Errors end their token and lexing goes on at the next line")
+  {
+    Document document("let a = $;\nlet b = 'xy';\nlet c = 1;\n");
+
+    REQUIRE(describe(document)
+            == std::vector<std::string>{ "0:0+3 keyword", "0:4+1 variable", "0:6+1 operator",
+                                         "1:0+3 keyword", "1:4+1 variable", "1:6+1 operator",
+                                         "2:0+3 keyword", "2:4+1 variable", "2:6+1 operator",
+                                         "2:8+1 number", "0:8 Unexpected token: $",
+                                         "1:10 Invalid character: 'xy'." });
+  }
+
+  SECTION("Edits give the tokens of lexing the new text from scratch")
+  {
+    std::string text;
+    for (int i = 0; i < 40; i++) {
+      text += "fn f" + std::to_string(i) + "(a: int) {\n"
+              "  /* a comment\n"
+              "     on two lines */ let s = \"a string\n"
+              "over two\"; // and ñ 😀\n"
+              "  return a " + std::string(i % 3 == 0 ? "+=" : "<=") + " 1;\n"
+              "}\n";
+    }
+
+    const char *fragments[] = { "\"", "/*", "*/", "\n", "x", "$", "😀", "'a'", " ", "//", "" };
+    Document document(text);
+    std::uint32_t state = 12345;
+    auto random = [&state](std::uint32_t bound) {
+      state = state * 1103515245 + 12345;
+      return (state >> 16) % bound;
+    };
+
+    for (int round = 0; round < 300; round++) {
+      std::uint32_t lines = (std::uint32_t)document.tokens().back().line + 2;
+      std::uint32_t line  = random(lines);
+      std::uint32_t col   = random(30);
+      std::uint32_t end   = line + random(3);
+
+      document.edit(line, col, end, random(30), fragments[random(11)]);
+      REQUIRE(describe(document) == describe(Document(document.text())));
+    }
+  }
+}
+
+TEST_CASE("Language server", "[lsp]")
+{
+  std::string uri = "file:///test.tl";
+  std::stringstream in(
+      message("{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"textDocument/semanticTokens/full\"}")
+      + message("{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"initialize\",\"params\":{}}")
+      + message("{\"jsonrpc\":\"2.0\",\"method\":\"initialized\",\"params\":{}}")
+      + message("{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didOpen\",\"params\":"
+                "{\"textDocument\":{\"uri\":\"" + uri + "\",\"languageId\":\"tela\","
+                "\"version\":1,\"text\":\"let a = 1;\\nlet b = 2;\\n\"}}}")
+      + message("{\"jsonrpc\":\"2.0\",\"id\":3,\"method\":\"textDocument/semanticTokens/full\","
+                "\"params\":{\"textDocument\":{\"uri\":\"" + uri + "\"}}}")
+      + message("{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didChange\",\"params\":"
+                "{\"textDocument\":{\"uri\":\"" + uri + "\",\"version\":2},\"contentChanges\":"
+                "[{\"range\":{\"start\":{\"line\":1,\"character\":8},"
+                "\"end\":{\"line\":1,\"character\":9}},\"text\":\"$\"}]}}")
+      + message("{\"jsonrpc\":\"2.0\",\"id\":4,"
+                "\"method\":\"textDocument/semanticTokens/full/delta\",\"params\":"
+                "{\"textDocument\":{\"uri\":\"" + uri + "\"},\"previousResultId\":\"1\"}}")
+      + message("{\"jsonrpc\":\"2.0\",\"id\":5,\"method\":\"textDocument/hover\",\"params\":{}}")
+      + message("not json")
+      + message("{\"jsonrpc\":\"2.0\",\"id\":6,\"method\":\"shutdown\"}")
+      + message("{\"jsonrpc\":\"2.0\",\"method\":\"exit\"}"));
+  std::stringstream out;
+
+  LanguageServer server(in, out);
+  REQUIRE(server.serve() == 0);
+
+  std::vector<Json> sent = messages(out.str());
+  REQUIRE(sent.size() == 9);
+
+  REQUIRE(sent[0]["id"].as_number() == 1);
+  REQUIRE(sent[0]["error"]["code"].as_number() == -32002);
+
+  const Json &capabilities = sent[1]["result"]["capabilities"];
+  REQUIRE(capabilities["textDocumentSync"]["change"].as_number() == 2);
+  REQUIRE(capabilities["semanticTokensProvider"]["full"]["delta"].as_bool());
+  REQUIRE(capabilities["semanticTokensProvider"]["legend"]["tokenTypes"].size() == 6);
+
+  REQUIRE(sent[2]["method"].as_string() == "textDocument/publishDiagnostics");
+  REQUIRE(sent[2]["params"]["diagnostics"].size() == 0);
+
+  REQUIRE(sent[3]["result"]["resultId"].as_string() == "1");
+  REQUIRE(sent[3]["result"]["data"].dump()
+          == "[0,0,3,0,0,0,4,1,1,0,0,2,1,5,0,0,2,1,2,0,1,0,3,0,0,0,4,1,1,0,0,2,1,5,0,0,2,1,2,0]");
+
+  const Json &diagnostics = sent[4]["params"]["diagnostics"];
+  REQUIRE(sent[4]["params"]["version"].as_number() == 2);
+  REQUIRE(diagnostics.size() == 1);
+  REQUIRE(diagnostics[0]["message"].as_string() == "Unexpected token: $");
+  REQUIRE(diagnostics[0]["range"]["start"]["line"].as_number() == 1);
+  REQUIRE(diagnostics[0]["range"]["start"]["character"].as_number() == 8);
+
+  REQUIRE(sent[5]["result"]["resultId"].as_string() == "2");
+  REQUIRE(sent[5]["result"]["edits"].dump() == "[{\"start\":35,\"deleteCount\":5,\"data\":[]}]");
+
+  REQUIRE(sent[6]["error"]["code"].as_number() == -32601);
+  REQUIRE(sent[7]["error"]["code"].as_number() == -32700);
+  REQUIRE(sent[8]["id"].as_number() == 6);
+  REQUIRE(sent[8]["result"].is_null());
+}
@@ -0,0 +1,186 @@
+#include "module/module.hpp"
+#include "checker/checker.hpp"
+#include "error/error.hpp"
+#include "folder/folder.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include "vm/vm.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+static void write_file(const std::string &path, const std::string &contents)
+{
+  std::ofstream file(path, std::ios::binary);
+  file << contents;
+}
+
+static void remove_module(const std::string &name)
+{
+  std::remove((name + ".tl").c_str());
+  std::remove((name + ".tli").c_str());
+}
+
+// Builds the program at `path` on `jobs` threads and returns its output, along with the number
+// of interfaces that had to be rebuilt.
+static std::string run(const std::string &path, std::uint32_t &rebuilds, unsigned int jobs = 1)
+{
+  SourceManager sources;
+  Lexer lexer(sources, sources.load(path));
+  Parser parser(lexer.tokenize());
+  Ast ast = parser.parse();
+
+  Folder folder(ast);
+  folder.fold();
+
+  Modules modules(sources, jobs);
+  Bytecode program = modules.build(ast, path);
+  rebuilds         = modules.rebuilds();
+
+  std::FILE *out = std::tmpfile();
+  Vm vm(program, out);
+  vm.run();
+
+  std::string text;
+  std::rewind(out);
+  for (int c; (c = std::fgetc(out)) != EOF;)
+    text.push_back((char)c);
+  std::fclose(out);
+
+  return text;
+}
+
+TEST_CASE("Building of modules", "[module]")
+{
+  std::uint32_t rebuilds = 0;
+
+  write_file("tela_util.tl", "let greeting = \"hi\";\n"
+                             "fn twice(x: int): int { return x * 2; }\n"
+                             "fn greet() { print(greeting); }\n");
+  write_file("tela_lib.tl", "import tela_util;\n"
+                            "fn quad(x: int): int { return twice(twice(x)); }\n");
+  write_file("tela_main.tl", "import tela_lib;\n"
+                             "import tela_util;\n"
+                             "fn main() { greet(); print(quad(3)); }\n");
+
+  SECTION("Imported modules are compiled into interfaces once")
+  {
+    REQUIRE(run("tela_main.tl", rebuilds) == "hi\n12\n");
+    REQUIRE(rebuilds == 2);
+
+    REQUIRE(run("tela_main.tl", rebuilds) == "hi\n12\n");
+    REQUIRE(rebuilds == 0);
+  }
+
+  SECTION("Importers are only rebuilt when an interface changes")
+  {
+    REQUIRE(run("tela_main.tl", rebuilds) == "hi\n12\n");
+
+    write_file("tela_util.tl", "let greeting = \"hello\";\n"
+                               "fn twice(x: int): int { return x + x + 1; }\n"
+                               "fn greet() { print(greeting); }\n");
+    REQUIRE(run("tela_main.tl", rebuilds) == "hello\n15\n");
+    REQUIRE(rebuilds == 1);
+
+    write_file("tela_util.tl", "fn twice(x: int, y: int): int { return x * y; }\n"
+                               "fn greet() {}\n");
+    REQUIRE_THROWS_AS(run("tela_main.tl", rebuilds), Error);
+  }
+
+  SECTION("Interfaces are used without their sources")
+  {
+    REQUIRE(run("tela_main.tl", rebuilds) == "hi\n12\n");
+
+    std::remove("tela_util.tl");
+    std::remove("tela_lib.tl");
+    REQUIRE(run("tela_main.tl", rebuilds) == "hi\n12\n");
+    REQUIRE(rebuilds == 0);
+  }
+
+  SECTION("Modules are built in parallel")
+  {
+    std::string main = "import tela_lib;\n";
+    std::string sum  = "0";
+
+    for (char c = 'a'; c <= 'h'; c++) {
+      std::string name = std::string("tela_leaf_") + c;
+      write_file(name + ".tl", "import tela_lib;\nfn " + name + "(): int { return quad(1); }\n");
+      main += "import " + name + ";\n";
+      sum += " + " + name + "()";
+    }
+    write_file("tela_main.tl", main + "fn main() { print(" + sum + "); }\n");
+
+    REQUIRE(run("tela_main.tl", rebuilds, 4) == "32\n");
+    REQUIRE(rebuilds == 10);
+
+    write_file("tela_util.tl", "fn twice(x: int): int { return x * 3; }\n"
+                               "fn greet() {}\n");
+    REQUIRE(run("tela_main.tl", rebuilds, 4) == "72\n");
+    REQUIRE(rebuilds == 1);
+
+    for (char c = 'a'; c <= 'h'; c++)
+      remove_module(std::string("tela_leaf_") + c);
+  }
+
+  SECTION("Programs are checked against the interfaces of their imports")
+  {
+    SourceManager sources;
+    Lexer lexer(sources, sources.add("tela_main.tl", "import tela_lib;\n"
+                                                     "fn main() { quad(1, 2); twice(3); }\n"));
+    Parser parser(lexer.tokenize());
+    Ast ast = parser.parse();
+
+    Modules modules(sources);
+    Compiler::Exports exports = modules.interfaces(ast, "tela_main.tl");
+    REQUIRE(exports.size() == 1);
+    REQUIRE(exports["tela_lib"].size() == 1);
+    REQUIRE(modules.rebuilds() == 2);
+
+    TypeTable types;
+    Checker checker(ast, types, 1, &exports);
+    std::vector<std::string> messages;
+    for (Checker::Diagnostic &diagnostic : checker.check())
+      messages.push_back(diagnostic.message);
+    REQUIRE(messages
+            == std::vector<std::string>{ "Wrong number of arguments to 'quad'.",
+                                         "Undefined function: twice" });
+
+    Lexer missing(sources, sources.add("tela_main.tl", "import tela_missing;\n"
+                                                       "fn main() { nosuch(1); }\n"));
+    Parser missing_parser(missing.tokenize());
+    Ast missing_ast = missing_parser.parse();
+    REQUIRE_THROWS_AS(modules.interfaces(missing_ast, "tela_main.tl"), Error);
+  }
+
+  SECTION("Errors")
+  {
+    write_file("tela_cycle.tl", "import tela_cycle;\n");
+    write_file("tela_cycle_a.tl", "import tela_cycle_b;\n");
+    write_file("tela_cycle_b.tl", "import tela_util;\nimport tela_cycle_a;\n");
+
+    const char *inputs[] = {
+      "import tela_missing;",
+      "import tela_cycle;",
+      "import tela_cycle_a;",
+      "import tela_main;",
+      "import tela_util; fn twice() {}",
+      "import tela_util; fn main() { twice(); }",
+    };
+
+    for (const char *input : inputs) {
+      write_file("tela_main.tl", input);
+      REQUIRE_THROWS_AS(run("tela_main.tl", rebuilds), Error);
+      REQUIRE_THROWS_AS(run("tela_main.tl", rebuilds, 4), Error);
+    }
+
+    remove_module("tela_cycle");
+    remove_module("tela_cycle_a");
+    remove_module("tela_cycle_b");
+  }
+
+  remove_module("tela_util");
+  remove_module("tela_lib");
+  remove_module("tela_main");
+}
@@ -0,0 +1,159 @@
+#include "optimizer/optimizer.hpp"
+#include "irgen/irgen.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+static Ir generate(const std::string &input)
+{
+  SourceManager sources;
+  Lexer lexer(sources, sources.add("test.tl", input));
+  Parser parser(lexer.tokenize());
+  Ast ast = parser.parse();
+
+  IrGen irgen(ast);
+  return irgen.generate();
+}
+
+static std::string optimize(const std::string &input)
+{
+  Ir ir = generate(input);
+
+  Optimizer optimizer(ir);
+  optimizer.optimize();
+
+  return ir.dump();
+}
+
+static std::string first_function(const std::string &ir)
+{
+  return ir.substr(0, ir.find("fn <entry>"));
+}
+
+TEST_CASE("Copy propagation", "[optimizer]")
+{
+  Ir ir = generate(
+      "fn f(a: int): int { let x = a; let n = 5; while (a < n) { x = x; a++; } return x; }");
+
+  Optimizer optimizer(ir);
+  optimizer.propagate_copies();
+  std::string dump = ir.dump();
+
+  REQUIRE(dump.find("copy") == std::string::npos);
+  REQUIRE(dump.find("lt %3, %1\n") != std::string::npos);
+  REQUIRE(dump.find("return %0\n") != std::string::npos);
+}
+
+TEST_CASE("Common subexpression elimination", "[optimizer]")
+{
+  SECTION("Commutative operands")
+  {
+    Ir ir = generate("fn f(a: int, b: int): int { let x = a * b; let y = b * a; return x + y; }");
+
+    Optimizer optimizer(ir);
+    optimizer.eliminate_common_subexpressions();
+
+    REQUIRE(ir.dump().find("  %4 = add %2, %2\n") != std::string::npos);
+  }
+
+  SECTION("Only dominating instructions are reused")
+  {
+    std::string ir = first_function(optimize("fn f(a: int, b: int): int { let x = 0; "
+                                             "if (a) x = a - b; else x = 1; return a - b + x; }"));
+
+    REQUIRE(ir.find("sub %0, %1\n") != ir.rfind("sub %0, %1\n"));
+  }
+
+  SECTION("Phis of equal values collapse")
+  {
+    std::string ir = first_function(optimize("fn f(a: int, b: int): int { let x = a * b; "
+                                             "if (a) x = b * a; else x = a * b; return x; }"));
+
+    REQUIRE(ir.find("phi") == std::string::npos);
+    REQUIRE(ir.find("mul") == ir.rfind("mul"));
+    REQUIRE(ir.find("return %2\n") != std::string::npos);
+  }
+}
+
+TEST_CASE("Dead code elimination", "[optimizer]")
+{
+  SECTION("Unused values disappear")
+  {
+    std::string ir = first_function(optimize(
+        "fn f(a: int): int { let i = 0; while (i < 10) { let d = i * 2 + 1; i++; } return a; }"));
+
+    REQUIRE(ir.find("mul") == std::string::npos);
+    REQUIRE(ir.find("const 2") == std::string::npos);
+    REQUIRE(ir.find("incr") != std::string::npos);
+  }
+
+  SECTION("Operations that may fail are kept")
+  {
+    std::string ir = first_function(optimize("fn f(a: int): int { let x = a / 2; let y = a + 1; "
+                                             "let z = 1 + 2; let s = \"s\"[0]; return 0; }"));
+
+    REQUIRE(ir.find("div") != std::string::npos);
+    REQUIRE(ir.find("add %0, ") != std::string::npos);
+    REQUIRE(ir.find("const 2") != std::string::npos);
+    REQUIRE(ir.find("index") != std::string::npos);
+    REQUIRE(ir.find("add %") == ir.rfind("add %"));
+  }
+
+  SECTION("Effects are kept")
+  {
+    std::string ir = optimize("let g = 0; fn f(): int { g = 1; print(g); return 0; } "
+                              "fn main() { f(); }");
+
+    REQUIRE(ir.find("store_global g") != std::string::npos);
+    REQUIRE(ir.find("print(") != std::string::npos);
+    REQUIRE(ir.find("call f()") != std::string::npos);
+  }
+}
+
+TEST_CASE("Removal of unreachable blocks", "[optimizer]")
+{
+  std::string ir = first_function(optimize(
+      "fn f(a: int): int { while (a) { if (a > 2) return 1; else return 2; a = 5; } return a; }"));
+
+  REQUIRE(ir
+          == "fn f(1)\n"
+             "b0:\n"
+             "  %0 = param 0\n"
+             "  jump b1\n"
+             "b1: ; preds = b0\n"
+             "  branch %0, b2, b3\n"
+             "b2: ; preds = b1\n"
+             "  %3 = const 2\n"
+             "  %4 = gt %0, %3\n"
+             "  branch %4, b4, b5\n"
+             "b3: ; preds = b1\n"
+             "  return %0\n"
+             "b4: ; preds = b2\n"
+             "  %7 = const 1\n"
+             "  return %7\n"
+             "b5: ; preds = b2\n"
+             "  return %3\n");
+}
+
+TEST_CASE("Optimization of large functions", "[optimizer]")
+{
+  std::string input = "fn f(a: int, b: int): int { let s = 0; let i = 0;";
+  for (int i = 0; i < 20000; i++) {
+    input += " s += a * b; let t" + std::to_string(i) + " = s + 1;";
+    input += " if (i) { s = s + b * a; } i++;";
+  }
+  input += " while (i) { s = s + a * b; i--; } return s; }";
+
+  Ir ir = generate(input);
+  std::size_t before = ir.instrs.size();
+
+  Optimizer optimizer(ir);
+  optimizer.optimize();
+
+  REQUIRE(ir.instrs.size() < before / 2);
+
+  std::string dump = first_function(ir.dump());
+  REQUIRE(dump.find("mul") == dump.rfind("mul"));
+  REQUIRE(dump.find("copy") == std::string::npos);
+}
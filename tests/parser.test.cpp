@@ -0,0 +1,183 @@
+#include "parser/parser.hpp"
+#include "error/error.hpp"
+#include "lexer/lexer.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+static SourceManager sources;
+
+static Ast parse(const char *input)
+{
+  Lexer lexer(sources, sources.add("test.tl", input));
+  Parser parser(lexer.tokenize());
+
+  return parser.parse();
+}
+
+static std::string parse_expr(const char *input)
+{
+  std::string source = std::string("fn f() { ") + input + "; }";
+  Ast ast            = parse(source.c_str());
+
+  std::uint32_t fn    = ast.list_items(ast.lhs(0))[0];
+  std::uint32_t block = ast.rhs(fn);
+
+  return ast.dump(ast.list_items(ast.lhs(block))[0]);
+}
+
+TEST_CASE("Parsing of binary operators", "[parser]")
+{
+  SECTION("Multiplication binds tighter than addition")
+  {
+    REQUIRE(parse_expr("1 + 2 * 3") == "(+ 1 (* 2 3))");
+    REQUIRE(parse_expr("1 * 2 + 3") == "(+ (* 1 2) 3)");
+  }
+
+  SECTION("Binary operators are left-associative")
+  {
+    REQUIRE(parse_expr("1 - 2 - 3") == "(- (- 1 2) 3)");
+    REQUIRE(parse_expr("a / b % c") == "(% (/ a b) c)");
+  }
+
+  SECTION("C operator precedence")
+  {
+    REQUIRE(parse_expr("a || b && c") == "(|| a (&& b c))");
+    REQUIRE(parse_expr("a | b ^ c & d") == "(| a (^ b (& c d)))");
+    REQUIRE(parse_expr("a == b < c") == "(== a (< b c))");
+    REQUIRE(parse_expr("a & b == c") == "(& a (== b c))");
+    REQUIRE(parse_expr("a >= b + 1") == "(>= a (+ b 1))");
+  }
+
+  SECTION("Parentheses override precedence")
+  {
+    REQUIRE(parse_expr("(1 + 2) * 3") == "(* (+ 1 2) 3)");
+  }
+}
+
+TEST_CASE("Parsing of unary and postfix operators", "[parser]")
+{
+  SECTION("Prefix operators")
+  {
+    REQUIRE(parse_expr("-a * b") == "(* (- a) b)");
+    REQUIRE(parse_expr("!~a") == "(! (~ a))");
+    REQUIRE(parse_expr("- -a") == "(- (- a))");
+    REQUIRE(parse_expr("++a") == "(++ a)");
+  }
+
+  SECTION("Postfix operators")
+  {
+    REQUIRE(parse_expr("a++") == "(a ++)");
+    REQUIRE(parse_expr("a[i]--") == "(([] a i) --)");
+    REQUIRE(parse_expr("a.b.c") == "(. (. a b) c)");
+    REQUIRE(parse_expr("f(1, x + 1)(2)") == "(call (call f 1 (+ x 1)) 2)");
+    REQUIRE(parse_expr("f()") == "(call f)");
+  }
+
+  SECTION("Increment of a non-assignable operand")
+  {
+    REQUIRE_THROWS_AS(parse_expr("1++"), Error);
+    REQUIRE_THROWS_AS(parse_expr("--f()"), Error);
+  }
+}
+
+TEST_CASE("Parsing of assignment and ternary operators", "[parser]")
+{
+  SECTION("Assignment is right-associative")
+  {
+    REQUIRE(parse_expr("a = b = c") == "(= a (= b c))");
+    REQUIRE(parse_expr("a += b * 2") == "(+= a (* b 2))");
+  }
+
+  SECTION("Ternary operator")
+  {
+    REQUIRE(parse_expr("a ? b : c") == "(? a b c)");
+    REQUIRE(parse_expr("a ? b : c ? d : e") == "(? a b (? c d e))");
+    REQUIRE(parse_expr("x = a || b ? 1 : 2") == "(= x (? (|| a b) 1 2))");
+  }
+
+  SECTION("Assignment to a non-assignable expression")
+  {
+    REQUIRE_THROWS_AS(parse_expr("a + b = c"), Error);
+    REQUIRE_THROWS_AS(parse_expr("a ? b : c = d"), Error);
+  }
+}
+
+TEST_CASE("Parsing of literals", "[parser]")
+{
+  REQUIRE(parse_expr("'a'") == "'a'");
+  REQUIRE(parse_expr("\"str\"") == "\"str\"");
+  REQUIRE(parse_expr("0x10") == "0x10");
+}
+
+TEST_CASE("Parsing of statements", "[parser]")
+{
+  SECTION("Variable declarations")
+  {
+    Ast ast = parse("let a; let b: int; let c = 1; let d: float = 2.0;");
+
+    REQUIRE(ast.dump() == "(program (let a) (let b int) (let c 1) (let d float 2.0))");
+  }
+
+  SECTION("Control flow")
+  {
+    Ast ast = parse("fn f() { if (a) return 1; else { b = 2; } while (b < 3) b++; return; }");
+
+    REQUIRE(ast.dump()
+            == "(program (fn f () (block (if a (return 1) (block (= b 2))) (while (< b 3) (b ++)) "
+               "(return))))");
+  }
+
+  SECTION("Function declarations")
+  {
+    Ast ast = parse("fn add(a: int, b: int): int { return a + b; } fn log(fmt: string, ...) {}");
+
+    REQUIRE(ast.dump()
+            == "(program (fn add ((a int) (b int)) int (block (return (+ a b)))) "
+               "(fn log ((fmt string) ...) (block)))");
+  }
+
+  SECTION("Imports")
+  {
+    Ast ast = parse("import util; fn f() {}");
+
+    REQUIRE(ast.dump() == "(program (import util) (fn f () (block)))");
+    REQUIRE_THROWS_AS(parse("fn f() { import util; }"), Error);
+  }
+
+  SECTION("Missing semicolon")
+  {
+    REQUIRE_THROWS_AS(parse("let a = 1"), Error);
+  }
+
+  SECTION("Unclosed block")
+  {
+    REQUIRE_THROWS_AS(parse("fn f() { a = 1;"), Error);
+  }
+
+  SECTION("Statement at top level")
+  {
+    REQUIRE_THROWS_AS(parse("a = 1;"), Error);
+  }
+}
+
+TEST_CASE("AST layout", "[parser]")
+{
+  Ast ast = parse("fn f() { return 1 + 2 * 3; }");
+
+  REQUIRE(ast.kind(0) == AstKind::N_PROGRAM);
+  REQUIRE(ast.kinds.size() == ast.main_tokens.size());
+  REQUIRE(ast.kinds.size() == ast.data.size());
+
+  std::uint32_t fn = ast.list_items(ast.lhs(0))[0];
+  REQUIRE(ast.kind(fn) == AstKind::N_FN);
+  REQUIRE(ast.token(fn).value == "f");
+
+  std::uint32_t ret = ast.list_items(ast.lhs(ast.rhs(fn)))[0];
+  REQUIRE(ast.kind(ret) == AstKind::N_RETURN);
+
+  std::uint32_t add = ast.lhs(ret);
+  REQUIRE(ast.kind(add) == AstKind::N_BINARY);
+  REQUIRE(ast.token(add).type == TokenType::T_ADD);
+  REQUIRE(sources.resolve(ast.token(add).loc).col == 19);
+  REQUIRE(ast.kind(ast.rhs(add)) == AstKind::N_BINARY);
+}
@@ -0,0 +1,120 @@
+#include "pipeline/pipeline.hpp"
+#include "error/error.hpp"
+#include "parser/parser.hpp"
+#include "ring/ring.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <thread>
+
+// A program of `count` functions, large enough to take several batches.
+static std::string program(int count)
+{
+  std::string input;
+
+  for (int i = 0; i < count; i++) {
+    input += "fn f" + std::to_string(i) + "(a: int): int {\n"
+             "  let b = a * " + std::to_string(i) + " + \"s\"[0];\n"
+             "  while (b > 10) { b -= 3; }\n"
+             "  return b;\n"
+             "}\n";
+  }
+
+  return input;
+}
+
+static std::string parse(const std::string &input, bool pipelined)
+{
+  SourceManager sources;
+  Lexer lexer(sources, sources.add("test.tl", input));
+
+  if (!pipelined)
+    return Parser(lexer.tokenize()).parse().dump();
+
+  TokenPipeline tokens(lexer);
+  return Parser(tokens).parse().dump();
+}
+
+TEST_CASE("Single-producer single-consumer ring", "[pipeline]")
+{
+  SECTION("Items come out in order until the ring is empty")
+  {
+    Ring<int, 4> ring;
+    int item = 0;
+
+    for (int round = 0; round < 3; round++) {
+      for (int i = 0; i < 4; i++) {
+        int value = round * 10 + i;
+        REQUIRE(ring.try_push(value));
+      }
+      REQUIRE_FALSE(ring.try_push(item));
+
+      for (int i = 0; i < 4; i++) {
+        REQUIRE(ring.try_pop(item));
+        REQUIRE(item == round * 10 + i);
+      }
+      REQUIRE_FALSE(ring.try_pop(item));
+    }
+  }
+
+  SECTION("Items cross threads in order")
+  {
+    Ring<int, 8> ring;
+    std::thread producer([&] {
+      for (int i = 0; i < 100000; i++) {
+        int value = i;
+        while (!ring.try_push(value))
+          std::this_thread::yield();
+      }
+    });
+
+    bool ordered = true;
+    for (int i = 0; i < 100000; i++) {
+      int item = -1;
+      while (!ring.try_pop(item))
+        std::this_thread::yield();
+      ordered = ordered && item == i;
+    }
+    producer.join();
+
+    REQUIRE(ordered);
+  }
+}
+
+TEST_CASE("Pipelined lexing and parsing", "[pipeline]")
+{
+  SECTION("The AST is the same as when lexing first")
+  {
+    for (int count : { 0, 1, 1000 }) {
+      std::string input = program(count);
+      REQUIRE(parse(input, true) == parse(input, false));
+    }
+  }
+
+  SECTION("Errors of the lexer reach the parser")
+  {
+    SourceManager sources;
+    Lexer lexer(sources, sources.add("test.tl", program(1000) + "fn g() { return \"open; }"));
+    TokenPipeline tokens(lexer);
+    Parser parser(tokens);
+
+    try {
+      parser.parse();
+      FAIL("No error was raised.");
+    } catch (Error &error) {
+      SourcePosition position = sources.resolve(error.loc);
+      REQUIRE(std::string(error.what()) == "Unterminated string.");
+      REQUIRE(position.row == 5001);
+      REQUIRE(position.col == 17);
+    }
+  }
+
+  SECTION("The lexer stops when the parser fails")
+  {
+    SourceManager sources;
+    Lexer lexer(sources, sources.add("test.tl", "fn (" + program(5000)));
+    TokenPipeline tokens(lexer);
+    Parser parser(tokens);
+
+    REQUIRE_THROWS_AS(parser.parse(), Error);
+  }
+}
@@ -0,0 +1,170 @@
+#include "prelude/prelude.hpp"
+#include "checker/checker.hpp"
+#include "error/error.hpp"
+#include "folder/folder.hpp"
+#include "interface/interface.hpp"
+#include "lexer/lexer.hpp"
+#include "module/module.hpp"
+#include "parser/parser.hpp"
+#include "vm/vm.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// An image of the prelude `source`, aligned like the one linked into tela.
+class TestPrelude {
+  std::vector<std::uint64_t> words;
+  std::size_t size;
+
+  public:
+  TestPrelude(const std::string &source)
+  {
+    SourceManager sources;
+    std::string image = prelude_image(sources, sources.add("prelude.tl", source));
+
+    this->words.resize(image.size() / 8 + 1);
+    this->size = image.size();
+    std::memcpy(this->words.data(), image.data(), image.size());
+  }
+
+  std::string_view view() const
+  {
+    return std::string_view((const char *)this->words.data(), this->size);
+  }
+};
+
+static void write_file(const std::string &path, const std::string &contents)
+{
+  std::ofstream file(path, std::ios::binary);
+  file << contents;
+}
+
+// Builds the program at `path` with `prelude` and returns its output.
+static std::string run(const std::string &path, const TestPrelude &prelude,
+                       std::uint32_t &rebuilds, Bytecode *linked = nullptr)
+{
+  SourceManager sources;
+  Lexer lexer(sources, sources.load(path));
+  Parser parser(lexer.tokenize());
+  Ast ast = parser.parse();
+
+  Folder folder(ast);
+  folder.fold();
+
+  Modules modules(sources, 1, nullptr, prelude.view());
+  Bytecode program = modules.build(ast, path);
+  rebuilds         = modules.rebuilds();
+
+  std::FILE *out = std::tmpfile();
+  Vm vm(program, out);
+  vm.run();
+
+  std::string text;
+  std::rewind(out);
+  for (int c; (c = std::fgetc(out)) != EOF;)
+    text.push_back((char)c);
+  std::fclose(out);
+
+  if (linked != nullptr)
+    *linked = std::move(program);
+  return text;
+}
+
+TEST_CASE("The prelude", "[prelude]")
+{
+  TestPrelude prelude("fn abs(x: any): any { return x < 0 ? -x : x; }\n"
+                      "fn twice(x: int): int { return abs(x) * 2; }\n");
+  std::uint32_t rebuilds = 0;
+
+  SECTION("Programs call it without importing it")
+  {
+    write_file("tela_prelude_main.tl", "fn main() { print(abs(-3), twice(-4)); }\n");
+    REQUIRE(run("tela_prelude_main.tl", prelude, rebuilds) == "3 8\n");
+
+    write_file("tela_prelude_main.tl", "import prelude;\nfn main() { print(twice(5)); }\n");
+    REQUIRE(run("tela_prelude_main.tl", prelude, rebuilds) == "10\n");
+  }
+
+  SECTION("Definitions of the program take precedence")
+  {
+    write_file("tela_prelude_main.tl", "fn abs(x: int): int { return 42; }\n"
+                                       "fn main() { print(abs(-1), twice(-1)); }\n");
+    REQUIRE(run("tela_prelude_main.tl", prelude, rebuilds) == "42 2\n");
+
+    write_file("tela_prelude_main.tl", "let twice = 1;\nfn main() { twice(2); }\n");
+    REQUIRE_THROWS_AS(run("tela_prelude_main.tl", prelude, rebuilds), Error);
+    write_file("tela_prelude_main.tl", "fn main() { abs(1, 2); }\n");
+    REQUIRE_THROWS_AS(run("tela_prelude_main.tl", prelude, rebuilds), Error);
+  }
+
+  SECTION("It is only linked into programs that call it")
+  {
+    Bytecode linked;
+    write_file("tela_prelude_main.tl", "fn main() { print(1); }\n");
+    REQUIRE(run("tela_prelude_main.tl", prelude, rebuilds, &linked) == "1\n");
+
+    for (const Bytecode::Function &function : linked.functions)
+      REQUIRE(function.name != "abs");
+  }
+
+  SECTION("Modules that call it depend on it")
+  {
+    write_file("tela_prelude_util.tl", "fn half(x: int): int { return abs(x) / 2; }\n");
+    write_file("tela_prelude_main.tl", "import tela_prelude_util;\n"
+                                       "fn main() { print(half(-8)); }\n");
+
+    REQUIRE(run("tela_prelude_main.tl", prelude, rebuilds) == "4\n");
+    REQUIRE(rebuilds == 1);
+
+    Interface interface("tela_prelude_util.tli");
+    REQUIRE(interface.dependency_count() == 1);
+    REQUIRE(interface.dependency(0).name == Compiler::PRELUDE);
+
+    REQUIRE(run("tela_prelude_main.tl", prelude, rebuilds) == "4\n");
+    REQUIRE(rebuilds == 0);
+
+    TestPrelude changed("fn abs(x: any, ...): any { return x < 0 ? 0 - x : x; }\n");
+    REQUIRE(run("tela_prelude_main.tl", changed, rebuilds) == "4\n");
+    REQUIRE(rebuilds == 1);
+
+    std::remove("tela_prelude_util.tl");
+    std::remove("tela_prelude_util.tli");
+  }
+
+  SECTION("It is checked against")
+  {
+    SourceManager sources;
+    Lexer lexer(sources, sources.add("test.tl", "fn main() { abs(1); twice(); }"));
+    Parser parser(lexer.tokenize());
+    Ast ast = parser.parse();
+    TypeTable types;
+
+    std::vector<Bytecode::Function> functions =
+        Interface(prelude.view().data(), prelude.view().size(), "<prelude>").exports();
+    Checker checker(ast, types, 1, nullptr, &functions);
+    std::vector<Checker::Diagnostic> diagnostics = checker.check();
+
+    REQUIRE(diagnostics.size() == 1);
+    REQUIRE(diagnostics[0].message == "Wrong number of arguments to 'twice'.");
+  }
+
+  SECTION("Malformed images are rejected")
+  {
+    std::uint64_t garbage[4] = { 1, 2, 3, 4 };
+    write_file("tela_prelude_main.tl", "fn main() {}\n");
+
+    SourceManager sources;
+    Lexer lexer(sources, sources.load("tela_prelude_main.tl"));
+    Parser parser(lexer.tokenize());
+    Ast ast = parser.parse();
+
+    Modules modules(sources, 1, nullptr, std::string_view((const char *)garbage, sizeof(garbage)));
+    REQUIRE_THROWS_AS(modules.build(ast, "tela_prelude_main.tl"), Error);
+  }
+
+  std::remove("tela_prelude_main.tl");
+}
@@ -0,0 +1,170 @@
+#include "query/query.hpp"
+#include "error/error.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+static const std::string ADD   = "fn add(a: int, b: int): int { return a + b; }\n";
+static const std::string TWICE = "fn twice(x: int): int { return add(x, x); }\n";
+static const std::string MAIN  = "fn main() { print(twice(1)); }\n";
+
+// Each diagnostic as "<row>:<col> <message>".
+static std::vector<std::string> describe(const SourceManager &sources,
+                                         const std::vector<Checker::Diagnostic> &diagnostics)
+{
+  std::vector<std::string> output;
+
+  for (const Checker::Diagnostic &diagnostic : diagnostics) {
+    SourcePosition position = sources.resolve(diagnostic.loc);
+    output.push_back(std::to_string(position.row) + ":" + std::to_string(position.col) + " "
+                     + diagnostic.message);
+  }
+
+  return output;
+}
+
+TEST_CASE("Incremental checking with queries", "[query]")
+{
+  SourceManager sources;
+  QueryDatabase queries(sources);
+  queries.set_source("test.tl", ADD + TWICE + MAIN);
+
+  REQUIRE(queries.check("test.tl").empty());
+  REQUIRE(queries.executions(QueryKind::Q_CHECK) == 3);
+
+  SECTION("Results are memoized")
+  {
+    REQUIRE(queries.check("test.tl").empty());
+    queries.set_source("test.tl", ADD + TWICE + MAIN);
+    REQUIRE(queries.check("test.tl").empty());
+
+    REQUIRE(queries.executions(QueryKind::Q_TOKENS) == 1);
+    REQUIRE(queries.executions(QueryKind::Q_PARSE) == 1);
+    REQUIRE(queries.executions(QueryKind::Q_CHECK) == 3);
+  }
+
+  SECTION("Editing a body only checks that function again")
+  {
+    queries.set_source("test.tl", ADD + TWICE + "fn main() { print(twice(\"s\")); }\n");
+
+    REQUIRE(describe(sources, queries.check("test.tl"))
+            == std::vector<std::string>{ "3:25 Type mismatch: expected int, found string." });
+    REQUIRE(queries.executions(QueryKind::Q_PARSE) == 2);
+    REQUIRE(queries.executions(QueryKind::Q_CHECK) == 4);
+  }
+
+  SECTION("Changing a signature checks its callers again")
+  {
+    queries.set_source("test.tl", "fn add(a: int, b: string): int { return a; }\n" + TWICE + MAIN);
+
+    REQUIRE(describe(sources, queries.check("test.tl"))
+            == std::vector<std::string>{ "2:39 Type mismatch: expected string, found int." });
+    REQUIRE(queries.signature("test.tl", "add") == "fn(int, string): int");
+    REQUIRE(queries.executions(QueryKind::Q_CHECK) == 5);
+  }
+
+  SECTION("Edits that leave the tokens in place stop at the tokens")
+  {
+    queries.set_source("test.tl", ADD.substr(0, ADD.size() - 1) + " // sum\n" + TWICE + MAIN);
+
+    REQUIRE(queries.check("test.tl").empty());
+    REQUIRE(queries.executions(QueryKind::Q_TOKENS) == 2);
+    REQUIRE(queries.executions(QueryKind::Q_PARSE) == 1);
+  }
+
+  SECTION("Diagnostics follow the lines they are on")
+  {
+    std::string source = ADD + TWICE + "fn main() { print(twice(\"s\")); }\n";
+
+    queries.set_source("test.tl", source);
+    REQUIRE(describe(sources, queries.check("test.tl"))
+            == std::vector<std::string>{ "3:25 Type mismatch: expected int, found string." });
+
+    queries.set_source("test.tl", "\n" + source);
+    REQUIRE(describe(sources, queries.check("test.tl"))
+            == std::vector<std::string>{ "4:25 Type mismatch: expected int, found string." });
+  }
+
+  SECTION("Buffers of earlier contents are released")
+  {
+    std::string body = "fn main() { print(twice(\"s\")); }\n";
+
+    for (int i = 0; i < 100; i++) {
+      queries.set_source("test.tl", ADD + TWICE + body + std::string(i % 2, ' '));
+      REQUIRE(describe(sources, queries.check("test.tl"))
+              == std::vector<std::string>{ "3:25 Type mismatch: expected int, found string." });
+    }
+    queries.set_source("test.tl", "\n" + ADD + TWICE + body);
+    REQUIRE(describe(sources, queries.check("test.tl"))
+            == std::vector<std::string>{ "4:25 Type mismatch: expected int, found string." });
+
+    queries.set_source("test.tl", ADD + TWICE + MAIN);
+    REQUIRE(sources.add("probe.tl", "") < 4);
+  }
+
+  SECTION("Errors are raised and not memoized")
+  {
+    queries.set_source("test.tl", ADD + "fn twice(x: int {\n" + MAIN);
+    REQUIRE_THROWS_AS(queries.check("test.tl"), Error);
+    REQUIRE_THROWS_AS(queries.check("test.tl"), Error);
+    REQUIRE(queries.executions(QueryKind::Q_PARSE) == 3);
+
+    queries.set_source("test.tl", ADD + TWICE + MAIN);
+    REQUIRE(queries.check("test.tl").empty());
+    REQUIRE(queries.executions(QueryKind::Q_CHECK) == 3);
+
+    REQUIRE_THROWS_AS(queries.check("missing.tl"), Error);
+  }
+}
+
+TEST_CASE("Checking against imported modules", "[query]")
+{
+  SourceManager sources;
+  QueryDatabase queries(sources);
+  queries.set_source("lib/util.tl", ADD + TWICE);
+  queries.set_source("lib/main.tl", "import util;\n" + MAIN);
+
+  REQUIRE(queries.check("lib/main.tl").empty());
+  REQUIRE(queries.exports("lib/util.tl").size() == 2);
+  REQUIRE(queries.executions(QueryKind::Q_CHECK) == 1);
+
+  SECTION("Editing the body of an exported function does not check importers again")
+  {
+    queries.set_source("lib/util.tl", ADD + "fn twice(x: int): int { return x * 2; }\n");
+    REQUIRE(queries.check("lib/util.tl").empty());
+    REQUIRE(queries.check("lib/main.tl").empty());
+    REQUIRE(queries.executions(QueryKind::Q_CHECK) == 3);
+  }
+
+  SECTION("Removing an exported function checks importers again")
+  {
+    queries.set_source("lib/util.tl", ADD + "fn thrice(x: int): int { return x * 3; }\n");
+    REQUIRE(describe(sources, queries.check("lib/main.tl"))
+            == std::vector<std::string>{ "2:19 Undefined function: twice" });
+
+    queries.set_source("lib/util.tl", ADD + "fn twice(x: int, y: int): int { return x; }\n");
+    REQUIRE(describe(sources, queries.check("lib/main.tl"))
+            == std::vector<std::string>{ "2:24 Wrong number of arguments to 'twice'." });
+  }
+
+  SECTION("Removed modules are missing for their importers")
+  {
+    queries.remove_source("lib/util.tl");
+    REQUIRE(describe(sources, queries.check("lib/main.tl"))
+            == std::vector<std::string>{ "1:8 Unknown module: util",
+                                         "2:19 Undefined function: twice" });
+    REQUIRE_THROWS_AS(queries.check("lib/util.tl"), Error);
+    REQUIRE(queries.exports("lib/util.tl").empty());
+
+    queries.set_source("lib/util.tl", ADD + TWICE);
+    REQUIRE(queries.check("lib/main.tl").empty());
+  }
+
+  SECTION("Modules that were never set are missing")
+  {
+    queries.set_source("lib/main.tl", "import other;\nfn main() { nosuch(1); }\n");
+    REQUIRE(describe(sources, queries.check("lib/main.tl"))
+            == std::vector<std::string>{ "1:8 Unknown module: other",
+                                         "2:13 Undefined function: nosuch" });
+  }
+}
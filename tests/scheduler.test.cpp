@@ -0,0 +1,111 @@
+#include "scheduler/scheduler.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST_CASE("Scheduler class tests", "[scheduler]")
+{
+  std::mutex mutex;
+  std::vector<std::string> log;
+  auto record = [&](const std::string &name) {
+    return [&, name] {
+      std::lock_guard<std::mutex> lock(mutex);
+      log.push_back(name);
+    };
+  };
+  auto position = [&](const std::string &name) {
+    for (std::size_t i = 0; i < log.size(); i++) {
+      if (log[i] == name)
+        return i;
+    }
+    return log.size();
+  };
+
+  SECTION("Tasks run after their dependencies")
+  {
+    for (unsigned int workers : { 1u, 4u }) {
+      Scheduler scheduler(workers);
+      log.clear();
+
+      std::uint32_t a = scheduler.add("a", 1, record("a"));
+      std::uint32_t b = scheduler.add("b", 1, record("b"), { a });
+      std::uint32_t c = scheduler.add("c", 1, record("c"), { a });
+      std::uint32_t d = scheduler.add("d", 1, record("d"), { b });
+      scheduler.depend(d, c);
+      scheduler.run();
+
+      REQUIRE(log.size() == 4);
+      REQUIRE(position("a") < position("b"));
+      REQUIRE(position("a") < position("c"));
+      REQUIRE(position("b") < position("d"));
+      REQUIRE(position("c") < position("d"));
+    }
+  }
+
+  SECTION("The critical path is started first")
+  {
+    Scheduler scheduler(1);
+
+    scheduler.add("short", 1, record("short"));
+    std::uint32_t head = scheduler.add("head", 1, record("head"));
+    scheduler.add("tail", 10, record("tail"), { head });
+    scheduler.run();
+
+    REQUIRE(log == std::vector<std::string>{ "head", "tail", "short" });
+  }
+
+  SECTION("Tasks can add tasks")
+  {
+    Scheduler scheduler(4);
+    std::atomic<int> count(0);
+
+    std::uint32_t root = scheduler.add("root", 1, record("root"));
+    scheduler.add("spawn", 1, [&] {
+      std::vector<std::uint32_t> leaves;
+      for (int i = 0; i < 100; i++)
+        leaves.push_back(scheduler.add("leaf", 1, [&] { count++; }, { root }));
+      scheduler.add("join", 1, [&] { record("join " + std::to_string(count))(); }, leaves);
+    });
+    scheduler.run();
+
+    REQUIRE(count == 100);
+    REQUIRE(log.back() == "join 100");
+  }
+
+  SECTION("The first exception is rethrown")
+  {
+    Scheduler scheduler(4);
+
+    std::uint32_t fail = scheduler.add("fail", 1, [] { throw std::runtime_error("fail"); });
+    scheduler.add("after", 1, record("after"), { fail });
+
+    REQUIRE_THROWS_AS(scheduler.run(), std::runtime_error);
+    REQUIRE(log.empty());
+  }
+
+  SECTION("The report follows the longest chain")
+  {
+    Scheduler scheduler(2);
+
+    std::uint32_t a = scheduler.add("a", 1, record("a"));
+    std::uint32_t b = scheduler.add("b", 1, [] {
+      std::vector<int> work(1 << 20, 1);
+      volatile int sum = 0;
+      for (int value : work)
+        sum = sum + value;
+    }, { a });
+    scheduler.add("c", 1, record("c"), { a });
+    scheduler.add("d", 1, record("d"), { b });
+    scheduler.run();
+
+    Scheduler::Report report = scheduler.report();
+    REQUIRE(report.workers == 2);
+    REQUIRE(report.path == std::vector<std::string>{ "a", "b", "d" });
+    REQUIRE(report.critical <= report.wall);
+    REQUIRE(report.busy <= report.wall * 2);
+    REQUIRE(report.idle >= 0);
+  }
+}
@@ -0,0 +1,31 @@
+#include "server/server.hpp"
+#include "error/error.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+
+TEST_CASE("Server class tests", "[server]")
+{
+  std::remove("tela_server.sock");
+
+  SECTION("Only one server listens on a socket")
+  {
+    Server server("tela_server.sock");
+    REQUIRE_THROWS_AS(Server("tela_server.sock"), Error);
+  }
+
+  SECTION("A socket can be listened on again once its server is gone")
+  {
+    {
+      Server server("tela_server.sock");
+    }
+    Server server("tela_server.sock");
+  }
+
+  SECTION("Errors")
+  {
+    REQUIRE_THROWS_AS(Server::forward("tela_server.sock", { "--check", "a.tl" }), Error);
+    REQUIRE_THROWS_AS(Server(std::string(200, 'x')), Error);
+  }
+
+  std::remove("tela_server.sock");
+}
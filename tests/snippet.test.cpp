@@ -0,0 +1,85 @@
+#include "lexer/snippet.hpp"
+#include "error/error.hpp"
+#include "lexer/lexer.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+// Each token as "<row>:<col> <text>", for comparing tokens of different sources.
+static std::vector<std::string> describe(const SourceManager &sources,
+                                         std::vector<Token> tokens)
+{
+  std::vector<std::string> output;
+
+  for (Token &token : tokens) {
+    SourcePosition position = sources.resolve(token.loc);
+    output.push_back(std::to_string(position.row) + ":" + std::to_string(position.col) + " "
+                     + token.str());
+  }
+
+  return output;
+}
+
+template <std::size_t N, std::size_t L, std::size_t M>
+static void require_lexed(const Snippet<N, L, M> &snippet, const char (&input)[M])
+{
+  SourceManager sources;
+  Lexer lexer(sources, sources.add("lexer.tl", input));
+
+  REQUIRE(describe(sources, snippet.tokenize(sources, "snippet.tl"))
+          == describe(sources, lexer.tokenize()));
+}
+
+constexpr auto CALL = TELA_SNIPPET("print(\"%s\\n\", 1'000 + 0x1f * 2.5);");
+
+static_assert(CALL.size.tokens == 12 && CALL.size.lines == 0);
+static_assert(CALL.tokens[0].type == TokenType::T_ID);
+static_assert(CALL.tokens[2].type == TokenType::T_STRING && CALL.tokens[2].length == 3);
+static_assert(CALL.tokens[4].type == TokenType::T_NUMBER && CALL.tokens[4].length == 4);
+static_assert(CALL.tokens[11].type == TokenType::T_EOF);
+
+static_assert(!snippet_lex<8, 2>("\"unterminated").ok());
+static_assert(!snippet_lex<8, 2>("/* unclosed").ok());
+static_assert(!snippet_lex<8, 2>("'ab'").ok());
+static_assert(!snippet_lex<8, 2>("1.2.3").ok());
+static_assert(!snippet_lex<8, 2>("a $ b").ok());
+static_assert(!snippet_lex<8, 2>("\xff").ok());
+static_assert(!snippet_lex<2, 0>("a b").ok());
+static_assert(!snippet_lex<8, 1>("a\nb\nc").ok());
+
+TEST_CASE("Snippets lexed at compile time", "[snippet]")
+{
+  SECTION("Tokens match the lexer")
+  {
+    require_lexed(CALL, "print(\"%s\\n\", 1'000 + 0x1f * 2.5);");
+    require_lexed(TELA_SNIPPET("fn main(a: int, ...) {\n"
+                               "  // comment\n"
+                               "  let ñame = a /* x */ >= 0b101 ? 'c' : '\\t';\n"
+                               "  return ñame++ != a && !b || c <<= d;\n"
+                               "}\n"),
+                  "fn main(a: int, ...) {\n"
+                  "  // comment\n"
+                  "  let ñame = a /* x */ >= 0b101 ? 'c' : '\\t';\n"
+                  "  return ñame++ != a && !b || c <<= d;\n"
+                  "}\n");
+    require_lexed(TELA_SNIPPET("x+=1;y-=2;z*=3;w/=4;v%=5;u&=6;t|=7;s^=8;~r[q].p--"),
+                  "x+=1;y-=2;z*=3;w/=4;v%=5;u&=6;t|=7;s^=8;~r[q].p--");
+    require_lexed(TELA_SNIPPET(""), "");
+  }
+
+  SECTION("Errors are raised when the tokens are taken")
+  {
+    constexpr auto snippet = snippet_lex<8, 2>("let a;\nlet b = \"open;");
+    SourceManager sources;
+
+    try {
+      snippet.tokenize(sources, "snippet.tl");
+      FAIL("No error was raised.");
+    } catch (Error &error) {
+      SourcePosition position = sources.resolve(error.loc);
+      REQUIRE(std::string(error.what()) == "Unterminated string.");
+      REQUIRE(position.row == 2);
+      REQUIRE(position.col == 9);
+    }
+  }
+}
@@ -0,0 +1,109 @@
+#include "source/source.hpp"
+#include "error/error.hpp"
+#include "lexer/lexer.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST_CASE("Resolution of source locations", "[source]")
+{
+  SECTION("Locations of several sources")
+  {
+    SourceManager sources;
+    std::uint32_t a = sources.add("a.tl", "let x = 1;");
+    std::uint32_t b = sources.add("b.tl", "x\n  y");
+
+    std::vector<Token> first  = Lexer(sources, a).tokenize();
+    std::vector<Token> second = Lexer(sources, b).tokenize();
+
+    SourcePosition x = sources.resolve(first[1].loc);
+    REQUIRE_FALSE(strcmp(x.path, "a.tl"));
+    REQUIRE(x.row == 1);
+    REQUIRE(x.col == 5);
+
+    SourcePosition y = sources.resolve(second[1].loc);
+    REQUIRE_FALSE(strcmp(y.path, "b.tl"));
+    REQUIRE(y.row == 2);
+    REQUIRE(y.col == 3);
+  }
+
+  SECTION("Columns count code points")
+  {
+    SourceManager sources;
+    std::uint32_t source      = sources.add("test.tl", "été\nπ = \"ü\" x");
+    std::vector<Token> tokens = Lexer(sources, source).tokenize();
+
+    REQUIRE(sources.resolve(tokens[1].loc).col == 1);
+    REQUIRE(sources.resolve(tokens[3].loc).col == 5);
+    REQUIRE(sources.resolve(tokens[4].loc).col == 9);
+  }
+
+  SECTION("Locations of large sources")
+  {
+    SourceManager sources;
+    std::string input = "a" + std::string(3 << 20, '\n') + "  b";
+
+    std::vector<Token> tokens = Lexer(sources, sources.add("test.tl", input)).tokenize();
+
+    SourcePosition b = sources.resolve(tokens[1].loc);
+    REQUIRE(b.row == (3 << 20) + 1);
+    REQUIRE(b.col == 3);
+    REQUIRE(sources.resolve(tokens[0].loc).row == 1);
+  }
+
+  // Locations of sources don't take from one another however dense their tokens are, which is
+  // scaled down to a token in every MiB of several sources of 5 GiB each.
+  SECTION("Dense sources past 4 GiB")
+  {
+    SourceManager sources;
+    std::uint64_t size = (std::uint64_t)5 << 30;
+    std::vector<SourceLoc> locs;
+
+    for (int i = 0; i < 3; i++) {
+      std::uint32_t buffer = sources.add("source" + std::to_string(i), std::string());
+      for (std::uint64_t offset = 1 << 20; offset <= size; offset += 1 << 20)
+        sources.add_line(buffer, offset);
+      for (std::uint64_t offset = 0; offset < size; offset += 1 << 20)
+        locs.push_back(sources.locate(buffer, offset + 7));
+    }
+
+    for (std::size_t i = 0; i < locs.size(); i += 997) {
+      SourcePosition position = sources.resolve(locs[i]);
+      REQUIRE(std::string(position.path) == "source" + std::to_string(i / 5120));
+      REQUIRE(position.row == i % 5120 + 1);
+      REQUIRE(position.col == 8);
+    }
+    REQUIRE(sources.resolve(locs.back()).row == 5120);
+  }
+
+  SECTION("Streamed sources")
+  {
+    SourceManager sources;
+    std::istringstream stream("a\n\n b");
+    std::vector<Token> tokens = Lexer(sources, sources.add_stream("-"), stream).tokenize();
+
+    SourcePosition b = sources.resolve(tokens[1].loc);
+    REQUIRE_FALSE(strcmp(b.path, "-"));
+    REQUIRE(b.row == 3);
+    REQUIRE(b.col == 2);
+
+    // Rows and columns too large for their bits are clamped.
+    std::uint64_t rows   = (std::uint64_t)1 << (SourceManager::OFFSET_BITS - SourceManager::COL_BITS);
+    std::uint64_t cols   = (std::uint64_t)1 << SourceManager::COL_BITS;
+    std::uint32_t buffer = sources.add_stream("-");
+    SourcePosition far   = sources.resolve(sources.locate(buffer, rows * 2, cols * 2));
+    REQUIRE(far.row == rows - 1);
+    REQUIRE(far.col == cols - 2);
+  }
+
+  SECTION("Missing locations")
+  {
+    SourceManager sources;
+    sources.add("test.tl", "x");
+
+    REQUIRE(sources.resolve(SourceManager::NONE).path == nullptr);
+    REQUIRE(Error("Hello!").loc == SourceManager::NONE);
+  }
+}
@@ -0,0 +1,75 @@
+#include "symbols/symbols.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+TEST_CASE("SymbolTable class tests", "[symbols]")
+{
+  SymbolTable symbols;
+
+  SECTION("Inner scopes shadow outer ones")
+  {
+    symbols.declare(1, 10);
+    symbols.declare(2, 20);
+
+    symbols.enter();
+    symbols.declare(1, 11);
+    symbols.declare(3, 31);
+    REQUIRE(symbols.depth() == 1);
+    REQUIRE(symbols.find(1) == 11);
+    REQUIRE(symbols.find(2) == 20);
+    REQUIRE(symbols.declared(1));
+    REQUIRE(!symbols.declared(2));
+
+    symbols.enter();
+    symbols.declare(3, 32);
+    REQUIRE(symbols.find(3) == 32);
+    symbols.leave();
+
+    REQUIRE(symbols.find(3) == 31);
+    symbols.leave();
+
+    REQUIRE(symbols.depth() == 0);
+    REQUIRE(symbols.find(1) == 10);
+    REQUIRE(symbols.find(3) == SymbolTable::NONE);
+    REQUIRE(symbols.declared(1));
+    REQUIRE(symbols.size() == 2);
+  }
+
+  SECTION("Leaving scopes matches a reference implementation")
+  {
+    // Every scope as a map of its own bindings, innermost last.
+    std::vector<std::map<std::uint32_t, std::uint32_t>> reference(1);
+    std::srand(7);
+
+    for (int step = 0; step < 20000; step++) {
+      int action = std::rand() % 10;
+
+      if (action == 0) {
+        symbols.enter();
+        reference.emplace_back();
+      } else if (action == 1 && reference.size() > 1) {
+        symbols.leave();
+        reference.pop_back();
+      } else {
+        std::uint32_t name = (std::uint32_t)(std::rand() % 300);
+        symbols.declare(name, (std::uint32_t)step);
+        reference.back()[name] = (std::uint32_t)step;
+      }
+
+      if (step % 97 == 0) {
+        for (std::uint32_t name = 0; name < 300; name++) {
+          std::uint32_t expected = SymbolTable::NONE;
+          for (const auto &scope : reference) {
+            auto found = scope.find(name);
+            if (found != scope.end())
+              expected = found->second;
+          }
+          REQUIRE(symbols.find(name) == expected);
+          REQUIRE(symbols.declared(name) == (reference.back().count(name) != 0));
+        }
+      }
+    }
+  }
+}
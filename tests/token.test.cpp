@@ -5,29 +5,27 @@ TEST_CASE("Token class tests", "[token]")
 {
   SECTION("Token initialization without value")
   {
-    Token tok(TokenType::T_ADD, 1, 1);
+    Token tok(TokenType::T_ADD, 0);
 
     REQUIRE(tok.type == TokenType::T_ADD);
     REQUIRE(tok.value == "");
-    REQUIRE(tok.row == 1);
-    REQUIRE(tok.col == 1);
+    REQUIRE(tok.loc == 0);
     REQUIRE_FALSE(strcmp(tok.str(), "+"));
   }
 
   SECTION("Token initialization with value")
   {
-    Token tok(TokenType::T_NUMBER, "1", 1, 1);
+    Token tok(TokenType::T_NUMBER, "1", 0);
 
     REQUIRE(tok.type == TokenType::T_NUMBER);
     REQUIRE(tok.value == "1");
-    REQUIRE(tok.row == 1);
-    REQUIRE(tok.col == 1);
+    REQUIRE(tok.loc == 0);
     REQUIRE_FALSE(strcmp(tok.str(), "1"));
   }
 
   SECTION("Token::is_in")
   {
-    Token tok(TokenType::T_ADD, 1, 1);
+    Token tok(TokenType::T_ADD, 0);
 
     REQUIRE(tok.is_in(TokenType::T_ADD | TokenType::T_EOF));
     REQUIRE(tok.is_in(TokenType::T_ID | TokenType::T_ADD | TokenType::T_EOF));
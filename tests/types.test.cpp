@@ -0,0 +1,69 @@
+#include "types/types.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+#include <vector>
+
+TEST_CASE("TypeTable class tests", "[types]")
+{
+  TypeTable types;
+
+  SECTION("Primitive types")
+  {
+    REQUIRE(TypeTable::primitive("int") == TypeTable::INT);
+    REQUIRE(TypeTable::primitive("string") == TypeTable::STRING);
+    REQUIRE(TypeTable::primitive("?") == TypeTable::NONE);
+    REQUIRE(TypeTable::primitive("integer") == TypeTable::NONE);
+
+    REQUIRE(types.kind(TypeTable::FLOAT) == TypeKind::K_FLOAT);
+    REQUIRE(types.str(TypeTable::CHAR) == "char");
+    REQUIRE(types.size() == 0);
+  }
+
+  SECTION("Equal types share an id")
+  {
+    TypeId binary = types.function(TypeTable::INT, { TypeTable::INT, TypeTable::INT }, false);
+    TypeId unary  = types.function(TypeTable::INT, { TypeTable::INT }, false);
+    TypeId print  = types.function(TypeTable::NIL, { TypeTable::STRING }, true);
+
+    REQUIRE(binary != unary);
+    REQUIRE(binary != print);
+    REQUIRE(types.function(TypeTable::INT, { TypeTable::INT, TypeTable::INT }, false) == binary);
+    REQUIRE(types.function(TypeTable::INT, { TypeTable::INT }, true) != unary);
+    REQUIRE(types.size() == 4);
+
+    TypeId higher = types.function(binary, { unary, TypeTable::ANY }, false);
+    REQUIRE(types.kind(higher) == TypeKind::K_FUNCTION);
+    REQUIRE(types.result(higher) == binary);
+    REQUIRE(types.params(higher) == std::vector<TypeId>{ unary, TypeTable::ANY });
+    REQUIRE(!types.variadic(higher));
+
+    REQUIRE(types.str(print) == "fn(string, ...): nil");
+    REQUIRE(types.str(higher) == "fn(fn(int): int, any): fn(int, int): int");
+    REQUIRE(types.str(types.function(TypeTable::NIL, {}, true)) == "fn(...): nil");
+  }
+
+  SECTION("Threads interning the same types get the same ids")
+  {
+    auto build = [&](std::vector<TypeId> &ids) {
+      for (TypeId a = 0; a <= TypeTable::STRING; a++) {
+        for (TypeId b = 0; b <= TypeTable::STRING; b++) {
+          for (std::uint32_t count = 1; count <= 40; count++)
+            ids.push_back(types.function(a, std::vector<TypeId>(count, b), count % 2 == 0));
+        }
+      }
+      ids.push_back(types.function(ids[0], { ids[1], ids[2] }, false));
+    };
+
+    std::vector<std::vector<TypeId>> ids(8);
+    std::vector<std::thread> threads;
+    for (std::vector<TypeId> &list : ids)
+      threads.emplace_back(build, std::ref(list));
+    for (std::thread &thread : threads)
+      thread.join();
+
+    for (const std::vector<TypeId> &list : ids)
+      REQUIRE(list == ids[0]);
+    REQUIRE(types.size() == 7 * 7 * 40 + 1);
+    REQUIRE(types.params(ids[0].back()) == std::vector<TypeId>{ ids[0][1], ids[0][2] });
+  }
+}
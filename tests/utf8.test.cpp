@@ -0,0 +1,80 @@
+#include "utf8/utf8.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+static std::size_t validate(const std::string &input)
+{
+  return utf8_validate(input.data(), input.size());
+}
+
+TEST_CASE("Validation of UTF-8", "[utf8]")
+{
+  SECTION("Well-formed input")
+  {
+    REQUIRE(validate("") == 0);
+    REQUIRE(validate("plain ASCII") == 11);
+    REQUIRE(validate("\xc2\x80\xdf\xbf") == 4);
+    REQUIRE(validate("\xe0\xa0\x80\xed\x9f\xbf\xee\x80\x80\xef\xbf\xbf") == 12);
+    REQUIRE(validate("\xf0\x90\x80\x80\xf4\x8f\xbf\xbf") == 8);
+  }
+
+  SECTION("Malformed input")
+  {
+    REQUIRE(validate("\x80") == 0);
+    REQUIRE(validate("ab\xc0\x80") == 2);
+    REQUIRE(validate("\xc1\xbf") == 0);
+    REQUIRE(validate("\xe0\x9f\xbf") == 0);
+    REQUIRE(validate("\xed\xa0\x80") == 0);
+    REQUIRE(validate("\xf0\x8f\xbf\xbf") == 0);
+    REQUIRE(validate("\xf4\x90\x80\x80") == 0);
+    REQUIRE(validate("\xf5\x80\x80\x80") == 0);
+    REQUIRE(validate("\xe2\x82") == 0);
+    REQUIRE(validate("\xe2\x82x") == 0);
+    REQUIRE(validate("\xff") == 0);
+  }
+
+  SECTION("Errors are found at any offset")
+  {
+    std::string ascii(100, 'a');
+
+    for (std::size_t offset = 0; offset < ascii.size(); offset++) {
+      std::string input = ascii;
+      input[offset]     = '\xc3';
+      REQUIRE(validate(input) == offset);
+
+      input.insert(offset + 1, "\xa9");
+      REQUIRE(validate(input) == input.size());
+    }
+  }
+}
+
+TEST_CASE("Decoding of UTF-8", "[utf8]")
+{
+  unsigned int length;
+
+  REQUIRE(utf8_decode("A", length) == 'A');
+  REQUIRE(length == 1);
+  REQUIRE(utf8_decode("\xc3\xa9", length) == 0xe9);
+  REQUIRE(length == 2);
+  REQUIRE(utf8_decode("\xe2\x82\xac", length) == 0x20ac);
+  REQUIRE(length == 3);
+  REQUIRE(utf8_decode("\xf0\x9f\x98\x80", length) == 0x1f600);
+  REQUIRE(length == 4);
+}
+
+TEST_CASE("Identifier properties", "[utf8]")
+{
+  REQUIRE(utf8_is_xid_start(0xe9));
+  REQUIRE(utf8_is_xid_start(0x3c0));
+  REQUIRE(utf8_is_xid_start(0x5909));
+  REQUIRE(!utf8_is_xid_start(0x301));
+  REQUIRE(!utf8_is_xid_start(0x660));
+  REQUIRE(!utf8_is_xid_start(0x2260));
+  REQUIRE(!utf8_is_xid_start(0x1f600));
+
+  REQUIRE(utf8_is_xid_continue(0xe9));
+  REQUIRE(utf8_is_xid_continue(0x301));
+  REQUIRE(utf8_is_xid_continue(0x660));
+  REQUIRE(!utf8_is_xid_continue(0xa0));
+  REQUIRE(!utf8_is_xid_continue(0x2260));
+}
@@ -0,0 +1,85 @@
+#include "value/value.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <limits>
+
+TEST_CASE("Value class tests", "[value]")
+{
+  SECTION("Integers are stored inline as 48-bit two's complement")
+  {
+    REQUIRE(Value().is_int());
+    REQUIRE(Value().as_int() == 0);
+    REQUIRE(Value::from_int(42).type() == ValueType::V_INT);
+    REQUIRE(Value::from_int(-42).as_int() == -42);
+    REQUIRE(Value::from_int(Value::MAX_INT).as_int() == Value::MAX_INT);
+    REQUIRE(Value::from_int(Value::MIN_INT).as_int() == Value::MIN_INT);
+    REQUIRE(Value::from_int(Value::MAX_INT + 1).as_int() == Value::MIN_INT);
+    REQUIRE(Value::from_int(-1).as_float() == -1.0);
+  }
+
+  SECTION("Doubles are stored as themselves")
+  {
+    REQUIRE(Value::from_float(1.5).type() == ValueType::V_FLOAT);
+    REQUIRE(Value::from_float(1.5).as_float() == 1.5);
+    REQUIRE(Value::from_float(-0.0).is_float());
+    REQUIRE(std::signbit(Value::from_float(-0.0).as_float()));
+    REQUIRE(Value::from_float(-INFINITY).as_float() == -INFINITY);
+    REQUIRE(Value::from_float(std::numeric_limits<double>::max()).is_float());
+  }
+
+  SECTION("NaNs are canonicalized")
+  {
+    double nan = std::numeric_limits<double>::quiet_NaN();
+
+    REQUIRE(Value::from_float(nan).is_float());
+    REQUIRE(Value::from_float(-nan).is_float());
+    REQUIRE(Value::from_float(-nan).identical(Value::from_float(nan)));
+    REQUIRE(std::isnan(Value::from_float(0.0 / Value::from_float(0.0).as_float()).as_float()));
+  }
+
+  SECTION("Chars and strings")
+  {
+    REQUIRE(Value::from_char('a').type() == ValueType::V_CHAR);
+    REQUIRE(Value::from_char('a').as_int() == 'a');
+    REQUIRE(Value::from_char('\xff').as_char() == '\xff');
+    REQUIRE(Value::from_string(7).type() == ValueType::V_STRING);
+    REQUIRE(Value::from_string(0xffffffff).as_string() == 0xffffffff);
+    REQUIRE(Value::from_char('a').is_integral());
+    REQUIRE(Value::from_int(1).is_integral());
+    REQUIRE_FALSE(Value::from_string(1).is_integral());
+    REQUIRE_FALSE(Value::from_float(1.0).is_integral());
+  }
+
+  SECTION("Truthiness")
+  {
+    REQUIRE_FALSE(Value::from_int(0).truthy());
+    REQUIRE(Value::from_int(-1).truthy());
+    REQUIRE_FALSE(Value::from_float(-0.0).truthy());
+    REQUIRE(Value::from_float(0.5).truthy());
+    REQUIRE_FALSE(Value::from_char('\0').truthy());
+    REQUIRE(Value::from_string(0).truthy());
+  }
+
+  SECTION("Integer fast paths wrap like the slow paths")
+  {
+    Value a = Value::from_int(-7);
+    Value b = Value::from_int(3);
+
+    REQUIRE(Value::both_int(a, b));
+    REQUIRE_FALSE(Value::both_int(a, Value::from_char('a')));
+    REQUIRE(Value::both_float(Value::from_float(1.0), Value::from_float(-INFINITY)));
+    REQUIRE_FALSE(Value::both_float(Value::from_float(1.0), a));
+
+    REQUIRE(Value::int_add(a, b).as_int() == -4);
+    REQUIRE(Value::int_sub(b, a).as_int() == 10);
+    REQUIRE(Value::int_mul(a, b).as_int() == -21);
+    REQUIRE(Value::int_and(a, b).as_int() == (-7 & 3));
+    REQUIRE(Value::int_or(a, b).as_int() == (-7 | 3));
+    REQUIRE(Value::int_xor(a, b).as_int() == (-7 ^ 3));
+    REQUIRE(Value::int_xor(a, b).is_int());
+    REQUIRE(Value::int_incr(Value::from_int(Value::MAX_INT), 1).as_int() == Value::MIN_INT);
+    REQUIRE(Value::int_incr(a, -1).as_int() == -8);
+    REQUIRE(Value::int_mul(Value::from_int(Value::MIN_INT), Value::from_int(-1)).as_int()
+            == Value::MIN_INT);
+  }
+}
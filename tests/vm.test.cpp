@@ -0,0 +1,295 @@
+#include "vm/vm.hpp"
+#include "compiler/compiler.hpp"
+#include "error/error.hpp"
+#include "folder/folder.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+static std::atomic<std::size_t> allocations(0);
+static SourceManager sources;
+
+void *operator new(std::size_t size)
+{
+  allocations++;
+  if (void *ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+static Bytecode compile(const char *input)
+{
+  Lexer lexer(sources, sources.add("test.tl", input));
+  Parser parser(lexer.tokenize());
+  Ast ast = parser.parse();
+
+  Folder folder(ast);
+  folder.fold();
+
+  Compiler compiler(ast);
+  return compiler.compile();
+}
+
+static std::int64_t run(const char *input)
+{
+  Bytecode program = compile(input);
+  Vm vm(program);
+
+  return vm.run().as_int();
+}
+
+static std::string output(const char *input)
+{
+  Bytecode program = compile(input);
+  std::FILE *out   = std::tmpfile();
+  Vm vm(program, out);
+  vm.run();
+
+  std::string text;
+  std::rewind(out);
+  for (int c; (c = std::fgetc(out)) != EOF;)
+    text.push_back((char)c);
+  std::fclose(out);
+
+  return text;
+}
+
+TEST_CASE("Execution of arithmetic operators", "[vm]")
+{
+  REQUIRE(run("fn main() { let a = 7; let b = 2; return a + b * 3 - 1; }") == 12);
+  REQUIRE(run("fn main() { let a = 7; let b = 2; return a / b; }") == 3);
+  REQUIRE(run("fn main() { let a = -7; let b = 2; return a % b; }") == -1);
+  REQUIRE(run("fn main() { let a = 5; return -a; }") == -5);
+  REQUIRE(run("fn main() { let a = 5; return +a; }") == 5);
+  REQUIRE(output("fn main() { let a = 1.5; print(a * 2, a / 2, -a); }") == "3 0.75 -1.5\n");
+  REQUIRE(output("fn main() { let a = 3; print(a / 2.0); }") == "1.5\n");
+  REQUIRE(output("fn main() { let c = 'a'; print(c, c + 1); }") == "a 98\n");
+  REQUIRE(output("fn main() { let c = 'a'; print(c + 0, c * 1, - -c); }") == "97 97 97\n");
+}
+
+TEST_CASE("Execution of 48-bit integer arithmetic", "[vm]")
+{
+  REQUIRE(run("fn main() { let a = 140737488355327; return a + 1; }") == Value::MIN_INT);
+  REQUIRE(run("fn main() { let a = -140737488355327; return a - 2; }") == Value::MAX_INT);
+  REQUIRE(run("fn main() { let a = 16777216; return a * a; }") == 0);
+  REQUIRE(run("fn main() { let a = -1; return a * 3 ^ 1; }") == -4);
+  REQUIRE(output("fn main() { let a = 0.0; print(a / 0.5 == 0.0, -a < 1.0); }") == "1 1\n");
+  REQUIRE(run("fn main() { return 140737488355327 + 1 > 0; }") == 0);
+  REQUIRE(run("fn main() { return 140737488355327 * 1024 / 1024; }") == -1);
+  REQUIRE(run("fn main() { let a = 140737488355327; return a * 1024 / 1024; }") == -1);
+  REQUIRE_THROWS_AS(compile("fn main() { return 140737488355328; }"), Error);
+  REQUIRE_THROWS_AS(compile("fn main() { return 99999999999999999999 - 1; }"), Error);
+}
+
+TEST_CASE("Execution doesn't allocate", "[vm]")
+{
+  Bytecode program = compile("fn fib(n: int): int { return n < 2 ? n : fib(n - 1) + fib(n - 2); }"
+                             "fn main() { let i = 0; let f = 0.5; while (i < 1000) { f = f * 1.5 + i;"
+                             " i++; } return fib(10) + (f > 0.0); }");
+  Vm vm(program);
+  REQUIRE(vm.run().as_int() == 56);
+
+  std::size_t before = allocations;
+  Value result       = vm.run();
+  std::size_t after  = allocations;
+
+  REQUIRE(result.as_int() == 56);
+  REQUIRE(after == before);
+}
+
+TEST_CASE("Execution of bitwise operators", "[vm]")
+{
+  REQUIRE(run("fn main() { let a = 12; let b = 10; return a & b; }") == 8);
+  REQUIRE(run("fn main() { let a = 12; let b = 10; return a | b; }") == 14);
+  REQUIRE(run("fn main() { let a = 12; let b = 10; return a ^ b; }") == 6);
+  REQUIRE(run("fn main() { let a = 12; return ~a; }") == -13);
+}
+
+TEST_CASE("Execution of comparison and logical operators", "[vm]")
+{
+  REQUIRE(run("fn main() { let a = 1; let b = 2; return (a < b) + (a > b) * 2 + (a <= 1) * 4; }")
+          == 5);
+  REQUIRE(run("fn main() { let a = 1; let b = 2; return (a == b) + (a != b) * 2 + (b >= 3) * 4; }")
+          == 2);
+  REQUIRE(run("fn main() { let a = 3; return !a; }") == 0);
+  REQUIRE(run("fn main() { let a = 3; let b = 4; return a && b; }") == 1);
+  REQUIRE(run("fn main() { let a = 0; let b = 4; return a || b; }") == 1);
+  REQUIRE(run("fn main() { let a = 0; let b = 0; return a || b; }") == 0);
+  REQUIRE(output("fn t() { print(\"t\"); return 1; }"
+                 "fn main() { let a = 0; let b = 1; a && t(); b || t(); b && t(); }")
+          == "t\n");
+  REQUIRE(run("fn main() { let a = 2; return a > 1 ? 10 : 20; }") == 10);
+}
+
+TEST_CASE("Execution of assignment operators", "[vm]")
+{
+  REQUIRE(run("fn main() { let a = 10; a += 5; a -= 3; a *= 2; a /= 4; a %= 4; return a; }") == 2);
+  REQUIRE(run("fn main() { let a = 12; a &= 10; a |= 1; a ^= 3; return a; }") == 10);
+  REQUIRE(run("fn main() { let a; let b; a = b = 3; return a + b; }") == 6);
+}
+
+TEST_CASE("Execution of increment and decrement operators", "[vm]")
+{
+  REQUIRE(run("fn main() { let a = 5; let b = a++; return a * 10 + b; }") == 65);
+  REQUIRE(run("fn main() { let a = 5; let b = ++a; return a * 10 + b; }") == 66);
+  REQUIRE(run("fn main() { let a = 5; let b = a--; return a * 10 + b; }") == 45);
+  REQUIRE(run("fn main() { let a = 5; let b = --a; return a * 10 + b; }") == 44);
+  REQUIRE(output("fn main() { let a = 1.5; a++; print(a); }") == "2.5\n");
+}
+
+TEST_CASE("Execution of control flow", "[vm]")
+{
+  REQUIRE(run("fn main() { let i = 0; let s = 0; while (i < 10) { s += i; i++; } return s; }")
+          == 45);
+  REQUIRE(run("fn main() { let a = 3; if (a > 2) return 1; else return 2; }") == 1);
+  REQUIRE(run("fn main() { let a = 3; if (a > 5) return 1; return 2; }") == 2);
+  REQUIRE(run("fn f() { } fn main() { return f(); }") == 0);
+}
+
+TEST_CASE("Execution of function calls", "[vm]")
+{
+  REQUIRE(run("fn add(a: int, b: int): int { return a + b; } fn main() { return add(2, 3); }") == 5);
+  REQUIRE(run("fn fib(n: int): int { return n < 2 ? n : fib(n - 1) + fib(n - 2); }"
+              "fn main() { return fib(15); }")
+          == 610);
+  REQUIRE(run("fn f(a: int, ...) { return a; } fn main() { return f(4, 5, 6); }") == 4);
+  REQUIRE(run("let g = 2; fn main() { g *= 21; return g; }") == 42);
+  REQUIRE(output("fn main() { print(\"x\", 1, 'c'); print(); }") == "x 1 c\n\n");
+}
+
+TEST_CASE("Execution of string indexing", "[vm]")
+{
+  REQUIRE(output("fn main() { let s = \"hello\"; print(s[1]); }") == "e\n");
+  REQUIRE(run("fn main() { let s = \"a\"; let t = \"a\"; return s == t; }") == 1);
+}
+
+TEST_CASE("Runtime errors", "[vm]")
+{
+  SECTION("Division by zero")
+  {
+    Bytecode program = compile("fn main() {\n  let a = 0;\n  return 1 / a;\n}");
+    Vm vm(program);
+
+    try {
+      vm.run();
+      FAIL("Expected an error");
+    } catch (Error &e) {
+      REQUIRE(sources.resolve(e.loc).row == 3);
+      REQUIRE(sources.resolve(e.loc).col == 12);
+    }
+  }
+
+  SECTION("Invalid operands")
+  {
+    Bytecode program = compile("fn main() { let s = \"a\"; return s + 1; }");
+    Vm vm(program);
+
+    REQUIRE_THROWS_AS(vm.run(), Error);
+
+    Bytecode bitwise = compile("fn main() { let f = 2.5; return f | 0; }");
+    Vm vm_bitwise(bitwise);
+
+    REQUIRE_THROWS_AS(vm_bitwise.run(), Error);
+
+    // The modulo may run as the second part of a superinstruction.
+    program = compile("fn main() {\n  let s = \"a\";\n  return s % 2;\n}");
+    Vm fused(program);
+
+    try {
+      fused.run();
+      FAIL("Expected an error");
+    } catch (Error &e) {
+      REQUIRE(sources.resolve(e.loc).row == 3);
+      REQUIRE(sources.resolve(e.loc).col == 12);
+    }
+  }
+
+  SECTION("Index out of range")
+  {
+    Bytecode program = compile("fn main() { let s = \"a\"; return s[1]; }");
+    Vm vm(program);
+
+    REQUIRE_THROWS_AS(vm.run(), Error);
+  }
+
+  SECTION("Stack overflow")
+  {
+    Bytecode program = compile("fn f(n: int) { return f(n + 1); } fn main() { return f(0); }");
+    Vm vm(program);
+
+    REQUIRE_THROWS_AS(vm.run(), Error);
+  }
+}
+
+TEST_CASE("Superinstructions", "[vm]")
+{
+  SECTION("Every superinstruction takes the place of its first part")
+  {
+    for (unsigned int op = Bytecode::BASE_OP_COUNT; op < Bytecode::OP_COUNT; op++) {
+      Op first  = Bytecode::op_first((Op)op);
+      Op second = Bytecode::op_second((Op)op);
+      Bytecode program;
+
+      REQUIRE((unsigned int)first < Bytecode::BASE_OP_COUNT);
+      REQUIRE((unsigned int)second < Bytecode::BASE_OP_COUNT);
+      REQUIRE(!Bytecode::op_branches(first));
+      REQUIRE(Bytecode::op_size((Op)op) == Bytecode::op_size(first));
+      REQUIRE(Bytecode::op_name((Op)op)
+              == std::string(Bytecode::op_name(first)) + (Bytecode::op_name(second) + 1));
+
+      for (Op part : { first, second }) {
+        program.emit(part);
+        for (unsigned int i = 0; i < Bytecode::op_size(part); i++)
+          program.emit_u8(0);
+      }
+      program.emit(Op::O_HALT);
+
+      // The second part stays in place, though it may start a superinstruction of its own.
+      std::vector<std::uint8_t> code = program.fused();
+      std::uint32_t next             = 1 + Bytecode::op_size(first);
+      REQUIRE(code.size() == program.code.size());
+      REQUIRE(code[0] == op);
+      REQUIRE(std::equal(code.begin() + 1, code.begin() + next, program.code.begin() + 1));
+      REQUIRE(Bytecode::op_first((Op)code[next]) == second);
+    }
+  }
+
+  SECTION("Fused code runs like the code it came from")
+  {
+    const char *input = "fn main() { let i = 0; let s = 0; while (i < 100) { s = s + i * 3 % 7;"
+                        " if (s > 50 && i != 3) s -= 50; i++; } return s; }";
+    Bytecode program  = compile(input);
+    std::vector<std::uint64_t> pairs;
+    Vm vm(program);
+
+    REQUIRE(vm.run().as_int() == vm.profile(pairs).as_int());
+  }
+
+  SECTION("Profiles count the instructions that follow one another")
+  {
+    Bytecode program = compile("fn main() { let i = 0; while (i < 10) i++; return i; }");
+    std::vector<std::uint64_t> pairs;
+    Vm vm(program);
+
+    REQUIRE(vm.profile(pairs).as_int() == 10);
+    REQUIRE(pairs.size() == Bytecode::OP_COUNT * Bytecode::OP_COUNT);
+    REQUIRE(pairs[(int)Op::O_LT * Bytecode::OP_COUNT + (int)Op::O_JUMP_IF_FALSE] == 11);
+    REQUIRE(pairs[(int)Op::O_JUMP * Bytecode::OP_COUNT + (int)Op::O_LOAD_LOCAL] == 0);
+  }
+}
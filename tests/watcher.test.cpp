@@ -0,0 +1,111 @@
+#include "watcher/watcher.hpp"
+#include "error/error.hpp"
+#include "query/query.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static void write_file(const std::string &path, const std::string &contents)
+{
+  std::ofstream file(path, std::ios::binary);
+  file << contents;
+}
+
+static std::string read_file(const std::string &path)
+{
+  std::ifstream file(path, std::ios::binary);
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+TEST_CASE("Watching sources", "[watcher]")
+{
+  std::filesystem::remove_all("tela_watch");
+  std::filesystem::create_directories("tela_watch/lib");
+  write_file("tela_watch/main.tl", "fn main() {}\n");
+  write_file("tela_watch/lib/util.tl", "fn f() {}\n");
+  write_file("tela_watch/notes.txt", "");
+
+  SECTION("Sources are listed when the watch starts")
+  {
+    Watcher watcher("tela_watch");
+    REQUIRE(watcher.sources()
+            == std::vector<std::string>{ "tela_watch/lib/util.tl", "tela_watch/main.tl" });
+  }
+
+  SECTION("Saved sources are reported once")
+  {
+    Watcher watcher("tela_watch");
+
+    write_file("tela_watch/notes.txt", "ignored");
+    write_file("tela_watch/main.tl", "fn main() { print(1); }\n");
+    write_file("tela_watch/main.tl", "fn main() { print(2); }\n");
+    write_file("tela_watch/lib/util.tl", "fn f() { return 1; }\n");
+    REQUIRE(watcher.wait()
+            == std::vector<std::string>{ "tela_watch/lib/util.tl", "tela_watch/main.tl" });
+
+    std::filesystem::remove("tela_watch/main.tl");
+    REQUIRE(watcher.wait() == std::vector<std::string>{ "tela_watch/main.tl" });
+  }
+
+  SECTION("Directories created later are watched")
+  {
+    Watcher watcher("tela_watch");
+
+    std::filesystem::create_directories("tela_watch/new");
+    write_file("tela_watch/new/a.tl", "fn a() {}\n");
+    REQUIRE(watcher.wait() == std::vector<std::string>{ "tela_watch/new/a.tl" });
+
+    write_file("tela_watch/new/a.tl", "fn a() { return 1; }\n");
+    REQUIRE(watcher.wait() == std::vector<std::string>{ "tela_watch/new/a.tl" });
+  }
+
+  SECTION("Importers are checked against what is left of the modules they import")
+  {
+    write_file("tela_watch/lib/main.tl", "import util;\nfn main() { f(); }\n");
+
+    Watcher watcher("tela_watch");
+    SourceManager sources;
+    QueryDatabase queries(sources);
+
+    auto update = [&queries](const std::vector<std::string> &paths) {
+      for (const std::string &path : paths) {
+        if (std::filesystem::is_regular_file(path))
+          queries.set_source(path, read_file(path));
+        else
+          queries.remove_source(path);
+      }
+    };
+    auto messages = [&queries](const std::string &path) {
+      std::vector<std::string> messages;
+      for (const Checker::Diagnostic &diagnostic : queries.check(path))
+        messages.push_back(diagnostic.message);
+      return messages;
+    };
+
+    update(watcher.sources());
+    REQUIRE(messages("tela_watch/lib/main.tl").empty());
+
+    write_file("tela_watch/lib/util.tl", "fn g() {}\n");
+    update(watcher.wait());
+    REQUIRE(messages("tela_watch/lib/main.tl")
+            == std::vector<std::string>{ "Undefined function: f" });
+
+    std::filesystem::remove("tela_watch/lib/util.tl");
+    update(watcher.wait());
+    REQUIRE(messages("tela_watch/lib/main.tl")
+            == std::vector<std::string>{ "Unknown module: util", "Undefined function: f" });
+  }
+
+  SECTION("Errors")
+  {
+    REQUIRE_THROWS_AS(Watcher("tela_watch/missing"), Error);
+    REQUIRE_THROWS_AS(Watcher("tela_watch/main.tl"), Error);
+  }
+
+  std::filesystem::remove_all("tela_watch");
+}
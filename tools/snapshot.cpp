@@ -0,0 +1,58 @@
+#include <cstdio>
+#include "error/error.hpp"
+#include "prelude/prelude.hpp"
+#include "source/source.hpp"
+#include <fstream>
+#include <string>
+
+// Compiles the prelude into the C++ source that links its image into tela:
+//
+//   tela-snapshot <prelude.tl> <output.cpp>
+int main(int argc, char **argv)
+{
+  SourceManager sources;
+
+  try
+  {
+    if (argc != 3)
+      throw Error("Usage: %s <prelude.tl> <output.cpp>", argv[0]);
+
+    std::string image = prelude_image(sources, sources.load(argv[1]));
+    std::string output = "// Generated by tela-snapshot from prelude.tl.\n"
+                         "#include \"prelude/prelude.hpp\"\n\n"
+                         "alignas(8) const char PRELUDE_SNAPSHOT[] =";
+
+    // Octal escapes always take three digits, so they never run into the next character.
+    for (std::size_t i = 0; i < image.size(); i++)
+    {
+      char escape[5];
+      snprintf(escape, sizeof(escape), "\\%03o", (unsigned int)(unsigned char)image[i]);
+      output += i % 16 == 0 ? "\n  \"" : "";
+      output += escape;
+      output += i % 16 == 15 || i + 1 == image.size() ? "\"" : "";
+    }
+    output += ";\n\nconst std::size_t PRELUDE_SNAPSHOT_SIZE = " + std::to_string(image.size())
+              + ";\n";
+
+    std::ofstream out(argv[2], std::ios::binary | std::ios::trunc);
+    if (!out.write(output.data(), (std::streamsize)output.size()).flush())
+      throw Error("Cannot write file: %s", argv[2]);
+  }
+  catch (Error& error)
+  {
+    SourcePosition position = sources.resolve(error.loc);
+
+    if (position.path != nullptr)
+    {
+      fprintf(stderr, "%s:%llu:%llu: %s\n", position.path, (unsigned long long)position.row,
+              (unsigned long long)position.col, error.what());
+    }
+    else
+    {
+      fprintf(stderr, "%s: %s\n", argv[0], error.what());
+    }
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Turns a profile of the pairs of instructions that ran one after the other, as written by
+// tela --profile-ops, into the superinstructions of the most frequent ones:
+//
+//   tela-superinstructions <profile> <count> <output.hpp>
+//
+// Every line of the profile is "<count> <first> <second>"; blank lines and lines starting with #
+// are skipped. This doesn't link tela-lib, which is built from what it generates.
+struct Pair
+{
+  unsigned long long count;
+  std::string first;
+  std::string second;
+};
+
+static bool is_opcode(const std::string &name)
+{
+  if (name.size() < 3 || name.compare(0, 2, "O_") != 0)
+    return false;
+
+  for (char c : name)
+  {
+    if (!(c >= 'A' && c <= 'Z') && c != '_')
+      return false;
+  }
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  char *end = nullptr;
+  unsigned long count = argc == 4 ? std::strtoul(argv[2], &end, 10) : 0;
+
+  if (argc != 4 || *end != '\0')
+  {
+    fprintf(stderr, "Usage: %s <profile> <count> <output.hpp>\n", argv[0]);
+    return 1;
+  }
+
+  std::ifstream in(argv[1]);
+  if (!in)
+  {
+    fprintf(stderr, "%s: Cannot read file: %s\n", argv[0], argv[1]);
+    return 1;
+  }
+
+  std::vector<Pair> pairs;
+  std::string line;
+  for (unsigned int row = 1; std::getline(in, line); row++)
+  {
+    std::size_t start = line.find_first_not_of(" \t\r");
+    if (start == std::string::npos || line[start] == '#')
+      continue;
+
+    std::istringstream fields(line);
+    Pair pair;
+    std::string rest;
+    if (!(fields >> pair.count >> pair.first >> pair.second) || (fields >> rest)
+        || !is_opcode(pair.first) || !is_opcode(pair.second))
+    {
+      fprintf(stderr, "%s:%u: Invalid pair: %s\n", argv[1], row, line.c_str());
+      return 1;
+    }
+    pairs.push_back(pair);
+  }
+
+  // The most frequent pairs first, and in the order of the profile among equals.
+  std::stable_sort(pairs.begin(), pairs.end(),
+                   [](const Pair &a, const Pair &b) { return a.count > b.count; });
+  pairs.resize(std::min(pairs.size(), (std::size_t)count));
+
+  std::string output = "// Generated by tela-superinstructions from a profile of the interpreter.\n"
+                       "#ifndef SUPERINSTRUCTIONS_HPP\n"
+                       "#define SUPERINSTRUCTIONS_HPP\n\n"
+                       "#define TELA_SUPERINSTRUCTIONS(X)";
+  for (const Pair &pair : pairs)
+  {
+    output += " \\\n  X(" + pair.first + "_" + pair.second.substr(2) + ", " + pair.first + ", "
+              + pair.second + ")";
+  }
+  output += "\n\n#endif\n";
+
+  std::ofstream out(argv[3], std::ios::binary | std::ios::trunc);
+  if (!out.write(output.data(), (std::streamsize)output.size()).flush())
+  {
+    fprintf(stderr, "%s: Cannot write file: %s\n", argv[0], argv[3]);
+    return 1;
+  }
+
+  return 0;
+}
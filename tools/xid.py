@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""Generates src/utf8/xid.hpp, the XID_Start and XID_Continue tables used by the lexer.
+
+The tables hold the non-ASCII code point ranges of both properties as found in the Unicode
+database of the running Python interpreter; ASCII is handled separately by the lexer.
+"""
+
+import os
+import sys
+import unicodedata
+
+
+def ranges(predicate):
+    out, first = [], None
+    for cp in range(0x80, 0x110000):
+        if predicate(chr(cp)):
+            if first is None:
+                first = cp
+        elif first is not None:
+            out.append((first, cp - 1))
+            first = None
+    if first is not None:
+        out.append((first, 0x10FFFF))
+    return out
+
+
+def table(name, items):
+    lines = [f"inline constexpr Utf8Range {name}[] = {{"]
+    row = ""
+    for first, last in items:
+        item = f" {{ 0x{first:05x}, 0x{last:05x} }},"
+        if len(row) + len(item) > 98:
+            lines.append(" " + row)
+            row = ""
+        row += item
+    lines.append(" " + row)
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def main():
+    start = ranges(lambda c: c.isidentifier())
+    cont = ranges(lambda c: ("a" + c).isidentifier())
+
+    path = os.path.join(os.path.dirname(__file__), "..", "src", "utf8", "xid.hpp")
+    with open(path, "w", newline="\n") as out:
+        out.write(
+            "// Generated by tools/xid.py from Unicode "
+            + unicodedata.unidata_version
+            + "; do not edit.\n"
+        )
+        out.write("#ifndef XID_HPP\n#define XID_HPP\n\n")
+        out.write('#include "utf8.hpp"\n\n')
+        out.write(table("XID_START", start) + "\n\n")
+        out.write(table("XID_CONTINUE", cont) + "\n\n")
+        out.write("#endif\n")
+
+    print(f"{len(start)} XID_Start ranges, {len(cont)} XID_Continue ranges", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()